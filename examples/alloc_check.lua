@@ -0,0 +1,42 @@
+---------------------------------------------------------------------------------------------
+--
+-- Checks that the process callback does not allocate in steady state. The
+-- callback below builds a string once per second, which client:check_error()
+-- reports as soon as the warm-up of 50 cycles is over.
+--
+---------------------------------------------------------------------------------------------
+
+local jack = require("luajack")
+
+local PROCESS = [[
+    local client, out = ...
+
+    local count = 0
+
+    client:process_callback(function(nframes)
+        out:clear()
+        count = count + nframes
+        if count >= client:sample_rate() then
+            count = 0
+            local label = "second " .. tostring(client:frame_time()) -- allocates
+        end
+    end)
+]]
+
+local client = jack.client_open("alloc_check")
+
+client:process_load(PROCESS, client, client:output_audio_port("out"))
+client:alloc_strict("flag", 50)
+client:activate()
+
+for i = 1, 5 do
+    client:sleep(1)
+    local stats = client:alloc_stats()
+    print(string.format("cycles %d, allocating %d, max/cycle %d, heap %d bytes",
+                        stats.cycles, stats.allocating_cycles,
+                        stats.max_cycle_allocs, stats.bytes))
+    local ok, err = pcall(client.check_error, client)
+    if not ok then
+        print("violation: "..err)
+    end
+end
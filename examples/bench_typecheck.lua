@@ -0,0 +1,56 @@
+---------------------------------------------------------------------------------------------
+--
+-- Measures the cost per call of LuaJack functions whose time is dominated by
+-- the argument type check, with the type check by cached metatable pointer
+-- and with the luaL_testudata() fallback for comparison. No JACK server is
+-- needed: jack.ringbuffer_read() on an empty ringbuffer only validates its
+-- argument and checks the read space, array:len() and array:get() only
+-- validate the array and push a number.
+--
+-- The fallback is forced by replacing the first upvalue of the C function
+-- (the table of metatable pointers) with nil, the same as for a function
+-- that was registered without it.
+--
+-- Usage: lua bench_typecheck.lua [iterations]
+--
+---------------------------------------------------------------------------------------------
+
+local jack = require("luajack")
+
+local N = tonumber(arg and arg[1]) or 10000000
+
+local rbuf  = jack.ringbuffer(1024)
+local array = jack.array({ 1, 2, 3, 4 })
+
+local function measure(f)
+    f(1000) -- warm up
+    local t0 = os.clock()
+    f(N)
+    local t1 = os.clock()
+    local tempty0 = os.clock()
+    for i = 1, N do end
+    local tempty1 = os.clock()
+    return ((t1 - t0) - (tempty1 - tempty0)) * 1e9 / N
+end
+
+local function bench(name, cfunc, loop)
+    local cached = measure(function(n) loop(cfunc, n) end)
+    local _, types = debug.getupvalue(cfunc, 1)
+    debug.setupvalue(cfunc, 1, nil)
+    local fallback = measure(function(n) loop(cfunc, n) end)
+    debug.setupvalue(cfunc, 1, types)
+    print(string.format("%-22s %8.1f ns/call cached metatable %8.1f ns/call luaL_testudata",
+                        name, cached, fallback))
+end
+
+bench("jack.ringbuffer_read", jack.ringbuffer_read, function(read, n)
+    for i = 1, n do read(rbuf) end
+end)
+
+bench("array:len", getmetatable(array).__index.len, function(len, n)
+    for i = 1, n do len(array) end
+end)
+
+bench("array:get", getmetatable(array).__index.get, function(get, n)
+    for i = 1, n do get(array, 2) end
+end)
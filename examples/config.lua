@@ -0,0 +1,45 @@
+---------------------------------------------------------------------------------------------
+--
+-- Passes a configuration table to the process chunk at load time and sends
+-- updated presets as serialized tables through a ringbuffer.
+--
+---------------------------------------------------------------------------------------------
+
+local jack = require("luajack")
+
+local PROCESS = [[
+    local client, inp, out, config, rbuf = ...
+
+    local preset = config.presets[config.initial]
+
+    client:process_callback(function(nframes)
+        local tag, data = rbuf:read()
+        if tag then
+            preset = jack.deserialize(data) -- allocates, only done on updates
+        end
+        out:copy_from(inp)
+        out:scale(preset.gain)
+    end)
+]]
+
+local config = {
+    initial = "soft",
+    presets = {
+        soft = { gain = 0.25, curve = { 0, 0.1, 0.3, 0.6, 1.0 } },
+        loud = { gain = 0.9,  curve = { 0, 0.4, 0.7, 0.9, 1.0 } },
+    },
+}
+
+local client = jack.client_open("config")
+local inp    = client:input_audio_port("in")
+local out    = client:output_audio_port("out")
+local rbuf   = jack.ringbuffer(4096)
+
+client:process_load(PROCESS, client, inp, out, config, rbuf)
+client:activate()
+
+for _, name in ipairs { "loud", "soft", "loud" } do
+    client:sleep(2)
+    rbuf:write(1, jack.serialize(config.presets[name]))
+    client:check_error()
+end
@@ -0,0 +1,47 @@
+---------------------------------------------------------------------------------------------
+--
+-- Convolves an input port with an impulse response. Usage:
+--
+--     lua convolver.lua [ir.wav]
+--
+-- Without argument a synthetic two second reverb tail is used.
+--
+---------------------------------------------------------------------------------------------
+
+local jack = require("luajack")
+
+local PROCESS = [[
+    local client, convolver, input, output = ...
+
+    client:process_callback(function(nframes)
+        convolver:process(input, output)
+    end)
+]]
+
+local client = jack.client_open("convolver")
+
+local ir = arg[1]
+if not ir then
+    ir = {}
+    local rate = client:sample_rate()
+    for i = 1, 2 * rate do
+        ir[i] = (math.random() * 2 - 1) * math.exp(-6.9 * i / (2 * rate)) * 0.05
+    end
+    ir[1] = 1
+end
+
+local convolver = client:convolver(ir, { head = 4 })
+
+client:process_load(PROCESS, client, convolver, client:input_audio_port("in"),
+                                                client:output_audio_port("out"))
+client:activate()
+
+print(string.format("%d partitions of %d frames", convolver:partitions(), convolver:block()))
+
+while true do
+    client:sleep(1)
+    client:check_error()
+    if convolver:late() > 0 or convolver:mismatches() > 0 then
+        print(string.format("late %d, mismatches %d", convolver:late(), convolver:mismatches()))
+    end
+end
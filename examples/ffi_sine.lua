@@ -0,0 +1,53 @@
+---------------------------------------------------------------------------------------------
+--
+-- Per-sample DSP in the process callback through the LuaJIT FFI fast path:
+-- generates a sine wave whose frequency is set from the main thread.
+--
+-- Requires LuaJack built against LuaJIT (make LUA_PKG_CONFIG_NAME=luajit).
+--
+---------------------------------------------------------------------------------------------
+
+local jack = require("luajack")
+
+local PROCESS = [[
+    local client, port_out, rbuf = ...
+
+    local ffi  = require("ffi")
+    local jff  = require("luajack.ffi")
+
+    local out  = jff.port(port_out)
+    local read = jff.reader(jff.ringbuffer(rbuf), 16)
+    local rate = client:sample_rate()
+    local freq = 440
+    local phase = 0
+
+    local function process(nframes)
+        local tag, data, len = read()
+        while tag do
+            freq = tonumber(ffi.string(data, len)) or freq
+            tag, data, len = read()
+        end
+        local buf, n = jff.buffer(out)
+        local inc = 2 * math.pi * freq / rate
+        for i = 0, n - 1 do
+            buf[i] = 0.2 * math.sin(phase)
+            phase = phase + inc
+        end
+        phase = phase % (2 * math.pi)
+    end
+    
+    client:process_callback(process)
+]]
+
+local rbuf     = jack.ringbuffer(1000)
+local client   = jack.client_open("ffi_sine")
+local port_out = client:output_audio_port("out")
+
+client:process_load(PROCESS, client, port_out, rbuf)
+client:activate()
+
+for _, f in ipairs({ 220, 330, 440, 550, 660 }) do
+    rbuf:write(0, tostring(f))
+    client:sleep(1)
+    client:check_error()
+end
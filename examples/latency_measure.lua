@@ -0,0 +1,64 @@
+---------------------------------------------------------------------------------------------
+--
+-- Measures the round trip latency from an output port to an input port.
+--
+-- For testing without audio hardware start a dummy server, e.g.
+--
+--     jackd -d dummy -p 256 &
+--
+-- and invoke this script with "loopback", the ports are then connected
+-- directly to each other. Otherwise connect "latency_measure:out" and
+-- "latency_measure:in" to the chain that is to be measured.
+--
+---------------------------------------------------------------------------------------------
+
+local jack = require("luajack")
+
+local method   = arg[1] == "loopback" and "impulse" or (arg[1] or "mls")
+local loopback = arg[1] == "loopback"
+
+local PROCESS = [[
+    local client, port_out, port_in, rbuf, method = ...
+
+    local probe = jack.latency_probe(port_out, port_in, { method = method })
+
+    probe:start()
+
+    local function process(nframes)
+        local latency = probe:process()
+        if latency then
+            local _, gain = probe:result()
+            rbuf:write(latency, tostring(gain))
+        end
+    end
+    
+    client:process_callback(process)
+]]
+
+local rbuf     = jack.ringbuffer(1000)
+local client   = jack.client_open("latency_measure", { no_start_server=true })
+local port_out = client:output_audio_port("out")
+local port_in  = client:input_audio_port("in")
+
+client:process_load(PROCESS, client, port_out, port_in, rbuf, method)
+client:activate()
+
+if loopback then
+    client:connect(port_out, port_in)
+end
+
+local latency, gain
+repeat
+    client:sleep(0.1)
+    client:check_error()
+    latency, gain = rbuf:read()
+until latency
+
+if latency < 0 then
+    print(string.format("no signal detected (loop gain %s)", gain))
+else
+    print(string.format("round trip latency: %d frames (%.3f ms, loop gain %s)", 
+                        latency, client:frames_to_usecs(latency) / 1000, gain))
+end
+
+client:close()
@@ -0,0 +1,44 @@
+---------------------------------------------------------------------------------------------
+--
+-- Meters two input ports in the process context and prints the levels in dBFS
+-- at 10 Hz from the main context.
+--
+---------------------------------------------------------------------------------------------
+
+local jack = require("luajack")
+
+local PROCESS = [[
+    local client, meter, port_1, port_2 = ...
+
+    meter:attach(1, port_1)
+    meter:attach(2, port_2)
+
+    client:process_callback(function(nframes)
+        meter:process()
+    end)
+]]
+
+local client = jack.client_open("meters")
+local meter  = client:meter(2, { hold = 1.5, decay = 20, rms = 0.3, true_peak = true })
+
+client:process_load(PROCESS, client, meter, client:input_audio_port("in_1"),
+                                            client:input_audio_port("in_2"))
+client:activate()
+
+local function db(x)
+    return x > 0 and 20 * math.log(x, 10) or -math.huge
+end
+
+while true do
+    client:sleep(0.1)
+    client:check_error()
+    if meter:update() then
+        local line = {}
+        for ch = 1, meter:channels() do
+            local peak, rms, true_peak, hold = meter:read(ch)
+            line[#line + 1] = string.format("%d: peak %6.1f rms %6.1f tp %6.1f hold %6.1f", 
+                                            ch, db(peak), db(rms), db(true_peak), db(hold))
+        end
+        print(table.concat(line, " | "))
+    end
+end
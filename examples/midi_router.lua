@@ -0,0 +1,41 @@
+---------------------------------------------------------------------------------------------
+--
+-- Keyboard split and controller filter: two MIDI inputs are merged, the lower
+-- half of the keyboard goes one octave down on channel 2 of output 'bass',
+-- the upper half with a softer velocity curve to output 'lead'. Only the
+-- modulation wheel and sustain controllers pass. The routing is done in C,
+-- no Lua code runs per MIDI event.
+--
+---------------------------------------------------------------------------------------------
+
+local jack = require("luajack")
+
+local PROCESS = [[
+    local client, router = ...
+
+    client:process_callback(function(nframes)
+        router:process()
+    end)
+]]
+
+local client = jack.client_open("midi_router")
+
+local inputs  = { client:input_midi_port("in_1"),  client:input_midi_port("in_2") }
+local outputs = { client:output_midi_port("lead"), client:output_midi_port("bass") }
+
+local router = jack.midi_router(inputs, outputs, {
+    { type = "cc", controllers = { 1, 64 }, output = 1 },
+    { type = "cc", controllers = { 1, 64 }, output = 2, stop = true },
+    { type = "cc", drop = true },
+    { type = "note", notes = { 0, 59 }, output = 2, to_channel = 2, transpose = -12, stop = true },
+    { type = "note", output = 1, velocity = 1.5 },
+    { type = { "pitchbend", "pressure" }, output = 1 },
+})
+
+client:process_load(PROCESS, client, router)
+client:activate()
+
+while true do
+    client:sleep(5)
+    print("events", router:events(), "dropped", router:dropped())
+end
@@ -0,0 +1,30 @@
+---------------------------------------------------------------------------------------------
+--
+-- Runs the native example module examples/plugins/gain.so in the process 
+-- callback, Lua is only used for changing its parameter.
+--
+-- Build the module first: cd plugins && cc -O2 -shared -fPIC -I../../src -o gain.so gain.c -lm
+--
+---------------------------------------------------------------------------------------------
+
+local jack = require("luajack")
+
+local client = jack.client_open("native_gain")
+local ins  = { client:input_audio_port("in_1"),  client:input_audio_port("in_2") }
+local outs = { client:output_audio_port("out_1"), client:output_audio_port("out_2") }
+
+local gain = client:process_native("./plugins/gain.so", { 
+    inputs  = ins, 
+    outputs = outs,
+    params  = { gain = 0.0 }
+})
+
+print(gain:name(), table.concat(gain:params(), ", "))
+
+client:activate()
+
+for _, g in ipairs({ 0.25, 0.5, 1.0, 0.5, 0.0 }) do
+    gain:set("gain", g)
+    client:sleep(1)
+    client:check_error()
+end
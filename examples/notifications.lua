@@ -0,0 +1,27 @@
+---------------------------------------------------------------------------------------------
+--
+-- Prints server notifications (xruns, graph changes, port and client registrations).
+--
+---------------------------------------------------------------------------------------------
+
+local jack = require("luajack")
+
+local client = jack.client_open("notifications")
+
+client:enable_notifications(256)
+client:activate()
+
+local function handler(kind, usecs, ...)
+    print(string.format("%14.6f %-20s", usecs / 1e6, kind), ...)
+end
+
+local dropped = 0
+
+while true do
+    client:drain_notifications(handler)
+    if client:notifications_dropped() > dropped then
+        dropped = client:notifications_dropped()
+        print("dropped notifications:", dropped)
+    end
+    client:sleep(0.2)
+end
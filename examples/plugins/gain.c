@@ -0,0 +1,77 @@
+/*
+ * Example native module for client:process_native(), see examples/native_gain.lua
+ *
+ * Build: cc -O2 -shared -fPIC -I../../src -o gain.so gain.c -lm
+ *
+ * Copies every input to the output with the same index, multiplied by the
+ * smoothed parameter "gain".
+ */
+#include <stdlib.h>
+#include <math.h>
+
+#include "luajack_plugin.h"
+
+typedef struct {
+    uint32_t channels;
+    float    gain;
+    float    target;
+    float    coeff;
+} Gain;
+
+static const char* const paramNames[] = { "gain", NULL };
+
+static void* gain_init(const luajack_plugin_config* config)
+{
+    Gain* g = calloc(1, sizeof(Gain));
+    if (g) {
+        g->channels = config->n_inputs < config->n_outputs ? config->n_inputs : config->n_outputs;
+        g->gain     = 1.0f;
+        g->target   = 1.0f;
+        g->coeff    = 1.0f - expf(-1.0f / (0.005f * config->sample_rate)); /* 5 ms */
+    }
+    return g;
+}
+
+static void gain_process(void* instance, const float* const* inputs, float* const* outputs, uint32_t nframes)
+{
+    Gain*    g = instance;
+    uint32_t c, i;
+    float    gain = g->gain;
+    for (c = 0; c < g->channels; ++c) {
+        gain = g->gain;
+        for (i = 0; i < nframes; ++i) {
+            gain += g->coeff * (g->target - gain);
+            outputs[c][i] = gain * inputs[c][i];
+        }
+    }
+    g->gain = gain;
+}
+
+static void gain_set_param(void* instance, uint32_t param, double value)
+{
+    Gain* g = instance;
+    if (param == 0) {
+        g->target = (float) value;
+    }
+}
+
+static void gain_release(void* instance)
+{
+    free(instance);
+}
+
+static const luajack_plugin plugin = 
+{
+    LUAJACK_PLUGIN_API_VERSION,
+    "gain",
+    paramNames,
+    gain_init,
+    gain_process,
+    gain_set_param,
+    gain_release
+};
+
+LUAJACK_PLUGIN_EXPORT const luajack_plugin* luajack_plugin_entry(void)
+{
+    return &plugin;
+}
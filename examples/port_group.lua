@@ -0,0 +1,36 @@
+---------------------------------------------------------------------------------------------
+--
+-- 64 channel pass-through with a master gain and a mono monitor mix, using
+-- port groups instead of per-channel loops in the process callback.
+--
+---------------------------------------------------------------------------------------------
+
+local jack = require("luajack")
+
+local CHANNELS = 64
+
+local PROCESS = [[
+    local client, inputs, outputs, monitor = ...
+
+    local ins  = jack.port_group(inputs)
+    local outs = jack.port_group(outputs)
+    local gain = 0.5
+
+    client:process_callback(function(nframes)
+        outs:copy_from(ins)
+        outs:gain(gain)
+        outs:sum_into(monitor, 1 / #outs)
+    end)
+]]
+
+local client  = jack.client_open("group")
+local inputs, outputs = {}, {}
+for i = 1, CHANNELS do
+    inputs[i]  = client:input_audio_port("in_"..i)
+    outputs[i] = client:output_audio_port("out_"..i)
+end
+local monitor = client:output_audio_port("monitor")
+
+client:process_load(PROCESS, client, inputs, outputs, monitor)
+client:activate()
+client:sleep()
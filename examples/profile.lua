@@ -0,0 +1,54 @@
+---------------------------------------------------------------------------------------------
+--
+-- Profiles a deliberately slow process callback for five seconds and writes
+-- the folded stacks to profile.folded, which can be rendered with 
+--
+--     flamegraph.pl profile.folded > profile.svg
+--
+---------------------------------------------------------------------------------------------
+
+local jack = require("luajack")
+
+local PROCESS = [[
+    local client, out = ...
+
+    local phase = 0
+
+    local function sample(rate)
+        phase = phase + 440 / rate
+        return math.sin(2 * math.pi * phase) * 0.1
+    end
+
+    -- per sample Lua work, the kind of code the profiler should point at
+    local function envelope(nframes)
+        local rate, peak = client:sample_rate(), 0
+        for i = 1, nframes do
+            peak = math.max(peak, math.abs(sample(rate)))
+        end
+        return peak
+    end
+
+    client:process_callback(function(nframes)
+        out:clear()
+        envelope(nframes)
+    end)
+]]
+
+local client = jack.client_open("profile")
+
+client:process_load(PROCESS, client, client:output_audio_port("out"))
+client:activate()
+
+local profiler = client:profiler({ interval = 500 })
+profiler:start()
+client:sleep(5)
+profiler:stop()
+client:check_error()
+
+local recorded, dropped = profiler:samples()
+print(string.format("%d samples, %d dropped", recorded, dropped))
+print(profiler:report("flat"))
+
+local file = assert(io.open("profile.folded", "w"))
+file:write((profiler:report("folded")))
+file:close()
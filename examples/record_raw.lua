@@ -0,0 +1,46 @@
+---------------------------------------------------------------------------------------------
+--
+-- Records 8 input channels for ten seconds to a raw interleaved 16 bit file.
+-- The process callback only interleaves the float samples into a ringbuffer,
+-- the conversion to 16 bit with dither is done in the main thread.
+--
+--     lua record_raw.lua out.raw
+--
+---------------------------------------------------------------------------------------------
+
+local jack = require("luajack")
+
+local CHANNELS = 8
+
+local PROCESS = [[
+    local client, inputs, rbuf = ...
+
+    local ins = jack.port_group(inputs)
+
+    client:process_callback(function(nframes)
+        ins:write_interleaved(rbuf, 1, "float32")
+    end)
+]]
+
+local client = jack.client_open("record")
+local inputs = {}
+for i = 1, CHANNELS do
+    inputs[i] = client:input_audio_port("in_"..i)
+end
+local rbuf = jack.ringbuffer(1024 * 1024, true)
+local file = assert(io.open(arg[1] or "out.raw", "wb"))
+
+client:process_load({ libs = {} }, PROCESS, client, inputs, rbuf)
+client:activate()
+
+local stop = os.time() + 10
+while os.time() < stop do
+    local tag, data = rbuf:read()
+    while tag do
+        file:write(jack.convert(data, "float32", "int16", true))
+        tag, data = rbuf:read()
+    end
+    client:sleep(0.05)
+    client:check_error()
+end
+file:close()
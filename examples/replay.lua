@@ -0,0 +1,68 @@
+---------------------------------------------------------------------------------------------
+--
+-- Records ten seconds of input and gain messages of a simple process chunk,
+-- then replays the recording offline twice: the first run writes the golden
+-- file, the second run compares against it.
+--
+--     lua replay.lua record      records session.rec
+--     lua replay.lua golden      writes golden.rec
+--     lua replay.lua check       compares with golden.rec
+--
+---------------------------------------------------------------------------------------------
+
+local jack = require("luajack")
+
+local PROCESS = [[
+    local client, inp, out, rbuf = ...
+
+    local gain = 1.0
+
+    client:process_callback(function(nframes)
+        local tag, data = rbuf:read()
+        while tag do
+            gain = tonumber(data)
+            tag, data = rbuf:read()
+        end
+        out:copy_from(inp)
+        out:scale(gain)
+    end)
+]]
+
+local mode = arg[1] or "record"
+
+local client = jack.client_open("replay")
+local inp    = client:input_audio_port("in")
+local out    = client:output_audio_port("out")
+local rbuf   = jack.ringbuffer(4096)
+
+client:process_load({ libs = { "math" } }, PROCESS, client, inp, out, rbuf)
+
+if mode == "record" then
+    local recorder = client:recorder("session.rec", { inputs = { inp }, rbufs = { rbuf } })
+    client:activate()
+    recorder:start()
+    for i = 1, 10 do
+        rbuf:write(1, tostring(i / 10))
+        client:sleep(1)
+    end
+    recorder:stop()
+    print("recorded cycles, messages:", recorder:cycles())
+    print("overruns:", recorder:overruns())
+    recorder:close()
+    client:check_error()
+
+elseif mode == "golden" then
+    local cycles = client:replay("session.rec", { inputs = { inp }, outputs = { out },
+                                                  rbufs  = { rbuf }, output = "golden.rec" })
+    print("replayed cycles:", cycles)
+
+else
+    local cycles, maxdiff, cycle = client:replay("session.rec", { inputs = { inp }, outputs = { out },
+                                                                  rbufs  = { rbuf }, golden = "golden.rec",
+                                                                  tolerance = 1e-6 })
+    print(string.format("%d cycles, max difference %g", cycles, maxdiff))
+    if cycle then
+        print("first mismatch in cycle "..cycle)
+        os.exit(1)
+    end
+end
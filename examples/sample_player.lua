@@ -0,0 +1,39 @@
+---------------------------------------------------------------------------------------------
+--
+-- Plays a sample loaded once in the main context from several process chunks.
+-- The array is passed by reference, the samples exist only once in memory,
+-- mono float WAV files are even mapped directly from the page cache.
+--
+--     lua sample_player.lua sample.wav
+--
+---------------------------------------------------------------------------------------------
+
+local jack = require("luajack")
+
+local PROCESS = [[
+    local client, out, sample = ...
+
+    local pos = 1
+    local n   = 0
+
+    client:process_callback(function(nframes)
+        n   = sample:copy_to(out, pos)
+        pos = (n < nframes) and 1 or pos + n   -- loop
+    end)
+]]
+
+local sample = jack.array_file(arg[1] or "sample.wav", { lock = true })
+
+print(string.format("%d samples, %s, mapped: %s", #sample,
+                    sample:sample_rate() or "unknown rate", tostring(sample:is_mapped())))
+
+local clients = {}
+for i = 1, 4 do
+    local client = jack.client_open("player"..i)
+    local out    = client:output_audio_port("out")
+    client:process_load(PROCESS, client, out, sample)
+    client:activate()
+    clients[i] = client
+end
+
+clients[1]:sleep(10)
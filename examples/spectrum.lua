@@ -0,0 +1,47 @@
+---------------------------------------------------------------------------------------------
+--
+-- Prints a coarse text spectrum of an input port at 10 Hz. The process 
+-- context only feeds the analyzer fifo, the FFTs run on the analyzer's worker 
+-- thread.
+--
+---------------------------------------------------------------------------------------------
+
+local jack = require("luajack")
+
+local PROCESS = [[
+    local client, analyzer, port = ...
+
+    client:process_callback(function(nframes)
+        analyzer:push(port)
+    end)
+]]
+
+local client   = jack.client_open("spectrum")
+local analyzer = client:analyzer({ size = 4096, hop = 1024, window = "hann", smoothing = 0.5 })
+
+client:process_load(PROCESS, client, analyzer, client:input_audio_port("in"))
+client:activate()
+
+local BANDS = { 63, 125, 250, 500, 1000, 2000, 4000, 8000, 16000 }
+local spectrum = {}
+
+while true do
+    client:sleep(0.1)
+    client:check_error()
+    if analyzer:update() then
+        analyzer:read(spectrum, true)
+        local line = {}
+        for i, hz in ipairs(BANDS) do
+            local lo, hi = hz / math.sqrt(2), hz * math.sqrt(2)
+            local max = -200
+            for bin = 2, analyzer:bins() do
+                local f = analyzer:frequency(bin)
+                if f >= lo and f < hi and spectrum[bin] > max then
+                    max = spectrum[bin]
+                end
+            end
+            line[i] = string.format("%5d:%6.1f", hz, max)
+        end
+        print(table.concat(line, " "))
+    end
+end
@@ -0,0 +1,46 @@
+---------------------------------------------------------------------------------------------
+--
+-- Plays a chord of three detuned wavetable voices plus a sine sub oscillator.
+-- The wavetable is built once in the main context and shared by all voices.
+--
+---------------------------------------------------------------------------------------------
+
+local jack = require("luajack")
+
+local PROCESS = [[
+    local client, wavetable, out = ...
+
+    local voices = {}
+    for i, hz in ipairs({ 220, 277.18, 329.63 }) do
+        voices[i] = client:oscillator(wavetable, hz, 0.15)
+    end
+    local sub = client:oscillator("sine", 110, 0.2)
+    local t   = 0
+
+    client:process_callback(function(nframes)
+        t = t + nframes / client:sample_rate()
+        sub:render(out)
+        for i, voice in ipairs(voices) do
+            -- slow vibrato, ramped per block
+            voice:set(voice:frequency() * (1 + 0.0005 * math.sin(t * 5 + i)))
+            voice:add(out)
+        end
+    end)
+]]
+
+-- one cycle of a sawtooth with a softened edge
+local cycle = {}
+for i = 1, 256 do
+    cycle[i] = math.tanh(3 * (1 - 2 * (i - 1) / 256)) / math.tanh(3)
+end
+
+local client    = jack.client_open("synth")
+local wavetable = jack.wavetable(cycle, 2048)
+
+client:process_load(PROCESS, client, wavetable, client:output_audio_port("out"))
+client:activate()
+
+while true do
+    client:sleep(1)
+    client:check_error()
+end
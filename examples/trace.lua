@@ -0,0 +1,39 @@
+---------------------------------------------------------------------------------------------
+--
+-- Records a timeline of the process callback and the main loop for three 
+-- seconds and writes it to trace.json. Open the file in chrome://tracing or
+-- https://ui.perfetto.dev.
+--
+---------------------------------------------------------------------------------------------
+
+local jack = require("luajack")
+
+local PROCESS = [[
+    local client, port_in, port_out = ...
+
+    client:process_callback(function(nframes)
+        client:trace_begin("copy")
+        port_out:copy_from(port_in)
+        client:trace_end()
+    end)
+]]
+
+local client = jack.client_open("trace")
+
+client:process_load(PROCESS, client, client:input_audio_port("in"),
+                                     client:output_audio_port("out"))
+
+jack.trace_start()
+jack.trace_thread_name("main loop")
+client:activate()
+
+for i = 1, 30 do
+    jack.trace_begin("gui frame")
+    client:sleep(0.1)
+    client:check_error()
+    jack.trace_end()
+end
+
+jack.trace_stop()
+local count, dropped = jack.trace_dump("trace.json")
+print(string.format("%d events written, %d dropped", count, dropped))
@@ -0,0 +1,92 @@
+-------------------------------------------------------------------------------
+-- LuaJack FFI fast path (LuaJIT only)
+-------------------------------------------------------------------------------
+-- Wraps the plain C entry points of src/luajack_ffi.h so that process chunks
+-- running under LuaJIT can access port buffers and ringbuffers without going
+-- through the Lua C API, i.e. the process function can be JIT compiled.
+--
+--    local jff  = require("luajack.ffi")
+--    local out  = jff.port(port_out)       -- once, when loading the chunk
+--    ...
+--    local buf, n = jff.buffer(out)        -- per cycle: float*, nframes
+--    for i = 0, n - 1 do buf[i] = ... end
+-------------------------------------------------------------------------------
+
+local ffi = require("ffi")
+
+local M = {}
+
+M._VERSION = "LuaJackFFI 0.1"
+
+ffi.cdef[[
+typedef struct jack_ringbuffer_t jack_ringbuffer_t;
+typedef struct luajack_ffi_port luajack_ffi_port;
+
+int    luajack_ffi_abi_version(void);
+float* luajack_ffi_port_buffer(luajack_ffi_port* port, uint32_t* nframes);
+int    luajack_ffi_ringbuffer_write(jack_ringbuffer_t* rbuf, int32_t tag, const void* data, uint32_t len);
+int    luajack_ffi_ringbuffer_read(jack_ringbuffer_t* rbuf, int32_t* tag, void* data, uint32_t* len);
+void   luajack_ffi_clear(float* dst, uint32_t nframes);
+void   luajack_ffi_copy (float* dst, const float* src, uint32_t nframes);
+void   luajack_ffi_mix  (float* dst, const float* src, float gain, uint32_t nframes);
+void   luajack_ffi_scale(float* dst, float gain, uint32_t nframes);
+]]
+
+local ABI_VERSION = 1
+
+-- the library is already loaded by require("luajack"), but without
+-- RTLD_GLOBAL, so its symbols have to be looked up through its path
+local path = assert(package.searchpath("luajack", package.cpath), "luajack library not found")
+local C    = ffi.load(path)
+
+assert(C.luajack_ffi_abi_version() == ABI_VERSION, "luajack FFI ABI version mismatch")
+
+M.C = C
+
+local nframes = ffi.new("uint32_t[1]")
+
+-- Returns the FFI handle of a LuaJack port object.
+function M.port(port)
+   return ffi.cast("luajack_ffi_port*", port:ffi_handle())
+end
+
+-- Returns the raw jack_ringbuffer_t* of a LuaJack ringbuffer object.
+function M.ringbuffer(rbuf)
+   return ffi.cast("jack_ringbuffer_t*", rbuf:ptr())
+end
+
+-- Returns the float* buffer and the number of frames of the current process
+-- block, or nil, 0 outside of the process callback.
+function M.buffer(port)
+   local buf = C.luajack_ffi_port_buffer(port, nframes)
+   if buf == nil then return nil, 0 end
+   return buf, nframes[0]
+end
+
+-- Creates a reader for messages with up to maxlen bytes data. The returned
+-- function returns tag, data (char*), len for the next message or nil.
+function M.reader(rbuf, maxlen)
+   local data = ffi.new("char[?]", maxlen)
+   local tag  = ffi.new("int32_t[1]")
+   local len  = ffi.new("uint32_t[1]")
+   return function()
+      while true do
+         len[0] = maxlen
+         local rc = C.luajack_ffi_ringbuffer_read(rbuf, tag, data, len)
+         if rc == 0 then return nil end
+         if rc == 1 then return tag[0], data, len[0] end
+         -- rc == 2: message too large, skipped
+      end
+   end
+end
+
+function M.write(rbuf, tag, data, len)
+   return C.luajack_ffi_ringbuffer_write(rbuf, tag, data, len or (data and #data or 0)) == 1
+end
+
+M.clear = C.luajack_ffi_clear
+M.copy  = C.luajack_ffi_copy
+M.mix   = C.luajack_ffi_mix
+M.scale = C.luajack_ffi_scale
+
+return M
@@ -0,0 +1,110 @@
+#include "util.h"
+#include "alloc.h"
+#include "alloc_util.h"
+
+static JackAllocStats* getCheckedStats(lua_State* L, JackClient* client)
+{
+    if (client->isInProcessContext) {
+        luaL_error(L, "method can only be called in main context");
+    }
+    if (!client->shared->processContext) {
+        luaL_error(L, "process chunk must be loaded before");
+    }
+    if (!client->shared->allocStats) {
+        luaL_error(L, "allocation accounting is not supported by this Lua implementation");
+    }
+    return client->shared->allocStats;
+}
+
+static void setIntegerField(lua_State* L, const char* name, lua_Integer value)
+{
+    lua_pushinteger(L, value);
+    lua_setfield(L, -2, name);
+}
+
+static int alloc_stats(lua_State* L)
+/* stats = client:alloc_stats()
+ * returns the allocation counters of the process context:
+ *   allocs, reallocs, frees, bytes, peak_bytes  totals of the process state
+ *   cycles             number of process callback invocations
+ *   last_allocs, last_bytes, last_frees  counts of the last callback
+ *   max_cycle_allocs   maximal allocations in one callback
+ *   allocating_cycles  number of callbacks that allocated
+ *   violations         callbacks that allocated in strict mode after warm-up
+ *   violation_cycle    last violating callback (0 if none)
+ * The values are read while the process callback runs and may be slightly
+ * inconsistent with each other.
+ */
+{
+    JackClient*     client = getCheckedClient(L, 1);
+    JackAllocStats* stats  = getCheckedStats(L, client);
+
+    lua_newtable(L);
+    setIntegerField(L, "allocs",            stats->allocs);
+    setIntegerField(L, "reallocs",          stats->reallocs);
+    setIntegerField(L, "frees",             stats->frees);
+    setIntegerField(L, "bytes",             stats->bytes);
+    setIntegerField(L, "peak_bytes",        stats->peakBytes);
+    setIntegerField(L, "cycles",            stats->cycles);
+    setIntegerField(L, "last_allocs",       stats->lastAllocs);
+    setIntegerField(L, "last_bytes",        stats->lastBytes);
+    setIntegerField(L, "last_frees",        stats->lastFrees);
+    setIntegerField(L, "max_cycle_allocs",  stats->maxCycleAllocs);
+    setIntegerField(L, "allocating_cycles", stats->allocatingCycles);
+    setIntegerField(L, "violations",        stats->violations);
+    setIntegerField(L, "violation_cycle",   stats->violationCycle);
+    return 1;
+}
+
+static int alloc_strict(lua_State* L)
+/* client:alloc_strict(mode[, warmup])
+ * checks that the process callback does not allocate once warmup further
+ * callbacks have run (default 100). Modes:
+ *   "off"    only count
+ *   "flag"   the next client:check_error() raises an error, the process
+ *            callback continues
+ *   "error"  the process callback is stopped as if it raised an error,
+ *            which is reported by client:check_error()
+ */
+{
+    static const char* const modes[] = { "off", "flag", "error", NULL };
+
+    JackClient*     client = getCheckedClient(L, 1);
+    JackAllocStats* stats  = getCheckedStats(L, client);
+    int             mode   = luaL_checkoption(L, 2, NULL, modes);
+    lua_Integer     warmup = luaL_optinteger(L, 3, 100);
+    luaL_argcheck(L, warmup >= 0, 3, "invalid warmup");
+
+    stats->strictMode = ALLOC_STRICT_OFF;
+    stats->warmupEnd  = stats->cycles + warmup + 1;
+    atomic_set(&stats->unreported, 0);
+    stats->strictMode = mode;
+    return 0;
+}
+
+static const struct luaL_Reg ClientMethods[] =
+{
+    { "alloc_stats",    alloc_stats },
+    { "alloc_strict",   alloc_strict },
+    { NULL, NULL } /* sentinel */
+};
+
+static const struct luaL_Reg ModuleFunctions[] =
+{
+    { "alloc_stats",    alloc_stats },
+    { "alloc_strict",   alloc_strict },
+    { NULL, NULL } /* sentinel */
+};
+
+bool luajack_open_alloc(lua_State* L, int module, int clientMeta, int clientClass)
+{
+    lua_pushvalue(L, module);
+        setfuncs(L, ModuleFunctions);
+
+        lua_pushvalue(L, clientClass);
+            setfuncs(L, ClientMethods);
+
+    lua_pop(L, 2);
+
+    return true;
+}
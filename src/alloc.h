@@ -0,0 +1,6 @@
+#ifndef LUAJACK_ALLOC_H
+#define LUAJACK_ALLOC_H
+
+bool luajack_open_alloc(lua_State* L, int module, int clientMeta, int clientClass);
+
+#endif // LUAJACK_ALLOC_H
@@ -0,0 +1,111 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "util.h"
+#include "alloc_util.h"
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+void* countingAlloc(void* ud, void* ptr, size_t osize, size_t nsize)
+{
+    JackAllocStats* stats = (JackAllocStats*) ud;
+
+    if (ptr == NULL) {
+        osize = 0; /* osize encodes the object type if ptr is NULL */
+    }
+    if (nsize == 0) {
+        if (ptr) {
+            free(ptr);
+            stats->frees += 1;
+            stats->bytes -= osize;
+            if (stats->inCallback) {
+                stats->cycleFrees += 1;
+            }
+        }
+        return NULL;
+    }
+    void* rslt = realloc(ptr, nsize);
+    if (rslt) {
+        if (ptr) stats->reallocs += 1;
+        else     stats->allocs   += 1;
+
+        stats->bytes += (lua_Integer) nsize - (lua_Integer) osize;
+        if (stats->bytes > stats->peakBytes) {
+            stats->peakBytes = stats->bytes;
+        }
+        /* shrinking blocks is not counted as allocation */
+        if (stats->inCallback && nsize > osize) {
+            stats->cycleAllocs += 1;
+            stats->cycleBytes  += nsize - osize;
+        }
+    }
+    return rslt;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+static int panic(lua_State* L)
+{
+    const char* msg = lua_tostring(L, -1);
+    fprintf(stderr, "PANIC: unprotected error in call to Lua API (%s)\n",
+                    msg ? msg : "error object is not a string");
+    fflush(stderr);
+    return 0;
+}
+
+lua_State* newCountingState(JackAllocStats** stats)
+{
+    JackAllocStats* s = calloc(1, sizeof(JackAllocStats));
+    if (!s) {
+        *stats = NULL;
+        return NULL;
+    }
+    lua_State* L = lua_newstate(countingAlloc, s);
+    if (L) {
+        lua_atpanic(L, panic);
+        *stats = s;
+    }
+    else {
+        free(s);
+        *stats = NULL;
+        /* LuaJIT without GC64 refuses custom allocators on 64 bit */
+        L = luaL_newstate();
+    }
+    return L;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+bool endAllocCycle(JackAllocStats* stats)
+{
+    stats->inCallback = false;
+
+    lua_Integer cycle = stats->cycles + 1;
+    int         allocs = stats->cycleAllocs;
+
+    stats->lastAllocs = allocs;
+    stats->lastBytes  = stats->cycleBytes;
+    stats->lastFrees  = stats->cycleFrees;
+    stats->cycles     = cycle;
+
+    if (allocs == 0) {
+        return false;
+    }
+    stats->allocatingCycles += 1;
+    if (allocs > stats->maxCycleAllocs) {
+        stats->maxCycleAllocs = allocs;
+    }
+    if (stats->strictMode == ALLOC_STRICT_OFF || cycle < stats->warmupEnd) {
+        return false;
+    }
+    stats->violations     += 1;
+    stats->violationCycle  = cycle;
+    stats->violationAllocs = allocs;
+    stats->violationBytes  = stats->cycleBytes;
+    if (stats->strictMode == ALLOC_STRICT_FLAG) {
+        atomic_inc(&stats->unreported);
+    }
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,84 @@
+#ifndef LUAJACK_ALLOC_UTIL_H
+#define LUAJACK_ALLOC_UTIL_H
+
+#include "util.h"
+
+/////////////////////////////////////////////////////////////////////////////////
+
+/* Allocation accounting of a process context. The allocator of the process
+ * state counts all allocations, the counts of the current cycle are only
+ * collected while the Lua process callback runs. Counters are written by the
+ * thread that runs the state and read without locking by the main context. */
+
+enum {
+    ALLOC_STRICT_OFF   = 0,
+    ALLOC_STRICT_FLAG  = 1,  /* report through client:check_error(), keep running */
+    ALLOC_STRICT_ERROR = 2   /* stop the process callback like a runtime error */
+};
+
+typedef struct JackAllocStats {
+    /* totals of the state */
+    volatile lua_Integer allocs;
+    volatile lua_Integer reallocs;
+    volatile lua_Integer frees;
+    volatile lua_Integer bytes;
+    volatile lua_Integer peakBytes;
+
+    /* counts inside the process callback */
+    bool                 inCallback;
+    volatile lua_Integer cycles;
+    int                  cycleAllocs;
+    lua_Integer          cycleBytes;
+    int                  cycleFrees;
+    volatile int         lastAllocs;
+    volatile lua_Integer lastBytes;
+    volatile int         lastFrees;
+    volatile int         maxCycleAllocs;
+    volatile lua_Integer allocatingCycles;
+
+    /* strict mode */
+    volatile int         strictMode;
+    volatile lua_Integer warmupEnd;      /* first checked cycle */
+    volatile lua_Integer violations;
+    volatile lua_Integer violationCycle; /* last violating cycle */
+    volatile int         violationAllocs;
+    volatile lua_Integer violationBytes;
+    AtomicCounter        unreported;
+}
+JackAllocStats;
+
+/////////////////////////////////////////////////////////////////////////////////
+
+/* lua_Alloc function, ud is the JackAllocStats */
+
+#define countingAlloc luajack_countingAlloc
+
+void* countingAlloc(void* ud, void* ptr, size_t osize, size_t nsize);
+
+/* Creates a Lua state using countingAlloc. If the Lua implementation does not
+ * support custom allocators (LuaJIT on 64 bit without GC64) a state without
+ * accounting is returned and *stats is NULL. */
+
+#define newCountingState luajack_newCountingState
+
+lua_State* newCountingState(JackAllocStats** stats);
+
+/////////////////////////////////////////////////////////////////////////////////
+
+static inline void beginAllocCycle(JackAllocStats* stats)
+{
+    stats->cycleAllocs = 0;
+    stats->cycleBytes  = 0;
+    stats->cycleFrees  = 0;
+    stats->inCallback  = true;
+}
+
+/* Returns true if the cycle violated the strict mode */
+
+#define endAllocCycle luajack_endAllocCycle
+
+bool endAllocCycle(JackAllocStats* stats);
+
+/////////////////////////////////////////////////////////////////////////////////
+
+#endif // LUAJACK_ALLOC_UTIL_H
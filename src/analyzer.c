@@ -0,0 +1,229 @@
+#include <math.h>
+
+#include "util.h"
+#include "analyzer.h"
+#include "analyzer_util.h"
+
+static const char* const WindowNames[] = { "rect", "hann", "blackman", NULL };
+
+static int analyzer_new(lua_State* L)
+/* analyzer = client:analyzer([options])
+ * creates a spectrum analyzer. The process context only copies samples into
+ * a fifo, a worker thread computes the windowed FFTs and publishes magnitude
+ * spectra to the main context. Options:
+ *   size      = frames    FFT size, power of two (default 2048)
+ *   hop       = frames    frames between two spectra (default size/4)
+ *   window    = name      "hann" (default), "blackman" or "rect"
+ *   smoothing = 0 .. 1    weight of the previous spectrum (default 0)
+ *   fifo      = frames    fifo capacity (default one second, at least 2*size)
+ */
+{
+    JackClient* client     = getCheckedClient(L, 1);
+    float       sampleRate = (float) jack_get_sample_rate(client->ptr);
+
+    lua_Integer size = getIntegerOption(L, 2, "size", 2048);
+    luaL_argcheck(L, size >= 16 && size <= 65536 && (size & (size - 1)) == 0, 2, 
+                     "size must be a power of two between 16 and 65536");
+    lua_Integer hop = getIntegerOption(L, 2, "hop", size / 4);
+    luaL_argcheck(L, hop >= 1 && hop <= size, 2, "invalid hop");
+
+    lua_Number smoothing = getNumberOption(L, 2, "smoothing", 0);
+    luaL_argcheck(L, smoothing >= 0 && smoothing < 1, 2, "invalid smoothing");
+
+    lua_Integer fifo = getIntegerOption(L, 2, "fifo", (lua_Integer) sampleRate);
+    if (fifo < 2 * size) {
+        fifo = 2 * size;
+    }
+    int window = WINDOW_HANN;
+    if (lua_istable(L, 2)) {
+        lua_getfield(L, 2, "window");
+        if (!lua_isnil(L, -1)) {
+            window = luaL_checkoption(L, -1, NULL, WindowNames);
+        }
+        lua_pop(L, 1);
+    }
+    JackAnalyzer* analyzer = (JackAnalyzer*) lua_newuserdata(L, sizeof(JackAnalyzer));
+    memset(analyzer, 0, sizeof(JackAnalyzer));
+    luaL_setmetatable(L, ANALYZER_TYPE_NAME);
+    analyzer->isInProcessContext = client->isInProcessContext;
+    analyzer->shared = createAnalyzer((int) size, (int) hop, (int) fifo, (JackWindowType) window,
+                                      (float) smoothing, sampleRate);
+    if (!analyzer->shared) {
+        return luaL_error(L, "cannot create analyzer");
+    }
+    return 1;
+}
+
+static int analyzer_release(lua_State* L)
+{
+    JackAnalyzer* analyzer = getCheckedAnalyzer(L, 1);
+    releaseAnalyzer(analyzer->shared);
+    analyzer->shared = NULL;
+    return 0;
+}
+
+static int analyzer_toString(lua_State* L)
+{
+    JackAnalyzer* analyzer = getCheckedAnalyzer(L, 1);
+    lua_pushfstring(L, "%s: %p", ANALYZER_TYPE_NAME, analyzer->shared);
+    return 1;
+}
+
+static int analyzer_push(lua_State* L)
+/* bool = analyzer:push(port_or_scratch)
+ * copies the current process block into the analyzer fifo. Returns false if
+ * the worker thread has fallen behind and the block was dropped. Must be 
+ * called from the process callback.
+ */
+{
+    JackAnalyzer* analyzer = getCheckedAnalyzer(L, 1);
+    jack_nframes_t nframes;
+    const float* in = getCheckedSignalBuffer(L, 2, &nframes);
+    if (!analyzer->isInProcessContext) {
+        return luaL_error(L, "analyzer can only be fed in process context");
+    }
+    lua_pushboolean(L, !in || pushAnalyzer(analyzer->shared, in, nframes));
+    return 1;
+}
+
+static int analyzer_update(lua_State* L)
+/* bool = analyzer:update()
+ * takes the newest spectrum published by the worker thread, returns false if
+ * nothing was published since the last update. Intended to be called at GUI
+ * rate.
+ */
+{
+    JackAnalyzer* analyzer = getCheckedAnalyzer(L, 1);
+    if (analyzer->isInProcessContext) {
+        return luaL_error(L, "analyzer can only be read in main context");
+    }
+    lua_pushboolean(L, updateAnalyzer(analyzer->shared));
+    return 1;
+}
+
+static int analyzer_read(lua_State* L)
+/* t = analyzer:read([t [, db]])
+ * stores the magnitudes of the last update() into t[1] .. t[bins()] and
+ * returns t. A new table is created if t is nil. If db is true, the values
+ * are in dB full scale.
+ */
+{
+    JackAnalyzer* analyzer = getCheckedAnalyzer(L, 1);
+    bool          db       = lua_toboolean(L, 3);
+    if (lua_isnoneornil(L, 2)) {
+        lua_settop(L, 1);
+        lua_createtable(L, analyzer->shared->bins, 0);
+    } else {
+        luaL_checktype(L, 2, LUA_TTABLE);
+        lua_settop(L, 2);
+    }
+    const float* values = analyzer->shared->buffers[analyzer->shared->frontIndex];
+    int i;
+    for (i = 0; i < analyzer->shared->bins; ++i) {
+        float m = values[i];
+        if (db) {
+            m = (m > 1e-10f) ? 20.0f * log10f(m) : -200.0f;
+        }
+        lua_pushnumber(L, m);
+        lua_rawseti(L, 2, i + 1);
+    }
+    return 1;
+}
+
+static int analyzer_frequency(lua_State* L)
+/* hz = analyzer:frequency(bin)
+ * returns the center frequency of the bin.
+ */
+{
+    JackAnalyzer* analyzer = getCheckedAnalyzer(L, 1);
+    lua_Integer   bin      = luaL_checkinteger(L, 2);
+    luaL_argcheck(L, bin >= 1 && bin <= analyzer->shared->bins, 2, "invalid bin");
+    lua_pushnumber(L, (bin - 1) * analyzer->shared->sampleRate / analyzer->shared->size);
+    return 1;
+}
+
+static int analyzer_bins(lua_State* L)
+{
+    JackAnalyzer* analyzer = getCheckedAnalyzer(L, 1);
+    lua_pushinteger(L, analyzer->shared->bins);
+    return 1;
+}
+
+static int analyzer_size(lua_State* L)
+{
+    JackAnalyzer* analyzer = getCheckedAnalyzer(L, 1);
+    lua_pushinteger(L, analyzer->shared->size);
+    return 1;
+}
+
+static int analyzer_published(lua_State* L)
+/* n = analyzer:published()
+ * returns the number of spectra published by the worker thread.
+ */
+{
+    JackAnalyzer* analyzer = getCheckedAnalyzer(L, 1);
+    lua_pushinteger(L, atomic_get(&analyzer->shared->published));
+    return 1;
+}
+
+static int analyzer_overruns(lua_State* L)
+/* n = analyzer:overruns()
+ * returns the number of blocks dropped because the fifo was full.
+ */
+{
+    JackAnalyzer* analyzer = getCheckedAnalyzer(L, 1);
+    lua_pushinteger(L, atomic_get(&analyzer->shared->overruns));
+    return 1;
+}
+
+static const struct luaL_Reg ClientMethods[] = 
+{
+    { "analyzer",   analyzer_new },
+    { NULL, NULL } /* sentinel */
+};
+
+static const struct luaL_Reg AnalyzerMetaMethods[] = 
+{
+    { "__tostring", analyzer_toString },
+    { "__gc",       analyzer_release },
+    { NULL, NULL } /* sentinel */
+};
+
+static const struct luaL_Reg AnalyzerMethods[] = 
+{
+    { "push",       analyzer_push },
+    { "update",     analyzer_update },
+    { "read",       analyzer_read },
+    { "frequency",  analyzer_frequency },
+    { "bins",       analyzer_bins },
+    { "size",       analyzer_size },
+    { "published",  analyzer_published },
+    { "overruns",   analyzer_overruns },
+    { NULL, NULL } /* sentinel */
+};
+
+static const struct luaL_Reg ModuleFunctions[] = 
+{
+    { "analyzer",   analyzer_new },
+    { NULL, NULL } /* sentinel */
+};
+
+bool luajack_open_analyzer(lua_State* L, int module, int clientMeta, int clientClass,
+                                                     int analyzerMeta, int analyzerClass)
+{
+    lua_pushvalue(L, module);
+        setfuncs(L, ModuleFunctions);
+
+        lua_pushvalue(L, clientClass);
+            setfuncs(L, ClientMethods);
+
+            lua_pushvalue(L, analyzerMeta);
+                setfuncs(L, AnalyzerMetaMethods);
+    
+                lua_pushvalue(L, analyzerClass);
+                    setfuncs(L, AnalyzerMethods);
+    
+    lua_pop(L, 4);
+    
+    return true;
+}
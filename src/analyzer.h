@@ -0,0 +1,7 @@
+#ifndef LUAJACK_ANALYZER_H
+#define LUAJACK_ANALYZER_H
+
+bool luajack_open_analyzer(lua_State* L, int module, int clientMeta, int clientClass,
+                                                     int analyzerMeta, int analyzerClass);
+
+#endif // LUAJACK_ANALYZER_H
@@ -0,0 +1,196 @@
+#include <stdlib.h>
+#include <math.h>
+
+#include "util.h"
+#include "analyzer_util.h"
+#include "trace_util.h"
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+static void initWindow(JackAnalyzerShared* analyzer, JackWindowType type)
+{
+    const int n = analyzer->size;
+    double sum = 0;
+    int i;
+    for (i = 0; i < n; ++i) {
+        double x = 2.0 * M_PI * i / n;
+        double w;
+        switch (type) {
+            case WINDOW_HANN:     w = 0.5 - 0.5 * cos(x); break;
+            case WINDOW_BLACKMAN: w = 0.42 - 0.5 * cos(x) + 0.08 * cos(2 * x); break;
+            default:              w = 1.0; break;
+        }
+        analyzer->window[i] = (float) w;
+        sum += w;
+    }
+    /* a full scale sine at a bin center gives magnitude 1 */
+    for (i = 0; i < n; ++i) {
+        analyzer->window[i] *= (float)(2.0 / sum);
+    }
+}
+
+static void analyzeFrame(JackAnalyzerShared* analyzer)
+{
+    const int n = analyzer->size;
+    float*    w = analyzer->windowed;
+    int i;
+    for (i = 0; i < n; ++i) {
+        w[i] = analyzer->frame[i] * analyzer->window[i];
+    }
+    realFft(analyzer->fft, w, analyzer->re, analyzer->im);
+
+    float* out = analyzer->buffers[analyzer->backIndex];
+    float  s   = analyzer->smoothing;
+    for (i = 0; i < analyzer->bins; ++i) {
+        float m = sqrtf(analyzer->re[i] * analyzer->re[i] + analyzer->im[i] * analyzer->im[i]);
+        m = s * analyzer->magnitudes[i] + (1.0f - s) * m;
+        analyzer->magnitudes[i] = m;
+        out[i] = m;
+    }
+    /* publish */
+    int old;
+    do {
+        old = atomic_get(&analyzer->middle);
+    } while (!atomic_set_if_equal(&analyzer->middle, old, analyzer->backIndex | ANALYZER_FRESH));
+    analyzer->backIndex = old & ~ANALYZER_FRESH;
+    atomic_inc(&analyzer->published);
+}
+
+static void analyzerWorker(void* arg)
+{
+    JackAnalyzerShared* analyzer = (JackAnalyzerShared*) arg;
+    const int    n        = analyzer->size;
+    const int    hop      = analyzer->hop;
+    const size_t hopBytes = sizeof(float) * hop;
+
+    async_mutex_lock(&analyzer->mutex);
+    while (!analyzer->stopped) {
+        async_mutex_unlock(&analyzer->mutex);
+
+        while (jack_ringbuffer_read_space(analyzer->fifo) >= hopBytes) {
+            memmove(analyzer->frame, analyzer->frame + hop, sizeof(float) * (n - hop));
+            jack_ringbuffer_read(analyzer->fifo, (char*)(analyzer->frame + n - hop), hopBytes);
+            traceThreadBegin("analyzer worker", "analyzer fft");
+            analyzeFrame(analyzer);
+            traceEnd();
+        }
+        async_mutex_lock(&analyzer->mutex);
+        if (!analyzer->stopped) {
+            async_mutex_wait_millis(&analyzer->mutex, analyzer->pollMillis);
+        }
+    }
+    async_mutex_unlock(&analyzer->mutex);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+JackAnalyzerShared* createAnalyzer(int size, int hop, int fifoSize, JackWindowType window,
+                                   float smoothing, float sampleRate)
+{
+    JackAnalyzerShared* analyzer = (JackAnalyzerShared*) calloc(1, sizeof(JackAnalyzerShared));
+    if (!analyzer) {
+        return NULL;
+    }
+    analyzer->refCounter = 1;
+    analyzer->size       = size;
+    analyzer->hop        = hop;
+    analyzer->bins       = size / 2 + 1;
+    analyzer->sampleRate = sampleRate;
+    analyzer->smoothing  = smoothing;
+    analyzer->fifo       = jack_ringbuffer_create(sizeof(float) * fifoSize);
+    analyzer->fft        = createFft(size);
+    analyzer->window     = (float*) calloc(size, sizeof(float));
+    analyzer->frame      = (float*) calloc(size, sizeof(float));
+    analyzer->windowed   = (float*) calloc(size, sizeof(float));
+    analyzer->re         = (float*) calloc(analyzer->bins, sizeof(float));
+    analyzer->im         = (float*) calloc(analyzer->bins, sizeof(float));
+    analyzer->magnitudes = (float*) calloc(analyzer->bins, sizeof(float));
+    int i;
+    bool ok = analyzer->fifo && analyzer->fft && analyzer->window && analyzer->frame
+           && analyzer->windowed && analyzer->re && analyzer->im && analyzer->magnitudes;
+    for (i = 0; i < 3; ++i) {
+        analyzer->buffers[i] = (float*) calloc(analyzer->bins, sizeof(float));
+        ok = ok && analyzer->buffers[i];
+    }
+    if (!ok) {
+        releaseAnalyzer(analyzer);
+        return NULL;
+    }
+    if (jack_ringbuffer_mlock(analyzer->fifo) != 0) {
+        verbosePrintf("could not lock analyzer fifo into memory\n");
+    }
+    analyzer->frontIndex = 0;
+    analyzer->middle     = 1;
+    analyzer->backIndex  = 2;
+    initWindow(analyzer, window);
+
+    /* poll at half the hop period, a spectrum is at most half a hop late */
+    analyzer->pollMillis = (int)(500.0f * hop / sampleRate);
+    if (analyzer->pollMillis < 1) {
+        analyzer->pollMillis = 1;
+    }
+    analyzer->hasMutex  = async_mutex_init(&analyzer->mutex);
+    analyzer->hasThread = analyzer->hasMutex 
+                       && async_thread_create(&analyzer->thread, analyzerWorker, analyzer);
+    if (!analyzer->hasThread) {
+        releaseAnalyzer(analyzer);
+        return NULL;
+    }
+    return analyzer;
+}
+
+void releaseAnalyzer(JackAnalyzerShared* analyzer)
+{
+    if (analyzer && atomic_dec(&analyzer->refCounter) == 0) {
+        if (analyzer->hasThread) {
+            async_mutex_lock(&analyzer->mutex);
+            analyzer->stopped = true;
+            async_mutex_notify(&analyzer->mutex);
+            async_mutex_unlock(&analyzer->mutex);
+            async_thread_join(analyzer->thread);
+        }
+        if (analyzer->hasMutex) {
+            async_mutex_destruct(&analyzer->mutex);
+        }
+        if (analyzer->fifo) {
+            jack_ringbuffer_free(analyzer->fifo);
+        }
+        int i;
+        for (i = 0; i < 3; ++i) {
+            free(analyzer->buffers[i]);
+        }
+        releaseFft(analyzer->fft);
+        free(analyzer->window);
+        free(analyzer->frame);
+        free(analyzer->windowed);
+        free(analyzer->re);
+        free(analyzer->im);
+        free(analyzer->magnitudes);
+        free(analyzer);
+    }
+}
+
+void transferAnalyzer(lua_State* T, JackAnalyzerShared* sharedAnalyzer)
+{
+    JackAnalyzer* analyzer = (JackAnalyzer*) lua_newuserdata(T, sizeof(JackAnalyzer));
+    memset(analyzer, 0, sizeof(JackAnalyzer));
+    luaL_setmetatable(T, ANALYZER_TYPE_NAME);
+    analyzer->shared             = sharedAnalyzer;
+    analyzer->isInProcessContext = true;
+    atomic_inc(&sharedAnalyzer->refCounter);
+}
+
+bool updateAnalyzer(JackAnalyzerShared* analyzer)
+{
+    int old = atomic_get(&analyzer->middle);
+    if (!(old & ANALYZER_FRESH)) {
+        return false;
+    }
+    while (!atomic_set_if_equal(&analyzer->middle, old, analyzer->frontIndex)) {
+        old = atomic_get(&analyzer->middle);
+    }
+    analyzer->frontIndex = old & ~ANALYZER_FRESH;
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,117 @@
+#ifndef LUAJACK_ANALYZER_UTIL_H
+#define LUAJACK_ANALYZER_UTIL_H
+
+#include "util.h"
+#include "fft_util.h"
+
+/////////////////////////////////////////////////////////////////////////////////
+
+typedef enum {
+    WINDOW_RECT,
+    WINDOW_HANN,
+    WINDOW_BLACKMAN
+}
+JackWindowType;
+
+typedef struct {
+    AtomicCounter        refCounter;
+    int                  size;           /* fft size */
+    int                  hop;            /* frames between two spectra */
+    int                  bins;           /* size/2 + 1 */
+    float                sampleRate;
+    float                smoothing;      /* 0 .. 1, weight of the previous spectrum */
+
+    /* process context -> worker */
+    jack_ringbuffer_t*   fifo;
+    AtomicCounter        overruns;
+
+    /* worker state */
+    Thread               thread;
+    bool                 hasThread;
+    Mutex                mutex;
+    bool                 hasMutex;
+    volatile bool        stopped;
+    int                  pollMillis;
+    JackFft*             fft;
+    float*               window;
+    float*               frame;          /* last size input samples */
+    float*               windowed;
+    float*               re;
+    float*               im;
+    float*               magnitudes;
+
+    /* triple buffer: the worker writes into buffers[backIndex] and exchanges
+     * it with the middle buffer, the main context exchanges its front buffer 
+     * with the middle buffer if that holds a fresh spectrum */
+    float*               buffers[3];
+    AtomicCounter        middle;         /* buffer index | ANALYZER_FRESH */
+    int                  backIndex;
+    int                  frontIndex;
+    AtomicCounter        published;
+}
+JackAnalyzerShared;
+
+#define ANALYZER_FRESH 4
+
+typedef struct {
+    JackAnalyzerShared*  shared;
+    bool                 isInProcessContext;
+}
+JackAnalyzer;
+
+static inline JackAnalyzer* getCheckedAnalyzer(lua_State* L, int stackIndex)
+{
+    JackAnalyzer* analyzer = (JackAnalyzer*) checkudata(L, stackIndex, ANALYZER_TYPE, ANALYZER_TYPE_NAME);
+    return analyzer;
+}
+
+static inline JackAnalyzer* getOptionalAnalyzer(lua_State* L, int stackIndex)
+{
+    JackAnalyzer* analyzer = (JackAnalyzer*) testudata(L, stackIndex, ANALYZER_TYPE, ANALYZER_TYPE_NAME);
+    return analyzer;
+}
+
+/////////////////////////////////////////////////////////////////////////////////
+
+/* Creates the analyzer and starts its worker thread, the fifo holds fifoSize
+ * samples */
+
+#define createAnalyzer luajack_createAnalyzer 
+
+JackAnalyzerShared* createAnalyzer(int size, int hop, int fifoSize, JackWindowType window,
+                                   float smoothing, float sampleRate);
+
+/* Stops and joins the worker thread if this was the last reference */
+
+#define releaseAnalyzer luajack_releaseAnalyzer 
+
+void releaseAnalyzer(JackAnalyzerShared* analyzer);
+
+#define transferAnalyzer luajack_transferAnalyzer 
+
+void transferAnalyzer(lua_State* T, JackAnalyzerShared* analyzer);
+
+/* Copies samples into the fifo, never blocks. Returns false and counts an 
+ * overrun if the worker has fallen behind. */
+
+static inline bool pushAnalyzer(JackAnalyzerShared* analyzer, const float* in, jack_nframes_t nframes)
+{
+    size_t bytes = sizeof(float) * nframes;
+    if (jack_ringbuffer_write_space(analyzer->fifo) < bytes) {
+        atomic_inc(&analyzer->overruns);
+        return false;
+    }
+    jack_ringbuffer_write(analyzer->fifo, (const char*) in, bytes);
+    return true;
+}
+
+/* Takes the newest published spectrum into the front buffer, returns false 
+ * if there is no new spectrum */
+
+#define updateAnalyzer luajack_updateAnalyzer 
+
+bool updateAnalyzer(JackAnalyzerShared* analyzer);
+
+/////////////////////////////////////////////////////////////////////////////////
+
+#endif // LUAJACK_ANALYZER_UTIL_H
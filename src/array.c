@@ -0,0 +1,258 @@
+#include "util.h"
+#include "array.h"
+#include "array_util.h"
+
+static const char* const FileFormatNames[] = { "raw", "wav", NULL };
+
+static JackArray* pushNewArray(lua_State* L)
+{
+    JackArray* array = (JackArray*) lua_newuserdata(L, sizeof(JackArray));
+    memset(array, 0, sizeof(JackArray));
+    luaL_setmetatable(L, ARRAY_TYPE_NAME);
+    return array;
+}
+
+static int array_new(lua_State* L)
+/* array = jack.array(values)
+ * creates an immutable array of float samples from an array of numbers or
+ * from a string of packed 32 bit floats in native byte order. Arrays are
+ * passed by reference to process chunks and worker threads, i.e. the samples
+ * exist only once, independent of the number of Lua states using them.
+ */
+{
+    JackArray* array;
+    if (lua_type(L, 1) == LUA_TSTRING) {
+        size_t len;
+        const char* data = lua_tolstring(L, 1, &len);
+        array = pushNewArray(L);
+        array->shared = createArray(len / sizeof(float));
+        if (!array->shared) {
+            return luaL_error(L, "out of memory");
+        }
+        memcpy(array->shared->memory, data, sizeof(float) * array->shared->length);
+    } else {
+        luaL_checktype(L, 1, LUA_TTABLE);
+        size_t length = (size_t) luaL_len(L, 1);
+        array = pushNewArray(L);
+        array->shared = createArray(length);
+        if (!array->shared) {
+            return luaL_error(L, "out of memory");
+        }
+        size_t i;
+        for (i = 0; i < length; ++i) {
+            lua_rawgeti(L, 1, i + 1);
+            array->shared->memory[i] = (float) lua_tonumber(L, -1);
+            lua_pop(L, 1);
+        }
+    }
+    return 1;
+}
+
+static int array_load(lua_State* L)
+/* array = jack.array_file(fileName [, options])
+ * creates an immutable array of float samples from a file. Raw files of 32
+ * bit floats in native byte order and mono WAV files with 32 bit float
+ * samples are memory mapped read-only, other WAV files are decoded. Options:
+ *   format  = "raw"|"wav"   file format (default "wav" for file names ending
+ *                           with ".wav", "raw" otherwise)
+ *   channel = n             channel of the WAV file (default 1)
+ *   lock    = true|false    lock the samples in memory, so that the process
+ *                           callback cannot page fault on them (default false)
+ */
+{
+    size_t      len;
+    const char* fileName = luaL_checklstring(L, 1, &len);
+    bool        isWav    = len >= 4 && (   strcmp(fileName + len - 4, ".wav") == 0
+                                        || strcmp(fileName + len - 4, ".WAV") == 0);
+    int         format   = isWav ? ARRAY_FILE_WAV : ARRAY_FILE_RAW;
+    bool        lock     = false;
+    if (lua_istable(L, 2)) {
+        lua_getfield(L, 2, "format");
+        if (!lua_isnil(L, -1)) {
+            format = luaL_checkoption(L, -1, NULL, FileFormatNames);
+        }
+        lua_getfield(L, 2, "lock");
+        lock = lua_toboolean(L, -1);
+        lua_pop(L, 2);
+    }
+    lua_Integer channel = getIntegerOption(L, 2, "channel", 1);
+
+    const char* errorMessage = NULL;
+    JackArray* array = pushNewArray(L);
+    array->shared = loadArray(fileName, (JackArrayFileFormat) format, (int) channel - 1, lock, &errorMessage);
+    if (!array->shared) {
+        return luaL_error(L, "cannot load samples from '%s': %s", fileName, errorMessage);
+    }
+    return 1;
+}
+
+static int array_release(lua_State* L)
+{
+    JackArray* array = getCheckedArray(L, 1);
+    releaseArray(array->shared);
+    array->shared = NULL;
+    return 0;
+}
+
+static int array_toString(lua_State* L)
+{
+    JackArray* array = getCheckedArray(L, 1);
+    lua_pushfstring(L, "%s: %p", ARRAY_TYPE_NAME, array->shared);
+    return 1;
+}
+
+static JackArrayShared* getCheckedArrayShared(lua_State* L, int stackIndex)
+{
+    JackArray* array = getCheckedArray(L, stackIndex);
+    if (!array->shared) {
+        luaL_argerror(L, stackIndex, "released array");
+    }
+    return array->shared;
+}
+
+static int array_len(lua_State* L)
+/* n = array:len() or #array
+ */
+{
+    JackArrayShared* array = getCheckedArrayShared(L, 1);
+    lua_pushinteger(L, (lua_Integer) array->length);
+    return 1;
+}
+
+static int array_get(lua_State* L)
+/* value = array:get(i)
+ * returns the i-th sample (1-based) or nil if i is out of range.
+ */
+{
+    JackArrayShared* array = getCheckedArrayShared(L, 1);
+    lua_Integer      i     = luaL_checkinteger(L, 2);
+    if (i >= 1 && (size_t) i <= array->length) {
+        lua_pushnumber(L, array->data[i - 1]);
+    } else {
+        lua_pushnil(L);
+    }
+    return 1;
+}
+
+static int array_sample_rate(lua_State* L)
+/* rate = array:sample_rate()
+ * returns the sample rate of the WAV file the array was loaded from or nil.
+ */
+{
+    JackArrayShared* array = getCheckedArrayShared(L, 1);
+    if (array->sampleRate > 0) {
+        lua_pushinteger(L, array->sampleRate);
+    } else {
+        lua_pushnil(L);
+    }
+    return 1;
+}
+
+static int array_is_mapped(lua_State* L)
+/* flag = array:is_mapped()
+ * true if the samples are read from a memory mapped file.
+ */
+{
+    JackArrayShared* array = getCheckedArrayShared(L, 1);
+    lua_pushboolean(L, array->mapping != NULL);
+    return 1;
+}
+
+static int array_render(lua_State* L, bool mix)
+{
+    JackArrayShared* array = getCheckedArrayShared(L, 1);
+    jack_nframes_t nframes;
+    jack_default_audio_sample_t* out = getCheckedSignalBuffer(L, 2, &nframes);
+    lua_Integer pos  = luaL_checkinteger(L, 3);
+    lua_Number  gain = mix ? luaL_optnumber(L, 4, 1.0) : 1.0;
+    luaL_argcheck(L, pos >= 1, 3, "invalid position");
+
+    if (!out) {
+        lua_pushinteger(L, 0);
+        return 1;
+    }
+    nframes = getOptionalNframes(L, mix ? 5 : 4, nframes);
+
+    size_t n = 0;
+    if ((size_t)(pos - 1) < array->length) {
+        n = array->length - (size_t)(pos - 1);
+        if (n > nframes) {
+            n = nframes;
+        }
+    }
+    const float* in = array->data + (n > 0 ? pos - 1 : 0);
+    size_t i;
+    if (mix) {
+        float g = (float) gain;
+        for (i = 0; i < n; ++i) {
+            out[i] += g * in[i];
+        }
+    } else {
+        memcpy(out, in, sizeof(float) * n);
+        memset(out + n, 0, sizeof(float) * (nframes - n));
+    }
+    lua_pushinteger(L, (lua_Integer) n);
+    return 1;
+}
+
+static int array_copy_to(lua_State* L)
+/* n = array:copy_to(dst, pos [, nframes])
+ * copies the samples starting at position pos (1-based) to the port or
+ * scratch buffer dst, the part of dst beyond the end of the array is
+ * cleared. Returns the number of samples taken from the array.
+ */
+{
+    return array_render(L, false);
+}
+
+static int array_mix_to(lua_State* L)
+/* n = array:mix_to(dst, pos [, gain [, nframes]])
+ * adds the samples starting at position pos (1-based) multiplied by gain
+ * (default 1.0) to the port or scratch buffer dst. Returns the number of
+ * samples taken from the array.
+ */
+{
+    return array_render(L, true);
+}
+
+static const struct luaL_Reg ArrayMetaMethods[] =
+{
+    { "__tostring", array_toString },
+    { "__gc",       array_release },
+    { "__len",      array_len },
+    { NULL, NULL } /* sentinel */
+};
+
+static const struct luaL_Reg ArrayMethods[] =
+{
+    { "len",          array_len },
+    { "get",          array_get },
+    { "sample_rate",  array_sample_rate },
+    { "is_mapped",    array_is_mapped },
+    { "copy_to",      array_copy_to },
+    { "mix_to",       array_mix_to },
+    { NULL, NULL } /* sentinel */
+};
+
+static const struct luaL_Reg ModuleFunctions[] =
+{
+    { "array",      array_new },
+    { "array_file", array_load },
+    { NULL, NULL } /* sentinel */
+};
+
+bool luajack_open_array(lua_State* L, int module, int arrayMeta, int arrayClass)
+{
+    lua_pushvalue(L, module);
+        setfuncs(L, ModuleFunctions);
+
+        lua_pushvalue(L, arrayMeta);
+            setfuncs(L, ArrayMetaMethods);
+
+            lua_pushvalue(L, arrayClass);
+                setfuncs(L, ArrayMethods);
+
+    lua_pop(L, 3);
+
+    return true;
+}
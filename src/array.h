@@ -0,0 +1,6 @@
+#ifndef LUAJACK_ARRAY_H
+#define LUAJACK_ARRAY_H
+
+bool luajack_open_array(lua_State* L, int module, int arrayMeta, int arrayClass);
+
+#endif // LUAJACK_ARRAY_H
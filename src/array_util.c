@@ -0,0 +1,225 @@
+#include <stdio.h>
+
+#if !defined(_WIN32)
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+    #define LUAJACK_ARRAY_USE_MMAP
+#endif
+
+#include "util.h"
+#include "array_util.h"
+#include "wav_util.h"
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+JackArrayShared* createArray(size_t length)
+{
+    JackArrayShared* array = (JackArrayShared*) calloc(1, sizeof(JackArrayShared));
+    if (!array) {
+        return NULL;
+    }
+    array->memory = (float*) calloc(length > 0 ? length : 1, sizeof(float));
+    if (!array->memory) {
+        free(array);
+        return NULL;
+    }
+    array->refCounter = 1;
+    array->data       = array->memory;
+    array->length     = length;
+    return array;
+}
+
+static void lockSamples(JackArrayShared* array, const char* fileName)
+{
+#if defined(LUAJACK_ARRAY_USE_MMAP)
+    void*  p    = array->mapping ? array->mapping     : (void*) array->memory;
+    size_t size = array->mapping ? array->mappingSize : sizeof(float) * array->length;
+    if (size > 0 && mlock(p, size) == 0) {
+        array->isLocked = true;
+    } else {
+        verbosePrintf("cannot lock samples of '%s' in memory\n", fileName);
+    }
+#endif
+}
+
+#if defined(LUAJACK_ARRAY_USE_MMAP)
+
+static bool isLittleEndian(void)
+{
+    union { unsigned int i; unsigned char c[4]; } u;
+    u.i = 1;
+    return u.c[0] == 1;
+}
+
+static void* mapFile(const char* fileName, size_t* size, const char** errorMessage)
+{
+    int fd = open(fileName, O_RDONLY);
+    if (fd < 0) {
+        *errorMessage = "cannot open file";
+        return NULL;
+    }
+    void* mapping = NULL;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        *errorMessage = "empty file";
+    } else {
+        mapping = mmap(NULL, (size_t) st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping == MAP_FAILED) {
+            mapping = NULL;
+            *errorMessage = "cannot map file";
+        } else {
+            *size = (size_t) st.st_size;
+            madvise(mapping, *size, MADV_WILLNEED);
+        }
+    }
+    close(fd);
+    return mapping;
+}
+
+#endif
+
+static JackArrayShared* loadRawArray(const char* fileName, const char** errorMessage)
+{
+    JackArrayShared* array = NULL;
+#if defined(LUAJACK_ARRAY_USE_MMAP)
+    size_t size    = 0;
+    void*  mapping = mapFile(fileName, &size, errorMessage);
+    if (!mapping) {
+        return NULL;
+    }
+    array = (JackArrayShared*) calloc(1, sizeof(JackArrayShared));
+    if (!array) {
+        munmap(mapping, size);
+        *errorMessage = "out of memory";
+        return NULL;
+    }
+    array->refCounter  = 1;
+    array->mapping     = mapping;
+    array->mappingSize = size;
+    array->data        = (const float*) mapping;
+    array->length      = size / sizeof(float);
+#else
+    FILE* file = fopen(fileName, "rb");
+    if (!file) {
+        *errorMessage = "cannot open file";
+        return NULL;
+    }
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    if (size <= 0) {
+        *errorMessage = "empty file";
+    } else {
+        array = createArray((size_t) size / sizeof(float));
+        if (!array) {
+            *errorMessage = "out of memory";
+        } else {
+            array->length = fread(array->memory, sizeof(float), array->length, file);
+        }
+    }
+    fclose(file);
+#endif
+    return array;
+}
+
+static JackArrayShared* loadWavArray(const char* fileName, int channel, const char** errorMessage)
+{
+    JackWavInfo info;
+    if (!readWavInfo(fileName, &info, errorMessage)) {
+        return NULL;
+    }
+    if (channel < 0 || channel >= info.channels) {
+        *errorMessage = "invalid channel";
+        return NULL;
+    }
+#if defined(LUAJACK_ARRAY_USE_MMAP)
+    if (   info.format == WAV_FORMAT_FLOAT && info.bits == 32 && info.channels == 1
+        && info.dataOffset % sizeof(float) == 0 && isLittleEndian())
+    {
+        size_t size    = 0;
+        void*  mapping = mapFile(fileName, &size, errorMessage);
+        if (!mapping) {
+            return NULL;
+        }
+        if ((size_t) info.dataOffset > size) {
+            munmap(mapping, size);
+            *errorMessage = "truncated data chunk";
+            return NULL;
+        }
+        JackArrayShared* array = (JackArrayShared*) calloc(1, sizeof(JackArrayShared));
+        if (!array) {
+            munmap(mapping, size);
+            *errorMessage = "out of memory";
+            return NULL;
+        }
+        size_t dataBytes = size - info.dataOffset;
+        if (info.dataBytes < dataBytes) {
+            dataBytes = info.dataBytes;
+        }
+        array->refCounter  = 1;
+        array->mapping     = mapping;
+        array->mappingSize = size;
+        array->data        = (const float*)((const char*) mapping + info.dataOffset);
+        array->length      = dataBytes / sizeof(float);
+        array->sampleRate  = info.sampleRate;
+        return array;
+    }
+#endif
+    int nframes, nchannels, sampleRate;
+    float* samples = readWavFile(fileName, channel, &nframes, &nchannels, &sampleRate, errorMessage);
+    if (!samples) {
+        return NULL;
+    }
+    JackArrayShared* array = (JackArrayShared*) calloc(1, sizeof(JackArrayShared));
+    if (!array) {
+        free(samples);
+        *errorMessage = "out of memory";
+        return NULL;
+    }
+    array->refCounter = 1;
+    array->memory     = samples;
+    array->data       = samples;
+    array->length     = nframes;
+    array->sampleRate = sampleRate;
+    return array;
+}
+
+JackArrayShared* loadArray(const char* fileName, JackArrayFileFormat format, int channel,
+                           bool lock, const char** errorMessage)
+{
+    JackArrayShared* array = (format == ARRAY_FILE_WAV) ? loadWavArray(fileName, channel, errorMessage)
+                                                        : loadRawArray(fileName, errorMessage);
+    if (array && lock) {
+        lockSamples(array, fileName);
+    }
+    return array;
+}
+
+void releaseArray(JackArrayShared* array)
+{
+    if (array && atomic_dec(&array->refCounter) == 0) {
+#if defined(LUAJACK_ARRAY_USE_MMAP)
+        if (array->mapping) {
+            munmap(array->mapping, array->mappingSize);
+        }
+        else if (array->isLocked) {
+            munlock(array->memory, sizeof(float) * array->length);
+        }
+#endif
+        free(array->memory);
+        free(array);
+    }
+}
+
+void transferArray(lua_State* T, JackArrayShared* sharedArray)
+{
+    JackArray* array = (JackArray*) lua_newuserdata(T, sizeof(JackArray));
+    memset(array, 0, sizeof(JackArray));
+    luaL_setmetatable(T, ARRAY_TYPE_NAME);
+    array->shared = sharedArray;
+    atomic_inc(&sharedArray->refCounter);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
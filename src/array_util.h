@@ -0,0 +1,78 @@
+#ifndef LUAJACK_ARRAY_UTIL_H
+#define LUAJACK_ARRAY_UTIL_H
+
+#include "util.h"
+
+/////////////////////////////////////////////////////////////////////////////////
+
+/* Immutable array of float samples, e.g. a sample set or a waveform. It is
+ * created once in the main context and transferred by reference to any
+ * number of process and worker states. The samples are either malloc'ed or
+ * point into a read-only memory mapping of a raw float or WAV file, so that
+ * also unrelated processes share the same physical pages. */
+
+typedef struct {
+    AtomicCounter  refCounter;
+    const float*   data;
+    size_t         length;
+    int            sampleRate;     /* 0 if unknown */
+    float*         memory;         /* malloc'ed samples or NULL */
+    void*          mapping;        /* mapped file or NULL */
+    size_t         mappingSize;
+    bool           isLocked;       /* mapping is locked in memory */
+}
+JackArrayShared;
+
+typedef struct {
+    JackArrayShared* shared;
+}
+JackArray;
+
+static inline JackArray* getCheckedArray(lua_State* L, int stackIndex)
+{
+    JackArray* array = (JackArray*) checkudata(L, stackIndex, ARRAY_TYPE, ARRAY_TYPE_NAME);
+    return array;
+}
+
+static inline JackArray* getOptionalArray(lua_State* L, int stackIndex)
+{
+    JackArray* array = (JackArray*) testudata(L, stackIndex, ARRAY_TYPE, ARRAY_TYPE_NAME);
+    return array;
+}
+
+/////////////////////////////////////////////////////////////////////////////////
+
+typedef enum {
+    ARRAY_FILE_RAW,    /* 32 bit floats in native byte order, no header */
+    ARRAY_FILE_WAV
+}
+JackArrayFileFormat;
+
+/* Allocates an array of zeros, the samples may be set through
+ * array->memory until the array is shared. */
+
+#define createArray luajack_createArray
+
+JackArrayShared* createArray(size_t length);
+
+/* Maps the file if the samples can be used as they are, i.e. raw files and
+ * mono WAV files with 32 bit float samples, otherwise the channel (0-based)
+ * is decoded into memory. If lock is set, mapped pages are locked in memory,
+ * so that the process callback does not page fault on first access. */
+
+#define loadArray luajack_loadArray
+
+JackArrayShared* loadArray(const char* fileName, JackArrayFileFormat format, int channel,
+                           bool lock, const char** errorMessage);
+
+#define releaseArray luajack_releaseArray
+
+void releaseArray(JackArrayShared* array);
+
+#define transferArray luajack_transferArray
+
+void transferArray(lua_State* T, JackArrayShared* array);
+
+/////////////////////////////////////////////////////////////////////////////////
+
+#endif // LUAJACK_ARRAY_UTIL_H
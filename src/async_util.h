@@ -46,6 +46,8 @@
 
 /////////////////////////////////////////////////////////////////////////////////////////////
 
+#include <stdlib.h>
+
 #if defined(LUAJACK_ASYNC_USE_WIN32) || defined(LUAJACK_ASYNC_USE_WINTHREAD)
     #include <windows.h>
 #endif
@@ -133,6 +135,21 @@ static inline int atomic_get(AtomicCounter* value)
 #endif
 }
 
+static inline void atomic_set(AtomicCounter* value, int newValue)
+{
+#if defined(LUAJACK_ASYNC_USE_WIN32)
+    InterlockedExchange(value, newValue);
+#elif defined(LUAJACK_ASYNC_USE_APPLE)
+    OSMemoryBarrier();
+    *(volatile AtomicCounter*)value = newValue;
+    OSMemoryBarrier();
+#elif defined(LUAJACK_ASYNC_USE_GNU)
+    __sync_synchronize();
+    *(volatile AtomicCounter*)value = newValue;
+    __sync_synchronize();
+#endif
+}
+
 /////////////////////////////////////////////////////////////////////////////////////////////
 
 
@@ -282,6 +299,20 @@ static inline bool async_mutex_lock(Mutex* mutex)
 
 /////////////////////////////////////////////////////////////////////////////////////////////
 
+/* Never blocks, returns false if the mutex is held by another thread */
+
+static inline bool async_mutex_trylock(Mutex* mutex) 
+{
+#if defined(LUAJACK_ASYNC_USE_PTHREAD)
+    int rc = pthread_mutex_trylock(&mutex->mutex);
+    return (rc == 0);
+#elif defined(LUAJACK_ASYNC_USE_WINTHREAD)
+    return TryEnterCriticalSection(&mutex->mutex) != 0;
+#endif
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+
 static inline bool async_mutex_unlock(Mutex* mutex) 
 {
 #if defined(LUAJACK_ASYNC_USE_PTHREAD)
@@ -374,4 +405,71 @@ static inline bool async_mutex_notify(Mutex* mutex)
 }
 /////////////////////////////////////////////////////////////////////////////////////////////
 
+#if defined(LUAJACK_ASYNC_USE_PTHREAD)
+    typedef pthread_t Thread;
+#elif defined(LUAJACK_ASYNC_USE_WINTHREAD)
+    typedef HANDLE    Thread;
+#endif
+
+typedef void (*ThreadFunction)(void* arg);
+
+typedef struct
+{
+    ThreadFunction function;
+    void*          arg;
+} ThreadStart;
+
+#if defined(LUAJACK_ASYNC_USE_PTHREAD)
+static void* async_thread_start(void* arg)
+#elif defined(LUAJACK_ASYNC_USE_WINTHREAD)
+static DWORD WINAPI async_thread_start(LPVOID arg)
+#endif
+{
+    ThreadStart start = *(ThreadStart*) arg;
+    free(arg);
+    start.function(start.arg);
+    return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+
+static inline bool async_thread_create(Thread* thread, ThreadFunction function, void* arg)
+{
+    ThreadStart* start = (ThreadStart*) malloc(sizeof(ThreadStart));
+    if (!start) {
+        return false;
+    }
+    start->function = function;
+    start->arg      = arg;
+#if defined(LUAJACK_ASYNC_USE_PTHREAD)
+    int rc = pthread_create(thread, NULL, async_thread_start, start);
+    if (rc != 0) {
+        free(start);
+    }
+    return (rc == 0);
+#elif defined(LUAJACK_ASYNC_USE_WINTHREAD)
+    *thread = CreateThread(NULL, 0, async_thread_start, start, 0, NULL);
+    if (*thread == NULL) {
+        free(start);
+    }
+    return (*thread != NULL);
+#endif
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+
+static inline bool async_thread_join(Thread thread)
+{
+#if defined(LUAJACK_ASYNC_USE_PTHREAD)
+    int rc = pthread_join(thread, NULL);
+    return (rc == 0);
+#elif defined(LUAJACK_ASYNC_USE_WINTHREAD)
+    DWORD rc = WaitForSingleObject(thread, INFINITE);
+    CloseHandle(thread);
+    return (rc == WAIT_OBJECT_0);
+#endif
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+
 #endif // LUAJACK_ASYNC_UTIL_H
@@ -7,11 +7,9 @@
 
 static int buffer_clear(lua_State* L)
 {
-    JackPort* dstPort = getCheckedPort(L, 1);
-    
-    if (dstPort->ptr && dstPort->shared && dstPort->shared->client) {
-        lua_Integer nframes = dstPort->shared->client->currentProcessNframes;
-        jack_default_audio_sample_t* out  = jack_port_get_buffer (dstPort->ptr, nframes);;
+    jack_nframes_t nframes;
+    jack_default_audio_sample_t* out = getCheckedSignalBuffer(L, 1, &nframes);
+    if (out) {
         memset(out, 0, sizeof(jack_default_audio_sample_t) * nframes);
     }
     return 0;
@@ -19,25 +17,52 @@ static int buffer_clear(lua_State* L)
 
 static int buffer_copy(lua_State* L)
 {
-    JackPort*     dstPort = getCheckedPort(L, 1);
-    JackPort*     srcPort = getCheckedPort(L, 2);
-    
-    if (dstPort->ptr && srcPort->ptr && dstPort->shared && dstPort->shared->client) {
-        lua_Integer nframes;
-        if (lua_isnumber(L, 3)) {
-            nframes = lua_tointeger(L, 3);
-            if (nframes < 0) {
-                nframes = 0;
-            } else if (nframes > dstPort->shared->client->currentProcessNframes) {
-                nframes = dstPort->shared->client->currentProcessNframes; // TODO error
-            }
-        } else {
-            nframes = dstPort->shared->client->currentProcessNframes;
+    jack_nframes_t nframes;
+    jack_default_audio_sample_t* out = getCheckedSignalBuffer(L, 1, &nframes);
+    jack_default_audio_sample_t* in  = getCheckedSignalBuffer(L, 2, &nframes);
+
+    if (out && in) {
+        nframes = getOptionalNframes(L, 3, nframes);
+        memmove(out, in, sizeof(jack_default_audio_sample_t) * nframes);
+    }
+    return 0;
+}
+
+static int buffer_mix(lua_State* L)
+/* dst:mix_from(src [, gain [, nframes]]) 
+ * adds the samples of 'src' multiplied by 'gain' (default 1.0) to 'dst'.
+ */
+{
+    jack_nframes_t nframes;
+    jack_default_audio_sample_t* out  = getCheckedSignalBuffer(L, 1, &nframes);
+    jack_default_audio_sample_t* in   = getCheckedSignalBuffer(L, 2, &nframes);
+    jack_default_audio_sample_t  gain = (jack_default_audio_sample_t) luaL_optnumber(L, 3, 1.0);
+
+    if (out && in) {
+        nframes = getOptionalNframes(L, 4, nframes);
+        jack_nframes_t i;
+        for (i = 0; i < nframes; ++i) {
+            out[i] += gain * in[i];
+        }
+    }
+    return 0;
+}
+
+static int buffer_scale(lua_State* L)
+/* dst:scale(gain [, nframes]) 
+ * multiplies the samples of 'dst' by 'gain'.
+ */
+{
+    jack_nframes_t nframes;
+    jack_default_audio_sample_t* out  = getCheckedSignalBuffer(L, 1, &nframes);
+    jack_default_audio_sample_t  gain = (jack_default_audio_sample_t) luaL_checknumber(L, 2);
+
+    if (out) {
+        nframes = getOptionalNframes(L, 3, nframes);
+        jack_nframes_t i;
+        for (i = 0; i < nframes; ++i) {
+            out[i] *= gain;
         }
-        jack_default_audio_sample_t* in   = jack_port_get_buffer (srcPort->ptr, nframes);
-        jack_default_audio_sample_t* out  = jack_port_get_buffer (dstPort->ptr, nframes);;
-        
-        memcpy (out, in, sizeof(jack_default_audio_sample_t) * nframes);
     }
     return 0;
 }
@@ -47,6 +72,8 @@ static const struct luaL_Reg PortMethods[] =
 {
     { "clear",      buffer_clear },
     { "copy_from",  buffer_copy },
+    { "mix_from",   buffer_mix },
+    { "scale",      buffer_scale },
     { NULL, NULL } /* sentinel */
 };
 
@@ -54,20 +81,25 @@ static const struct luaL_Reg ModuleFunctions[] =
 {
     { "clear", buffer_clear },
     { "copy",  buffer_copy },
+    { "mix",   buffer_mix },
+    { "scale", buffer_scale },
     { NULL, NULL } /* sentinel */
 };
 
 bool luajack_open_buffer(lua_State* L, int module, int clientMeta, int clientClass,
-                                                   int   portMeta, int   portClass)
+                                                   int   portMeta, int   portClass,
+                                                int scratchMeta, int scratchClass)
 {
     lua_pushvalue(L, module);
-        luaL_setfuncs(L, ModuleFunctions, 0);
+        setfuncs(L, ModuleFunctions);
 
         lua_pushvalue(L, portClass);
-            luaL_setfuncs(L, PortMethods, 0);
+            setfuncs(L, PortMethods);
 
-    lua_pop(L, 2);
+            lua_pushvalue(L, scratchClass);
+                setfuncs(L, PortMethods);
+
+    lua_pop(L, 3);
     
     return true;
 }
-
@@ -2,6 +2,7 @@
 #define LUAJACK_BUFFER_H
 
 bool luajack_open_buffer(lua_State* L, int module, int clientMeta, int clientClass,
-                                                   int   portMeta, int   portClass);
+                                                   int   portMeta, int   portClass,
+                                                int scratchMeta, int scratchClass);
 
 #endif // LUAJACK_BUFFER_H
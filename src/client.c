@@ -7,6 +7,9 @@
 #include "util.h"
 #include "client.h"
 #include "client_util.h"
+#include "notify_util.h"
+#include "rt_util.h"
+#include "alloc_util.h"
 
 static int client_ptr(lua_State* L)
 {
@@ -40,6 +43,7 @@ static int client_open(lua_State* L)
 
     client->shared->processCallbackRef = LUA_NOREF;
     async_mutex_init(&client->shared->mutex);
+    async_mutex_init(&client->shared->portsCacheMutex);
     
     jack_status_t status;
     {
@@ -60,6 +64,7 @@ static int client_open(lua_State* L)
         client->isMaster             = true;
         client->shared->mainContext  = thisContext;
         client->shared->ptr          = client->ptr;
+        setNotificationCallbacks(client->shared);
         verbosePrintf("created client '%s'\n", jack_get_client_name(client->ptr));
         return 1;
     }
@@ -121,14 +126,57 @@ static int client_uuid_to_name(lua_State* L)
 }
 
 static int activate(lua_State* L)
+/* client:activate([options])
+ * options for hardening the process thread:
+ *   flush_denormals    = true   sets FTZ/DAZ on the process thread
+ *   stack_prefault     = bytes  touches this much of the process thread stack,
+ *                               at most 128 KiB and never more than the thread's
+ *                               free stack minus a safety margin
+ *   lua_stack_prefault = slots  preallocates the process context's Lua stack
+ *   mlockall           = true   locks all current and future memory
+ *   cpus               = { cpu, ... } pins the process thread to these cpus
+ * The results can be inspected with client:rt_status().
+ */
 {
     JackClient* client = getCheckedClient(L, 1);
+    JackRtOptions options;
+    if (getRtOptions(L, 2, &options)) {
+        if (!client->isMaster) {
+            return luaL_argerror(L, 1, "options can only be given for master client object");
+        }
+        if (client->isActivated) {
+            return luaL_error(L, "client is already activated");
+        }
+        applyRtOptions(client->shared, &options);
+    }
     if (jack_activate(client->ptr) != 0)
         return luaL_error(L, "cannot activate client");
     client->isActivated = true;
     return 0;
 }
 
+static int rt_status(lua_State* L)
+/* client:rt_status()
+ * returns a table with the results of the options given to activate() or 
+ * nil if no options were given. The process thread results are only 
+ * available after the first process cycle.
+ */
+{
+    JackClient* client = getCheckedClient(L, 1);
+    JackRtOptions* options = client->shared->rtOptions;
+    if (!options) {
+        lua_pushnil(L);
+        return 1;
+    }
+    lua_newtable(L);
+    lua_pushboolean(L, options->denormalsFlushed);   lua_setfield(L, -2, "flush_denormals");
+    lua_pushboolean(L, options->stackPrefaulted);    lua_setfield(L, -2, "stack_prefault");
+    lua_pushboolean(L, options->luaStackPrefaulted); lua_setfield(L, -2, "lua_stack_prefault");
+    lua_pushboolean(L, options->memoryLocked);       lua_setfield(L, -2, "mlockall");
+    lua_pushboolean(L, options->affinitySet);        lua_setfield(L, -2, "cpus");
+    return 1;
+}
+
 static int deactivate(lua_State* L)
 {
     JackClient* client = getCheckedClient(L, 1);
@@ -185,6 +233,19 @@ static int client_check_error(lua_State* L)
             async_mutex_unlock(&shared->mutex);
         }
     }
+    JackAllocStats* stats = shared ? shared->allocStats : NULL;
+    if (stats && atomic_get(&stats->unreported) > 0) {
+        atomic_set(&stats->unreported, 0);
+        char errmsg[160];
+        snprintf(errmsg, sizeof(errmsg), "process callback allocated %d times (%ld bytes) "
+                                         "in cycle %ld after warm-up (%ld violations)",
+                                         stats->violationAllocs,
+                                         (long) stats->violationBytes,
+                                         (long) stats->violationCycle,
+                                         (long) stats->violations);
+        lua_pushstring(L, errmsg);
+        return lua_error(L);
+    }
     return 0;
 }
 
@@ -218,6 +279,7 @@ static const struct luaL_Reg ClientMethods[] =
     { "uuid_to_name",        client_uuid_to_name },
     { "activate",            activate },
     { "deactivate",          deactivate },
+    { "rt_status",           rt_status },
     { "buffer_size",         buffer_size },
     { "close",               client_close},
     { "sleep",               client_sleep },
@@ -244,6 +306,7 @@ static const struct luaL_Reg ModuleFunctions[] =
     { "client_uuid_to_name", client_uuid_to_name },
     { "activate",            activate },
     { "deactivate",          deactivate },
+    { "rt_status",           rt_status },
     { "buffer_size",         buffer_size },
     { "sleep",               client_sleep },
     { "client_check_error",  client_check_error },
@@ -255,13 +318,13 @@ static const struct luaL_Reg ModuleFunctions[] =
 bool luajack_open_client(lua_State* L, int module, int clientMeta, int clientClass)
 {
     lua_pushvalue(L, module);
-        luaL_setfuncs(L, ModuleFunctions, 0);
+        setfuncs(L, ModuleFunctions);
 
         lua_pushvalue(L, clientMeta);
-            luaL_setfuncs(L, ClientMetaMethods, 0);
+            setfuncs(L, ClientMetaMethods);
     
             lua_pushvalue(L, clientClass);
-                luaL_setfuncs(L, ClientMethods, 0);
+                setfuncs(L, ClientMethods);
     
     lua_pop(L, 3);
 
@@ -2,6 +2,13 @@
 
 #include "util.h"
 #include "client_util.h"
+#include "port_util.h"
+#include "notify_util.h"
+#include "scratch_util.h"
+#include "native_util.h"
+#include "rt_util.h"
+#include "profiler_util.h"
+#include "recorder_util.h"
 
 //////////////////////////////////////////////////////////////////////////////////////////////
 // JackOptionParameters {
@@ -122,6 +129,16 @@ void releaseClient(JackClient* client)
             jack_client_close(client->ptr);
 
             verbosePrintf("client closed\n");
+
+            releaseNativeChain(client->shared->nativeChain);
+            client->shared->nativeChain = NULL;
+
+            /* the recorder holds references of the client's ports, so it
+             * is released here instead of in releaseClientShared */
+            releaseRecorder(client->shared->recorder);
+            releaseRecorder(client->shared->retiredRecorder);
+            client->shared->recorder        = NULL;
+            client->shared->retiredRecorder = NULL;
             
             if (client->shared) {
                 client->shared->ptr = NULL;
@@ -140,12 +157,20 @@ void releaseClientShared(JackClientShared* shared)
 {
     if (shared && atomic_dec(&shared->refCounter) == 0) {
         async_mutex_destruct(&shared->mutex);
+        async_mutex_destruct(&shared->portsCacheMutex);
         if (shared->processContextChunkName) {
             free(shared->processContextChunkName);
         }
         if (shared->errorInProcessContext) {
             free(shared->errorInProcessContext);
         }
+        releaseCachedPorts(shared);
+        releaseNotificationQueue(shared->notificationQueue);
+        releaseClientScratchPools(shared);
+        free(shared->rtOptions);
+        releaseProfiler(shared->profiler);
+        releaseProfiler(shared->retiredProfiler);
+        free(shared->allocStats);
         free(shared);
     }
 }
@@ -0,0 +1,118 @@
+#ifndef LUAJACK_COMPAT_H
+#define LUAJACK_COMPAT_H
+
+/* Shims for building against Lua 5.2 and LuaJIT 2.1 (Lua 5.1 API plus the 
+ * 5.2 extensions of LuaJIT 2.1). LuaJack is written against the Lua 5.3 API,
+ * only the functions used by LuaJack are provided here. */
+
+#include <math.h>
+
+#include <lua.h>
+#include <lauxlib.h>
+
+/////////////////////////////////////////////////////////////////////////////////
+
+#if LUA_VERSION_NUM < 502
+
+#define LUA_OK 0
+
+/* Lua 5.1 has no predefined registry slot for the main thread. LuaJack 
+ * stores it under a negative integer key that luaL_ref never uses when the 
+ * module is opened (see initCompat). */
+#define LUA_RIDX_MAINTHREAD (-0x4c4a)
+
+static inline void luajack_initCompat(lua_State* L)
+{
+    lua_rawgeti(L, LUA_REGISTRYINDEX, LUA_RIDX_MAINTHREAD);
+    int isSet = !lua_isnil(L, -1);
+    lua_pop(L, 1);
+    if (!isSet) {
+        lua_pushthread(L);
+        lua_rawseti(L, LUA_REGISTRYINDEX, LUA_RIDX_MAINTHREAD);
+    }
+}
+
+static inline int luajack_absindex(lua_State* L, int i)
+{
+    return (i > 0 || i <= LUA_REGISTRYINDEX) ? i : lua_gettop(L) + i + 1;
+}
+
+static inline void lua_rawgetp(lua_State* L, int i, const void* p)
+{
+    i = luajack_absindex(L, i);
+    lua_pushlightuserdata(L, (void*) p);
+    lua_rawget(L, i);
+}
+
+static inline void lua_rawsetp(lua_State* L, int i, const void* p)
+{
+    i = luajack_absindex(L, i);
+    lua_pushlightuserdata(L, (void*) p);
+    lua_insert(L, -2);
+    lua_rawset(L, i);
+}
+
+static inline lua_Integer luaL_len(lua_State* L, int i)
+{
+    return (lua_Integer) lua_objlen(L, i);
+}
+
+#define lua_rawlen(L, i) lua_objlen(L, i)
+
+#define lua_absindex(L, i) luajack_absindex(L, i)
+
+/* Lua 5.1 library open functions register their globals themselves */
+static inline void luajack_requiref(lua_State* L, const char* modname, lua_CFunction openf)
+{
+    lua_pushcfunction(L, openf);
+    lua_pushstring(L, modname);
+    lua_call(L, 1, 1);
+}
+
+#define luaL_requiref(L, modname, openf, glb) luajack_requiref(L, modname, openf)
+
+/* Lua 5.1 lua_load has no mode argument */
+#define lua_load(L, reader, data, chunkname, mode) (lua_load)(L, reader, data, chunkname)
+
+#else
+
+static inline void luajack_initCompat(lua_State* L)
+{
+}
+
+#endif // LUA_VERSION_NUM < 502
+
+/////////////////////////////////////////////////////////////////////////////////
+
+#if LUA_VERSION_NUM < 503
+
+static inline int lua_geti(lua_State* L, int i, lua_Integer n)
+{
+    lua_pushinteger(L, n);
+    lua_gettable(L, i < 0 && i > LUA_REGISTRYINDEX ? i - 1 : i);
+    return lua_type(L, -1);
+}
+
+static inline void lua_seti(lua_State* L, int i, lua_Integer n)
+{
+    lua_pushinteger(L, n);
+    lua_insert(L, -2);
+    lua_settable(L, i < 0 && i > LUA_REGISTRYINDEX ? i - 1 : i);
+}
+
+static inline int lua_isinteger(lua_State* L, int i)
+{
+    if (lua_type(L, i) == LUA_TNUMBER) {
+        lua_Number x = lua_tonumber(L, i);
+        return x == floor(x) && x == (lua_Number)(lua_Integer) x;
+    }
+    return 0;
+}
+
+#endif // LUA_VERSION_NUM < 503
+
+/////////////////////////////////////////////////////////////////////////////////
+
+#define initCompat luajack_initCompat
+
+#endif // LUAJACK_COMPAT_H
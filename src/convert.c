@@ -0,0 +1,148 @@
+#include "util.h"
+#include "convert.h"
+#include "convert_util.h"
+
+/* samples converted at once */
+#define CONVERT_BLOCK 256
+
+static uint32_t ditherSeed(lua_State* L)
+{
+    static AtomicCounter counter = 0;
+    return (uint32_t)(size_t) L ^ ((uint32_t) atomic_inc(&counter) * 2654435761u);
+}
+
+static int convert_convert(lua_State* L)
+/* data = jack.convert(data, from, to [, dither])
+ * converts a string of samples between the formats "float32", "int16",
+ * "int24" and "int32" (little endian, see group:write_interleaved()). 16 and
+ * 24 bit results get TPDF dither if dither is true. Intended for worker
+ * threads, e.g. to convert float32 data from the process context to the
+ * format of a file.
+ */
+{
+    size_t           len;
+    const char*      data   = luaL_checklstring(L, 1, &len);
+    JackSampleFormat from   = checkSampleFormat(L, 2);
+    JackSampleFormat to     = checkSampleFormat(L, 3);
+    uint32_t         seed   = ditherSeed(L);
+    uint32_t*        dither = lua_toboolean(L, 4) ? &seed : NULL;
+
+    size_t n         = len / sampleFormatBytes(from);
+    size_t fromBytes = sampleFormatBytes(from);
+    size_t toBytes   = sampleFormatBytes(to);
+    float  block[CONVERT_BLOCK];
+
+    luaL_Buffer b;
+    luaL_buffinit(L, &b);
+    size_t pos = 0;
+    while (pos < n) {
+        size_t count = n - pos;
+        if (count > CONVERT_BLOCK) {
+            count = CONVERT_BLOCK;
+        }
+        if (count * toBytes > LUAL_BUFFERSIZE) {
+            count = LUAL_BUFFERSIZE / toBytes;
+        }
+        decodeSamples(data + pos * fromBytes, 1, from, block, 1, count);
+        char* out = luaL_prepbuffer(&b);
+        encodeSamples(block, 1, out, 1, to, count, dither);
+        luaL_addsize(&b, count * toBytes);
+        pos += count;
+    }
+    luaL_pushresult(&b);
+    return 1;
+}
+
+static int convert_interleave(lua_State* L)
+/* data = jack.interleave(channels, format [, dither])
+ * interleaves the channels, an array of strings of float32 samples, into a
+ * string of samples in format. Channels shorter than the longest one are
+ * padded with zeros.
+ */
+{
+    luaL_checktype(L, 1, LUA_TTABLE);
+    JackSampleFormat format   = checkSampleFormat(L, 2);
+    uint32_t         seed     = ditherSeed(L);
+    uint32_t*        dither   = lua_toboolean(L, 3) ? &seed : NULL;
+    int              nchannels = (int) luaL_len(L, 1);
+    luaL_argcheck(L, nchannels >= 1, 1, "no channels");
+    luaL_checkstack(L, nchannels + LUA_MINSTACK, "too many channels");
+
+    int    first  = lua_gettop(L) + 1;
+    size_t frames = 0;
+    int    c;
+    for (c = 0; c < nchannels; ++c) {
+        lua_rawgeti(L, 1, c + 1);
+        if (lua_type(L, -1) != LUA_TSTRING) {
+            return luaL_error(L, "channel %d is not a string", c + 1);
+        }
+        size_t n = lua_rawlen(L, -1) / sizeof(float);
+        if (n > frames) {
+            frames = n;
+        }
+    }
+    size_t frameBytes = (size_t) nchannels * sampleFormatBytes(format);
+    char*  out        = (char*) lua_newuserdata(L, frameBytes * frames + 1);
+    float  block[CONVERT_BLOCK];
+    for (c = 0; c < nchannels; ++c) {
+        size_t      len;
+        const char* data = lua_tolstring(L, first + c, &len);
+        size_t      n    = len / sizeof(float);
+        size_t      pos;
+        for (pos = 0; pos < frames; pos += CONVERT_BLOCK) {
+            size_t count = (frames - pos < CONVERT_BLOCK) ? frames - pos : CONVERT_BLOCK;
+            size_t valid = (pos >= n) ? 0 : ((n - pos < count) ? n - pos : count);
+            decodeSamples(data + pos * sizeof(float), 1, SAMPLE_FLOAT32, block, 1, valid);
+            memset(block + valid, 0, sizeof(float) * (count - valid));
+            encodeSamples(block, 1, out + pos * frameBytes + (size_t) c * sampleFormatBytes(format),
+                          nchannels, format, count, dither);
+        }
+    }
+    lua_pushlstring(L, out, frameBytes * frames);
+    return 1;
+}
+
+static int convert_deinterleave(lua_State* L)
+/* channels = jack.deinterleave(data, format, nchannels)
+ * splits a string of interleaved samples in format into an array of
+ * nchannels strings of float32 samples.
+ */
+{
+    size_t           len;
+    const char*      data      = luaL_checklstring(L, 1, &len);
+    JackSampleFormat format    = checkSampleFormat(L, 2);
+    lua_Integer      nchannels = luaL_checkinteger(L, 3);
+    luaL_argcheck(L, nchannels >= 1 && nchannels <= 65536, 3, "invalid number of channels");
+
+    size_t frameBytes = (size_t) nchannels * sampleFormatBytes(format);
+    size_t frames     = len / frameBytes;
+    lua_createtable(L, (int) nchannels, 0);
+    float* out = (float*) lua_newuserdata(L, sizeof(float) * frames + 1);
+    int c;
+    for (c = 0; c < nchannels; ++c) {
+        decodeSamples(data + (size_t) c * sampleFormatBytes(format), nchannels, format, out, 1, frames);
+        encodeSamples(out, 1, out, 1, SAMPLE_FLOAT32, frames, NULL);
+        lua_pushlstring(L, (const char*) out, sizeof(float) * frames);
+        lua_rawseti(L, -3, c + 1);
+    }
+    lua_pop(L, 1);
+    return 1;
+}
+
+static const struct luaL_Reg ModuleFunctions[] =
+{
+    { "convert",      convert_convert },
+    { "interleave",   convert_interleave },
+    { "deinterleave", convert_deinterleave },
+    { NULL, NULL } /* sentinel */
+};
+
+bool luajack_open_convert(lua_State* L, int module)
+{
+    lua_pushvalue(L, module);
+        setfuncs(L, ModuleFunctions);
+
+    lua_pop(L, 1);
+
+    return true;
+}
@@ -0,0 +1,6 @@
+#ifndef LUAJACK_CONVERT_H
+#define LUAJACK_CONVERT_H
+
+bool luajack_open_convert(lua_State* L, int module);
+
+#endif // LUAJACK_CONVERT_H
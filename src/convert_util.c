@@ -0,0 +1,168 @@
+#include "util.h"
+#include "convert_util.h"
+
+static const char* const SampleFormatNames[] = { "float32", "int16", "int24", "int32", NULL };
+
+JackSampleFormat checkSampleFormat(lua_State* L, int arg)
+{
+    return (JackSampleFormat) luaL_checkoption(L, arg, NULL, SampleFormatNames);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+/* byte wise little endian access, compilers merge this into single loads and
+ * stores on little endian machines */
+
+static inline void put16(unsigned char* p, int32_t v)
+{
+    p[0] = (unsigned char) v;
+    p[1] = (unsigned char)(v >> 8);
+}
+
+static inline void put24(unsigned char* p, int32_t v)
+{
+    p[0] = (unsigned char) v;
+    p[1] = (unsigned char)(v >> 8);
+    p[2] = (unsigned char)(v >> 16);
+}
+
+static inline void put32(unsigned char* p, uint32_t v)
+{
+    p[0] = (unsigned char) v;
+    p[1] = (unsigned char)(v >> 8);
+    p[2] = (unsigned char)(v >> 16);
+    p[3] = (unsigned char)(v >> 24);
+}
+
+static inline int32_t get16(const unsigned char* p)
+{
+    return (int16_t)(p[0] | (p[1] << 8));
+}
+
+static inline int32_t get24(const unsigned char* p)
+{
+    return (int32_t)(p[0] << 8 | (p[1] << 16) | ((uint32_t) p[2] << 24)) >> 8;
+}
+
+static inline uint32_t get32(const unsigned char* p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+
+/* triangular probability density noise in (-1, 1) */
+
+static inline float tpdf(uint32_t* state)
+{
+    uint32_t a = *state = *state * 1664525u + 1013904223u;
+    uint32_t b = *state = *state * 1664525u + 1013904223u;
+    return ((float)(a >> 8) + (float)(b >> 8)) * (1.0f / 16777216.0f) - 1.0f;
+}
+
+static inline int32_t roundClip(float v, float lo, float hi)
+{
+    if (!(v == v)) {
+        v = 0.0f; /* NaN, converting it to int is undefined */
+    }
+    v += (v >= 0.0f) ? 0.5f : -0.5f;
+    v  = (v < lo) ? lo : ((v > hi) ? hi : v);
+    return (int32_t) v;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+void encodeSamples(const float* in, size_t inStride,
+                   void* out, size_t outStride, JackSampleFormat format,
+                   size_t n, uint32_t* dither)
+{
+    unsigned char* p    = (unsigned char*) out;
+    size_t         step = outStride * sampleFormatBytes(format);
+    size_t         i;
+
+    switch (format)
+    {
+        case SAMPLE_FLOAT32:
+            for (i = 0; i < n; ++i, p += step) {
+                union { float f; uint32_t i; } u;
+                u.f = in[i * inStride];
+                put32(p, u.i);
+            }
+            break;
+
+        case SAMPLE_INT16:
+            if (dither) {
+                for (i = 0; i < n; ++i, p += step) {
+                    put16(p, roundClip(in[i * inStride] * 32768.0f + tpdf(dither), -32768.0f, 32767.0f));
+                }
+            } else {
+                for (i = 0; i < n; ++i, p += step) {
+                    put16(p, roundClip(in[i * inStride] * 32768.0f, -32768.0f, 32767.0f));
+                }
+            }
+            break;
+
+        case SAMPLE_INT24:
+            if (dither) {
+                for (i = 0; i < n; ++i, p += step) {
+                    put24(p, roundClip(in[i * inStride] * 8388608.0f + tpdf(dither), -8388608.0f, 8388607.0f));
+                }
+            } else {
+                for (i = 0; i < n; ++i, p += step) {
+                    put24(p, roundClip(in[i * inStride] * 8388608.0f, -8388608.0f, 8388607.0f));
+                }
+            }
+            break;
+
+        case SAMPLE_INT32:
+            /* float has too few mantissa bits for the range, dither below
+             * float resolution would be useless */
+            for (i = 0; i < n; ++i, p += step) {
+                double v = (double) in[i * inStride] * 2147483648.0;
+                if (!(v == v)) {
+                    v = 0.0;
+                }
+                v += (v >= 0.0) ? 0.5 : -0.5;
+                v  = (v < -2147483648.0) ? -2147483648.0 : ((v > 2147483647.0) ? 2147483647.0 : v);
+                put32(p, (uint32_t)(int32_t) v);
+            }
+            break;
+    }
+}
+
+void decodeSamples(const void* in, size_t inStride, JackSampleFormat format,
+                   float* out, size_t outStride, size_t n)
+{
+    const unsigned char* p    = (const unsigned char*) in;
+    size_t               step = inStride * sampleFormatBytes(format);
+    size_t               i;
+
+    switch (format)
+    {
+        case SAMPLE_FLOAT32:
+            for (i = 0; i < n; ++i, p += step) {
+                union { float f; uint32_t i; } u;
+                u.i = get32(p);
+                out[i * outStride] = u.f;
+            }
+            break;
+
+        case SAMPLE_INT16:
+            for (i = 0; i < n; ++i, p += step) {
+                out[i * outStride] = (float) get16(p) * (1.0f / 32768.0f);
+            }
+            break;
+
+        case SAMPLE_INT24:
+            for (i = 0; i < n; ++i, p += step) {
+                out[i * outStride] = (float) get24(p) * (1.0f / 8388608.0f);
+            }
+            break;
+
+        case SAMPLE_INT32:
+            for (i = 0; i < n; ++i, p += step) {
+                out[i * outStride] = (float)((double)(int32_t) get32(p) * (1.0 / 2147483648.0));
+            }
+            break;
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,58 @@
+#ifndef LUAJACK_CONVERT_UTIL_H
+#define LUAJACK_CONVERT_UTIL_H
+
+#include "util.h"
+
+/////////////////////////////////////////////////////////////////////////////////
+
+/* Sample formats of interleaved data, all little endian as in WAV files.
+ * Integer samples are scaled by 2^(bits-1) and clipped. */
+
+typedef enum {
+    SAMPLE_FLOAT32,
+    SAMPLE_INT16,
+    SAMPLE_INT24,      /* packed, 3 bytes */
+    SAMPLE_INT32
+}
+JackSampleFormat;
+
+static inline int sampleFormatBytes(JackSampleFormat format)
+{
+    switch (format) {
+        case SAMPLE_INT16: return 2;
+        case SAMPLE_INT24: return 3;
+        default:           return 4;
+    }
+}
+
+/* "float32", "int16", "int24" or "int32" at argument arg */
+
+#define checkSampleFormat luajack_checkSampleFormat
+
+JackSampleFormat checkSampleFormat(lua_State* L, int arg);
+
+/////////////////////////////////////////////////////////////////////////////////
+
+/* Encodes n samples read from in with a stride of inStride floats to out with
+ * a stride of outStride samples. If dither is not NULL, 16 and 24 bit samples
+ * get TPDF dither of +-1 LSB from the random generator state *dither. With
+ * strides of 1 the loops are simple enough to be vectorized by the compiler,
+ * interleaving is done with outStride = number of channels. */
+
+#define encodeSamples luajack_encodeSamples
+
+void encodeSamples(const float* in, size_t inStride,
+                   void* out, size_t outStride, JackSampleFormat format,
+                   size_t n, uint32_t* dither);
+
+/* Decodes n samples read from in with a stride of inStride samples to out
+ * with a stride of outStride floats. */
+
+#define decodeSamples luajack_decodeSamples
+
+void decodeSamples(const void* in, size_t inStride, JackSampleFormat format,
+                   float* out, size_t outStride, size_t n);
+
+/////////////////////////////////////////////////////////////////////////////////
+
+#endif // LUAJACK_CONVERT_UTIL_H
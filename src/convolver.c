@@ -0,0 +1,210 @@
+#include "util.h"
+#include "convolver.h"
+#include "convolver_util.h"
+#include "wav_util.h"
+#include "array_util.h"
+
+static int convolver_new(lua_State* L)
+/* convolver = client:convolver(ir [, options])
+ * creates a convolver for the impulse response ir, which is either an array
+ * of sample values, a jack.array or the file name of a WAV file. The impulse response is 
+ * transformed here, i.e. in the main context, the convolver is then passed 
+ * to the process context. Options:
+ *   channel = n         channel of the WAV file (default 1)
+ *   gain    = factor    linear gain applied to the impulse response (default 1)
+ *   head    = n         partitions computed in the process context, the 
+ *                       others are computed ahead on a worker thread (default 4)
+ *   block   = frames    partition size, must be a power of two and equal to
+ *                       the process block size (default client buffer size)
+ */
+{
+    JackClient* client     = getCheckedClient(L, 1);
+    float       sampleRate = (float) jack_get_sample_rate(client->ptr);
+
+    if (client->isInProcessContext) {
+        return luaL_error(L, "convolver cannot be created in process context");
+    }
+    lua_Integer block = getIntegerOption(L, 3, "block", jack_get_buffer_size(client->ptr));
+    luaL_argcheck(L, block >= 2 && block <= 65536 && (block & (block - 1)) == 0, 3, 
+                     "block must be a power of two");
+    lua_Integer head = getIntegerOption(L, 3, "head", 4);
+    luaL_argcheck(L, head >= 1 && head <= 1024, 3, "invalid head");
+    lua_Number  gain = getNumberOption(L, 3, "gain", 1.0);
+
+    /* created before the impulse response is allocated, so that nothing can
+     * raise an error while ir must be freed */
+    JackConvolver* convolver = (JackConvolver*) lua_newuserdata(L, sizeof(JackConvolver));
+    memset(convolver, 0, sizeof(JackConvolver));
+    luaL_setmetatable(L, CONVOLVER_TYPE_NAME);
+
+    float*     ir       = NULL;
+    int        irLength = 0;
+    JackArray* array    = getOptionalArray(L, 2);
+    if (array) {
+        luaL_argcheck(L, array->shared, 2, "released array");
+        if (array->shared->sampleRate > 0 && array->shared->sampleRate != (int) sampleRate) {
+            return luaL_error(L, "sample rate %d of impulse response differs from client sample rate %d",
+                                 array->shared->sampleRate, (int) sampleRate);
+        }
+    } else if (lua_type(L, 2) == LUA_TSTRING) {
+        lua_Integer channel = getIntegerOption(L, 3, "channel", 1);
+        int nchannels, fileRate;
+        const char* errorMessage = NULL;
+        ir = readWavFile(lua_tostring(L, 2), (int) channel - 1, &irLength, &nchannels, &fileRate, &errorMessage);
+        if (!ir) {
+            return luaL_error(L, "cannot read impulse response '%s': %s", lua_tostring(L, 2), errorMessage);
+        }
+        if (fileRate != (int) sampleRate) {
+            free(ir);
+            return luaL_error(L, "sample rate %d of impulse response '%s' differs from client sample rate %d",
+                                 fileRate, lua_tostring(L, 2), (int) sampleRate);
+        }
+    } else {
+        luaL_checktype(L, 2, LUA_TTABLE);
+        irLength = (int) luaL_len(L, 2);
+        ir = (float*) malloc(sizeof(float) * (irLength > 0 ? irLength : 1));
+        if (!ir) {
+            return luaL_error(L, "out of memory");
+        }
+        int i;
+        /* raw access and lua_tonumber() do not raise errors */
+        for (i = 0; i < irLength; ++i) {
+            lua_rawgeti(L, 2, i + 1);
+            ir[i] = (float) lua_tonumber(L, -1);
+            lua_pop(L, 1);
+        }
+    }
+    convolver->shared = array ? createConvolver(array->shared->data, (int) array->shared->length, 
+                                                (float) gain, (int) block, (int) head, sampleRate)
+                              : createConvolver(ir, irLength, (float) gain, (int) block, (int) head, sampleRate);
+    free(ir);
+    if (!convolver->shared) {
+        return luaL_error(L, "cannot create convolver");
+    }
+    return 1;
+}
+
+static int convolver_release(lua_State* L)
+{
+    JackConvolver* convolver = getCheckedConvolver(L, 1);
+    releaseConvolver(convolver->shared);
+    convolver->shared = NULL;
+    return 0;
+}
+
+static int convolver_toString(lua_State* L)
+{
+    JackConvolver* convolver = getCheckedConvolver(L, 1);
+    lua_pushfstring(L, "%s: %p", CONVOLVER_TYPE_NAME, convolver->shared);
+    return 1;
+}
+
+static int convolver_process(lua_State* L)
+/* convolver:process(in [, out])
+ * convolves the current process block of the port or scratch buffer in into
+ * out. If out is not given, the result replaces the samples of in. Must be 
+ * called from the process callback.
+ */
+{
+    JackConvolver* convolver = getCheckedConvolver(L, 1);
+    jack_nframes_t nframes;
+    const float* in  = getCheckedSignalBuffer(L, 2, &nframes);
+    jack_nframes_t outNframes = nframes;
+    float*       out = lua_isnoneornil(L, 3) ? (float*) in 
+                                             : getCheckedSignalBuffer(L, 3, &outNframes);
+    if (!convolver->isInProcessContext) {
+        return luaL_error(L, "convolver can only be processed in process context");
+    }
+    if (in && out) {
+        if (out != in && outNframes < nframes) {
+            nframes = outNframes;
+        }
+        processConvolver(convolver->shared, in, out, nframes);
+    }
+    return 0;
+}
+
+static int convolver_partitions(lua_State* L)
+{
+    JackConvolver* convolver = getCheckedConvolver(L, 1);
+    lua_pushinteger(L, convolver->shared->partitions);
+    return 1;
+}
+
+static int convolver_block(lua_State* L)
+{
+    JackConvolver* convolver = getCheckedConvolver(L, 1);
+    lua_pushinteger(L, convolver->shared->block);
+    return 1;
+}
+
+static int convolver_late(lua_State* L)
+/* n = convolver:late()
+ * returns the number of blocks for which the worker thread did not deliver
+ * the tail in time. These blocks lack the tail of the impulse response.
+ */
+{
+    JackConvolver* convolver = getCheckedConvolver(L, 1);
+    lua_pushinteger(L, atomic_get(&convolver->shared->late));
+    return 1;
+}
+
+static int convolver_mismatches(lua_State* L)
+/* n = convolver:mismatches()
+ * returns the number of process blocks that were silenced because their 
+ * size did not match the partition size.
+ */
+{
+    JackConvolver* convolver = getCheckedConvolver(L, 1);
+    lua_pushinteger(L, atomic_get(&convolver->shared->mismatches));
+    return 1;
+}
+
+static const struct luaL_Reg ClientMethods[] = 
+{
+    { "convolver",  convolver_new },
+    { NULL, NULL } /* sentinel */
+};
+
+static const struct luaL_Reg ConvolverMetaMethods[] = 
+{
+    { "__tostring", convolver_toString },
+    { "__gc",       convolver_release },
+    { NULL, NULL } /* sentinel */
+};
+
+static const struct luaL_Reg ConvolverMethods[] = 
+{
+    { "process",    convolver_process },
+    { "partitions", convolver_partitions },
+    { "block",      convolver_block },
+    { "late",       convolver_late },
+    { "mismatches", convolver_mismatches },
+    { NULL, NULL } /* sentinel */
+};
+
+static const struct luaL_Reg ModuleFunctions[] = 
+{
+    { "convolver",  convolver_new },
+    { NULL, NULL } /* sentinel */
+};
+
+bool luajack_open_convolver(lua_State* L, int module, int clientMeta, int clientClass,
+                                                      int convolverMeta, int convolverClass)
+{
+    lua_pushvalue(L, module);
+        setfuncs(L, ModuleFunctions);
+
+        lua_pushvalue(L, clientClass);
+            setfuncs(L, ClientMethods);
+
+            lua_pushvalue(L, convolverMeta);
+                setfuncs(L, ConvolverMetaMethods);
+    
+                lua_pushvalue(L, convolverClass);
+                    setfuncs(L, ConvolverMethods);
+    
+    lua_pop(L, 4);
+    
+    return true;
+}
@@ -0,0 +1,7 @@
+#ifndef LUAJACK_CONVOLVER_H
+#define LUAJACK_CONVOLVER_H
+
+bool luajack_open_convolver(lua_State* L, int module, int clientMeta, int clientClass,
+                                                      int convolverMeta, int convolverClass);
+
+#endif // LUAJACK_CONVOLVER_H
@@ -0,0 +1,244 @@
+#include <stdlib.h>
+#include <math.h>
+
+#include "util.h"
+#include "convolver_util.h"
+#include "trace_util.h"
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+static unsigned int nextPowerOfTwo(unsigned int n)
+{
+    unsigned int p = 1;
+    while (p < n) {
+        p <<= 1;
+    }
+    return p;
+}
+
+/* acc += x * h for all bins */
+static void multiplyAccumulate(int bins, float* accRe, float* accIm,
+                               const float* xRe, const float* xIm, 
+                               const float* hRe, const float* hIm)
+{
+    int i;
+    for (i = 0; i < bins; ++i) {
+        accRe[i] += xRe[i] * hRe[i] - xIm[i] * hIm[i];
+        accIm[i] += xRe[i] * hIm[i] + xIm[i] * hRe[i];
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+static void computeTail(JackConvolverShared* c, unsigned int n)
+{
+    const int    bins = c->bins;
+    unsigned int slot = n & c->tailMask;
+    float*       re   = c->tailRe + (size_t) slot * bins;
+    float*       im   = c->tailIm + (size_t) slot * bins;
+    int k;
+    memset(re, 0, sizeof(float) * bins);
+    memset(im, 0, sizeof(float) * bins);
+    for (k = c->head; k < c->partitions; ++k) {
+        size_t x = (size_t)((n - k) & c->fdlMask) * bins;
+        size_t h = (size_t) k * bins;
+        multiplyAccumulate(bins, re, im, c->fdlRe + x, c->fdlIm + x, c->irRe + h, c->irIm + h);
+    }
+    atomic_set(&c->tailTags[slot], (int) n);
+}
+
+static void convolverWorker(void* arg)
+{
+    JackConvolverShared* c = (JackConvolverShared*) arg;
+
+    async_mutex_lock(&c->mutex);
+    while (!c->stopped) {
+        unsigned int posted = (unsigned int) atomic_get(&c->posted);
+        
+        /* the tail for block n needs the input spectrum of block n - head */
+        if ((int)(posted - (c->nextTail - c->head)) >= 0) {
+            async_mutex_unlock(&c->mutex);
+            if ((int)(c->nextTail - posted) <= 0) {
+                /* too late, the process context has already used this block */
+                c->nextTail = posted + 1;
+            } else {
+                traceThreadBegin("convolver worker", "convolver tail");
+                computeTail(c, c->nextTail);
+                traceEnd();
+                c->nextTail += 1;
+            }
+            async_mutex_lock(&c->mutex);
+        } else {
+            async_mutex_wait_millis(&c->mutex, c->pollMillis);
+        }
+    }
+    async_mutex_unlock(&c->mutex);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+JackConvolverShared* createConvolver(const float* ir, int irLength, float gain, 
+                                     int block, int head, float sampleRate)
+{
+    JackConvolverShared* c = (JackConvolverShared*) calloc(1, sizeof(JackConvolverShared));
+    if (!c) {
+        return NULL;
+    }
+    c->refCounter = 1;
+    c->block      = block;
+    c->bins       = block + 1;
+    c->partitions = (irLength + block - 1) / block;
+    if (c->partitions < 1) {
+        c->partitions = 1;
+    }
+    c->head       = head < c->partitions ? head : c->partitions;
+    c->fdlMask    = nextPowerOfTwo(c->partitions + c->head + 1) - 1;
+    c->tailMask   = nextPowerOfTwo(c->head + 1) - 1;
+
+    size_t bins = c->bins;
+    c->irRe     = (float*) calloc(c->partitions  * bins, sizeof(float));
+    c->irIm     = (float*) calloc(c->partitions  * bins, sizeof(float));
+    c->fdlRe    = (float*) calloc((c->fdlMask + 1)  * bins, sizeof(float));
+    c->fdlIm    = (float*) calloc((c->fdlMask + 1)  * bins, sizeof(float));
+    c->tailRe   = (float*) calloc((c->tailMask + 1) * bins, sizeof(float));
+    c->tailIm   = (float*) calloc((c->tailMask + 1) * bins, sizeof(float));
+    c->tailTags = (AtomicCounter*) calloc(c->tailMask + 1, sizeof(AtomicCounter));
+    c->fft      = createFft(2 * block);
+    c->input    = (float*) calloc(2 * block, sizeof(float));
+    c->output   = (float*) calloc(2 * block, sizeof(float));
+    c->accRe    = (float*) calloc(bins, sizeof(float));
+    c->accIm    = (float*) calloc(bins, sizeof(float));
+    if (   !c->irRe || !c->irIm || !c->fdlRe || !c->fdlIm || !c->tailRe || !c->tailIm 
+        || !c->tailTags || !c->fft || !c->input || !c->output || !c->accRe || !c->accIm)
+    {
+        releaseConvolver(c);
+        return NULL;
+    }
+    /* partition spectra, each partition is zero padded to 2 * block */
+    int k, i;
+    for (k = 0; k < c->partitions; ++k) {
+        memset(c->input, 0, sizeof(float) * 2 * block);
+        for (i = 0; i < block && k * block + i < irLength; ++i) {
+            c->input[i] = gain * ir[k * block + i];
+        }
+        realFft(c->fft, c->input, c->irRe + k * bins, c->irIm + k * bins);
+    }
+    memset(c->input, 0, sizeof(float) * 2 * block);
+
+    /* the tails of the first head blocks are zero */
+    for (i = 0; i <= (int) c->tailMask; ++i) {
+        c->tailTags[i] = (i < c->head) ? i : -1;
+    }
+    c->posted     = -1;
+    c->nextTail   = c->head;
+    c->pollMillis = (int)(500.0f * block / sampleRate);
+    if (c->pollMillis < 1) {
+        c->pollMillis = 1;
+    }
+    if (c->partitions > c->head) {
+        c->hasMutex  = async_mutex_init(&c->mutex);
+        c->hasThread = c->hasMutex && async_thread_create(&c->thread, convolverWorker, c);
+        if (!c->hasThread) {
+            releaseConvolver(c);
+            return NULL;
+        }
+    }
+    return c;
+}
+
+void releaseConvolver(JackConvolverShared* c)
+{
+    if (c && atomic_dec(&c->refCounter) == 0) {
+        if (c->hasThread) {
+            async_mutex_lock(&c->mutex);
+            c->stopped = true;
+            async_mutex_notify(&c->mutex);
+            async_mutex_unlock(&c->mutex);
+            async_thread_join(c->thread);
+        }
+        if (c->hasMutex) {
+            async_mutex_destruct(&c->mutex);
+        }
+        releaseFft(c->fft);
+        free(c->irRe);
+        free(c->irIm);
+        free(c->fdlRe);
+        free(c->fdlIm);
+        free(c->tailRe);
+        free(c->tailIm);
+        free(c->tailTags);
+        free(c->input);
+        free(c->output);
+        free(c->accRe);
+        free(c->accIm);
+        free(c);
+    }
+}
+
+void transferConvolver(lua_State* T, JackConvolverShared* sharedConvolver)
+{
+    JackConvolver* convolver = (JackConvolver*) lua_newuserdata(T, sizeof(JackConvolver));
+    memset(convolver, 0, sizeof(JackConvolver));
+    luaL_setmetatable(T, CONVOLVER_TYPE_NAME);
+    convolver->shared             = sharedConvolver;
+    convolver->isInProcessContext = true;
+    atomic_inc(&sharedConvolver->refCounter);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+void processConvolver(JackConvolverShared* c, const float* in, float* out, jack_nframes_t nframes)
+{
+    const int    block = c->block;
+    const int    bins  = c->bins;
+    unsigned int n     = c->blockIndex;
+
+    if (nframes != (jack_nframes_t) block) {
+        atomic_inc(&c->mismatches);
+        memset(out, 0, sizeof(float) * nframes);
+        return;
+    }
+    memcpy(c->input,         c->input + block, sizeof(float) * block);
+    memcpy(c->input + block, in,               sizeof(float) * block);
+
+    size_t x = (size_t)(n & c->fdlMask) * bins;
+    realFft(c->fft, c->input, c->fdlRe + x, c->fdlIm + x);
+
+    if (c->hasThread) {
+        atomic_set(&c->posted, (int) n);
+        if (async_mutex_trylock(&c->mutex)) {
+            async_mutex_notify(&c->mutex);
+            async_mutex_unlock(&c->mutex);
+        }
+    }
+    memset(c->accRe, 0, sizeof(float) * bins);
+    memset(c->accIm, 0, sizeof(float) * bins);
+    int k;
+    for (k = 0; k < c->head; ++k) {
+        size_t xk = (size_t)((n - k) & c->fdlMask) * bins;
+        size_t h  = (size_t) k * bins;
+        multiplyAccumulate(bins, c->accRe, c->accIm, c->fdlRe + xk, c->fdlIm + xk, 
+                                                     c->irRe  + h,  c->irIm  + h);
+    }
+    if (c->hasThread) {
+        unsigned int slot = n & c->tailMask;
+        if (atomic_get(&c->tailTags[slot]) == (int) n) {
+            const float* re = c->tailRe + (size_t) slot * bins;
+            const float* im = c->tailIm + (size_t) slot * bins;
+            int i;
+            for (i = 0; i < bins; ++i) {
+                c->accRe[i] += re[i];
+                c->accIm[i] += im[i];
+            }
+        } else {
+            atomic_inc(&c->late);
+        }
+    }
+    realIfft(c->fft, c->accRe, c->accIm, c->output);
+    
+    /* overlap-save: the first half is circular aliasing */
+    memcpy(out, c->output + block, sizeof(float) * block);
+    c->blockIndex = n + 1;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
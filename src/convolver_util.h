@@ -0,0 +1,108 @@
+#ifndef LUAJACK_CONVOLVER_UTIL_H
+#define LUAJACK_CONVOLVER_UTIL_H
+
+#include "util.h"
+#include "fft_util.h"
+
+/////////////////////////////////////////////////////////////////////////////////
+
+/* Uniformly partitioned overlap-save convolution with partition size equal 
+ * to the process block size, so the convolver adds no latency beyond the 
+ * JACK period. The input spectra are kept in a frequency domain delay line.
+ * The process context multiplies the first 'head' partitions, the worker 
+ * thread precomputes the sum of all later partitions for the block that is 
+ * 'head' blocks ahead. */
+
+typedef struct {
+    AtomicCounter        refCounter;
+    int                  block;          /* partition size = process block size */
+    int                  bins;           /* block + 1 */
+    int                  partitions;
+    int                  head;           /* partitions computed in process context */
+
+    float*               irRe;           /* partitions * bins */
+    float*               irIm;
+
+    /* frequency domain delay line of input spectra, written by the process 
+     * context, the worker reads spectra that are at least head blocks old */
+    float*               fdlRe;          /* (fdlMask + 1) * bins */
+    float*               fdlIm;
+    unsigned int         fdlMask;
+    AtomicCounter        posted;         /* index of the newest input spectrum */
+
+    /* tail sums computed by the worker, tailTags[i] is the block index the 
+     * tail in slot i belongs to */
+    float*               tailRe;         /* (tailMask + 1) * bins */
+    float*               tailIm;
+    unsigned int         tailMask;
+    AtomicCounter*       tailTags;
+
+    /* process context state */
+    JackFft*             fft;
+    unsigned int         blockIndex;
+    float*               input;          /* 2 * block */
+    float*               output;         /* 2 * block */
+    float*               accRe;
+    float*               accIm;
+    AtomicCounter        late;
+    AtomicCounter        mismatches;
+
+    /* worker state */
+    Thread               thread;
+    bool                 hasThread;
+    Mutex                mutex;
+    bool                 hasMutex;
+    volatile bool        stopped;
+    int                  pollMillis;
+    unsigned int         nextTail;
+}
+JackConvolverShared;
+
+typedef struct {
+    JackConvolverShared* shared;
+    bool                 isInProcessContext;
+}
+JackConvolver;
+
+static inline JackConvolver* getCheckedConvolver(lua_State* L, int stackIndex)
+{
+    JackConvolver* convolver = (JackConvolver*) checkudata(L, stackIndex, CONVOLVER_TYPE, CONVOLVER_TYPE_NAME);
+    return convolver;
+}
+
+static inline JackConvolver* getOptionalConvolver(lua_State* L, int stackIndex)
+{
+    JackConvolver* convolver = (JackConvolver*) testudata(L, stackIndex, CONVOLVER_TYPE, CONVOLVER_TYPE_NAME);
+    return convolver;
+}
+
+/////////////////////////////////////////////////////////////////////////////////
+
+/* Computes the partition spectra of the impulse response and starts the 
+ * worker thread. Must not be called from the process context. */
+
+#define createConvolver luajack_createConvolver 
+
+JackConvolverShared* createConvolver(const float* ir, int irLength, float gain, 
+                                     int block, int head, float sampleRate);
+
+#define releaseConvolver luajack_releaseConvolver 
+
+void releaseConvolver(JackConvolverShared* convolver);
+
+#define transferConvolver luajack_transferConvolver 
+
+void transferConvolver(lua_State* T, JackConvolverShared* convolver);
+
+/* Convolves one block, in and out may be the same buffer. If nframes 
+ * differs from the partition size the output is silent and a mismatch is 
+ * counted. */
+
+#define processConvolver luajack_processConvolver 
+
+void processConvolver(JackConvolverShared* convolver, const float* in, float* out, 
+                      jack_nframes_t nframes);
+
+/////////////////////////////////////////////////////////////////////////////////
+
+#endif // LUAJACK_CONVOLVER_UTIL_H
@@ -0,0 +1,99 @@
+#include "util.h"
+#include "ffi.h"
+#include "luajack_ffi.h"
+#include "rbuf_util.h"
+
+int luajack_ffi_abi_version(void)
+{
+    return LUAJACK_FFI_ABI_VERSION;
+}
+
+float* luajack_ffi_port_buffer(luajack_ffi_port* port, uint32_t* nframes)
+{
+    jack_nframes_t n;
+    float* buffer = getSharedPortBuffer((JackPortShared*) port, &n);
+    *nframes = n;
+    return buffer;
+}
+
+int luajack_ffi_ringbuffer_write(jack_ringbuffer_t* rbuf, int32_t tag, const void* data, uint32_t len)
+{
+    return writeRbufMessage(rbuf, tag, (const char*) data, len) ? 1 : 0;
+}
+
+int luajack_ffi_ringbuffer_read(jack_ringbuffer_t* rbuf, int32_t* tag, void* data, uint32_t* len)
+{
+    return readRbufMessage(rbuf, tag, (char*) data, len);
+}
+
+void luajack_ffi_clear(float* dst, uint32_t nframes)
+{
+    memset(dst, 0, sizeof(float) * nframes);
+}
+
+void luajack_ffi_copy(float* dst, const float* src, uint32_t nframes)
+{
+    memmove(dst, src, sizeof(float) * nframes);
+}
+
+void luajack_ffi_mix(float* dst, const float* src, float gain, uint32_t nframes)
+{
+    uint32_t i;
+    for (i = 0; i < nframes; ++i) {
+        dst[i] += gain * src[i];
+    }
+}
+
+void luajack_ffi_scale(float* dst, float gain, uint32_t nframes)
+{
+    uint32_t i;
+    for (i = 0; i < nframes; ++i) {
+        dst[i] *= gain;
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+static int port_ffi_handle(lua_State* L)
+/* port:ffi_handle()
+ * returns a light userdata for luajack_ffi_port_buffer(), see luajack/ffi.lua.
+ */
+{
+    JackPort* port = getCheckedPort(L, 1);
+    if (!port->ptr || !port->shared) {
+        return luaL_argerror(L, 1, "port is unregistered");
+    }
+    lua_pushlightuserdata(L, port->shared);
+    return 1;
+}
+
+static int ffi_abi_version(lua_State* L)
+{
+    lua_pushinteger(L, LUAJACK_FFI_ABI_VERSION);
+    return 1;
+}
+
+static const struct luaL_Reg PortMethods[] = 
+{
+    { "ffi_handle",       port_ffi_handle },
+    { NULL, NULL } /* sentinel */
+};
+
+static const struct luaL_Reg ModuleFunctions[] = 
+{
+    { "ffi_abi_version",  ffi_abi_version },
+    { NULL, NULL } /* sentinel */
+};
+
+bool luajack_open_ffi(lua_State* L, int module, int portMeta, int portClass)
+{
+    lua_pushvalue(L, module);
+        setfuncs(L, ModuleFunctions);
+
+        lua_pushvalue(L, portClass);
+            setfuncs(L, PortMethods);
+
+    lua_pop(L, 2);
+    
+    return true;
+}
@@ -0,0 +1,6 @@
+#ifndef LUAJACK_FFI_H
+#define LUAJACK_FFI_H
+
+bool luajack_open_ffi(lua_State* L, int module, int portMeta, int portClass);
+
+#endif // LUAJACK_FFI_H
@@ -0,0 +1,170 @@
+#include <stdlib.h>
+#include <math.h>
+
+#include "fft_util.h"
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+JackFft* createFft(int size)
+{
+    if (size < 4 || (size & (size - 1)) != 0) {
+        return NULL;
+    }
+    JackFft* fft = (JackFft*) calloc(1, sizeof(JackFft));
+    if (!fft) {
+        return NULL;
+    }
+    int half = size / 2;
+    fft->size    = size;
+    fft->half    = half;
+    fft->bitrev  = (int*)   malloc(sizeof(int)   * half);
+    fft->twiddle = (float*) malloc(sizeof(float) * half);
+    fft->post    = (float*) malloc(sizeof(float) * half);
+    fft->work    = (float*) malloc(sizeof(float) * size);
+    if (!fft->bitrev || !fft->twiddle || !fft->post || !fft->work) {
+        releaseFft(fft);
+        return NULL;
+    }
+    int bits = 0;
+    while ((1 << bits) < half) {
+        ++bits;
+    }
+    int i, b;
+    for (i = 0; i < half; ++i) {
+        int r = 0;
+        for (b = 0; b < bits; ++b) {
+            r |= ((i >> b) & 1) << (bits - 1 - b);
+        }
+        fft->bitrev[i] = r;
+    }
+    for (i = 0; i < half / 2; ++i) {
+        double a = -2.0 * M_PI * i / half;
+        fft->twiddle[2*i]     = (float) cos(a);
+        fft->twiddle[2*i + 1] = (float) sin(a);
+        a = -2.0 * M_PI * i / size;
+        fft->post[2*i]        = (float) cos(a);
+        fft->post[2*i + 1]    = (float) sin(a);
+    }
+    return fft;
+}
+
+void releaseFft(JackFft* fft)
+{
+    if (fft) {
+        free(fft->bitrev);
+        free(fft->twiddle);
+        free(fft->post);
+        free(fft->work);
+        free(fft);
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+/* iterative radix-2 decimation in time on interleaved data, the butterflies
+ * of each stage run over contiguous memory */
+
+static void complexFft(JackFft* fft, float* z)
+{
+    const int n = fft->half;
+    int len, i, k;
+    for (len = 2; len <= n; len <<= 1) {
+        int step = n / len;
+        int h    = len / 2;
+        for (i = 0; i < n; i += len) {
+            float* a = z + 2*i;
+            float* b = a + 2*h;
+            for (k = 0; k < h; ++k) {
+                float wr = fft->twiddle[2*k*step];
+                float wi = fft->twiddle[2*k*step + 1];
+                float br = b[2*k] * wr - b[2*k + 1] * wi;
+                float bi = b[2*k] * wi + b[2*k + 1] * wr;
+                b[2*k]     = a[2*k]     - br;
+                b[2*k + 1] = a[2*k + 1] - bi;
+                a[2*k]     += br;
+                a[2*k + 1] += bi;
+            }
+        }
+    }
+}
+
+void realFft(JackFft* fft, const float* in, float* re, float* im)
+{
+    const int n = fft->half;
+    float*    z = fft->work;
+    int k;
+    for (k = 0; k < n; ++k) {
+        int r = fft->bitrev[k];
+        z[2*r]     = in[2*k];
+        z[2*r + 1] = in[2*k + 1];
+    }
+    complexFft(fft, z);
+
+    /* split the spectra of even and odd samples:
+     * X[k] = E[k] + W^k O[k] with E = (Z[k] + conj(Z[n-k])) / 2 
+     *                          and O = (Z[k] - conj(Z[n-k])) / 2i */
+    re[0] = z[0] + z[1];
+    im[0] = 0;
+    re[n] = z[0] - z[1];
+    im[n] = 0;
+    for (k = 1; k < n; ++k) {
+        float zr = z[2*k],       zi = z[2*k + 1];
+        float cr = z[2*(n - k)], ci = -z[2*(n - k) + 1];
+        float er = 0.5f * (zr + cr);
+        float ei = 0.5f * (zi + ci);
+        float pr = 0.5f * (zi - ci);
+        float pi = 0.5f * (cr - zr);
+        float wr, wi;
+        if (k < n / 2) {
+            wr = fft->post[2*k];
+            wi = fft->post[2*k + 1];
+        } else {
+            /* W^k = -i * W^(k - n/2) */
+            wr =  fft->post[2*(k - n/2) + 1];
+            wi = -fft->post[2*(k - n/2)];
+        }
+        re[k] = er + pr * wr - pi * wi;
+        im[k] = ei + pr * wi + pi * wr;
+    }
+}
+
+void realIfft(JackFft* fft, const float* re, const float* im, float* out)
+{
+    const int n = fft->half;
+    float*    z = fft->work;
+    int k;
+
+    /* merge into the spectrum of z = even + i * odd, conjugated so that the
+     * forward transform computes the inverse:
+     * E[k] = (X[k] + conj(X[n-k])) / 2, O[k] = (X[k] - conj(X[n-k])) * conj(W^k) / 2 */
+    for (k = 0; k < n; ++k) {
+        float xr = re[k],     xi = im[k];
+        float cr = re[n - k], ci = -im[n - k];
+        float er = 0.5f * (xr + cr);
+        float ei = 0.5f * (xi + ci);
+        float dr = 0.5f * (xr - cr);
+        float di = 0.5f * (xi - ci);
+        float wr, wi;
+        if (k < n / 2) {
+            wr = fft->post[2*k];
+            wi = fft->post[2*k + 1];
+        } else {
+            wr =  fft->post[2*(k - n/2) + 1];
+            wi = -fft->post[2*(k - n/2)];
+        }
+        float pr = dr * wr + di * wi;
+        float pi = di * wr - dr * wi;
+        int   r  = fft->bitrev[k];
+        z[2*r]     =   er - pi;
+        z[2*r + 1] = -(ei + pr);
+    }
+    complexFft(fft, z);
+
+    float scale = 1.0f / n;
+    for (k = 0; k < n; ++k) {
+        out[2*k]     =  z[2*k]     * scale;
+        out[2*k + 1] = -z[2*k + 1] * scale;
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,44 @@
+#ifndef LUAJACK_FFT_UTIL_H
+#define LUAJACK_FFT_UTIL_H
+
+/////////////////////////////////////////////////////////////////////////////////
+
+/* Real FFT of size n (power of two), computed as complex FFT of size n/2 
+ * with the even samples as real and the odd samples as imaginary part. 
+ * All tables are computed once in createFft, transforming does not 
+ * allocate. */
+
+typedef struct {
+    int     size;       /* real input size n */
+    int     half;       /* complex size n/2 */
+    int*    bitrev;     /* half entries */
+    float*  twiddle;    /* half/2 complex roots of size half, interleaved re/im */
+    float*  post;       /* half/2 complex roots of size n, interleaved re/im */
+    float*  work;       /* half complex values, interleaved re/im */
+}
+JackFft;
+
+#define createFft luajack_createFft
+
+JackFft* createFft(int size);
+
+#define releaseFft luajack_releaseFft
+
+void releaseFft(JackFft* fft);
+
+/* Transforms size real samples into size/2 + 1 complex bins */
+
+#define realFft luajack_realFft
+
+void realFft(JackFft* fft, const float* in, float* re, float* im);
+
+/* Inverse of realFft including the 1/size scaling, re and im are not 
+ * modified */
+
+#define realIfft luajack_realIfft
+
+void realIfft(JackFft* fft, const float* re, const float* im, float* out);
+
+/////////////////////////////////////////////////////////////////////////////////
+
+#endif // LUAJACK_FFT_UTIL_H
@@ -0,0 +1,346 @@
+#include "util.h"
+#include "group.h"
+#include "group_util.h"
+#include "port_util.h"
+#include "rbuf_util.h"
+#include "convert_util.h"
+
+/* bytes converted at once on the stack in the process callback */
+#define GROUP_BLOCK_BYTES 8192
+
+static int group_new(lua_State* L)
+/* group = jack.port_group(ports)
+ * creates a group of the audio ports in the array ports, which must all
+ * belong to the same client. The group operations work on all ports with one
+ * call, the buffers of the ports are looked up only once per cycle. Groups
+ * cannot be passed to the process context, create them in the process chunk
+ * from the transferred ports.
+ */
+{
+    luaL_checktype(L, 1, LUA_TTABLE);
+    int count = (int) luaL_len(L, 1);
+    luaL_argcheck(L, count >= 1 && count <= PORT_GROUP_MAX_PORTS, 1, "invalid number of ports");
+
+    JackPortGroup* group = (JackPortGroup*) lua_newuserdata(L, sizeof(JackPortGroup));
+    memset(group, 0, sizeof(JackPortGroup));
+    luaL_setmetatable(L, PORT_GROUP_TYPE_NAME);
+
+    group->ports   = (JackPortShared**) calloc(count, sizeof(JackPortShared*));
+    group->buffers = (jack_default_audio_sample_t**) calloc(count, sizeof(jack_default_audio_sample_t*));
+    if (!group->ports || !group->buffers) {
+        return luaL_error(L, "out of memory");
+    }
+    int i;
+    for (i = 0; i < count; ++i) {
+        lua_rawgeti(L, 1, i + 1);
+        JackPort* port = getOptionalPort(L, -1);
+        if (!port || !port->ptr) {
+            return luaL_error(L, "invalid port at index %d", i + 1);
+        }
+        if (strcmp(jack_port_type(port->ptr), JACK_DEFAULT_AUDIO_TYPE) != 0) {
+            return luaL_error(L, "port at index %d is not an audio port", i + 1);
+        }
+        if (group->client && port->shared->client != group->client) {
+            return luaL_error(L, "port at index %d belongs to another client", i + 1);
+        }
+        group->client = port->shared->client;
+        group->ports[group->count++] = port->shared;
+        atomic_inc(&port->shared->refCounter);
+        lua_pop(L, 1);
+    }
+    group->dither = (uint32_t)(size_t) group;
+    return 1;
+}
+
+static int group_release(lua_State* L)
+{
+    JackPortGroup* group = getCheckedPortGroup(L, 1);
+    int i;
+    for (i = 0; i < group->count; ++i) {
+        releasePort(group->ports[i]);
+    }
+    free(group->ports);
+    free(group->buffers);
+    group->ports   = NULL;
+    group->buffers = NULL;
+    group->count   = 0;
+    group->client  = NULL;
+    return 0;
+}
+
+static int group_toString(lua_State* L)
+{
+    JackPortGroup* group = getCheckedPortGroup(L, 1);
+    lua_pushfstring(L, "%s: %p", PORT_GROUP_TYPE_NAME, group);
+    return 1;
+}
+
+static int group_len(lua_State* L)
+/* n = group:len() or #group
+ */
+{
+    JackPortGroup* group = getCheckedPortGroup(L, 1);
+    lua_pushinteger(L, group->count);
+    return 1;
+}
+
+static int group_clear(lua_State* L)
+/* group:clear()
+ * clears the buffers of all ports.
+ */
+{
+    JackPortGroup* group = getCheckedPortGroup(L, 1);
+    jack_nframes_t offset, nframes;
+    jack_default_audio_sample_t** buffers = getPortGroupBuffers(group, &offset, &nframes);
+    if (buffers) {
+        int i;
+        for (i = 0; i < group->count; ++i) {
+            if (buffers[i]) {
+                memset(buffers[i] + offset, 0, sizeof(jack_default_audio_sample_t) * nframes);
+            }
+        }
+    }
+    return 0;
+}
+
+static int group_copy(lua_State* L)
+/* group:copy_from(src)
+ * copies the buffers of the group src with the same number of ports
+ * channel by channel.
+ */
+{
+    JackPortGroup* group = getCheckedPortGroup(L, 1);
+    JackPortGroup* src   = getCheckedPortGroup(L, 2);
+    luaL_argcheck(L, src->count == group->count, 2, "groups differ in number of ports");
+
+    jack_nframes_t offset = 0, nframes, srcOffset = 0, srcNframes;
+    jack_default_audio_sample_t** out = getPortGroupBuffers(group, &offset, &nframes);
+    jack_default_audio_sample_t** in  = getPortGroupBuffers(src, &srcOffset, &srcNframes);
+    if (out && in) {
+        if (srcNframes < nframes) {
+            nframes = srcNframes;
+        }
+        int i;
+        for (i = 0; i < group->count; ++i) {
+            if (out[i] && in[i]) {
+                memmove(out[i] + offset, in[i] + srcOffset, sizeof(jack_default_audio_sample_t) * nframes);
+            }
+        }
+    }
+    return 0;
+}
+
+static int group_gain(lua_State* L)
+/* group:gain(g)
+ * multiplies the buffers of all ports by g.
+ */
+{
+    JackPortGroup*              group = getCheckedPortGroup(L, 1);
+    jack_default_audio_sample_t gain  = (jack_default_audio_sample_t) luaL_checknumber(L, 2);
+
+    jack_nframes_t offset, nframes;
+    jack_default_audio_sample_t** buffers = getPortGroupBuffers(group, &offset, &nframes);
+    if (buffers) {
+        int i;
+        for (i = 0; i < group->count; ++i) {
+            jack_default_audio_sample_t* out = buffers[i];
+            if (out) {
+                out += offset;
+                jack_nframes_t j;
+                for (j = 0; j < nframes; ++j) {
+                    out[j] *= gain;
+                }
+            }
+        }
+    }
+    return 0;
+}
+
+static int group_sum(lua_State* L)
+/* group:sum_into(dst [, gain])
+ * sets the port or scratch buffer dst to the sum of the buffers of all
+ * ports multiplied by gain (default 1.0). dst may be a port of the group.
+ * At most the length of dst is summed.
+ */
+{
+    JackPortGroup*              group = getCheckedPortGroup(L, 1);
+    jack_nframes_t              dstNframes;
+    jack_default_audio_sample_t* dst  = getCheckedSignalBuffer(L, 2, &dstNframes);
+    jack_default_audio_sample_t gain  = (jack_default_audio_sample_t) luaL_optnumber(L, 3, 1.0);
+
+    jack_nframes_t offset = 0, nframes;
+    jack_default_audio_sample_t** buffers = getPortGroupBuffers(group, &offset, &nframes);
+    if (dst && buffers) {
+        if (dstNframes < nframes) {
+            nframes = dstNframes;
+        }
+        int i, member = -1;
+        for (i = 0; i < group->count; ++i) {
+            if (buffers[i] && buffers[i] + offset == dst) {
+                member = i;
+            }
+        }
+        if (member < 0) {
+            memset(dst, 0, sizeof(jack_default_audio_sample_t) * nframes);
+        }
+        for (i = 0; i < group->count; ++i) {
+            const jack_default_audio_sample_t* in = buffers[i];
+            if (in && i != member) {
+                in += offset;
+                jack_nframes_t j;
+                for (j = 0; j < nframes; ++j) {
+                    dst[j] += in[j];
+                }
+            }
+        }
+        if (gain != 1.0f) {
+            jack_nframes_t j;
+            for (j = 0; j < nframes; ++j) {
+                dst[j] *= gain;
+            }
+        }
+    }
+    return 0;
+}
+
+static int group_write_interleaved(lua_State* L)
+/* ok = group:write_interleaved(rbuf, tag, format [, dither])
+ * writes the current block of all ports as one ringbuffer message with the
+ * given tag. The data are the interleaved samples in format "float32",
+ * "int16", "int24" or "int32" (little endian), with TPDF dither if dither is
+ * true. Returns false if the ringbuffer has not enough space.
+ */
+{
+    JackPortGroup*   group  = getCheckedPortGroup(L, 1);
+    JackRbuf*        rbuf   = getCheckedRbuf(L, 2);
+    int32_t          tag    = (int32_t) luaL_checkinteger(L, 3);
+    JackSampleFormat format = checkSampleFormat(L, 4);
+    uint32_t*        dither = lua_toboolean(L, 5) ? &group->dither : NULL;
+
+    size_t frameBytes = (size_t) group->count * sampleFormatBytes(format);
+    luaL_argcheck(L, frameBytes <= GROUP_BLOCK_BYTES, 1, "too many ports for interleaving");
+
+    jack_nframes_t offset, nframes;
+    jack_default_audio_sample_t** buffers = getPortGroupBuffers(group, &offset, &nframes);
+    if (!buffers) {
+        lua_pushboolean(L, false);
+        return 1;
+    }
+    if (!writeRbufHeader(rbuf->ptr, tag, (uint32_t)(frameBytes * nframes))) {
+        lua_pushboolean(L, false);
+        return 1;
+    }
+    unsigned char  block[GROUP_BLOCK_BYTES];
+    jack_nframes_t blockFrames = (jack_nframes_t)(GROUP_BLOCK_BYTES / frameBytes);
+    jack_nframes_t pos;
+    for (pos = 0; pos < nframes; pos += blockFrames) {
+        jack_nframes_t n = (nframes - pos < blockFrames) ? nframes - pos : blockFrames;
+        int i;
+        for (i = 0; i < group->count; ++i) {
+            unsigned char* out = block + (size_t) i * sampleFormatBytes(format);
+            if (buffers[i]) {
+                encodeSamples(buffers[i] + offset + pos, 1, out, group->count, format, n, dither);
+            } else {
+                float zero = 0.0f;
+                encodeSamples(&zero, 0, out, group->count, format, n, NULL);
+            }
+        }
+        jack_ringbuffer_write(rbuf->ptr, (const char*) block, frameBytes * n);
+    }
+    lua_pushboolean(L, true);
+    return 1;
+}
+
+static int group_read_interleaved(lua_State* L)
+/* tag, frames = group:read_interleaved(rbuf, format)
+ * reads one ringbuffer message of interleaved samples in format "float32",
+ * "int16", "int24" or "int32" (little endian) into the current block of all
+ * ports. Frames missing in the message are cleared, surplus frames are 
+ * skipped. Returns the tag and the number of frames taken from the message
+ * or nil if there is no message.
+ */
+{
+    JackPortGroup*   group  = getCheckedPortGroup(L, 1);
+    JackRbuf*        rbuf   = getCheckedRbuf(L, 2);
+    JackSampleFormat format = checkSampleFormat(L, 3);
+
+    size_t frameBytes = (size_t) group->count * sampleFormatBytes(format);
+    luaL_argcheck(L, frameBytes <= GROUP_BLOCK_BYTES, 1, "too many ports for interleaving");
+
+    jack_nframes_t offset, nframes;
+    jack_default_audio_sample_t** buffers = getPortGroupBuffers(group, &offset, &nframes);
+    int32_t  tag;
+    uint32_t len;
+    if (!buffers || !readRbufHeader(rbuf->ptr, &tag, &len)) {
+        return 0;
+    }
+    jack_nframes_t frames = (jack_nframes_t)(len / frameBytes);
+    if (frames > nframes) {
+        frames = nframes;
+    }
+    unsigned char  block[GROUP_BLOCK_BYTES];
+    jack_nframes_t blockFrames = (jack_nframes_t)(GROUP_BLOCK_BYTES / frameBytes);
+    jack_nframes_t pos;
+    int i;
+    for (pos = 0; pos < frames; pos += blockFrames) {
+        jack_nframes_t n = (frames - pos < blockFrames) ? frames - pos : blockFrames;
+        jack_ringbuffer_read(rbuf->ptr, (char*) block, frameBytes * n);
+        for (i = 0; i < group->count; ++i) {
+            if (buffers[i]) {
+                decodeSamples(block + (size_t) i * sampleFormatBytes(format), group->count, format,
+                              buffers[i] + offset + pos, 1, n);
+            }
+        }
+    }
+    jack_ringbuffer_read_advance(rbuf->ptr, len - frameBytes * frames);
+    for (i = 0; i < group->count; ++i) {
+        if (buffers[i] && frames < nframes) {
+            memset(buffers[i] + offset + frames, 0, sizeof(jack_default_audio_sample_t) * (nframes - frames));
+        }
+    }
+    lua_pushinteger(L, tag);
+    lua_pushinteger(L, frames);
+    return 2;
+}
+
+static const struct luaL_Reg PortGroupMetaMethods[] =
+{
+    { "__tostring", group_toString },
+    { "__gc",       group_release },
+    { "__len",      group_len },
+    { NULL, NULL } /* sentinel */
+};
+
+static const struct luaL_Reg PortGroupMethods[] =
+{
+    { "len",        group_len },
+    { "clear",      group_clear },
+    { "copy_from",  group_copy },
+    { "gain",       group_gain },
+    { "sum_into",   group_sum },
+    { "write_interleaved", group_write_interleaved },
+    { "read_interleaved",  group_read_interleaved },
+    { NULL, NULL } /* sentinel */
+};
+
+static const struct luaL_Reg ModuleFunctions[] =
+{
+    { "port_group", group_new },
+    { NULL, NULL } /* sentinel */
+};
+
+bool luajack_open_group(lua_State* L, int module, int groupMeta, int groupClass)
+{
+    lua_pushvalue(L, module);
+        setfuncs(L, ModuleFunctions);
+
+        lua_pushvalue(L, groupMeta);
+            setfuncs(L, PortGroupMetaMethods);
+
+            lua_pushvalue(L, groupClass);
+                setfuncs(L, PortGroupMethods);
+
+    lua_pop(L, 3);
+
+    return true;
+}
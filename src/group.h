@@ -0,0 +1,6 @@
+#ifndef LUAJACK_GROUP_H
+#define LUAJACK_GROUP_H
+
+bool luajack_open_group(lua_State* L, int module, int groupMeta, int groupClass);
+
+#endif // LUAJACK_GROUP_H
@@ -0,0 +1,58 @@
+#ifndef LUAJACK_GROUP_UTIL_H
+#define LUAJACK_GROUP_UTIL_H
+
+#include "util.h"
+
+#define PORT_GROUP_MAX_PORTS 1024
+
+/////////////////////////////////////////////////////////////////////////////////
+
+/* Fixed list of audio ports of one client. The buffer pointers of all ports
+ * are fetched once per process cycle into a contiguous array, so that bulk
+ * operations on many channels need one Lua call instead of one per port. */
+
+typedef struct {
+    JackClientShared*             client;
+    int                           count;
+    unsigned long                 bufferCycle;   /* processCycle of buffers */
+    JackPortShared**              ports;
+    jack_default_audio_sample_t** buffers;       /* cycle buffers */
+    uint32_t                      dither;        /* random generator state */
+}
+JackPortGroup;
+
+static inline JackPortGroup* getCheckedPortGroup(lua_State* L, int stackIndex)
+{
+    JackPortGroup* group = (JackPortGroup*) checkudata(L, stackIndex, PORT_GROUP_TYPE, PORT_GROUP_TYPE_NAME);
+    return group;
+}
+
+/* Returns the buffer array of the group for the current process cycle and
+ * the offset and length of the current process block, or NULL if not called
+ * from within the process callback. Buffers of unregistered ports are NULL. */
+
+static inline jack_default_audio_sample_t** getPortGroupBuffers(JackPortGroup* group, jack_nframes_t* offset,
+                                                                                   jack_nframes_t* nframes)
+{
+    JackClientShared* client = group->client;
+    *offset  = 0;
+    *nframes = client ? client->currentProcessNframes : 0;
+    if (*nframes == 0) {
+        return NULL;
+    }
+    if (group->bufferCycle != client->processCycle) {
+        int i;
+        for (i = 0; i < group->count; ++i) {
+            JackPortShared* port = group->ports[i];
+            group->buffers[i] = port->ptr ? getSharedPortCycleBuffer(port, client->currentCycleNframes) 
+                                          : NULL;
+        }
+        group->bufferCycle = client->processCycle;
+    }
+    *offset = client->currentProcessOffset;
+    return group->buffers;
+}
+
+/////////////////////////////////////////////////////////////////////////////////
+
+#endif // LUAJACK_GROUP_UTIL_H
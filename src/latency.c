@@ -0,0 +1,258 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "util.h"
+#include "latency.h"
+#include "latency_util.h"
+#include "port_util.h"
+
+static int port_get_latency_range(lua_State* L)
+/* min, max = port:get_latency_range("capture" | "playback") */
+{
+    JackPort* port = getCheckedPort(L, 1);
+    jack_latency_callback_mode_t mode = getLatencyMode(L, 2);
+    jack_latency_range_t range;
+    jack_port_get_latency_range(port->ptr, mode, &range);
+    lua_pushinteger(L, range.min);
+    lua_pushinteger(L, range.max);
+    return 2;
+}
+
+static int port_set_latency_range(lua_State* L)
+/* port:set_latency_range("capture" | "playback", min [, max]) */
+{
+    JackPort* port = getCheckedPort(L, 1);
+    jack_latency_callback_mode_t mode = getLatencyMode(L, 2);
+    jack_latency_range_t range;
+    range.min = (jack_nframes_t) luaL_checkinteger(L, 3);
+    range.max = (jack_nframes_t) luaL_optinteger(L, 4, range.min);
+    jack_port_set_latency_range(port->ptr, mode, &range);
+    return 0;
+}
+
+static int latency_callback(lua_State* L)
+/* client:latency_callback(frames)
+ * installs a native latency callback that reports the latency ranges of all
+ * input ports plus 'frames' on all output ports of the client (and the other 
+ * way round for playback latency). Must be called before the client is 
+ * activated, may be called again later to change the latency.
+ */
+{
+    JackClient*    client = getCheckedClient(L, 1);
+    lua_Integer    frames = luaL_checkinteger(L, 2);
+    
+    if (!client->isMaster) {
+        return luaL_argerror(L, 1, "method can only be called on master client object");
+    }
+    luaL_argcheck(L, frames >= 0, 2, "latency must not be negative");
+
+    client->shared->processLatency = (jack_nframes_t) frames;
+    
+    if (!client->shared->hasLatencyCallback) {
+        if (client->isActivated) {
+            return luaL_error(L, "latency callback must be set before client is activated");
+        }
+        if (jack_set_latency_callback(client->ptr, latencyCallback, client->shared) != 0) {
+            return luaL_error(L, "cannot set latency callback");
+        }
+        client->shared->hasLatencyCallback = true;
+    }
+    else {
+        jack_recompute_total_latencies(client->ptr);
+    }
+    return 0;
+}
+
+static int recompute_latencies(lua_State* L)
+{
+    JackClient* client = getCheckedClient(L, 1);
+    if (jack_recompute_total_latencies(client->ptr) != 0) {
+        return luaL_error(L, "cannot recompute total latencies");
+    }
+    return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////////
+
+static int probe_toString(lua_State* L)
+{
+    JackLatencyProbe* probe = getCheckedLatencyProbe(L, 1);
+    lua_pushfstring(L, "%s: %p", LATENCY_PROBE_TYPE_NAME, 
+                                 probe);
+    return 1;
+}
+
+static int probe_new(lua_State* L)
+/* probe = jack.latency_probe(out_port, in_port [, options])
+ * options: method      - "impulse" (default) or "mls"
+ *          order       - MLS order 8..16 (default 12), 
+ *                        the MLS length is 2^order - 1 frames
+ *          max_latency - maximal measured latency in frames (default 8192)
+ *          level       - amplitude of the test signal (default 0.5)
+ *          threshold   - minimal loop gain for a valid measurement (default 0.1)
+ * Measures the round trip latency from out_port to in_port. Must be created in
+ * the process context.
+ */
+{
+    static const char* const methodNames[] = { "impulse", "mls", NULL };
+
+    JackPort* outPort = getCheckedPort(L, 1);
+    JackPort* inPort  = getCheckedPort(L, 2);
+    int       method  = LATENCY_PROBE_IMPULSE;
+    int       order   = 12;
+    lua_Integer maxLatency = 8192;
+    lua_Number  level      = 0.5;
+    lua_Number  threshold  = 0.1;
+
+    if (!outPort->isInProcessContext || !inPort->isInProcessContext) {
+        return luaL_error(L, "latency probe can only be created in process context");
+    }
+    if (lua_istable(L, 3)) {
+        lua_getfield(L, 3, "method");
+        if (!lua_isnil(L, -1)) {
+            method = luaL_checkoption(L, -1, NULL, methodNames);
+        }
+        lua_getfield(L, 3, "order");
+        order = (int) luaL_optinteger(L, -1, order);
+        lua_getfield(L, 3, "max_latency");
+        maxLatency = luaL_optinteger(L, -1, maxLatency);
+        lua_getfield(L, 3, "level");
+        level = luaL_optnumber(L, -1, level);
+        lua_getfield(L, 3, "threshold");
+        threshold = luaL_optnumber(L, -1, threshold);
+        lua_pop(L, 5);
+    }
+    luaL_argcheck(L, 8 <= order && order <= 16, 3, "order must be in range 8..16");
+    luaL_argcheck(L, maxLatency > 0, 3, "invalid max_latency");
+
+    JackLatencyProbe* probe = (JackLatencyProbe*) lua_newuserdata(L, sizeof(JackLatencyProbe));
+    memset(probe, 0, sizeof(JackLatencyProbe));
+    luaL_setmetatable(L, LATENCY_PROBE_TYPE_NAME);
+
+    if (!initLatencyProbe(probe, (JackLatencyProbeMethod)method, order, 
+                          (jack_nframes_t)maxLatency, (float)level, (float)threshold)) {
+        return luaL_error(L, "cannot create latency probe");
+    }
+    probe->outPort = outPort->shared; atomic_inc(&outPort->shared->refCounter);
+    probe->inPort  = inPort->shared;  atomic_inc(&inPort->shared->refCounter);
+    return 1;
+}
+
+static int probe_release(lua_State* L)
+{
+    JackLatencyProbe* probe = getCheckedLatencyProbe(L, 1);
+    releaseLatencyProbe(probe);
+    releasePort(probe->outPort); probe->outPort = NULL;
+    releasePort(probe->inPort);  probe->inPort  = NULL;
+    return 0;
+}
+
+static int probe_start(lua_State* L)
+{
+    JackLatencyProbe* probe = getCheckedLatencyProbe(L, 1);
+    startLatencyProbe(probe);
+    return 0;
+}
+
+static int probe_process(lua_State* L)
+/* latency = probe:process()
+ * must be called in every process cycle while the probe is used, owns the
+ * output port. Returns the measured latency in frames (-1 if no signal was 
+ * detected) in the cycle the measurement is finished, otherwise nil.
+ */
+{
+    JackLatencyProbe* probe = getCheckedLatencyProbe(L, 1);
+
+    jack_nframes_t nframes;
+    float* out = getSharedPortBuffer(probe->outPort, &nframes);
+    float* in  = getSharedPortBuffer(probe->inPort,  &nframes);
+    
+    if (out && in && processLatencyProbe(probe, out, in, nframes)) {
+        lua_pushinteger(L, probe->result);
+        return 1;
+    }
+    return 0;
+}
+
+static int probe_result(lua_State* L)
+/* latency, gain = probe:result() */
+{
+    JackLatencyProbe* probe = getCheckedLatencyProbe(L, 1);
+    lua_pushinteger(L, probe->result);
+    lua_pushnumber(L, probe->bestValue);
+    return 2;
+}
+
+static int probe_is_running(lua_State* L)
+{
+    JackLatencyProbe* probe = getCheckedLatencyProbe(L, 1);
+    lua_pushboolean(L, probe->state != LATENCY_PROBE_IDLE);
+    return 1;
+}
+
+/////////////////////////////////////////////////////////////////////////////////
+
+static const struct luaL_Reg PortMethods[] = 
+{
+    { "get_latency_range",   port_get_latency_range },
+    { "set_latency_range",   port_set_latency_range },
+    { NULL, NULL } /* sentinel */
+};
+
+static const struct luaL_Reg ClientMethods[] = 
+{
+    { "latency_callback",    latency_callback },
+    { "recompute_latencies", recompute_latencies },
+    { NULL, NULL } /* sentinel */
+};
+
+static const struct luaL_Reg ProbeMetaMethods[] = 
+{
+    { "__tostring", probe_toString },
+    { "__gc",       probe_release },
+    { NULL, NULL } /* sentinel */
+};
+
+static const struct luaL_Reg ProbeMethods[] = 
+{
+    { "start",      probe_start },
+    { "process",    probe_process },
+    { "result",     probe_result },
+    { "is_running", probe_is_running },
+    { NULL, NULL } /* sentinel */
+};
+
+static const struct luaL_Reg ModuleFunctions[] = 
+{
+    { "port_get_latency_range", port_get_latency_range },
+    { "port_set_latency_range", port_set_latency_range },
+    { "latency_callback",       latency_callback },
+    { "recompute_latencies",    recompute_latencies },
+    { "latency_probe",          probe_new },
+    { NULL, NULL } /* sentinel */
+};
+
+bool luajack_open_latency(lua_State* L, int module, int clientMeta, int clientClass,
+                                                     int   portMeta, int   portClass,
+                                                     int  probeMeta, int  probeClass)
+{
+    lua_pushvalue(L, module);
+        setfuncs(L, ModuleFunctions);
+
+        lua_pushvalue(L, clientClass);
+            setfuncs(L, ClientMethods);
+    
+            lua_pushvalue(L, portClass);
+                setfuncs(L, PortMethods);
+        
+                lua_pushvalue(L, probeMeta);
+                    setfuncs(L, ProbeMetaMethods);
+        
+                    lua_pushvalue(L, probeClass);
+                        setfuncs(L, ProbeMethods);
+            
+    lua_pop(L, 5);
+    
+    return true;
+}
@@ -0,0 +1,8 @@
+#ifndef LUAJACK_LATENCY_H
+#define LUAJACK_LATENCY_H
+
+bool luajack_open_latency(lua_State* L, int module, int clientMeta, int clientClass,
+                                                     int   portMeta, int   portClass,
+                                                     int  probeMeta, int  probeClass);
+
+#endif // LUAJACK_LATENCY_H
@@ -0,0 +1,216 @@
+#include <stdlib.h>
+#include <math.h>
+
+#include "util.h"
+#include "latency_util.h"
+
+/* number of multiply-adds per process cycle while correlating the MLS recording */
+#define LATENCY_PROBE_CORRELATION_BUDGET 262144
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+jack_latency_callback_mode_t getLatencyMode(lua_State* L, int arg)
+{
+    static const char* const modeNames[] = { "capture", "playback", NULL };
+    int mode = luaL_checkoption(L, arg, NULL, modeNames);
+    return (mode == 0) ? JackCaptureLatency : JackPlaybackLatency;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+void latencyCallback(jack_latency_callback_mode_t mode, void* arg)
+{
+    JackClientShared* client = (JackClientShared*) arg;
+    if (!client->ptr) {
+        return;
+    }
+    /* capture latency flows from our inputs to our outputs, playback latency
+     * from our outputs to our inputs */
+    unsigned long sourceFlag = (mode == JackCaptureLatency) ? JackPortIsInput  : JackPortIsOutput;
+    unsigned long targetFlag = (mode == JackCaptureLatency) ? JackPortIsOutput : JackPortIsInput;
+
+    const char** names = jack_get_ports(client->ptr, NULL, NULL, 0);
+    if (!names) {
+        return;
+    }
+    jack_latency_range_t range = { 0, 0 };
+    bool hasSource = false;
+    int i;
+    for (i = 0; names[i]; ++i) {
+        jack_port_t* port = jack_port_by_name(client->ptr, names[i]);
+        if (port && jack_port_is_mine(client->ptr, port) && (jack_port_flags(port) & sourceFlag)) {
+            jack_latency_range_t r;
+            jack_port_get_latency_range(port, mode, &r);
+            if (!hasSource || r.min < range.min) range.min = r.min;
+            if (!hasSource || r.max > range.max) range.max = r.max;
+            hasSource = true;
+        }
+    }
+    range.min += client->processLatency;
+    range.max += client->processLatency;
+    for (i = 0; names[i]; ++i) {
+        jack_port_t* port = jack_port_by_name(client->ptr, names[i]);
+        if (port && jack_port_is_mine(client->ptr, port) && (jack_port_flags(port) & targetFlag)) {
+            jack_port_set_latency_range(port, mode, &range);
+        }
+    }
+    jack_free(names);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+/* feedback masks of maximal length Galois LFSRs for orders 8..16 */
+static const uint32_t MlsMasks[] = 
+{
+    0xB8, 0x110, 0x240, 0x500, 0xE08, 0x1C80, 0x3802, 0x6000, 0xD008
+};
+
+static void generateMls(float* signal, int order, float level)
+{
+    uint32_t mask   = MlsMasks[order - 8];
+    uint32_t lfsr   = 1;
+    jack_nframes_t length = (1u << order) - 1;
+    jack_nframes_t i;
+    for (i = 0; i < length; ++i) {
+        signal[i] = (lfsr & 1) ? level : -level;
+        lfsr = (lfsr >> 1) ^ ((lfsr & 1) ? mask : 0);
+    }
+}
+
+bool initLatencyProbe(JackLatencyProbe* probe, JackLatencyProbeMethod method, 
+                      int mlsOrder, jack_nframes_t maxLatency, float level, float threshold)
+{
+    probe->method       = method;
+    probe->level        = level;
+    probe->threshold    = threshold;
+    probe->state        = LATENCY_PROBE_IDLE;
+    probe->result       = -1;
+    probe->signalLength = (method == LATENCY_PROBE_MLS) ? (1u << mlsOrder) - 1 : 1;
+    probe->recordLength = probe->signalLength + maxLatency;
+    probe->lagsPerCycle = LATENCY_PROBE_CORRELATION_BUDGET / probe->signalLength;
+    if (probe->lagsPerCycle < 1) {
+        probe->lagsPerCycle = 1;
+    }
+    probe->signal    = (float*) malloc(sizeof(float) * probe->signalLength);
+    probe->recording = (float*) malloc(sizeof(float) * probe->recordLength);
+    if (!probe->signal || !probe->recording) {
+        return false;
+    }
+    if (method == LATENCY_PROBE_MLS) {
+        generateMls(probe->signal, mlsOrder, probe->level);
+    } else {
+        probe->signal[0] = probe->level;
+    }
+    return true;
+}
+
+void releaseLatencyProbe(JackLatencyProbe* probe)
+{
+    if (probe->signal)    free(probe->signal);
+    if (probe->recording) free(probe->recording);
+    probe->signal    = NULL;
+    probe->recording = NULL;
+}
+
+void startLatencyProbe(JackLatencyProbe* probe)
+{
+    probe->recordPos = 0;
+    probe->lagPos    = 0;
+    probe->bestValue = 0;
+    probe->bestLag   = 0;
+    probe->state     = LATENCY_PROBE_RECORDING;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+static void record(JackLatencyProbe* probe, float* out, const float* in, jack_nframes_t nframes)
+{
+    jack_nframes_t i;
+    for (i = 0; i < nframes; ++i) {
+        jack_nframes_t pos = probe->recordPos + i;
+        out[i] = (pos < probe->signalLength) ? probe->signal[pos] : 0;
+    }
+    jack_nframes_t n = probe->recordLength - probe->recordPos;
+    if (n > nframes) {
+        n = nframes;
+    }
+    memcpy(probe->recording + probe->recordPos, in, sizeof(float) * n);
+    probe->recordPos += n;
+    
+    if (probe->recordPos == probe->recordLength) {
+        probe->state = LATENCY_PROBE_ANALYZING;
+    }
+}
+
+static void analyzeImpulse(JackLatencyProbe* probe)
+{
+    jack_nframes_t i;
+    for (i = 0; i < probe->recordLength; ++i) {
+        double value = fabsf(probe->recording[i]);
+        if (value > probe->bestValue) {
+            probe->bestValue = value;
+            probe->bestLag   = i;
+        }
+    }
+    probe->bestValue /= probe->level;
+    probe->state = LATENCY_PROBE_DONE;
+}
+
+static void analyzeMls(JackLatencyProbe* probe)
+{
+    jack_nframes_t maxLag = probe->recordLength - probe->signalLength;
+    jack_nframes_t endLag = probe->lagPos + probe->lagsPerCycle;
+    if (endLag > maxLag + 1) {
+        endLag = maxLag + 1;
+    }
+    const float* signal = probe->signal;
+    jack_nframes_t lag;
+    for (lag = probe->lagPos; lag < endLag; ++lag) {
+        const float* rec = probe->recording + lag;
+        float sum = 0;
+        jack_nframes_t i;
+        for (i = 0; i < probe->signalLength; ++i) {
+            sum += signal[i] * rec[i];
+        }
+        if (fabsf(sum) > probe->bestValue) {
+            probe->bestValue = fabsf(sum);
+            probe->bestLag   = lag;
+        }
+    }
+    probe->lagPos = endLag;
+    if (endLag > maxLag) {
+        /* normalize to loop gain */
+        probe->bestValue /= (double)probe->signalLength * probe->level * probe->level;
+        probe->state = LATENCY_PROBE_DONE;
+    }
+}
+
+bool processLatencyProbe(JackLatencyProbe* probe, float* out, const float* in, jack_nframes_t nframes)
+{
+    switch (probe->state) {
+        case LATENCY_PROBE_RECORDING: {
+            record(probe, out, in, nframes);
+            return false;
+        }
+        case LATENCY_PROBE_ANALYZING: {
+            memset(out, 0, sizeof(float) * nframes);
+            if (probe->method == LATENCY_PROBE_MLS) {
+                analyzeMls(probe);
+            } else {
+                analyzeImpulse(probe);
+            }
+            if (probe->state == LATENCY_PROBE_DONE) {
+                probe->result = (probe->bestValue >= probe->threshold) ? (lua_Integer)probe->bestLag : -1;
+                probe->state  = LATENCY_PROBE_IDLE;
+                return true;
+            }
+            return false;
+        }
+        default: {
+            memset(out, 0, sizeof(float) * nframes);
+            return false;
+        }
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
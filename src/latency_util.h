@@ -0,0 +1,87 @@
+#ifndef LUAJACK_LATENCY_UTIL_H
+#define LUAJACK_LATENCY_UTIL_H
+
+#include "util.h"
+
+/////////////////////////////////////////////////////////////////////////////////
+
+#define getLatencyMode luajack_getLatencyMode 
+
+jack_latency_callback_mode_t getLatencyMode(lua_State* L, int arg);
+
+/////////////////////////////////////////////////////////////////////////////////
+
+/* Native JACK latency callback: propagates the latency ranges of the client's
+ * input ports to its output ports (capture) and vice versa (playback), adding
+ * client->processLatency. */
+
+#define latencyCallback luajack_latencyCallback 
+
+void latencyCallback(jack_latency_callback_mode_t mode, void* arg);
+
+/////////////////////////////////////////////////////////////////////////////////
+
+typedef enum {
+    LATENCY_PROBE_IMPULSE,
+    LATENCY_PROBE_MLS
+}
+JackLatencyProbeMethod;
+
+typedef enum {
+    LATENCY_PROBE_IDLE,
+    LATENCY_PROBE_RECORDING,
+    LATENCY_PROBE_ANALYZING,
+    LATENCY_PROBE_DONE
+}
+JackLatencyProbeState;
+
+typedef struct {
+    JackPortShared*        outPort;
+    JackPortShared*        inPort;
+    JackLatencyProbeMethod method;
+    JackLatencyProbeState  state;
+    float                  level;
+    float                  threshold;
+    float*                 signal;        /* emitted test signal */
+    jack_nframes_t         signalLength;
+    float*                 recording;     /* signalLength + maxLatency frames */
+    jack_nframes_t         recordLength;
+    jack_nframes_t         recordPos;
+    jack_nframes_t         lagPos;        /* next lag to correlate */
+    jack_nframes_t         lagsPerCycle;
+    double                 bestValue;
+    jack_nframes_t         bestLag;
+    lua_Integer            result;        /* latency in frames, -1 if no signal detected */
+}
+JackLatencyProbe;
+
+static inline JackLatencyProbe* getCheckedLatencyProbe(lua_State* L, int stackIndex)
+{
+    JackLatencyProbe* probe = (JackLatencyProbe*) checkudata(L, stackIndex, LATENCY_PROBE_TYPE, LATENCY_PROBE_TYPE_NAME);
+    return probe;
+}
+
+#define initLatencyProbe luajack_initLatencyProbe 
+
+bool initLatencyProbe(JackLatencyProbe* probe, JackLatencyProbeMethod method, 
+                      int mlsOrder, jack_nframes_t maxLatency, float level, float threshold);
+
+#define releaseLatencyProbe luajack_releaseLatencyProbe 
+
+void releaseLatencyProbe(JackLatencyProbe* probe);
+
+#define startLatencyProbe luajack_startLatencyProbe 
+
+void startLatencyProbe(JackLatencyProbe* probe);
+
+/* Processes one cycle: emits the test signal into out, records in and 
+ * correlates the recording piecewise. Returns true if the measurement has been 
+ * finished in this cycle. */
+
+#define processLatencyProbe luajack_processLatencyProbe 
+
+bool processLatencyProbe(JackLatencyProbe* probe, float* out, const float* in, jack_nframes_t nframes);
+
+/////////////////////////////////////////////////////////////////////////////////
+
+#endif // LUAJACK_LATENCY_UTIL_H
@@ -0,0 +1,49 @@
+#ifndef LUAJACK_LUAJACK_FFI_H
+#define LUAJACK_LUAJACK_FFI_H
+
+/* Plain C entry points for LuaJIT's FFI (see luajack/ffi.lua). 
+ *
+ * These functions do not touch any Lua state, so process chunks calling them
+ * through the FFI can be compiled by the JIT compiler. The declarations in
+ * luajack/ffi.lua must be kept in sync with this header, incompatible changes
+ * require a new LUAJACK_FFI_ABI_VERSION.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <jack/ringbuffer.h>
+
+#include "main.h"
+
+#define LUAJACK_FFI_ABI_VERSION 1
+
+/* Opaque port handle, see port:ffi_handle(). The handle is valid as long as
+ * the port object it was obtained from. */
+typedef struct luajack_ffi_port luajack_ffi_port;
+
+LUAJACK_EXPORT int luajack_ffi_abi_version(void);
+
+/* Returns the audio buffer of the port for the current process block and
+ * stores the block length in *nframes. Returns NULL and *nframes = 0 outside 
+ * of the process callback. */
+LUAJACK_EXPORT float* luajack_ffi_port_buffer(luajack_ffi_port* port, uint32_t* nframes);
+
+/* Ringbuffer messages in the format of jack.ringbuffer_write/read: write 
+ * returns 1 on success and 0 if there is not enough space. Read returns 0 if 
+ * there is no complete message, 1 on success and 2 if the message data is 
+ * larger than *len (the message is skipped). On input *len is the capacity
+ * of data, on output the length of the message data. */
+LUAJACK_EXPORT int luajack_ffi_ringbuffer_write(jack_ringbuffer_t* rbuf, int32_t tag, 
+                                                const void* data, uint32_t len);
+
+LUAJACK_EXPORT int luajack_ffi_ringbuffer_read(jack_ringbuffer_t* rbuf, int32_t* tag, 
+                                               void* data, uint32_t* len);
+
+/* Buffer operations on nframes samples */
+LUAJACK_EXPORT void luajack_ffi_clear(float* dst, uint32_t nframes);
+LUAJACK_EXPORT void luajack_ffi_copy (float* dst, const float* src, uint32_t nframes);
+LUAJACK_EXPORT void luajack_ffi_mix  (float* dst, const float* src, float gain, uint32_t nframes);
+LUAJACK_EXPORT void luajack_ffi_scale(float* dst, float gain, uint32_t nframes);
+
+#endif // LUAJACK_LUAJACK_FFI_H
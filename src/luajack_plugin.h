@@ -0,0 +1,58 @@
+#ifndef LUAJACK_PLUGIN_H
+#define LUAJACK_PLUGIN_H
+
+/* Interface of native DSP modules for client:process_native().
+ *
+ * A module is a shared library exporting the function luajack_plugin_entry(),
+ * which returns a pointer to a static luajack_plugin descriptor. All 
+ * callbacks except process() and set_param() are invoked from the main 
+ * thread while the client is not active. process() and set_param() are 
+ * invoked from the JACK process thread and must be realtime safe.
+ */
+
+#include <stdint.h>
+
+#if defined(_WIN32)
+    #define LUAJACK_PLUGIN_EXPORT __declspec(dllexport)
+#else
+    #define LUAJACK_PLUGIN_EXPORT __attribute__((visibility("default")))
+#endif
+
+#define LUAJACK_PLUGIN_API_VERSION 1
+
+typedef struct {
+    uint32_t            sample_rate;
+    uint32_t            max_nframes;   /* buffer size when the module is loaded */
+    uint32_t            n_inputs;
+    uint32_t            n_outputs;
+    uint32_t            n_options;     /* string options from the config table */
+    const char* const*  option_keys;
+    const char* const*  option_values;
+}
+luajack_plugin_config;
+
+typedef struct {
+    int                 api_version;   /* LUAJACK_PLUGIN_API_VERSION */
+    const char*         name;
+
+    /* NULL terminated list of parameter names, parameters are identified by 
+     * their index in this list */
+    const char* const*  param_names;
+
+    /* returns a new instance or NULL on error */
+    void*  (*init)     (const luajack_plugin_config* config);
+
+    /* inputs and outputs are the port buffers for the whole cycle */
+    void   (*process)  (void* instance, const float* const* inputs, float* const* outputs, uint32_t nframes);
+
+    void   (*set_param)(void* instance, uint32_t param, double value);
+
+    void   (*release)  (void* instance);
+}
+luajack_plugin;
+
+typedef const luajack_plugin* (*luajack_plugin_entry_function)(void);
+
+#define LUAJACK_PLUGIN_ENTRY "luajack_plugin_entry"
+
+#endif // LUAJACK_PLUGIN_H
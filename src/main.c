@@ -9,10 +9,49 @@
 #include "process.h"
 #include "thread.h"
 #include "buffer.h"
+#include "smoother.h"
+#include "scheduler.h"
+#include "timing.h"
+#include "latency.h"
+#include "notify.h"
+#include "scratch.h"
+#include "ffi.h"
+#include "native.h"
+#include "meter.h"
+#include "analyzer.h"
+#include "convolver.h"
+#include "oscillator.h"
+#include "profiler.h"
+#include "trace.h"
+#include "alloc.h"
+#include "recorder.h"
+#include "serialize.h"
+#include "array.h"
+#include "group.h"
+#include "convert.h"
+#include "router.h"
 #include "async_util.h"
 
 static AtomicCounter initFlag = 0;
 
+/* Number of entries of the module and client class tables, counted when the
+ * module is opened for the first time. The module is opened again for every
+ * process chunk, these tables are then created presized instead of being
+ * rehashed while the functions are registered. */
+static volatile int moduleSize      = 0;
+static volatile int clientClassSize = 0;
+
+static int countEntries(lua_State* L, int index)
+{
+    int count = 0;
+    lua_pushnil(L);
+    while (lua_next(L, index) != 0) {
+        lua_pop(L, 1);
+        ++count;
+    }
+    return count;
+}
+
 static int verbose(lua_State* L)
 {
     setVerbose(checkonoff(L, 1));
@@ -34,12 +73,16 @@ LUAJACK_EXPORT int luaopen_luajack(lua_State* L)
         jack_set_info_function(verbosePrint);  
     }
     
+    initCompat(L);
+
+    luaL_checkstack(L, 50, "cannot grow Lua stack");
+
     int n = lua_gettop(L);
     
-    int module     = ++n; lua_newtable(L);
+    int module     = ++n; lua_createtable(L, 0, moduleSize);
 
     int clientMeta = ++n; luaL_newmetatable(L, CLIENT_TYPE_NAME);
-    int clientClass= ++n; lua_newtable(L);
+    int clientClass= ++n; lua_createtable(L, 0, clientClassSize);
 
     int portMeta = ++n; luaL_newmetatable(L, PORT_TYPE_NAME);
     int portClass= ++n; lua_newtable(L);
@@ -50,8 +93,58 @@ LUAJACK_EXPORT int luaopen_luajack(lua_State* L)
     int threadMeta = ++n; luaL_newmetatable(L, THREAD_TYPE_NAME);
     int threadClass= ++n; lua_newtable(L);
 
+    int smootherMeta = ++n; luaL_newmetatable(L, SMOOTHER_TYPE_NAME);
+    int smootherClass= ++n; lua_newtable(L);
+
+    int schedulerMeta = ++n; luaL_newmetatable(L, SCHEDULER_TYPE_NAME);
+    int schedulerClass= ++n; lua_newtable(L);
+
+    int probeMeta = ++n; luaL_newmetatable(L, LATENCY_PROBE_TYPE_NAME);
+    int probeClass= ++n; lua_newtable(L);
+
+    int scratchMeta = ++n; luaL_newmetatable(L, SCRATCH_TYPE_NAME);
+    int scratchClass= ++n; lua_newtable(L);
+
+    int nativeMeta = ++n; luaL_newmetatable(L, NATIVE_TYPE_NAME);
+    int nativeClass= ++n; lua_newtable(L);
+
+    int meterMeta = ++n; luaL_newmetatable(L, METER_TYPE_NAME);
+    int meterClass= ++n; lua_newtable(L);
+
+    int analyzerMeta = ++n; luaL_newmetatable(L, ANALYZER_TYPE_NAME);
+    int analyzerClass= ++n; lua_newtable(L);
+
+    int convolverMeta = ++n; luaL_newmetatable(L, CONVOLVER_TYPE_NAME);
+    int convolverClass= ++n; lua_newtable(L);
+
+    int oscillatorMeta = ++n; luaL_newmetatable(L, OSCILLATOR_TYPE_NAME);
+    int oscillatorClass= ++n; lua_newtable(L);
+
+    int wavetableMeta = ++n; luaL_newmetatable(L, WAVETABLE_TYPE_NAME);
+    int wavetableClass= ++n; lua_newtable(L);
+
+    int profilerMeta = ++n; luaL_newmetatable(L, PROFILER_TYPE_NAME);
+    int profilerClass= ++n; lua_newtable(L);
+
+    int recorderMeta = ++n; luaL_newmetatable(L, RECORDER_TYPE_NAME);
+    int recorderClass= ++n; lua_newtable(L);
+
+    int arrayMeta = ++n; luaL_newmetatable(L, ARRAY_TYPE_NAME);
+    int arrayClass= ++n; lua_newtable(L);
+
+    int groupMeta = ++n; luaL_newmetatable(L, PORT_GROUP_TYPE_NAME);
+    int groupClass= ++n; lua_newtable(L);
+
+    int routerMeta = ++n; luaL_newmetatable(L, MIDI_ROUTER_TYPE_NAME);
+    int routerClass= ++n; lua_newtable(L);
+
+    int eventDataMeta = ++n; luaL_newmetatable(L, EVENT_DATA_TYPE_NAME);
+    int eventDataClass= ++n; lua_newtable(L);
+
+    initTypes(L);
+
     lua_pushvalue(L, module);
-        luaL_setfuncs(L, ModuleFunctions, 0);
+        setfuncs(L, ModuleFunctions);
     
         lua_pushvalue(L, clientClass);
         lua_setfield (L, clientMeta, "__index");
@@ -65,6 +158,54 @@ LUAJACK_EXPORT int luaopen_luajack(lua_State* L)
         lua_pushvalue(L, threadClass);
         lua_setfield (L, threadMeta, "__index");
 
+        lua_pushvalue(L, smootherClass);
+        lua_setfield (L, smootherMeta, "__index");
+
+        lua_pushvalue(L, schedulerClass);
+        lua_setfield (L, schedulerMeta, "__index");
+
+        lua_pushvalue(L, probeClass);
+        lua_setfield (L, probeMeta, "__index");
+
+        lua_pushvalue(L, scratchClass);
+        lua_setfield (L, scratchMeta, "__index");
+
+        lua_pushvalue(L, nativeClass);
+        lua_setfield (L, nativeMeta, "__index");
+
+        lua_pushvalue(L, meterClass);
+        lua_setfield (L, meterMeta, "__index");
+
+        lua_pushvalue(L, analyzerClass);
+        lua_setfield (L, analyzerMeta, "__index");
+
+        lua_pushvalue(L, convolverClass);
+        lua_setfield (L, convolverMeta, "__index");
+
+        lua_pushvalue(L, oscillatorClass);
+        lua_setfield (L, oscillatorMeta, "__index");
+
+        lua_pushvalue(L, wavetableClass);
+        lua_setfield (L, wavetableMeta, "__index");
+
+        lua_pushvalue(L, profilerClass);
+        lua_setfield (L, profilerMeta, "__index");
+
+        lua_pushvalue(L, recorderClass);
+        lua_setfield (L, recorderMeta, "__index");
+
+        lua_pushvalue(L, arrayClass);
+        lua_setfield (L, arrayMeta, "__index");
+
+        lua_pushvalue(L, groupClass);
+        lua_setfield (L, groupMeta, "__index");
+
+        lua_pushvalue(L, routerClass);
+        lua_setfield (L, routerMeta, "__index");
+
+        lua_pushvalue(L, eventDataClass);
+        lua_setfield (L, eventDataMeta, "__index");
+
     lua_pop(L, 1);
     
     lua_checkstack(L, LUA_MINSTACK);
@@ -83,8 +224,69 @@ LUAJACK_EXPORT int luaopen_luajack(lua_State* L)
                                      threadMeta, threadClass);
 
     luajack_open_buffer (L, module, clientMeta, clientClass,
-                                      portMeta,   portClass);
+                                      portMeta,   portClass,
+                                   scratchMeta, scratchClass);
     
+    luajack_open_smoother(L, module, clientMeta, clientClass,
+                                   smootherMeta, smootherClass);
+
+    luajack_open_scheduler(L, module, clientMeta, clientClass,
+                                   schedulerMeta, schedulerClass,
+                                   eventDataMeta, eventDataClass);
+
+    luajack_open_timing (L, module, clientMeta, clientClass);
+
+    luajack_open_latency(L, module, clientMeta, clientClass,
+                                      portMeta,   portClass,
+                                     probeMeta,  probeClass);
+
+    luajack_open_notify (L, module, clientMeta, clientClass);
+
+    luajack_open_scratch(L, module, clientMeta, clientClass,
+                                   scratchMeta, scratchClass);
+
+    luajack_open_ffi    (L, module, portMeta, portClass);
+
+    luajack_open_native (L, module, clientMeta, clientClass,
+                                    nativeMeta, nativeClass);
+
+    luajack_open_meter  (L, module, clientMeta, clientClass,
+                                     meterMeta,  meterClass);
+
+    luajack_open_analyzer(L, module, clientMeta, clientClass,
+                                   analyzerMeta, analyzerClass);
+
+    luajack_open_convolver(L, module, clientMeta, clientClass,
+                                   convolverMeta, convolverClass);
+
+    luajack_open_oscillator(L, module, clientMeta, clientClass,
+                                   oscillatorMeta, oscillatorClass,
+                                    wavetableMeta,  wavetableClass);
+
+    luajack_open_profiler(L, module, clientMeta, clientClass,
+                                   profilerMeta, profilerClass);
+
+    luajack_open_trace  (L, module, clientMeta, clientClass);
+    luajack_open_alloc  (L, module, clientMeta, clientClass);
+
+    luajack_open_recorder(L, module, clientMeta, clientClass,
+                                   recorderMeta, recorderClass);
+
+    luajack_open_serialize(L, module);
+
+    luajack_open_array  (L, module, arrayMeta, arrayClass);
+
+    luajack_open_group  (L, module, groupMeta, groupClass);
+
+    luajack_open_convert(L, module);
+
+    luajack_open_router (L, module, routerMeta, routerClass);
+
+    if (moduleSize == 0) {
+        moduleSize      = countEntries(L, module);
+        clientClassSize = countEntries(L, clientClass);
+    }
+
     lua_settop(L, module);
     return 1;
 }
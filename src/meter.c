@@ -0,0 +1,195 @@
+#include "util.h"
+#include "meter.h"
+#include "meter_util.h"
+#include "port_util.h"
+
+static int getCheckedChannel(lua_State* L, int arg, JackMeter* meter)
+{
+    lua_Integer channel = luaL_checkinteger(L, arg);
+    luaL_argcheck(L, channel >= 1 && channel <= meter->shared->nchannels, arg, "invalid channel");
+    return (int)(channel - 1);
+}
+
+static int meter_new(lua_State* L)
+/* meter = client:meter(nchannels [, options])
+ * creates a bank of peak/rms meters. The meter can be passed to the process
+ * context, ports are attached and measured there, the main context reads the
+ * values. Options:
+ *   hold      = seconds   peak hold time (default 1.0)
+ *   decay     = dB/s      fall back rate of peak and hold (default 20)
+ *   rms       = seconds   rms integration time (default 0.3)
+ *   true_peak = true      additionally measure 4x oversampled peaks
+ */
+{
+    JackClient* client    = getCheckedClient(L, 1);
+    lua_Integer nchannels = luaL_checkinteger(L, 2);
+    luaL_argcheck(L, nchannels >= 1 && nchannels <= 4096, 2, "invalid number of channels");
+
+    lua_Number hold  = getNumberOption(L, 3, "hold",  1.0);
+    lua_Number decay = getNumberOption(L, 3, "decay", 20.0);
+    lua_Number rms   = getNumberOption(L, 3, "rms",   0.3);
+    bool truePeak    = false;
+    if (lua_istable(L, 3)) {
+        lua_getfield(L, 3, "true_peak");
+        truePeak = lua_toboolean(L, -1);
+        lua_pop(L, 1);
+    }
+    luaL_argcheck(L, hold >= 0 && decay >= 0 && rms > 0, 3, "invalid meter option");
+
+    JackMeter* meter = (JackMeter*) lua_newuserdata(L, sizeof(JackMeter));
+    memset(meter, 0, sizeof(JackMeter));
+    luaL_setmetatable(L, METER_TYPE_NAME);
+    meter->isInProcessContext = client->isInProcessContext;
+    meter->shared = createMeter((int) nchannels, (float) jack_get_sample_rate(client->ptr),
+                                (float) hold, (float) decay, (float) rms, truePeak);
+    if (!meter->shared) {
+        return luaL_error(L, "cannot create meter");
+    }
+    return 1;
+}
+
+static int meter_release(lua_State* L)
+{
+    JackMeter* meter = getCheckedMeter(L, 1);
+    releaseMeter(meter->shared);
+    meter->shared = NULL;
+    return 0;
+}
+
+static int meter_toString(lua_State* L)
+{
+    JackMeter* meter = getCheckedMeter(L, 1);
+    lua_pushfstring(L, "%s: %p", METER_TYPE_NAME, meter->shared);
+    return 1;
+}
+
+static int meter_attach(lua_State* L)
+/* meter:attach(channel, port)
+ * measures the port on the given channel. Must be called in the process 
+ * context.
+ */
+{
+    JackMeter* meter   = getCheckedMeter(L, 1);
+    int        channel = getCheckedChannel(L, 2, meter);
+    JackPort*  port    = getCheckedPort(L, 3);
+
+    if (!meter->isInProcessContext || !port->isInProcessContext) {
+        return luaL_error(L, "ports can only be attached in process context");
+    }
+    JackPortShared* old = meter->shared->ports[channel];
+    atomic_inc(&port->shared->refCounter);
+    meter->shared->ports[channel] = port->shared;
+    releasePort(old);
+    return 0;
+}
+
+static int meter_process(lua_State* L)
+/* meter:process()
+ * measures the current process block of all attached ports and publishes the
+ * values to the main context. Must be called from the process callback.
+ */
+{
+    JackMeter* meter = getCheckedMeter(L, 1);
+    if (!meter->isInProcessContext) {
+        return luaL_error(L, "meter can only be processed in process context");
+    }
+    processMeter(meter->shared);
+    return 0;
+}
+
+static int meter_update(lua_State* L)
+/* bool = meter:update()
+ * takes the newest values published by the process context, returns false if
+ * nothing was published since the last update. Intended to be called at GUI
+ * rate.
+ */
+{
+    JackMeter* meter = getCheckedMeter(L, 1);
+    if (meter->isInProcessContext) {
+        return luaL_error(L, "meter can only be read in main context");
+    }
+    lua_pushboolean(L, updateMeter(meter->shared));
+    return 1;
+}
+
+static int meter_read(lua_State* L)
+/* peak, rms, true_peak, hold = meter:read(channel)
+ * returns the linear values of the last update().
+ */
+{
+    JackMeter* meter   = getCheckedMeter(L, 1);
+    int        channel = getCheckedChannel(L, 2, meter);
+    JackMeterValues* values = &meter->shared->buffers[meter->shared->frontIndex][channel];
+    lua_pushnumber(L, values->peak);
+    lua_pushnumber(L, values->rms);
+    lua_pushnumber(L, values->truePeak);
+    lua_pushnumber(L, values->hold);
+    return 4;
+}
+
+static int meter_channels(lua_State* L)
+{
+    JackMeter* meter = getCheckedMeter(L, 1);
+    lua_pushinteger(L, meter->shared->nchannels);
+    return 1;
+}
+
+static int meter_published(lua_State* L)
+/* n = meter:published()
+ * returns the number of snapshots published by the process context.
+ */
+{
+    JackMeter* meter = getCheckedMeter(L, 1);
+    lua_pushinteger(L, atomic_get(&meter->shared->published));
+    return 1;
+}
+
+static const struct luaL_Reg ClientMethods[] = 
+{
+    { "meter",      meter_new },
+    { NULL, NULL } /* sentinel */
+};
+
+static const struct luaL_Reg MeterMetaMethods[] = 
+{
+    { "__tostring", meter_toString },
+    { "__gc",       meter_release },
+    { NULL, NULL } /* sentinel */
+};
+
+static const struct luaL_Reg MeterMethods[] = 
+{
+    { "attach",     meter_attach },
+    { "process",    meter_process },
+    { "update",     meter_update },
+    { "read",       meter_read },
+    { "channels",   meter_channels },
+    { "published",  meter_published },
+    { NULL, NULL } /* sentinel */
+};
+
+static const struct luaL_Reg ModuleFunctions[] = 
+{
+    { "meter",      meter_new },
+    { NULL, NULL } /* sentinel */
+};
+
+bool luajack_open_meter(lua_State* L, int module, int clientMeta, int clientClass,
+                                                  int  meterMeta, int  meterClass)
+{
+    lua_pushvalue(L, module);
+        setfuncs(L, ModuleFunctions);
+
+        lua_pushvalue(L, clientClass);
+            setfuncs(L, ClientMethods);
+
+            lua_pushvalue(L, meterMeta);
+                setfuncs(L, MeterMetaMethods);
+    
+                lua_pushvalue(L, meterClass);
+                    setfuncs(L, MeterMethods);
+    
+    lua_pop(L, 4);
+    
+    return true;
+}
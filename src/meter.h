@@ -0,0 +1,7 @@
+#ifndef LUAJACK_METER_H
+#define LUAJACK_METER_H
+
+bool luajack_open_meter(lua_State* L, int module, int clientMeta, int clientClass,
+                                                  int  meterMeta, int  meterClass);
+
+#endif // LUAJACK_METER_H
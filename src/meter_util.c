@@ -0,0 +1,221 @@
+#include <stdlib.h>
+#include <math.h>
+
+#include "util.h"
+#include "meter_util.h"
+#include "port_util.h"
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+static void initTruePeakCoeffs(JackMeterShared* meter)
+{
+    /* Hann windowed sinc, the value between x[n-4] and x[n-3] at fraction f
+     * is interpolated from x[n-7] .. x[n] */
+    int p, j;
+    for (p = 0; p < METER_TRUE_PEAK_PHASES; ++p) {
+        double f   = (double)(p + 1) / (METER_TRUE_PEAK_PHASES + 1);
+        double sum = 0;
+        for (j = 0; j < METER_TRUE_PEAK_TAPS; ++j) {
+            double x = (METER_TRUE_PEAK_TAPS / 2) - j - f;
+            double s = (x == 0) ? 1.0 : sin(M_PI * x) / (M_PI * x);
+            double w = 0.5 * (1.0 + cos(M_PI * x / (METER_TRUE_PEAK_TAPS / 2)));
+            meter->truePeakCoeffs[p][j] = (float)(s * w);
+            sum += s * w;
+        }
+        for (j = 0; j < METER_TRUE_PEAK_TAPS; ++j) {
+            meter->truePeakCoeffs[p][j] /= (float) sum;
+        }
+    }
+}
+
+JackMeterShared* createMeter(int nchannels, float sampleRate, float hold, float decay, 
+                             float rmsTime, bool withTruePeak)
+{
+    JackMeterShared* meter = (JackMeterShared*) calloc(1, sizeof(JackMeterShared));
+    if (!meter) {
+        return NULL;
+    }
+    meter->refCounter    = 1;
+    meter->nchannels     = nchannels;
+    meter->sampleRate    = sampleRate;
+    meter->holdTime      = hold * sampleRate;
+    meter->decayPerFrame = powf(10.0f, -decay / 20.0f / sampleRate);
+    meter->rmsTime       = rmsTime * sampleRate;
+    meter->withTruePeak  = withTruePeak;
+    meter->ports         = (JackPortShared**)  calloc(nchannels, sizeof(JackPortShared*));
+    meter->channels      = (JackMeterChannel*) calloc(nchannels, sizeof(JackMeterChannel));
+    int i;
+    for (i = 0; i < 3; ++i) {
+        meter->buffers[i] = (JackMeterValues*) calloc(nchannels, sizeof(JackMeterValues));
+    }
+    if (!meter->ports || !meter->channels || !meter->buffers[0] || !meter->buffers[1] || !meter->buffers[2]) {
+        releaseMeter(meter);
+        return NULL;
+    }
+    meter->frontIndex = 0;
+    meter->middle     = 1;
+    meter->backIndex  = 2;
+    initTruePeakCoeffs(meter);
+    return meter;
+}
+
+void releaseMeter(JackMeterShared* meter)
+{
+    if (meter && atomic_dec(&meter->refCounter) == 0) {
+        int i;
+        if (meter->ports) {
+            for (i = 0; i < meter->nchannels; ++i) {
+                releasePort(meter->ports[i]);
+            }
+            free(meter->ports);
+        }
+        for (i = 0; i < 3; ++i) {
+            free(meter->buffers[i]);
+        }
+        free(meter->channels);
+        free(meter);
+    }
+}
+
+void transferMeter(lua_State* T, JackMeterShared* sharedMeter)
+{
+    JackMeter* meter = (JackMeter*) lua_newuserdata(T, sizeof(JackMeter));
+    memset(meter, 0, sizeof(JackMeter));
+    luaL_setmetatable(T, METER_TYPE_NAME);
+    meter->shared             = sharedMeter;
+    meter->isInProcessContext = true;
+    atomic_inc(&sharedMeter->refCounter);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+static float blockPeak(const float* in, jack_nframes_t nframes)
+{
+    float peak = 0;
+    jack_nframes_t i;
+    for (i = 0; i < nframes; ++i) {
+        float a = fabsf(in[i]);
+        peak = a > peak ? a : peak;
+    }
+    return peak;
+}
+
+static float blockSquares(const float* in, jack_nframes_t nframes)
+{
+    float sum = 0;
+    jack_nframes_t i;
+    for (i = 0; i < nframes; ++i) {
+        sum += in[i] * in[i];
+    }
+    return sum;
+}
+
+static float interpolatedPeak(JackMeterShared* meter, JackMeterChannel* channel, 
+                              const float* in, jack_nframes_t nframes)
+{
+    const int H = METER_TRUE_PEAK_TAPS - 1;
+    float head[2 * (METER_TRUE_PEAK_TAPS - 1)];
+    float peak = 0;
+    jack_nframes_t i;
+    int p, j;
+
+    /* the first H samples need the history of the previous block */
+    jack_nframes_t n = nframes < (jack_nframes_t) H ? nframes : (jack_nframes_t) H;
+    memcpy(head,     channel->history, sizeof(float) * H);
+    memcpy(head + H, in,               sizeof(float) * n);
+    for (i = 0; i < n; ++i) {
+        const float* x = head + H + i;
+        for (p = 0; p < METER_TRUE_PEAK_PHASES; ++p) {
+            float y = 0;
+            for (j = 0; j < METER_TRUE_PEAK_TAPS; ++j) {
+                y += meter->truePeakCoeffs[p][j] * x[-j];
+            }
+            y = fabsf(y);
+            peak = y > peak ? y : peak;
+        }
+    }
+    for (i = n; i < nframes; ++i) {
+        const float* x = in + i;
+        for (p = 0; p < METER_TRUE_PEAK_PHASES; ++p) {
+            float y = 0;
+            for (j = 0; j < METER_TRUE_PEAK_TAPS; ++j) {
+                y += meter->truePeakCoeffs[p][j] * x[-j];
+            }
+            y = fabsf(y);
+            peak = y > peak ? y : peak;
+        }
+    }
+    if (nframes >= (jack_nframes_t) H) {
+        memcpy(channel->history, in + nframes - H, sizeof(float) * H);
+    } else {
+        memmove(channel->history, channel->history + nframes, sizeof(float) * (H - nframes));
+        memcpy(channel->history + H - nframes, in, sizeof(float) * nframes);
+    }
+    return peak;
+}
+
+void processMeter(JackMeterShared* meter)
+{
+    JackMeterValues* out = meter->buffers[meter->backIndex];
+    float decay    = 0;
+    float rmsCoeff = 0;
+    jack_nframes_t lastNframes = 0;
+    int c;
+    for (c = 0; c < meter->nchannels; ++c) {
+        JackMeterChannel* channel = &meter->channels[c];
+        jack_nframes_t nframes;
+        const float* in = getSharedPortBuffer(meter->ports[c], &nframes);
+        if (in && nframes > 0) {
+            if (nframes != lastNframes) {
+                decay       = powf(meter->decayPerFrame, (float) nframes);
+                rmsCoeff    = 1.0f - expf(-(float) nframes / meter->rmsTime);
+                lastNframes = nframes;
+            }
+            float peak = blockPeak(in, nframes);
+            float ms   = blockSquares(in, nframes) / nframes;
+
+            channel->peak        = fmaxf(peak, channel->peak * decay);
+            channel->meanSquare += rmsCoeff * (ms - channel->meanSquare);
+
+            if (meter->withTruePeak) {
+                float tp = fmaxf(peak, interpolatedPeak(meter, channel, in, nframes));
+                channel->truePeak = fmaxf(tp, channel->truePeak * decay);
+                peak = tp;
+            }
+            if (peak >= channel->hold) {
+                channel->hold       = peak;
+                channel->holdFrames = meter->holdTime;
+            } else if (channel->holdFrames > 0) {
+                channel->holdFrames -= nframes;
+            } else {
+                channel->hold = fmaxf(peak, channel->hold * decay);
+            }
+        }
+        out[c].peak     = channel->peak;
+        out[c].rms      = sqrtf(channel->meanSquare);
+        out[c].truePeak = meter->withTruePeak ? channel->truePeak : channel->peak;
+        out[c].hold     = channel->hold;
+    }
+    /* publish */
+    int old;
+    do {
+        old = atomic_get(&meter->middle);
+    } while (!atomic_set_if_equal(&meter->middle, old, meter->backIndex | METER_FRESH));
+    meter->backIndex = old & ~METER_FRESH;
+    atomic_inc(&meter->published);
+}
+
+bool updateMeter(JackMeterShared* meter)
+{
+    int old = atomic_get(&meter->middle);
+    if (!(old & METER_FRESH)) {
+        return false;
+    }
+    while (!atomic_set_if_equal(&meter->middle, old, meter->frontIndex)) {
+        old = atomic_get(&meter->middle);
+    }
+    meter->frontIndex = old & ~METER_FRESH;
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
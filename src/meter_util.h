@@ -0,0 +1,106 @@
+#ifndef LUAJACK_METER_UTIL_H
+#define LUAJACK_METER_UTIL_H
+
+#include "util.h"
+
+/////////////////////////////////////////////////////////////////////////////////
+
+#define METER_TRUE_PEAK_TAPS    8   /* taps per phase of the 4x interpolator */
+#define METER_TRUE_PEAK_PHASES  3   /* interpolated phases between two samples */
+
+typedef struct {
+    float peak;
+    float rms;
+    float truePeak;
+    float hold;
+}
+JackMeterValues;
+
+/* Per channel state, only accessed by the process context */
+typedef struct {
+    float    peak;
+    float    meanSquare;
+    float    truePeak;
+    float    hold;
+    float    holdFrames;
+    float    history[METER_TRUE_PEAK_TAPS - 1];
+}
+JackMeterChannel;
+
+typedef struct {
+    AtomicCounter        refCounter;
+    int                  nchannels;
+    float                sampleRate;
+    float                holdTime;       /* frames */
+    float                decayPerFrame;  /* linear factor */
+    float                rmsTime;        /* frames */
+    bool                 withTruePeak;
+    float                truePeakCoeffs[METER_TRUE_PEAK_PHASES][METER_TRUE_PEAK_TAPS];
+    JackPortShared**     ports;
+    JackMeterChannel*    channels;
+
+    /* triple buffer: the process context writes into buffers[backIndex] and
+     * exchanges it with the middle buffer, the main context exchanges its
+     * front buffer with the middle buffer if that holds a fresh snapshot */
+    JackMeterValues*     buffers[3];
+    AtomicCounter        middle;         /* buffer index | METER_FRESH */
+    int                  backIndex;
+    int                  frontIndex;
+    AtomicCounter        published;
+}
+JackMeterShared;
+
+#define METER_FRESH 4
+
+typedef struct {
+    JackMeterShared*     shared;
+    bool                 isInProcessContext;
+}
+JackMeter;
+
+static inline JackMeter* getCheckedMeter(lua_State* L, int stackIndex)
+{
+    JackMeter* meter = (JackMeter*) checkudata(L, stackIndex, METER_TYPE, METER_TYPE_NAME);
+    return meter;
+}
+
+static inline JackMeter* getOptionalMeter(lua_State* L, int stackIndex)
+{
+    JackMeter* meter = (JackMeter*) testudata(L, stackIndex, METER_TYPE, METER_TYPE_NAME);
+    return meter;
+}
+
+/////////////////////////////////////////////////////////////////////////////////
+
+/* hold and rms time in seconds, decay in dB per second */
+
+#define createMeter luajack_createMeter 
+
+JackMeterShared* createMeter(int nchannels, float sampleRate, float hold, float decay, 
+                             float rmsTime, bool withTruePeak);
+
+#define releaseMeter luajack_releaseMeter 
+
+void releaseMeter(JackMeterShared* meter);
+
+#define transferMeter luajack_transferMeter 
+
+void transferMeter(lua_State* T, JackMeterShared* meter);
+
+/* Measures the current process block of all attached ports and publishes 
+ * the values */
+
+#define processMeter luajack_processMeter 
+
+void processMeter(JackMeterShared* meter);
+
+/* Takes the newest published snapshot into the front buffer, returns false if
+ * there is no new snapshot */
+
+#define updateMeter luajack_updateMeter 
+
+bool updateMeter(JackMeterShared* meter);
+
+/////////////////////////////////////////////////////////////////////////////////
+
+#endif // LUAJACK_METER_UTIL_H
@@ -0,0 +1,318 @@
+#include <stdio.h>
+
+#include "util.h"
+#include "native.h"
+#include "native_util.h"
+#include "process_util.h"
+#include "client_util.h"
+
+#define NATIVE_MAX_OPTIONS 64
+
+static int getPortList(lua_State* L, int config, const char* field, JackClientShared* client,
+                       JackPortShared** ports)
+{
+    int n = 0;
+    lua_getfield(L, config, field);
+    if (lua_istable(L, -1)) {
+        int i;
+        for (i = 1; ; ++i) {
+            lua_geti(L, -1, i);
+            if (lua_isnil(L, -1)) {
+                lua_pop(L, 1);
+                break;
+            }
+            JackPort* port = getOptionalPort(L, -1);
+            if (!port || !port->shared || !port->ptr) {
+                return luaL_error(L, "invalid port in config.%s[%d]", field, i);
+            }
+            if (port->shared->client != client) {
+                return luaL_error(L, "port in config.%s[%d] does not belong to client", field, i);
+            }
+            if (n >= NATIVE_MAX_PORTS) {
+                return luaL_error(L, "too many ports in config.%s", field);
+            }
+            ports[n++] = port->shared;
+            lua_pop(L, 1);
+        }
+    } 
+    else if (!lua_isnil(L, -1)) {
+        return luaL_error(L, "config.%s must be a table", field);
+    }
+    lua_pop(L, 1);
+    return n;
+}
+
+static int findParam(const luajack_plugin* plugin, const char* name)
+{
+    int i;
+    if (plugin->param_names) {
+        for (i = 0; plugin->param_names[i]; ++i) {
+            if (strcmp(plugin->param_names[i], name) == 0) {
+                return i;
+            }
+        }
+    }
+    return -1;
+}
+
+static int paramCount(const luajack_plugin* plugin)
+{
+    int n = 0;
+    if (plugin->param_names) {
+        while (plugin->param_names[n]) ++n;
+    }
+    return n;
+}
+
+static int getCheckedParam(lua_State* L, int arg, const luajack_plugin* plugin)
+{
+    int param;
+    if (lua_type(L, arg) == LUA_TSTRING) {
+        param = findParam(plugin, lua_tostring(L, arg));
+        if (param < 0) {
+            return luaL_argerror(L, arg, lua_pushfstring(L, "unknown parameter '%s'", lua_tostring(L, arg)));
+        }
+    } else {
+        param = (int) luaL_checkinteger(L, arg) - 1;
+        luaL_argcheck(L, param >= 0 && param < paramCount(plugin), arg, "invalid parameter index");
+    }
+    return param;
+}
+
+static int process_native(lua_State* L)
+/* native = client:process_native(path, config)
+ * loads a native DSP module (see src/luajack_plugin.h) and appends it to the
+ * chain of native modules that is run at the beginning of every process cycle,
+ * before the Lua process callback. config fields:
+ *   inputs  = { port, ... }   ports passed as input buffers
+ *   outputs = { port, ... }   ports passed as output buffers
+ *   params  = { name = value, ... } initial parameter values
+ *   options = { key = value, ... }  strings passed to the module's init()
+ * Must be called before the client is activated.
+ */
+{
+    JackClient* client = getCheckedClient(L, 1);
+    const char* path   = luaL_checkstring(L, 2);
+    luaL_checktype(L, 3, LUA_TTABLE);
+
+    if (!client->isMaster) {
+        return luaL_argerror(L, 1, "method can only be called on master client object");
+    }
+    if (client->isActivated) {
+        return luaL_error(L, "native modules must be loaded before the client is activated");
+    }
+    JackClientShared* shared = client->shared;
+    if (!shared->nativeChain) {
+        shared->nativeChain = createNativeChain();
+        if (!shared->nativeChain) {
+            return luaL_error(L, "cannot create native module chain");
+        }
+    }
+    JackNativeChain* chain = shared->nativeChain;
+    if (chain->count >= NATIVE_MAX_MODULES) {
+        return luaL_error(L, "too many native modules");
+    }
+    JackNativeModule* m = &chain->modules[chain->count];
+    memset(m, 0, sizeof(JackNativeModule));
+    
+    m->nInputs  = getPortList(L, 3, "inputs",  shared, m->inputs);
+    m->nOutputs = getPortList(L, 3, "outputs", shared, m->outputs);
+
+    const char* keys  [NATIVE_MAX_OPTIONS];
+    const char* values[NATIVE_MAX_OPTIONS];
+    luajack_plugin_config config;
+    config.sample_rate   = jack_get_sample_rate(client->ptr);
+    config.max_nframes   = jack_get_buffer_size(client->ptr);
+    config.n_inputs      = m->nInputs;
+    config.n_outputs     = m->nOutputs;
+    config.n_options     = 0;
+    config.option_keys   = keys;
+    config.option_values = values;
+
+    /* the option strings are kept in a table on the stack until init() has returned */
+    int top = lua_gettop(L);
+    lua_newtable(L);
+    int strings = lua_gettop(L);
+    lua_getfield(L, 3, "options");
+    if (lua_istable(L, -1)) {
+        int options = lua_gettop(L);
+        lua_pushnil(L);
+        while (lua_next(L, options)) {
+            if (lua_type(L, -2) != LUA_TSTRING || !lua_isstring(L, -1)) {
+                return luaL_error(L, "options must be string keys with string or number values");
+            }
+            if (config.n_options >= NATIVE_MAX_OPTIONS) {
+                return luaL_error(L, "too many options");
+            }
+            int n = config.n_options++;
+            lua_pushvalue(L, -2);
+            keys[n] = lua_tostring(L, -1);
+            lua_rawseti(L, strings, 2 * n + 1);
+            lua_tostring(L, -1); /* converts numbers */
+            values[n] = lua_tostring(L, -1);
+            lua_rawseti(L, strings, 2 * n + 2);
+        }
+    }
+    
+    const char* errmsg = NULL;
+    m->plugin = loadNativePlugin(path, &m->library, &errmsg);
+    if (!m->plugin) {
+        return luaL_error(L, "cannot load native module '%s': %s", path, errmsg);
+    }
+    if (m->plugin->init) {
+        m->instance = m->plugin->init(&config);
+        if (!m->instance) {
+            unloadNativePlugin(m->library);
+            return luaL_error(L, "cannot initialize native module '%s'", path);
+        }
+    }
+    lua_settop(L, top);
+
+    /* the module is complete now, take over the port references */
+    uint32_t j;
+    for (j = 0; j < m->nInputs; ++j) {
+        atomic_inc(&m->inputs[j]->refCounter);
+    }
+    for (j = 0; j < m->nOutputs; ++j) {
+        atomic_inc(&m->outputs[j]->refCounter);
+    }
+    int index = chain->count++;
+
+    lua_getfield(L, 3, "params");
+    if (lua_istable(L, -1)) {
+        int params = lua_gettop(L);
+        lua_pushnil(L);
+        while (lua_next(L, params)) {
+            int param = getCheckedParam(L, -2, m->plugin);
+            double value = luaL_checknumber(L, -1);
+            if (m->plugin->set_param) {
+                m->plugin->set_param(m->instance, param, value);
+            }
+            lua_pop(L, 1);
+        }
+    }
+    lua_settop(L, top);
+    
+    jack_set_process_callback(client->ptr, processCallback, shared);
+
+    JackNative* native = (JackNative*) lua_newuserdata(L, sizeof(JackNative));
+    native->client = shared;
+    native->index  = index;
+    luaL_setmetatable(L, NATIVE_TYPE_NAME);
+    atomic_inc(&shared->refCounter);
+    return 1;
+}
+
+static const luajack_plugin* getNativePlugin(lua_State* L, JackNative* native)
+{
+    if (!native->client || !native->client->nativeChain) {
+        luaL_error(L, "native module is released");
+        return NULL;
+    }
+    return native->client->nativeChain->modules[native->index].plugin;
+}
+
+static int native_set(lua_State* L)
+/* bool = native:set(param, value)
+ * param is the parameter's name or its 1-based index. The value is passed
+ * to the module in the next process cycle. Returns false if the parameter 
+ * queue is full.
+ */
+{
+    JackNative* native = getCheckedNative(L, 1);
+    const luajack_plugin* plugin = getNativePlugin(L, native);
+    int    param = getCheckedParam(L, 2, plugin);
+    double value = luaL_checknumber(L, 3);
+    lua_pushboolean(L, postNativeParam(native->client->nativeChain, native->index, param, value));
+    return 1;
+}
+
+static int native_params(lua_State* L)
+/* { name, ... } = native:params() */
+{
+    JackNative* native = getCheckedNative(L, 1);
+    const luajack_plugin* plugin = getNativePlugin(L, native);
+    int n = paramCount(plugin);
+    lua_createtable(L, n, 0);
+    int i;
+    for (i = 0; i < n; ++i) {
+        lua_pushstring(L, plugin->param_names[i]);
+        lua_rawseti(L, -2, i + 1);
+    }
+    return 1;
+}
+
+static int native_name(lua_State* L)
+{
+    JackNative* native = getCheckedNative(L, 1);
+    const luajack_plugin* plugin = getNativePlugin(L, native);
+    lua_pushstring(L, plugin->name ? plugin->name : "");
+    return 1;
+}
+
+static int native_dropped(lua_State* L)
+/* n = native:dropped()
+ * returns the number of parameter changes lost because the queue was full.
+ */
+{
+    JackNative* native = getCheckedNative(L, 1);
+    getNativePlugin(L, native);
+    lua_pushinteger(L, atomic_get(&native->client->nativeChain->droppedParams));
+    return 1;
+}
+
+static int native_toString(lua_State* L)
+{
+    JackNative* native = getCheckedNative(L, 1);
+    lua_pushfstring(L, "%s: %d (%p)", NATIVE_TYPE_NAME, native->index + 1, native);
+    return 1;
+}
+
+static int native_release(lua_State* L)
+{
+    JackNative* native = getCheckedNative(L, 1);
+    if (native->client) {
+        releaseClientShared(native->client);
+        native->client = NULL;
+    }
+    return 0;
+}
+
+static const struct luaL_Reg ClientMethods[] = 
+{
+    { "process_native", process_native },
+    { NULL, NULL } /* sentinel */
+};
+
+static const struct luaL_Reg NativeMetaMethods[] = 
+{
+    { "__tostring", native_toString },
+    { "__gc",       native_release },
+    { NULL, NULL } /* sentinel */
+};
+
+static const struct luaL_Reg NativeMethods[] = 
+{
+    { "set",        native_set },
+    { "params",     native_params },
+    { "name",       native_name },
+    { "dropped",    native_dropped },
+    { NULL, NULL } /* sentinel */
+};
+
+bool luajack_open_native(lua_State* L, int module, int clientMeta, int clientClass,
+                                                   int nativeMeta, int nativeClass)
+{
+    lua_pushvalue(L, clientClass);
+        setfuncs(L, ClientMethods);
+
+        lua_pushvalue(L, nativeMeta);
+            setfuncs(L, NativeMetaMethods);
+    
+            lua_pushvalue(L, nativeClass);
+                setfuncs(L, NativeMethods);
+    
+    lua_pop(L, 3);
+    
+    return true;
+}
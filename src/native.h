@@ -0,0 +1,7 @@
+#ifndef LUAJACK_NATIVE_H
+#define LUAJACK_NATIVE_H
+
+bool luajack_open_native(lua_State* L, int module, int clientMeta, int clientClass,
+                                                   int nativeMeta, int nativeClass);
+
+#endif // LUAJACK_NATIVE_H
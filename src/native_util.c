@@ -0,0 +1,150 @@
+#include <stdlib.h>
+
+#if defined(_WIN32)
+    #include <windows.h>
+#else
+    #include <dlfcn.h>
+#endif
+
+#include "util.h"
+#include "native_util.h"
+#include "port_util.h"
+#include "rbuf_util.h"
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+JackNativeChain* createNativeChain(void)
+{
+    JackNativeChain* chain = (JackNativeChain*) calloc(1, sizeof(JackNativeChain));
+    if (!chain) {
+        return NULL;
+    }
+    chain->params = jack_ringbuffer_create(1024 * (8 + sizeof(JackNativeParam)));
+    if (!chain->params) {
+        free(chain);
+        return NULL;
+    }
+    jack_ringbuffer_mlock(chain->params);
+    return chain;
+}
+
+void releaseNativeChain(JackNativeChain* chain)
+{
+    if (chain) {
+        int i;
+        for (i = 0; i < chain->count; ++i) {
+            JackNativeModule* m = &chain->modules[i];
+            if (m->instance && m->plugin->release) {
+                m->plugin->release(m->instance);
+            }
+            unloadNativePlugin(m->library);
+            uint32_t j;
+            for (j = 0; j < m->nInputs; ++j) {
+                releasePort(m->inputs[j]);
+            }
+            for (j = 0; j < m->nOutputs; ++j) {
+                releasePort(m->outputs[j]);
+            }
+        }
+        jack_ringbuffer_free(chain->params);
+        free(chain);
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+const luajack_plugin* loadNativePlugin(const char* path, void** library, const char** errmsg)
+{
+    luajack_plugin_entry_function entry;
+#if defined(_WIN32)
+    HMODULE lib = LoadLibraryA(path);
+    if (!lib) {
+        *errmsg = "cannot load library";
+        return NULL;
+    }
+    entry = (luajack_plugin_entry_function) GetProcAddress(lib, LUAJACK_PLUGIN_ENTRY);
+#else
+    void* lib = dlopen(path, RTLD_NOW | RTLD_LOCAL);
+    if (!lib) {
+        *errmsg = dlerror();
+        return NULL;
+    }
+    *(void**)(&entry) = dlsym(lib, LUAJACK_PLUGIN_ENTRY);
+#endif
+    const luajack_plugin* plugin = entry ? entry() : NULL;
+    if (!plugin) {
+        *errmsg = "library has no " LUAJACK_PLUGIN_ENTRY "()";
+    }
+    else if (plugin->api_version != LUAJACK_PLUGIN_API_VERSION) {
+        *errmsg = "plugin api version mismatch";
+        plugin  = NULL;
+    }
+    else if (!plugin->process) {
+        *errmsg = "plugin has no process function";
+        plugin  = NULL;
+    }
+    if (!plugin) {
+        unloadNativePlugin(lib);
+        return NULL;
+    }
+    *library = lib;
+    return plugin;
+}
+
+void unloadNativePlugin(void* library)
+{
+    if (library) {
+#if defined(_WIN32)
+        FreeLibrary((HMODULE) library);
+#else
+        dlclose(library);
+#endif
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+bool postNativeParam(JackNativeChain* chain, int module, int32_t param, double value)
+{
+    JackNativeParam p;
+    p.param = param;
+    p.value = value;
+    if (!writeRbufMessage(chain->params, module, (const char*) &p, sizeof(p))) {
+        atomic_inc(&chain->droppedParams);
+        return false;
+    }
+    return true;
+}
+
+void processNativeChain(JackNativeChain* chain, jack_nframes_t nframes)
+{
+    JackNativeParam p;
+    int32_t         module;
+    uint32_t        len = sizeof(p);
+    int             rc;
+    while ((rc = readRbufMessage(chain->params, &module, (char*) &p, &len)) != RBUF_MESSAGE_NONE) {
+        if (   rc == RBUF_MESSAGE_OK && len == sizeof(p) 
+            && module >= 0 && module < chain->count) 
+        {
+            JackNativeModule* m = &chain->modules[module];
+            if (m->plugin->set_param) {
+                m->plugin->set_param(m->instance, (uint32_t) p.param, p.value);
+            }
+        }
+        len = sizeof(p);
+    }
+    int i;
+    for (i = 0; i < chain->count; ++i) {
+        JackNativeModule* m = &chain->modules[i];
+        uint32_t j;
+        for (j = 0; j < m->nInputs; ++j) {
+            m->inputBuffers[j] = getSharedPortCycleBuffer(m->inputs[j], nframes);
+        }
+        for (j = 0; j < m->nOutputs; ++j) {
+            m->outputBuffers[j] = getSharedPortCycleBuffer(m->outputs[j], nframes);
+        }
+        m->plugin->process(m->instance, m->inputBuffers, m->outputBuffers, nframes);
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
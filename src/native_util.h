@@ -0,0 +1,93 @@
+#ifndef LUAJACK_NATIVE_UTIL_H
+#define LUAJACK_NATIVE_UTIL_H
+
+#include "util.h"
+#include "luajack_plugin.h"
+
+/////////////////////////////////////////////////////////////////////////////////
+
+#define NATIVE_MAX_MODULES 32
+#define NATIVE_MAX_PORTS   64
+
+typedef struct {
+    void*                 library;
+    const luajack_plugin* plugin;
+    void*                 instance;
+    uint32_t              nInputs;
+    uint32_t              nOutputs;
+    JackPortShared*       inputs [NATIVE_MAX_PORTS];
+    JackPortShared*       outputs[NATIVE_MAX_PORTS];
+    const float*          inputBuffers [NATIVE_MAX_PORTS];
+    float*                outputBuffers[NATIVE_MAX_PORTS];
+}
+JackNativeModule;
+
+/* Modules of a client, run in order at the beginning of every process cycle.
+ * Parameter changes are passed from the main thread as ringbuffer messages
+ * with the module index as tag. */
+typedef struct JackNativeChain {
+    int                 count;
+    JackNativeModule    modules[NATIVE_MAX_MODULES];
+    jack_ringbuffer_t*  params;
+    AtomicCounter       droppedParams;
+}
+JackNativeChain;
+
+typedef struct {
+    int32_t  param;
+    double   value;
+}
+JackNativeParam;
+
+/* Lua handle of a module in the chain */
+typedef struct {
+    JackClientShared* client;
+    int               index;
+}
+JackNative;
+
+static inline JackNative* getCheckedNative(lua_State* L, int stackIndex)
+{
+    JackNative* native = (JackNative*) checkudata(L, stackIndex, NATIVE_TYPE, NATIVE_TYPE_NAME);
+    return native;
+}
+
+/////////////////////////////////////////////////////////////////////////////////
+
+#define createNativeChain luajack_createNativeChain 
+
+JackNativeChain* createNativeChain(void);
+
+/* Releases all module instances, unloads the libraries and the port 
+ * references. The client must not be active. */
+
+#define releaseNativeChain luajack_releaseNativeChain 
+
+void releaseNativeChain(JackNativeChain* chain);
+
+/* Loads the library and returns its plugin descriptor. On error NULL is 
+ * returned and *errmsg is set. */
+
+#define loadNativePlugin luajack_loadNativePlugin 
+
+const luajack_plugin* loadNativePlugin(const char* path, void** library, const char** errmsg);
+
+#define unloadNativePlugin luajack_unloadNativePlugin 
+
+void unloadNativePlugin(void* library);
+
+/* Returns false if the parameter queue is full */
+
+#define postNativeParam luajack_postNativeParam 
+
+bool postNativeParam(JackNativeChain* chain, int module, int32_t param, double value);
+
+/* Called from the process callback */
+
+#define processNativeChain luajack_processNativeChain 
+
+void processNativeChain(JackNativeChain* chain, jack_nframes_t nframes);
+
+/////////////////////////////////////////////////////////////////////////////////
+
+#endif // LUAJACK_NATIVE_UTIL_H
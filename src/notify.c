@@ -0,0 +1,190 @@
+#include <unistd.h>
+
+#include "util.h"
+#include "notify.h"
+#include "notify_util.h"
+
+static const char* const NotificationNames[] = 
+{
+    "xrun",
+    "graph_order",
+    "client_registration",
+    "port_registration",
+    "port_connect",
+    "port_rename",
+    "sample_rate",
+    "buffer_size"
+};
+
+static JackClient* getCheckedMasterClient(lua_State* L, int arg)
+{
+    JackClient* client = getCheckedClient(L, arg);
+    if (!client->isMaster) {
+        luaL_argerror(L, arg, "method can only be called on master client object");
+    }
+    return client;
+}
+
+static void pushPortNameById(lua_State* L, JackClient* client, jack_port_id_t id)
+{
+    jack_port_t* port = jack_port_by_id(client->ptr, id);
+    if (port) {
+        lua_pushstring(L, jack_port_name(port));
+    } else {
+        lua_pushinteger(L, id);
+    }
+}
+
+static int pushNotificationArgs(lua_State* L, JackClient* client, JackNotification* n)
+{
+    switch (n->type) {
+        case NOTIFY_XRUN:
+            lua_pushnumber(L, n->delay);
+            return 1;
+        case NOTIFY_GRAPH_ORDER:
+            return 0;
+        case NOTIFY_CLIENT_REGISTRATION:
+            lua_pushstring(L, n->name);
+            lua_pushboolean(L, n->flag);
+            return 2;
+        case NOTIFY_PORT_REGISTRATION:
+            pushPortNameById(L, client, n->a);
+            lua_pushboolean(L, n->flag);
+            return 2;
+        case NOTIFY_PORT_CONNECT:
+            pushPortNameById(L, client, n->a);
+            pushPortNameById(L, client, n->b);
+            lua_pushboolean(L, n->flag);
+            return 3;
+        case NOTIFY_PORT_RENAME:
+            lua_pushstring(L, n->name);
+            pushPortNameById(L, client, n->a);
+            return 2;
+        case NOTIFY_SAMPLE_RATE:
+        case NOTIFY_BUFFER_SIZE:
+            lua_pushinteger(L, n->a);
+            return 1;
+    }
+    return 0;
+}
+
+static int enable_notifications(lua_State* L)
+/* client:enable_notifications([capacity [, with_fd]])
+ * allocates the queue that receives server notifications. Notifications
+ * arriving before this call or while the queue is full are dropped.
+ */
+{
+    JackClient* client   = getCheckedMasterClient(L, 1);
+    lua_Integer capacity = luaL_optinteger(L, 2, 256);
+    bool        withFd   = lua_toboolean(L, 3);
+
+    luaL_argcheck(L, capacity > 0 && capacity <= 65536, 2, "capacity out of range");
+
+    if (client->shared->notificationQueue) {
+        return luaL_error(L, "notifications already enabled");
+    }
+    JackNotificationQueue* queue = createNotificationQueue((uint32_t) capacity, withFd);
+    if (!queue) {
+        return luaL_error(L, "cannot create notification queue");
+    }
+    atomic_set_ptr_if_equal((void**) &client->shared->notificationQueue, NULL, queue);
+    return 0;
+}
+
+static int drain_notifications(lua_State* L)
+/* client:drain_notifications(handler [, max])
+ * calls handler(kind, usecs, ...) for each queued notification, usecs is the 
+ * value of jack.time() when the notification arrived. Additional arguments:
+ *   "xrun"                 delay_usecs
+ *   "graph_order"          -
+ *   "client_registration"  client_name, registered
+ *   "port_registration"    port_name, registered
+ *   "port_connect"         port_name_a, port_name_b, connected
+ *   "port_rename"          old_name, new_name
+ *   "sample_rate"          sample_rate
+ *   "buffer_size"          nframes
+ * At most max notifications are processed, by default the queue capacity.
+ * Returns the number of processed notifications. The notification fd stays
+ * readable if notifications remain queued.
+ */
+{
+    JackClient* client = getCheckedMasterClient(L, 1);
+    luaL_checktype(L, 2, LUA_TFUNCTION);
+
+    JackNotificationQueue* queue = client->shared->notificationQueue;
+    if (!queue) {
+        return luaL_error(L, "notifications not enabled");
+    }
+    lua_Integer max = luaL_optinteger(L, 3, queue->mask + 1);
+    if (queue->fd >= 0) {
+        uint64_t value;
+        ssize_t rc = read(queue->fd, &value, sizeof(value));
+        (void)rc;
+    }
+    lua_Integer count = 0;
+    JackNotification n;
+    while (count < max && popNotification(queue, &n)) {
+        count += 1;
+        lua_pushvalue(L, 2);
+        lua_pushstring(L, NotificationNames[n.type]);
+        lua_pushinteger(L, n.time);
+        int nargs = pushNotificationArgs(L, client, &n);
+        if (lua_pcall(L, 2 + nargs, 0, 0) != LUA_OK) {
+            if (hasNotification(queue)) {
+                signalNotificationQueue(queue);
+            }
+            return lua_error(L);
+        }
+    }
+    if (hasNotification(queue)) {
+        signalNotificationQueue(queue);
+    }
+    lua_pushinteger(L, count);
+    return 1;
+}
+
+static int notifications_dropped(lua_State* L)
+/* client:notifications_dropped()
+ * returns the number of notifications lost because the queue was full.
+ */
+{
+    JackClient* client = getCheckedMasterClient(L, 1);
+    JackNotificationQueue* queue = client->shared->notificationQueue;
+    lua_pushinteger(L, queue ? atomic_get(&queue->dropped) : 0);
+    return 1;
+}
+
+static int notification_fd(lua_State* L)
+/* client:notification_fd()
+ * returns a file descriptor that becomes readable when notifications are 
+ * queued, or nil if notifications were enabled without fd or the platform
+ * has no eventfd.
+ */
+{
+    JackClient* client = getCheckedMasterClient(L, 1);
+    JackNotificationQueue* queue = client->shared->notificationQueue;
+    if (queue && queue->fd >= 0) {
+        lua_pushinteger(L, queue->fd);
+    } else {
+        lua_pushnil(L);
+    }
+    return 1;
+}
+
+static const struct luaL_Reg ClientMethods[] = 
+{
+    { "enable_notifications",  enable_notifications },
+    { "drain_notifications",   drain_notifications },
+    { "notifications_dropped", notifications_dropped },
+    { "notification_fd",       notification_fd },
+    { NULL, NULL } /* sentinel */
+};
+
+bool luajack_open_notify(lua_State* L, int module, int clientMeta, int clientClass)
+{
+    lua_pushvalue(L, clientClass);
+        setfuncs(L, ClientMethods);
+    lua_pop(L, 1);
+    
+    return true;
+}
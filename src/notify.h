@@ -0,0 +1,6 @@
+#ifndef LUAJACK_NOTIFY_H
+#define LUAJACK_NOTIFY_H
+
+bool luajack_open_notify(lua_State* L, int module, int clientMeta, int clientClass);
+
+#endif // LUAJACK_NOTIFY_H
@@ -0,0 +1,219 @@
+#include <stdlib.h>
+#include <unistd.h>
+
+#if defined(__linux__)
+    #include <sys/eventfd.h>
+#endif
+
+#include "util.h"
+#include "notify_util.h"
+#include "port_util.h"
+#include "scratch_util.h"
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+JackNotificationQueue* createNotificationQueue(uint32_t capacity, bool withFd)
+{
+    uint32_t size = 1;
+    while (size < capacity) {
+        size <<= 1;
+    }
+    JackNotificationQueue* queue = (JackNotificationQueue*) calloc(1, sizeof(JackNotificationQueue));
+    if (!queue) {
+        return NULL;
+    }
+    queue->slots = (JackNotificationSlot*) calloc(size, sizeof(JackNotificationSlot));
+    queue->mask  = size - 1;
+    queue->fd    = -1;
+    if (!queue->slots) {
+        free(queue);
+        return NULL;
+    }
+    uint32_t i;
+    for (i = 0; i < size; ++i) {
+        queue->slots[i].sequence = i;
+    }
+    if (withFd) {
+#if defined(__linux__)
+        queue->fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+#endif
+        if (queue->fd < 0) {
+            releaseNotificationQueue(queue);
+            return NULL;
+        }
+    }
+    return queue;
+}
+
+void releaseNotificationQueue(JackNotificationQueue* queue)
+{
+    if (queue) {
+        if (queue->fd >= 0) {
+            close(queue->fd);
+        }
+        free(queue->slots);
+        free(queue);
+    }
+}
+
+void pushNotification(JackClientShared* client, JackNotification* notification)
+{
+    JackNotificationQueue* queue = client->notificationQueue;
+    if (!queue) {
+        return;
+    }
+    notification->time = jack_get_time();
+    
+    while (true) {
+        uint32_t pos = (uint32_t) atomic_get(&queue->enqueuePos);
+        JackNotificationSlot* slot = &queue->slots[pos & queue->mask];
+        int32_t diff = (int32_t)((uint32_t)atomic_get(&slot->sequence) - pos);
+        if (diff == 0) {
+            if (atomic_set_if_equal(&queue->enqueuePos, (int)pos, (int)(pos + 1))) {
+                slot->notification = *notification;
+                atomic_set(&slot->sequence, (int)(pos + 1));
+                break;
+            }
+        } 
+        else if (diff < 0) {
+            atomic_inc(&queue->dropped);
+            return;
+        }
+    }
+    signalNotificationQueue(queue);
+}
+
+void signalNotificationQueue(JackNotificationQueue* queue)
+{
+#if defined(__linux__)
+    if (queue->fd >= 0) {
+        uint64_t one = 1;
+        ssize_t rc = write(queue->fd, &one, sizeof(one));
+        (void)rc;
+    }
+#endif
+}
+
+bool hasNotification(JackNotificationQueue* queue)
+{
+    uint32_t pos = (uint32_t) atomic_get(&queue->dequeuePos);
+    JackNotificationSlot* slot = &queue->slots[pos & queue->mask];
+    return (uint32_t)atomic_get(&slot->sequence) == pos + 1;
+}
+
+bool popNotification(JackNotificationQueue* queue, JackNotification* notification)
+{
+    uint32_t pos = (uint32_t) atomic_get(&queue->dequeuePos);
+    JackNotificationSlot* slot = &queue->slots[pos & queue->mask];
+    
+    if ((uint32_t)atomic_get(&slot->sequence) != pos + 1) {
+        return false;
+    }
+    *notification = slot->notification;
+    atomic_set(&slot->sequence, (int)(pos + queue->mask + 1));
+    atomic_set(&queue->dequeuePos, (int)(pos + 1));
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+static inline void initNotification(JackNotification* n, JackNotificationType type)
+{
+    n->type    = type;
+    n->a       = 0;
+    n->b       = 0;
+    n->flag    = false;
+    n->delay   = 0;
+    n->name[0] = '\0';
+}
+
+static int xrunCallback(void* arg)
+{
+    JackClientShared* client = (JackClientShared*) arg;
+    JackNotification n; initNotification(&n, NOTIFY_XRUN);
+    n.delay = jack_get_xrun_delayed_usecs(client->ptr);
+    pushNotification(client, &n);
+    return 0;
+}
+
+static int graphOrderCallback(void* arg)
+{
+    JackNotification n; initNotification(&n, NOTIFY_GRAPH_ORDER);
+    pushNotification((JackClientShared*) arg, &n);
+    return 0;
+}
+
+static void clientRegistrationCallback(const char* name, int reg, void* arg)
+{
+    JackNotification n; initNotification(&n, NOTIFY_CLIENT_REGISTRATION);
+    n.flag = reg;
+    strncpy(n.name, name, NOTIFY_NAME_SIZE - 1);
+    n.name[NOTIFY_NAME_SIZE - 1] = '\0';
+    pushNotification((JackClientShared*) arg, &n);
+}
+
+static void portConnectCallback(jack_port_id_t a, jack_port_id_t b, int connect, void* arg)
+{
+    JackNotification n; initNotification(&n, NOTIFY_PORT_CONNECT);
+    n.a    = a;
+    n.b    = b;
+    n.flag = connect;
+    pushNotification((JackClientShared*) arg, &n);
+}
+
+static int sampleRateCallback(jack_nframes_t rate, void* arg)
+{
+    JackNotification n; initNotification(&n, NOTIFY_SAMPLE_RATE);
+    n.a = rate;
+    pushNotification((JackClientShared*) arg, &n);
+    return 0;
+}
+
+static int bufferSizeCallback(jack_nframes_t nframes, void* arg)
+{
+    JackClientShared* client = (JackClientShared*) arg;
+    if (!resizeScratchPool(client, nframes)) {
+        verbosePrintf("cannot resize scratch buffers to %u frames\n", (unsigned) nframes);
+    }
+    JackNotification n; initNotification(&n, NOTIFY_BUFFER_SIZE);
+    n.a = nframes;
+    pushNotification(client, &n);
+    return 0;
+}
+
+static void portRegistrationCallback(jack_port_id_t port, int reg, void* arg)
+{
+    JackClientShared* client = (JackClientShared*) arg;
+    invalidateCachedPorts(client);
+    JackNotification n; initNotification(&n, NOTIFY_PORT_REGISTRATION);
+    n.a    = port;
+    n.flag = reg;
+    pushNotification(client, &n);
+}
+
+static int portRenameCallback(jack_port_id_t port, const char* oldName, const char* newName, void* arg)
+{
+    JackClientShared* client = (JackClientShared*) arg;
+    invalidateCachedPorts(client);
+    JackNotification n; initNotification(&n, NOTIFY_PORT_RENAME);
+    n.a = port;
+    strncpy(n.name, oldName, NOTIFY_NAME_SIZE - 1);
+    n.name[NOTIFY_NAME_SIZE - 1] = '\0';
+    pushNotification(client, &n);
+    return 0;
+}
+
+void setNotificationCallbacks(JackClientShared* client)
+{
+    jack_client_t* c = client->ptr;
+    jack_set_xrun_callback               (c, xrunCallback,               client);
+    jack_set_graph_order_callback        (c, graphOrderCallback,         client);
+    jack_set_client_registration_callback(c, clientRegistrationCallback, client);
+    jack_set_port_registration_callback  (c, portRegistrationCallback,   client);
+    jack_set_port_connect_callback       (c, portConnectCallback,        client);
+    jack_set_port_rename_callback        (c, portRenameCallback,         client);
+    jack_set_sample_rate_callback        (c, sampleRateCallback,         client);
+    jack_set_buffer_size_callback        (c, bufferSizeCallback,         client);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
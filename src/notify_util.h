@@ -0,0 +1,93 @@
+#ifndef LUAJACK_NOTIFY_UTIL_H
+#define LUAJACK_NOTIFY_UTIL_H
+
+#include "util.h"
+
+/////////////////////////////////////////////////////////////////////////////////
+
+typedef enum {
+    NOTIFY_XRUN,
+    NOTIFY_GRAPH_ORDER,
+    NOTIFY_CLIENT_REGISTRATION,
+    NOTIFY_PORT_REGISTRATION,
+    NOTIFY_PORT_CONNECT,
+    NOTIFY_PORT_RENAME,
+    NOTIFY_SAMPLE_RATE,
+    NOTIFY_BUFFER_SIZE
+}
+JackNotificationType;
+
+#define NOTIFY_NAME_SIZE 128
+
+typedef struct {
+    JackNotificationType type;
+    jack_time_t          time;     /* jack_get_time() when the notification arrived */
+    uint32_t             a;        /* port id, sample rate, buffer size */
+    uint32_t             b;        /* second port id */
+    bool                 flag;     /* registered or connected */
+    float                delay;    /* xrun delay in usecs */
+    char                 name[NOTIFY_NAME_SIZE];
+}
+JackNotification;
+
+typedef struct {
+    AtomicCounter    sequence;
+    JackNotification notification;
+}
+JackNotificationSlot;
+
+/* Bounded lock-free multi-producer/single-consumer queue: JACK may invoke
+ * notification callbacks from more than one thread, the main thread is the 
+ * only consumer. */
+typedef struct JackNotificationQueue {
+    JackNotificationSlot* slots;
+    uint32_t              mask;
+    AtomicCounter         enqueuePos;
+    AtomicCounter         dequeuePos;
+    AtomicCounter         dropped;
+    int                   fd;      /* eventfd signalled on new notifications or -1 */
+}
+JackNotificationQueue;
+
+/////////////////////////////////////////////////////////////////////////////////
+
+#define createNotificationQueue luajack_createNotificationQueue 
+
+JackNotificationQueue* createNotificationQueue(uint32_t capacity, bool withFd);
+
+#define releaseNotificationQueue luajack_releaseNotificationQueue 
+
+void releaseNotificationQueue(JackNotificationQueue* queue);
+
+#define pushNotification luajack_pushNotification 
+
+void pushNotification(JackClientShared* client, JackNotification* notification);
+
+#define popNotification luajack_popNotification 
+
+bool popNotification(JackNotificationQueue* queue, JackNotification* notification);
+
+/* Makes the eventfd of the queue readable (if any), e.g. if notifications 
+ * remain queued after the fd was reset by the consumer. */
+
+#define signalNotificationQueue luajack_signalNotificationQueue 
+
+void signalNotificationQueue(JackNotificationQueue* queue);
+
+#define hasNotification luajack_hasNotification 
+
+bool hasNotification(JackNotificationQueue* queue);
+
+/////////////////////////////////////////////////////////////////////////////////
+
+/* Sets all JACK notification callbacks for the client. The callbacks do not 
+ * invoke Lua, they only queue notifications if the client has a notification
+ * queue. Must be called before the client is activated. */
+
+#define setNotificationCallbacks luajack_setNotificationCallbacks 
+
+void setNotificationCallbacks(JackClientShared* client);
+
+/////////////////////////////////////////////////////////////////////////////////
+
+#endif // LUAJACK_NOTIFY_UTIL_H
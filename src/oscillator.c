@@ -0,0 +1,273 @@
+#include <math.h>
+
+#include "util.h"
+#include "oscillator.h"
+#include "oscillator_util.h"
+#include "array_util.h"
+
+static const char* const OscillatorKindNames[] = { "sine", "saw", "square", NULL };
+
+static int wavetable_new(lua_State* L)
+/* wavetable = jack.wavetable(cycle [, size])
+ * creates band limited mip levels from one cycle of a waveform given as 
+ * array of sample values or as jack.array. size is the table length, a power
+ * of two (default 2048). The wavetable is immutable and can be passed to the
+ * process context and shared by any number of oscillators.
+ */
+{
+    JackArray*  array  = getOptionalArray(L, 1);
+    if (!array) {
+        luaL_checktype(L, 1, LUA_TTABLE);
+    }
+    luaL_argcheck(L, !array || array->shared, 1, "released array");
+    int         length = array ? (int) array->shared->length : (int) luaL_len(L, 1);
+    lua_Integer size   = luaL_optinteger(L, 2, 2048);
+    luaL_argcheck(L, length >= 1, 1, "empty cycle");
+    luaL_argcheck(L, size >= 16 && size <= 65536 && (size & (size - 1)) == 0, 2, 
+                     "size must be a power of two between 16 and 65536");
+
+    float* cycle = NULL;
+    if (!array) {
+        cycle = (float*) malloc(sizeof(float) * length);
+        if (!cycle) {
+            return luaL_error(L, "out of memory");
+        }
+        int i;
+        for (i = 0; i < length; ++i) {
+            lua_rawgeti(L, 1, i + 1);
+            cycle[i] = (float) lua_tonumber(L, -1);
+            lua_pop(L, 1);
+        }
+    }
+    JackWavetable* wavetable = (JackWavetable*) lua_newuserdata(L, sizeof(JackWavetable));
+    memset(wavetable, 0, sizeof(JackWavetable));
+    luaL_setmetatable(L, WAVETABLE_TYPE_NAME);
+    wavetable->shared = createWavetable(array ? array->shared->data : cycle, length, (int) size);
+    free(cycle);
+    if (!wavetable->shared) {
+        return luaL_error(L, "cannot create wavetable");
+    }
+    return 1;
+}
+
+static int wavetable_release(lua_State* L)
+{
+    JackWavetable* wavetable = getCheckedWavetable(L, 1);
+    releaseWavetable(wavetable->shared);
+    wavetable->shared = NULL;
+    return 0;
+}
+
+static int wavetable_toString(lua_State* L)
+{
+    JackWavetable* wavetable = getCheckedWavetable(L, 1);
+    lua_pushfstring(L, "%s: %p", WAVETABLE_TYPE_NAME, wavetable->shared);
+    return 1;
+}
+
+static int wavetable_size(lua_State* L)
+{
+    JackWavetable* wavetable = getCheckedWavetable(L, 1);
+    lua_pushinteger(L, wavetable->shared->size);
+    return 1;
+}
+
+static int wavetable_levels(lua_State* L)
+{
+    JackWavetable* wavetable = getCheckedWavetable(L, 1);
+    lua_pushinteger(L, wavetable->shared->levels);
+    return 1;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+static int oscillator_new(lua_State* L)
+/* oscillator = client:oscillator(waveform [, frequency [, amplitude]])
+ * waveform  - "sine", "saw", "square" or a wavetable. Saw and square are 
+ *             band limited with polyBLEP, wavetables by mip level selection.
+ * frequency - in Hz (default 440)
+ * amplitude - linear (default 1)
+ * Oscillators are intended to be created in the process context.
+ */
+{
+    JackClient*    client    = getCheckedClient(L, 1);
+    JackWavetable* wavetable = getOptionalWavetable(L, 2);
+    int            kind      = OSCILLATOR_WAVETABLE;
+    if (!wavetable) {
+        kind = luaL_checkoption(L, 2, NULL, OscillatorKindNames);
+    } else if (!wavetable->shared) {
+        return luaL_argerror(L, 2, "released wavetable");
+    }
+    lua_Number frequency = luaL_optnumber(L, 3, 440);
+    lua_Number amplitude = luaL_optnumber(L, 4, 1);
+    luaL_argcheck(L, isfinite(frequency), 3, "finite number expected");
+    luaL_argcheck(L, isfinite(amplitude), 4, "finite number expected");
+
+    JackOscillator* oscillator = (JackOscillator*) lua_newuserdata(L, sizeof(JackOscillator));
+    initOscillator(oscillator, (JackOscillatorKind) kind, wavetable ? wavetable->shared : NULL,
+                   (float) jack_get_sample_rate(client->ptr), (float) frequency, (float) amplitude);
+    luaL_setmetatable(L, OSCILLATOR_TYPE_NAME);
+    return 1;
+}
+
+static int oscillator_release(lua_State* L)
+{
+    JackOscillator* oscillator = getCheckedOscillator(L, 1);
+    releaseWavetable(oscillator->wavetable);
+    oscillator->wavetable = NULL;
+    return 0;
+}
+
+static int oscillator_toString(lua_State* L)
+{
+    JackOscillator* oscillator = getCheckedOscillator(L, 1);
+    lua_pushfstring(L, "%s: %s (%p)", OSCILLATOR_TYPE_NAME, 
+                                      oscillator->wavetable ? "wavetable" 
+                                                            : OscillatorKindNames[oscillator->kind],
+                                      oscillator);
+    return 1;
+}
+
+static int oscillator_set(lua_State* L)
+/* oscillator:set(frequency [, amplitude])
+ * sets new values, they are ramped linearly during the next rendered block.
+ */
+{
+    JackOscillator* oscillator = getCheckedOscillator(L, 1);
+    lua_Number frequency = luaL_checknumber(L, 2);
+    lua_Number amplitude = luaL_optnumber(L, 3, oscillator->targetAmplitude);
+    luaL_argcheck(L, isfinite(frequency), 2, "finite number expected");
+    luaL_argcheck(L, isfinite(amplitude), 3, "finite number expected");
+    setOscillator(oscillator, (float) frequency, (float) amplitude);
+    return 0;
+}
+
+static int oscillator_frequency(lua_State* L)
+{
+    JackOscillator* oscillator = getCheckedOscillator(L, 1);
+    lua_pushnumber(L, oscillator->targetIncrement * oscillator->sampleRate);
+    return 1;
+}
+
+static int oscillator_amplitude(lua_State* L)
+{
+    JackOscillator* oscillator = getCheckedOscillator(L, 1);
+    lua_pushnumber(L, oscillator->targetAmplitude);
+    return 1;
+}
+
+static int oscillator_reset(lua_State* L)
+/* oscillator:reset([phase])
+ * sets the phase in cycles (default 0).
+ */
+{
+    JackOscillator* oscillator = getCheckedOscillator(L, 1);
+    lua_Number phase = luaL_optnumber(L, 2, 0);
+    luaL_argcheck(L, isfinite(phase), 2, "finite number expected");
+    oscillator->phase = wrapPhase(phase);
+    return 0;
+}
+
+static int oscillator_render(lua_State* L)
+/* oscillator:render(dst)
+ * writes the signal into the buffer of a port or scratch buffer. Advances the 
+ * oscillator by one block.
+ */
+{
+    JackOscillator* oscillator = getCheckedOscillator(L, 1);
+    jack_nframes_t nframes;
+    jack_default_audio_sample_t* out = getCheckedSignalBuffer(L, 2, &nframes);
+    if (out) {
+        renderOscillator(oscillator, out, nframes, false);
+    }
+    return 0;
+}
+
+static int oscillator_add(lua_State* L)
+/* oscillator:add(dst)
+ * adds the signal to the buffer of a port or scratch buffer. Advances the 
+ * oscillator by one block.
+ */
+{
+    JackOscillator* oscillator = getCheckedOscillator(L, 1);
+    jack_nframes_t nframes;
+    jack_default_audio_sample_t* out = getCheckedSignalBuffer(L, 2, &nframes);
+    if (out) {
+        renderOscillator(oscillator, out, nframes, true);
+    }
+    return 0;
+}
+
+static const struct luaL_Reg ClientMethods[] = 
+{
+    { "oscillator", oscillator_new },
+    { NULL, NULL } /* sentinel */
+};
+
+static const struct luaL_Reg OscillatorMetaMethods[] = 
+{
+    { "__tostring", oscillator_toString },
+    { "__gc",       oscillator_release },
+    { NULL, NULL } /* sentinel */
+};
+
+static const struct luaL_Reg OscillatorMethods[] = 
+{
+    { "set",        oscillator_set },
+    { "frequency",  oscillator_frequency },
+    { "amplitude",  oscillator_amplitude },
+    { "reset",      oscillator_reset },
+    { "render",     oscillator_render },
+    { "add",        oscillator_add },
+    { NULL, NULL } /* sentinel */
+};
+
+static const struct luaL_Reg WavetableMetaMethods[] = 
+{
+    { "__tostring", wavetable_toString },
+    { "__gc",       wavetable_release },
+    { NULL, NULL } /* sentinel */
+};
+
+static const struct luaL_Reg WavetableMethods[] = 
+{
+    { "size",       wavetable_size },
+    { "levels",     wavetable_levels },
+    { NULL, NULL } /* sentinel */
+};
+
+static const struct luaL_Reg ModuleFunctions[] = 
+{
+    { "oscillator", oscillator_new },
+    { "wavetable",  wavetable_new },
+    { NULL, NULL } /* sentinel */
+};
+
+bool luajack_open_oscillator(lua_State* L, int module, int clientMeta, int clientClass,
+                                                       int oscillatorMeta, int oscillatorClass,
+                                                       int wavetableMeta,  int wavetableClass)
+{
+    initSineTable();
+
+    lua_pushvalue(L, module);
+        setfuncs(L, ModuleFunctions);
+
+        lua_pushvalue(L, clientClass);
+            setfuncs(L, ClientMethods);
+
+            lua_pushvalue(L, oscillatorMeta);
+                setfuncs(L, OscillatorMetaMethods);
+    
+                lua_pushvalue(L, oscillatorClass);
+                    setfuncs(L, OscillatorMethods);
+    
+                    lua_pushvalue(L, wavetableMeta);
+                        setfuncs(L, WavetableMetaMethods);
+    
+                        lua_pushvalue(L, wavetableClass);
+                            setfuncs(L, WavetableMethods);
+    
+    lua_pop(L, 6);
+    
+    return true;
+}
@@ -0,0 +1,8 @@
+#ifndef LUAJACK_OSCILLATOR_H
+#define LUAJACK_OSCILLATOR_H
+
+bool luajack_open_oscillator(lua_State* L, int module, int clientMeta, int clientClass,
+                                                       int oscillatorMeta, int oscillatorClass,
+                                                       int wavetableMeta,  int wavetableClass);
+
+#endif // LUAJACK_OSCILLATOR_H
@@ -0,0 +1,217 @@
+#include <stdlib.h>
+#include <math.h>
+
+#include "util.h"
+#include "oscillator_util.h"
+#include "fft_util.h"
+
+#define SINE_TABLE_SIZE 4096
+
+static float SineTable[SINE_TABLE_SIZE + 1];
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+JackWavetableShared* createWavetable(const float* cycle, int length, int size)
+{
+    JackWavetableShared* wavetable = (JackWavetableShared*) calloc(1, sizeof(JackWavetableShared));
+    if (!wavetable) {
+        return NULL;
+    }
+    int levels = 0;
+    while (((size / 2) >> levels) >= 1) {
+        ++levels;
+    }
+    wavetable->refCounter = 1;
+    wavetable->size       = size;
+    wavetable->levels     = levels;
+    wavetable->tables     = (float*) malloc(sizeof(float) * levels * (size + 1));
+
+    JackFft* fft = createFft(size);
+    float* in = (float*) malloc(sizeof(float) * size);
+    float* re = (float*) malloc(sizeof(float) * (size / 2 + 1));
+    float* im = (float*) malloc(sizeof(float) * (size / 2 + 1));
+    float* fr = (float*) malloc(sizeof(float) * (size / 2 + 1));
+    float* fi = (float*) malloc(sizeof(float) * (size / 2 + 1));
+    
+    if (wavetable->tables && fft && in && re && im && fr && fi) {
+        int i, l;
+        /* resample the cycle to size by linear interpolation */
+        for (i = 0; i < size; ++i) {
+            float x    = (float) i * length / size;
+            int   j    = (int) x;
+            float frac = x - j;
+            in[i] = cycle[j] + frac * (cycle[(j + 1) % length] - cycle[j]);
+        }
+        realFft(fft, in, re, im);
+        re[0] = 0; /* remove DC */
+        for (l = 0; l < levels; ++l) {
+            int    maxHarmonic = (size / 2) >> l;
+            float* table       = wavetable->tables + (size_t) l * (size + 1);
+            for (i = 0; i <= size / 2; ++i) {
+                fr[i] = (i <= maxHarmonic) ? re[i] : 0;
+                fi[i] = (i <= maxHarmonic) ? im[i] : 0;
+            }
+            /* the Nyquist bin has no defined phase */
+            if (maxHarmonic == size / 2) {
+                fr[size / 2] = 0;
+            }
+            realIfft(fft, fr, fi, table);
+            table[size] = table[0];
+        }
+    } else {
+        releaseWavetable(wavetable);
+        wavetable = NULL;
+    }
+    releaseFft(fft);
+    free(in);
+    free(re);
+    free(im);
+    free(fr);
+    free(fi);
+    return wavetable;
+}
+
+void releaseWavetable(JackWavetableShared* wavetable)
+{
+    if (wavetable && atomic_dec(&wavetable->refCounter) == 0) {
+        free(wavetable->tables);
+        free(wavetable);
+    }
+}
+
+void transferWavetable(lua_State* T, JackWavetableShared* sharedWavetable)
+{
+    JackWavetable* wavetable = (JackWavetable*) lua_newuserdata(T, sizeof(JackWavetable));
+    memset(wavetable, 0, sizeof(JackWavetable));
+    luaL_setmetatable(T, WAVETABLE_TYPE_NAME);
+    wavetable->shared = sharedWavetable;
+    atomic_inc(&sharedWavetable->refCounter);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+void initSineTable(void)
+{
+    /* every Lua state opening the module calls this, other clients may 
+     * already be rendering from the table */
+    if (SineTable[SINE_TABLE_SIZE / 4] == 1.0f) {
+        return;
+    }
+    int i;
+    for (i = 0; i <= SINE_TABLE_SIZE; ++i) {
+        SineTable[i] = (float) sin(2.0 * M_PI * i / SINE_TABLE_SIZE);
+    }
+}
+
+void initOscillator(JackOscillator* oscillator, JackOscillatorKind kind, JackWavetableShared* wavetable,
+                    float sampleRate, float frequency, float amplitude)
+{
+    memset(oscillator, 0, sizeof(JackOscillator));
+    oscillator->kind            = kind;
+    oscillator->sampleRate      = sampleRate;
+    oscillator->wavetable       = wavetable;
+    setOscillator(oscillator, frequency, amplitude);
+    oscillator->increment       = oscillator->targetIncrement;
+    oscillator->amplitude       = amplitude;
+    if (wavetable) {
+        atomic_inc(&wavetable->refCounter);
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+/* polynomial band limited step, t is the phase, dt the increment */
+static inline float polyBlep(float t, float dt)
+{
+    if (t < dt) {
+        t /= dt;
+        return t + t - t * t - 1.0f;
+    } else if (t > 1.0f - dt) {
+        t = (t - 1.0f) / dt;
+        return t * t + t + t + 1.0f;
+    }
+    return 0;
+}
+
+static inline float lookup(const float* table, int size, float phase)
+{
+    float x    = phase * size;
+    int   i    = (int) x;
+    float frac = x - i;
+    return table[i] + frac * (table[i + 1] - table[i]);
+}
+
+/* the highest level whose harmonics all stay below Nyquist */
+static int selectLevel(JackWavetableShared* wavetable, float increment)
+{
+    int l = 0;
+    while (l < wavetable->levels - 1 && ((wavetable->size / 2) >> l) * increment >= 0.5f) {
+        ++l;
+    }
+    return l;
+}
+
+/* The phase of frame i is computed directly instead of accumulated, so the
+ * loops have no dependency between iterations and can be vectorized. Both 
+ * increment and amplitude ramp linearly over the block. */
+
+#define OSCILLATOR_LOOP(value) \
+    if (accumulate) { \
+        for (i = 0; i < nframes; ++i) { \
+            float fi = (float) i; \
+            float p  = phase + fi * inc + 0.5f * fi * (fi - 1.0f) * incStep; \
+            p -= floorf(p); \
+            out[i] += (amp + fi * ampStep) * (value); \
+        } \
+    } else { \
+        for (i = 0; i < nframes; ++i) { \
+            float fi = (float) i; \
+            float p  = phase + fi * inc + 0.5f * fi * (fi - 1.0f) * incStep; \
+            p -= floorf(p); \
+            out[i]  = (amp + fi * ampStep) * (value); \
+        } \
+    }
+
+void renderOscillator(JackOscillator* o, float* out, jack_nframes_t nframes, bool accumulate)
+{
+    if (nframes == 0) {
+        return;
+    }
+    const float phase   = o->phase;
+    const float inc     = o->increment;
+    const float amp     = o->amplitude;
+    const float incStep = (o->targetIncrement - inc) / nframes;
+    const float ampStep = (o->targetAmplitude - amp) / nframes;
+    jack_nframes_t i;
+
+    switch (o->kind) {
+        case OSCILLATOR_SINE: {
+            OSCILLATOR_LOOP(lookup(SineTable, SINE_TABLE_SIZE, p))
+            break;
+        }
+        case OSCILLATOR_SAW: {
+            OSCILLATOR_LOOP(2.0f * p - 1.0f - polyBlep(p, inc + fi * incStep))
+            break;
+        }
+        case OSCILLATOR_SQUARE: {
+            OSCILLATOR_LOOP(((p < 0.5f) ? 1.0f : -1.0f) 
+                            + polyBlep(p, inc + fi * incStep) 
+                            - polyBlep(p + ((p < 0.5f) ? 0.5f : -0.5f), inc + fi * incStep))
+            break;
+        }
+        case OSCILLATOR_WAVETABLE: {
+            JackWavetableShared* w = o->wavetable;
+            float maxInc = inc > o->targetIncrement ? inc : o->targetIncrement;
+            const float* table = w->tables + (size_t) selectLevel(w, maxInc) * (w->size + 1);
+            OSCILLATOR_LOOP(lookup(table, w->size, p))
+            break;
+        }
+    }
+    double n   = nframes;
+    double end = phase + n * inc + 0.5 * n * (n - 1) * incStep;
+    o->phase     = wrapPhase(end);
+    o->increment = o->targetIncrement;
+    o->amplitude = o->targetAmplitude;
+}
+
+//////////
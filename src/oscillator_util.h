@@ -0,0 +1,126 @@
+#ifndef LUAJACK_OSCILLATOR_UTIL_H
+#define LUAJACK_OSCILLATOR_UTIL_H
+
+#include <math.h>
+
+#include "util.h"
+
+/////////////////////////////////////////////////////////////////////////////////
+
+/* Band limited single cycle waveform, level l contains the harmonics up to
+ * (size/2) >> l. Immutable after creation, so it can be shared read-only by 
+ * any number of oscillators in main and process context. */
+
+typedef struct {
+    AtomicCounter        refCounter;
+    int                  size;           /* power of two */
+    int                  levels;
+    float*               tables;         /* levels * (size + 1), with guard point */
+}
+JackWavetableShared;
+
+typedef struct {
+    JackWavetableShared* shared;
+}
+JackWavetable;
+
+static inline JackWavetable* getCheckedWavetable(lua_State* L, int stackIndex)
+{
+    JackWavetable* wavetable = (JackWavetable*) checkudata(L, stackIndex, WAVETABLE_TYPE, WAVETABLE_TYPE_NAME);
+    return wavetable;
+}
+
+static inline JackWavetable* getOptionalWavetable(lua_State* L, int stackIndex)
+{
+    JackWavetable* wavetable = (JackWavetable*) testudata(L, stackIndex, WAVETABLE_TYPE, WAVETABLE_TYPE_NAME);
+    return wavetable;
+}
+
+/////////////////////////////////////////////////////////////////////////////////
+
+typedef enum {
+    OSCILLATOR_SINE,
+    OSCILLATOR_SAW,       /* polyBLEP */
+    OSCILLATOR_SQUARE,    /* polyBLEP */
+    OSCILLATOR_WAVETABLE
+}
+JackOscillatorKind;
+
+typedef struct {
+    JackOscillatorKind   kind;
+    float                sampleRate;
+    float                phase;          /* 0 .. 1 */
+    float                increment;      /* cycles per frame */
+    float                targetIncrement;
+    float                amplitude;
+    float                targetAmplitude;
+    JackWavetableShared* wavetable;
+}
+JackOscillator;
+
+static inline JackOscillator* getCheckedOscillator(lua_State* L, int stackIndex)
+{
+    JackOscillator* oscillator = (JackOscillator*) checkudata(L, stackIndex, OSCILLATOR_TYPE, OSCILLATOR_TYPE_NAME);
+    return oscillator;
+}
+
+/////////////////////////////////////////////////////////////////////////////////
+
+/* Builds the mip levels from one cycle of arbitrary length */
+
+#define createWavetable luajack_createWavetable 
+
+JackWavetableShared* createWavetable(const float* cycle, int length, int size);
+
+#define releaseWavetable luajack_releaseWavetable 
+
+void releaseWavetable(JackWavetableShared* wavetable);
+
+#define transferWavetable luajack_transferWavetable 
+
+void transferWavetable(lua_State* T, JackWavetableShared* wavetable);
+
+/////////////////////////////////////////////////////////////////////////////////
+
+#define initSineTable luajack_initSineTable
+
+void initSineTable(void);
+
+/* wavetable may be NULL for the other kinds, the oscillator takes a
+ * reference */
+
+#define initOscillator luajack_initOscillator
+
+void initOscillator(JackOscillator* oscillator, JackOscillatorKind kind, JackWavetableShared* wavetable,
+                    float sampleRate, float frequency, float amplitude);
+
+/* Frequency and amplitude are ramped linearly to the new values during 
+ * the next rendered block, the frequency is clamped to 0 .. Nyquist, a NaN
+ * frequency is taken as 0 */
+
+static inline void setOscillator(JackOscillator* oscillator, float frequency, float amplitude)
+{
+    float nyquist = 0.5f * oscillator->sampleRate;
+    frequency = !(frequency > 0) ? 0 : (frequency > nyquist) ? nyquist : frequency;
+    oscillator->targetIncrement = frequency / oscillator->sampleRate;
+    oscillator->targetAmplitude = amplitude;
+}
+
+/* Fractional part of a phase in cycles as float in 0 .. 1 (exclusive), the
+ * rounding to float must not yield 1 */
+
+static inline float wrapPhase(double phase)
+{
+    float p = (float)(phase - floor(phase));
+    return (p < 1.0f) ? p : 0.0f;
+}
+
+/* out[i] = signal or out[i] += signal, advances the oscillator by nframes */
+
+#define renderOscillator luajack_renderOscillator
+
+void renderOscillator(JackOscillator* oscillator, float* out, jack_nframes_t nframes, bool accumulate);
+
+/////////////////////////////////////////////////////////////////////////////////
+
+#endif // LUAJACK_OSCILLATOR_UTIL_H
@@ -2,6 +2,9 @@
 #include <string.h>
 #include <stdio.h>
 
+#include <errno.h>
+#include <regex.h>
+
 #include <jack/session.h>
 
 #include "util.h"
@@ -58,6 +61,473 @@ static int output_midi_port(lua_State* L)
 }    
 
 
+static int port_name(lua_State* L)
+{
+    JackPort* port = getCheckedPort(L, 1);
+    lua_pushstring(L, jack_port_name(port->ptr));
+    return 1;
+}
+
+static int port_short_name(lua_State* L)
+{
+    JackPort* port = getCheckedPort(L, 1);
+    lua_pushstring(L, jack_port_short_name(port->ptr));
+    return 1;
+}
+
+static int port_type(lua_State* L)
+{
+    JackPort* port = getCheckedPort(L, 1);
+    lua_pushstring(L, jack_port_type(port->ptr));
+    return 1;
+}
+
+static void pushPortFlags(lua_State* L, int flags)
+{
+    lua_createtable(L, 0, 5);
+    lua_pushboolean(L, flags & JackPortIsInput);    lua_setfield(L, -2, "is_input");
+    lua_pushboolean(L, flags & JackPortIsOutput);   lua_setfield(L, -2, "is_output");
+    lua_pushboolean(L, flags & JackPortIsPhysical); lua_setfield(L, -2, "is_physical");
+    lua_pushboolean(L, flags & JackPortCanMonitor); lua_setfield(L, -2, "can_monitor");
+    lua_pushboolean(L, flags & JackPortIsTerminal); lua_setfield(L, -2, "is_terminal");
+}
+
+static int port_flags(lua_State* L)
+{
+    JackPort* port = getCheckedPort(L, 1);
+    pushPortFlags(L, jack_port_flags(port->ptr));
+    return 1;
+}
+
+static jack_port_t* checkPortByName(lua_State* L, JackClient* client, int arg)
+{
+    const char*  name = checkPortName(L, arg);
+    jack_port_t* port = jack_port_by_name(client->ptr, name);
+    if (!port) {
+        luaL_error(L, "unknown port '%s'", name);
+    }
+    return port;
+}
+
+static int nport_flags(lua_State* L)
+{
+    JackClient* client = getCheckedClient(L, 1);
+    pushPortFlags(L, jack_port_flags(checkPortByName(L, client, 2)));
+    return 1;
+}
+
+static int nport_type(lua_State* L)
+{
+    JackClient* client = getCheckedClient(L, 1);
+    lua_pushstring(L, jack_port_type(checkPortByName(L, client, 2)));
+    return 1;
+}
+
+static int nport_exists(lua_State* L)
+{
+    JackClient* client = getCheckedClient(L, 1);
+    const char* name   = checkPortName(L, 2);
+    lua_pushboolean(L, jack_port_by_name(client->ptr, name) != NULL);
+    return 1;
+}
+
+static int port_is_mine(lua_State* L)
+{
+    JackClient* client = getCheckedClient(L, 1);
+    lua_pushboolean(L, jack_port_is_mine(client->ptr, checkPortByName(L, client, 2)));
+    return 1;
+}
+
+static int port_connections(lua_State* L)
+{
+    JackPort* port = getCheckedPort(L, 1);
+    const char** names = jack_port_get_connections(port->ptr);
+    pushPortNames(L, names);
+    if (names) jack_free(names);
+    return 1;
+}
+
+static int nport_connections(lua_State* L)
+{
+    JackClient* client = getCheckedClient(L, 1);
+    const char** names = jack_port_get_all_connections(client->ptr, checkPortByName(L, client, 2));
+    pushPortNames(L, names);
+    if (names) jack_free(names);
+    return 1;
+}
+
+static int port_connected(lua_State* L)
+/* n = port:connected()          - number of connections
+ * bool = port:connected(other)  - true if connected to other port
+ */
+{
+    JackPort* port = getCheckedPort(L, 1);
+    if (lua_isnoneornil(L, 2)) {
+        lua_pushinteger(L, jack_port_connected(port->ptr));
+    } else {
+        lua_pushboolean(L, jack_port_connected_to(port->ptr, checkPortName(L, 2)));
+    }
+    return 1;
+}
+
+static int nport_connected(lua_State* L)
+{
+    JackClient*  client = getCheckedClient(L, 1);
+    jack_port_t* port   = checkPortByName(L, client, 2);
+    lua_pushboolean(L, jack_port_connected_to(port, checkPortName(L, 3)));
+    return 1;
+}
+
+/////////////////////////////////////////////////////////////////////////////////
+
+static bool matches(regex_t* regex, const char* s)
+{
+    return !regex || regexec(regex, s, 0, NULL, 0) == 0;
+}
+
+static bool compilePattern(regex_t* regex, const char* pattern)
+{
+    return regcomp(regex, pattern, REG_EXTENDED | REG_NOSUB) == 0;
+}
+
+/* Copies the names of the cached ports into one malloc'ed block: a NULL 
+ * terminated array of pointers followed by the strings. Returns NULL if out 
+ * of memory. The ports cache is only locked while copying, must not raise 
+ * Lua errors. */
+static const char** copyCachedPorts(JackClient* client)
+{
+    async_mutex_lock(&client->shared->portsCacheMutex);
+    const char** names = getCachedPorts(client->shared);
+    size_t       count = 0;
+    size_t       bytes = 0;
+    int i;
+    for (i = 0; names && names[i]; ++i) {
+        count += 1;
+        bytes += strlen(names[i]) + 1;
+    }
+    const char** result = (const char**) malloc(sizeof(const char*) * (count + 1) + bytes);
+    if (result) {
+        char* p = (char*)(result + count + 1);
+        for (i = 0; names && names[i]; ++i) {
+            size_t len = strlen(names[i]) + 1;
+            memcpy(p, names[i], len);
+            result[i] = p;
+            p += len;
+        }
+        result[i] = NULL;
+    }
+    async_mutex_unlock(&client->shared->portsCacheMutex);
+    return result;
+}
+
+/* Removes the names not matching the patterns and flags from the NULL 
+ * terminated array in place, must not raise Lua errors. */
+static void filterPorts(JackClient* client, const char** names, regex_t* nameRegex, regex_t* typeRegex, int flags)
+{
+    int i, n = 0;
+    for (i = 0; names[i]; ++i) {
+        if (!matches(nameRegex, names[i])) {
+            continue;
+        }
+        if (typeRegex || flags) {
+            jack_port_t* port = jack_port_by_name(client->ptr, names[i]);
+            if (!port 
+             || (jack_port_flags(port) & flags) != flags
+             || !matches(typeRegex, jack_port_type(port))) {
+                continue;
+            }
+        }
+        names[n++] = names[i];
+    }
+    names[n] = NULL;
+}
+
+static int pushNameList(lua_State* L)
+{
+    pushPortNames(L, (const char**) lua_touserdata(L, 1));
+    return 1;
+}
+
+static int get_ports(lua_State* L)
+/* names = client:get_ports([name_pattern [, options]])
+ * name_pattern - regular expression for the port names
+ * options      - type: "audio", "midi" or regular expression for the port type
+ *                is_input, is_output, is_physical, can_monitor, is_terminal: 
+ *                only ports having all given flags
+ * The list of all ports is cached in the client and only queried from the
+ * server again after ports have been registered, unregistered or renamed.
+ */
+{
+    JackClient* client      = getCheckedClient(L, 1);
+    const char* namePattern = luaL_optstring(L, 2, NULL);
+    const char* typePattern = NULL;
+    int         flags       = 0;
+    
+    if (lua_istable(L, 3)) {
+        lua_getfield(L, 3, "type");
+        typePattern = luaL_optstring(L, -1, NULL);
+        if (typePattern && strcmp(typePattern, "audio") == 0) typePattern = JACK_DEFAULT_AUDIO_TYPE;
+        if (typePattern && strcmp(typePattern, "midi")  == 0) typePattern = JACK_DEFAULT_MIDI_TYPE;
+        lua_getfield(L, 3, "is_input");    if (lua_toboolean(L, -1)) flags |= JackPortIsInput;
+        lua_getfield(L, 3, "is_output");   if (lua_toboolean(L, -1)) flags |= JackPortIsOutput;
+        lua_getfield(L, 3, "is_physical"); if (lua_toboolean(L, -1)) flags |= JackPortIsPhysical;
+        lua_getfield(L, 3, "can_monitor"); if (lua_toboolean(L, -1)) flags |= JackPortCanMonitor;
+        lua_getfield(L, 3, "is_terminal"); if (lua_toboolean(L, -1)) flags |= JackPortIsTerminal;
+        lua_pop(L, 5); /* keep type string */
+    }
+    /* pushed before the patterns are compiled, nothing may raise until they
+     * are freed */
+    lua_pushcfunction(L, pushNameList);
+
+    regex_t nameRegex, typeRegex;
+    bool    nameValid = !namePattern || compilePattern(&nameRegex, namePattern);
+    bool    typeValid = !typePattern || compilePattern(&typeRegex, typePattern);
+    if (!nameValid || !typeValid) {
+        if (namePattern && nameValid) regfree(&nameRegex);
+        if (typePattern && typeValid) regfree(&typeRegex);
+        return luaL_error(L, "invalid pattern '%s'", nameValid ? typePattern : namePattern);
+    }
+    
+    const char** names = copyCachedPorts(client);
+    if (names) {
+        filterPorts(client, names, namePattern ? &nameRegex : NULL, 
+                                   typePattern ? &typeRegex : NULL, flags);
+    }
+    if (namePattern) regfree(&nameRegex);
+    if (typePattern) regfree(&typeRegex);
+    if (!names) {
+        return luaL_error(L, "out of memory");
+    }
+    /* the names are pushed in protected mode, so that they are also freed 
+     * on memory errors */
+    lua_pushlightuserdata(L, names);
+    int rc = lua_pcall(L, 1, 1, 0);
+    free(names);
+    if (rc != 0) {
+        return lua_error(L);
+    }
+    return 1;
+}
+
+/////////////////////////////////////////////////////////////////////////////////
+
+typedef struct {
+    const char*  src;
+    const char*  dst;
+    jack_port_t* srcPort;
+    jack_port_t* dstPort;
+}
+PortPair;
+
+static const char* pairName(lua_State* L, int pairsIndex, lua_Integer i, int j)
+{
+    lua_geti(L, -1, j);
+    JackPort*   port = getOptionalPort(L, -1);
+    const char* name = NULL;
+    if (port) {
+        name = port->ptr ? jack_port_name(port->ptr) : NULL;
+    } else if (lua_type(L, -1) == LUA_TSTRING) {
+        name = lua_tostring(L, -1);
+    }
+    lua_pop(L, 1); /* the name string or the port is kept alive by the pairs table */
+    if (!name) {
+        luaL_argerror(L, pairsIndex, lua_pushfstring(L, "invalid port in pair #%d", (int)i));
+    }
+    return name;
+}
+
+static PortPair* checkPortPairs(lua_State* L, JackClient* client, int pairsIndex, lua_Integer* n)
+{
+    *n = luaL_len(L, pairsIndex);
+    PortPair* pairs = (PortPair*) lua_newuserdata(L, sizeof(PortPair) * (*n + 1));
+    lua_Integer i;
+    for (i = 1; i <= *n; ++i) {
+        PortPair* p = pairs + i - 1;
+        lua_geti(L, pairsIndex, i);
+        if (!lua_istable(L, -1)) {
+            luaL_error(L, "pair #%d must be a table", (int)i);
+        }
+        p->src = pairName(L, pairsIndex, i, 1);
+        p->dst = pairName(L, pairsIndex, i, 2);
+        lua_pop(L, 1);
+        p->srcPort = jack_port_by_name(client->ptr, p->src);
+        p->dstPort = jack_port_by_name(client->ptr, p->dst);
+    }
+    return pairs;
+}
+
+static bool isWanted(PortPair* pairs, lua_Integer n, const char* src, const char* dst)
+{
+    lua_Integer i;
+    for (i = 0; i < n; ++i) {
+        if (strcmp(pairs[i].src, src) == 0 && strcmp(pairs[i].dst, dst) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void disconnectUnwanted(JackClient* client, PortPair* pairs, lua_Integer n, 
+                               jack_port_t* port, bool isSource)
+{
+    const char** names = jack_port_get_all_connections(client->ptr, port);
+    if (names) {
+        const char* name = jack_port_name(port);
+        int i;
+        for (i = 0; names[i]; ++i) {
+            const char* src = isSource ? name : names[i];
+            const char* dst = isSource ? names[i] : name;
+            if (!isWanted(pairs, n, src, dst)) {
+                jack_disconnect(client->ptr, src, dst);
+            }
+        }
+        jack_free(names);
+    }
+}
+
+static int bulkConnect(lua_State* L, JackClient* client, bool connect)
+/* n, errors = client:connect(pairs [, options])
+ * n, errors = client:disconnect(pairs)
+ * pairs   - list of {source, destination} port names or port objects 
+ * options - exclusive: the ports in the list are disconnected from all 
+ *                      ports not listed (patch recall)
+ * Pairs that are already in the wanted state are skipped without a server 
+ * request. Returns the number of pairs that are in the wanted state and a 
+ * table with error messages indexed by pair number or nil if all succeeded.
+ */
+{
+    bool exclusive = false;
+    if (connect && lua_istable(L, 3)) {
+        lua_getfield(L, 3, "exclusive");
+        exclusive = lua_toboolean(L, -1);
+        lua_pop(L, 1);
+    }
+    lua_Integer n;
+    PortPair* pairs = checkPortPairs(L, client, 2, &n);
+    
+    if (exclusive) {
+        lua_Integer i;
+        for (i = 0; i < n; ++i) {
+            if (pairs[i].srcPort) disconnectUnwanted(client, pairs, n, pairs[i].srcPort, true);
+            if (pairs[i].dstPort) disconnectUnwanted(client, pairs, n, pairs[i].dstPort, false);
+        }
+    }
+    int errors = 0;
+    int ok     = 0;
+    lua_Integer i;
+    for (i = 0; i < n; ++i) {
+        PortPair* p = pairs + i;
+        const char* err = NULL;
+        if (!p->srcPort) {
+            err = lua_pushfstring(L, "unknown port '%s'", p->src);
+        } else if (!p->dstPort) {
+            err = lua_pushfstring(L, "unknown port '%s'", p->dst);
+        } else {
+            bool isConnected = jack_port_connected_to(p->srcPort, p->dst);
+            if (connect && !isConnected) {
+                int rc = jack_connect(client->ptr, p->src, p->dst);
+                if (rc != 0 && rc != EEXIST) {
+                    err = lua_pushfstring(L, "cannot connect '%s' to '%s'", p->src, p->dst);
+                }
+            } else if (!connect && isConnected) {
+                if (jack_disconnect(client->ptr, p->src, p->dst) != 0) {
+                    err = lua_pushfstring(L, "cannot disconnect '%s' from '%s'", p->src, p->dst);
+                }
+            }
+        }
+        if (err) {
+            if (errors++ == 0) {
+                lua_newtable(L);
+                lua_insert(L, -2);
+            }
+            lua_rawseti(L, -2, i + 1);
+        } else {
+            ++ok;
+        }
+    }
+    lua_pushinteger(L, ok);
+    if (errors) {
+        lua_insert(L, -2);
+    } else {
+        lua_pushnil(L);
+    }
+    return 2;
+}
+
+static int port_connect_names(lua_State* L)
+/* client:connect(source, destination) or client:connect(pairs [, options]) */
+{
+    JackClient* client = getCheckedClient(L, 1);
+    if (lua_istable(L, 2)) {
+        return bulkConnect(L, client, true);
+    }
+    const char* src = checkPortName(L, 2);
+    const char* dst = checkPortName(L, 3);
+    int rc = jack_connect(client->ptr, src, dst);
+    if (rc != 0 && rc != EEXIST) {
+        return luaL_error(L, "cannot connect '%s' to '%s'", src, dst);
+    }
+    return 0;
+}
+
+static int port_disconnect_names(lua_State* L)
+/* client:disconnect(source, destination) or client:disconnect(pairs) */
+{
+    JackClient* client = getCheckedClient(L, 1);
+    if (lua_istable(L, 2)) {
+        return bulkConnect(L, client, false);
+    }
+    const char* src = checkPortName(L, 2);
+    const char* dst = checkPortName(L, 3);
+    if (jack_disconnect(client->ptr, src, dst) != 0) {
+        return luaL_error(L, "cannot disconnect '%s' from '%s'", src, dst);
+    }
+    return 0;
+}
+
+static int port_connect(lua_State* L)
+/* port:connect(other) - connects in the direction given by the port's flags */
+{
+    JackPort* port = getCheckedPort(L, 1);
+    JackClientShared* client = port->shared ? port->shared->client : NULL;
+    if (!port->ptr || !client) {
+        return luaL_argerror(L, 1, "port is released");
+    }
+    const char* name  = jack_port_name(port->ptr);
+    const char* other = checkPortName(L, 2);
+    bool isOutput = jack_port_flags(port->ptr) & JackPortIsOutput;
+    int rc = isOutput ? jack_connect(client->ptr, name, other)
+                      : jack_connect(client->ptr, other, name);
+    if (rc != 0 && rc != EEXIST) {
+        return luaL_error(L, "cannot connect '%s' and '%s'", name, other);
+    }
+    return 0;
+}
+
+static int port_disconnect(lua_State* L)
+/* port:disconnect([other]) - disconnects from other or from all ports */
+{
+    JackPort* port = getCheckedPort(L, 1);
+    JackClientShared* client = port->shared ? port->shared->client : NULL;
+    if (!port->ptr || !client) {
+        return luaL_argerror(L, 1, "port is released");
+    }
+    const char* name = jack_port_name(port->ptr);
+    int rc;
+    if (lua_isnoneornil(L, 2)) {
+        rc = jack_port_disconnect(client->ptr, port->ptr);
+    } else {
+        const char* other = checkPortName(L, 2);
+        bool isOutput = jack_port_flags(port->ptr) & JackPortIsOutput;
+        rc = isOutput ? jack_disconnect(client->ptr, name, other)
+                      : jack_disconnect(client->ptr, other, name);
+    }
+    if (rc != 0) {
+        return luaL_error(L, "cannot disconnect '%s'", name);
+    }
+    return 0;
+}
+
 static int port_release(lua_State* L)
 {
     JackPort* port = getCheckedPort(L, 1);
@@ -77,6 +547,14 @@ static const struct luaL_Reg PortMetaMethods[] =
 static const struct luaL_Reg PortMethods[] = 
 {
     { "ptr",                 port_ptr },
+    { "name",                port_name },
+    { "short_name",          port_short_name },
+    { "type",                port_type },
+    { "flags",               port_flags },
+    { "connect",             port_connect },
+    { "disconnect",          port_disconnect },
+    { "connections",         port_connections },
+    { "connected",           port_connected },
     { NULL, NULL } /* sentinel */
 };
 
@@ -86,6 +564,15 @@ static const struct luaL_Reg ClientMethods[] =
     { "output_audio_port",  output_audio_port },
     { "input_midi_port",    input_midi_port },
     { "output_midi_port",   output_midi_port },
+    { "get_ports",          get_ports },
+    { "connect",            port_connect_names },
+    { "disconnect",         port_disconnect_names },
+    { "nport_flags",        nport_flags },
+    { "nport_type",         nport_type },
+    { "nport_exists",       nport_exists },
+    { "port_is_mine",       port_is_mine },
+    { "nport_connections",  nport_connections },
+    { "nport_connected",    nport_connected },
     { NULL, NULL } /* sentinel */
 };
 
@@ -98,31 +585,35 @@ static const struct luaL_Reg ModuleFunctions[] =
         { "output_audio_port",  output_audio_port },
         { "input_midi_port",    input_midi_port },
         { "output_midi_port",   output_midi_port },
+        { "port_connect",       port_connect },
+        { "nport_connect",      port_connect_names },
+        { "connect",            port_connect_names },
+        { "port_disconnect",    port_disconnect },
+        { "nport_disconnect",   port_disconnect_names },
+        { "disconnect",         port_disconnect_names },
+        { "port_name",          port_name },
+        { "port_short_name",    port_short_name },
+        { "port_flags",         port_flags },
+        { "nport_flags",        nport_flags },
+        { "port_type",          port_type },
+        { "nport_type",         nport_type },
+        { "nport_exists",       nport_exists },
+        { "port_is_mine",       port_is_mine },
+        { "get_ports",          get_ports },
+        { "port_connections",   port_connections },
+        { "nport_connections",  nport_connections },
+        { "port_connected",     port_connected },
+        { "nport_connected",    nport_connected },
 #if 0
     #if 0 /* @@ CUSTOM PORT TYPE */
         { "input_custom_port", InputCustomPort }, 
         { "output_custom_port", OutputCustomPort }, 
     #endif
         { "port_unregister", PortUnregister },
-        { "port_connect", PortConnect },
-        { "nport_connect", PortnameConnect },
-        { "connect", PortnameConnect },
-        { "port_disconnect", PortDisconnect },
-        { "nport_disconnect", PortnameDisconnect },
-        { "disconnect", PortnameDisconnect },
-        { "port_name", PortName },
-        { "port_short_name", PortShortName },
-        { "port_flags", PortFlags },
-        { "nport_flags", PortnameFlags },
         { "port_uuid", PortUuid },
         { "nport_uuid", PortnameUuid },
-        { "port_type", PortType },
-        { "nport_type", PortnameType },
-        { "nport_exists", PortnameExists },
-        { "port_is_mine", PortIsMine },
         { "nport_is_mine", PortnameIsMine },
 /*      { "port_set_name", PortSetName }, DEPRECATED */
-        { "get_ports", GetPorts },
         { "port_set_alias", PortSetAlias },
         { "nport_set_alias", PortnameSetAlias },
         { "port_unset_alias", PortUnsetAlias },
@@ -133,10 +624,6 @@ static const struct luaL_Reg ModuleFunctions[] =
         { "nport_monitor", PortnameMonitor },
         { "port_monitoring", PortMonitoring },
         { "nport_monitoring", PortnameMonitoring },
-        { "port_connections", PortConnections },
-        { "nport_connections", PortnameConnections },
-        { "port_connected", PortConnectedTo },
-        { "nport_connected", PortnameConnectedTo },
 #endif
     { NULL, NULL } /* sentinel */
 };
@@ -145,16 +632,16 @@ bool luajack_open_port(lua_State* L, int module, int clientMeta, int clientClass
                                                   int   portMeta, int   portClass)
 {
     lua_pushvalue(L, module);
-        luaL_setfuncs(L, ModuleFunctions, 0);
+        setfuncs(L, ModuleFunctions);
 
         lua_pushvalue(L, clientClass);
-            luaL_setfuncs(L, ClientMethods, 0);
+            setfuncs(L, ClientMethods);
     
             lua_pushvalue(L, portMeta);
-                luaL_setfuncs(L, PortMetaMethods, 0);
+                setfuncs(L, PortMetaMethods);
         
                 lua_pushvalue(L, portClass);
-                    luaL_setfuncs(L, PortMethods, 0);
+                    setfuncs(L, PortMethods);
             
     lua_pop(L, 4);
     
@@ -103,3 +103,62 @@ void transferPort(lua_State* T, JackPortShared* sharedPort)
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+void invalidateCachedPorts(JackClientShared* client)
+{
+    atomic_inc(&client->portsGeneration);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+const char** getCachedPorts(JackClientShared* client)
+{
+    int generation = atomic_get(&client->portsGeneration);
+    
+    if (!client->portsCache || client->portsCacheGeneration != generation) {
+        releaseCachedPorts(client);
+        client->portsCache           = jack_get_ports(client->ptr, NULL, NULL, 0);
+        client->portsCacheGeneration = generation;
+    }
+    return client->portsCache;
+}
+
+void releaseCachedPorts(JackClientShared* client)
+{
+    if (client->portsCache) {
+        jack_free(client->portsCache);
+        client->portsCache = NULL;
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+const char* checkPortName(lua_State* L, int arg)
+{
+    JackPort* port = getOptionalPort(L, arg);
+    if (port) {
+        if (!port->ptr) {
+            luaL_argerror(L, arg, "port is released");
+        }
+        return jack_port_name(port->ptr);
+    }
+    return luaL_checkstring(L, arg);
+}
+
+void pushPortNames(lua_State* L, const char** names)
+{
+    int n = 0;
+    if (names) {
+        while (names[n]) ++n;
+    }
+    lua_createtable(L, n, 0);
+    int i;
+    for (i = 0; i < n; ++i) {
+        lua_pushstring(L, names[i]);
+        lua_rawseti(L, -2, i + 1);
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
@@ -28,6 +28,41 @@ void releasePort(JackPortShared* port);
 
 void transferPort(lua_State* T, JackPortShared* sharedPort);
 
+/////////////////////////////////////////////////////////////////////////////////
+
+/* Invalidates the cached port list of the client, called from the JACK port
+ * registration and rename callbacks */
+
+#define invalidateCachedPorts luajack_invalidateCachedPorts 
+
+void invalidateCachedPorts(JackClientShared* client);
+
+/////////////////////////////////////////////////////////////////////////////////
+
+/* Returns the names of all ports, cached until a port is registered, 
+ * unregistered or renamed. Must be called with client->portsCacheMutex 
+ * locked. */
+
+#define getCachedPorts luajack_getCachedPorts 
+
+const char** getCachedPorts(JackClientShared* client);
+
+#define releaseCachedPorts luajack_releaseCachedPorts 
+
+void releaseCachedPorts(JackClientShared* client);
+
+/////////////////////////////////////////////////////////////////////////////////
+
+/* Port name of a port object or string argument */
+
+#define checkPortName luajack_checkPortName 
+
+const char* checkPortName(lua_State* L, int arg);
+
+#define pushPortNames luajack_pushPortNames 
+
+void pushPortNames(lua_State* L, const char** names);
+
 
 /////////////////////////////////////////////////////////////////////////////////
 
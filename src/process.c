@@ -1,6 +1,7 @@
 #include "util.h"
 #include "process.h"
 #include "process_util.h"
+#include "alloc_util.h"
 
 static int process_error_handler(lua_State* L)
 {
@@ -8,6 +9,12 @@ static int process_error_handler(lua_State* L)
     return 1;
 }
 
+static int process_gc_step(lua_State* L)
+{
+    lua_gc(L, LUA_GCSTEP, 0);
+    return 0;
+}
+
 static const char* lua_string_reader(lua_State* L, void* data, size_t* size)
 {
     const char** scriptPtr = (const char**) data;
@@ -20,8 +27,114 @@ static const char* lua_string_reader(lua_State* L, void* data, size_t* size)
     return script;
 }
 
-// TODO: load file
+static void closeProcessState(lua_State* P, JackAllocStats* stats)
+{
+    lua_close(P);
+    free(stats);
+}
+
+/* Standard libraries that can be selected for the process state, the base
+ * library is always opened. */
+
+static const luaL_Reg StandardLibs[] = 
+{
+    { LUA_LOADLIBNAME, luaopen_package },
+#if LUA_VERSION_NUM >= 502
+    { LUA_COLIBNAME,   luaopen_coroutine },
+#endif
+    { LUA_TABLIBNAME,  luaopen_table },
+    { LUA_IOLIBNAME,   luaopen_io },
+    { LUA_OSLIBNAME,   luaopen_os },
+    { LUA_STRLIBNAME,  luaopen_string },
+#if LUA_VERSION_NUM >= 503
+    { LUA_UTF8LIBNAME, luaopen_utf8 },
+#endif
+    { LUA_MATHLIBNAME, luaopen_math },
+    { LUA_DBLIBNAME,   luaopen_debug },
+#ifdef LUA_JITLIBNAME
+    { LUA_BITLIBNAME,  luaopen_bit },
+    { LUA_JITLIBNAME,  luaopen_jit },
+    { LUA_FFILIBNAME,  luaopen_ffi },
+#endif
+    { NULL, NULL } /* sentinel */
+};
+
+static void openLib(lua_State* P, const char* name, lua_CFunction openf)
+{
+    luaL_requiref(P, name, openf, 1);
+    lua_pop(P, 1);
+}
+
+static void checkLibs(lua_State* L, int optIndex)
+/* Raises an error for unknown names in the libs option, must be done before
+ * the process state is created. */
+{
+    if (optIndex > 0 && lua_istable(L, optIndex)) {
+        lua_getfield(L, optIndex, "libs");
+        if (!lua_isnil(L, -1)) {
+            luaL_argcheck(L, lua_istable(L, -1), optIndex, "libs must be an array of library names");
+            int i, len = (int) luaL_len(L, -1);
+            for (i = 1; i <= len; ++i) {
+                lua_rawgeti(L, -1, i);
+                const char* name = lua_tostring(L, -1);
+                const luaL_Reg* lib = StandardLibs;
+                while (name && lib->name && strcmp(lib->name, name) != 0) {
+                    ++lib;
+                }
+                if (!name || (!lib->name && strcmp(name, "base") != 0)) {
+                    luaL_error(L, "unknown library '%s' in libs option", 
+                                  name ? name : luaL_typename(L, -1));
+                }
+                lua_pop(L, 1);
+            }
+        }
+        lua_pop(L, 1);
+    }
+}
+
+static void openLibs(lua_State* P, lua_State* L, int optIndex)
+/* Opens the libraries listed in the (checked) libs option or all standard 
+ * libraries if the option is not given. */
+{
+    bool all = true;
+    if (optIndex > 0 && lua_istable(L, optIndex)) {
+        lua_getfield(L, optIndex, "libs");
+        all = lua_isnil(L, -1);
+        lua_pop(L, 1);
+    }
+    if (all) {
+        luaL_openlibs(P);
+        return;
+    }
+    openLib(P, "_G", luaopen_base);
+
+    lua_getfield(L, optIndex, "libs");
+    int i, len = (int) luaL_len(L, -1);
+    for (i = 1; i <= len; ++i) {
+        lua_rawgeti(L, -1, i);
+        const char* name = lua_tostring(L, -1);
+        const luaL_Reg* lib;
+        for (lib = StandardLibs; lib->name; ++lib) {
+            if (strcmp(lib->name, name) == 0) {
+                openLib(P, lib->name, lib->func);
+            }
+        }
+        lua_pop(L, 1);
+    }
+    lua_pop(L, 1);
+}
+
 static int process_load(lua_State* L)
+/* client:process_load([options,] chunk, ...)
+ * loads the process chunk into a new Lua state and executes it with the 
+ * remaining arguments. Options:
+ *   libs = { name, ... }   standard libraries opened in the process state,
+ *                          e.g. { "table", "string", "math" } (default: all).
+ *                          The base library is always opened. Omitting io,
+ *                          os, debug and package makes the state smaller and
+ *                          faster to create and keeps blocking functions out
+ *                          of the real time thread.
+ */
 {
     int arg     = 1;
     int lastArg = lua_gettop(L);
@@ -35,16 +148,23 @@ static int process_load(lua_State* L)
     if (client->shared->processContext) {
         return luaL_error(L, "process chunk already loaded"); // TODO: reload for deactivated clients
     }
+    int options = 0;
+    if (lua_istable(L, arg)) {
+        options = arg++;
+        checkLibs(L, options);
+    }
     if (lua_type(L, arg) != LUA_TSTRING)
         luaL_error(L, "missing process chunk");
     
-    /* create the process_state (unrelated to the client state) */
-    lua_State* P = luaL_newstate();
+    /* create the process_state (unrelated to the client state), its
+     * allocations are counted */
+    JackAllocStats* stats;
+    lua_State* P = newCountingState(&stats);
     
     if (P == NULL)
         return luaL_error(L, "cannot create Lua state");
     
-    luaL_openlibs(P);
+    openLibs(P, L, options);
     
     int chunkName = arg; // for file
     if (true /* isFromScript*/) {
@@ -62,13 +182,13 @@ static int process_load(lua_State* L)
             lua_pushstring(L, lua_tostring(P, -1));
         else
             lua_pushfstring(L, "cannot load string (luaL_loadstring() error %d)", rc);
-        lua_close(P);
+        closeProcessState(P, stats);
         return lua_error(L);
     }
     
     int isErr = luajack_xmove(client->shared, P, L, chunkName, arg, lastArg);
     if (isErr) {
-        lua_close(P);
+        closeProcessState(P, stats);
         return lua_error(L);
     }
 
@@ -80,7 +200,7 @@ static int process_load(lua_State* L)
             lua_pushstring(L, lua_tostring(P, -1));
         else
             lua_pushfstring(L, "cannot execute chunk (lua_pcall() error %d)", rc);
-        lua_close(P);
+        closeProcessState(P, stats);
         return lua_error(L);
     }
 
@@ -91,48 +211,18 @@ static int process_load(lua_State* L)
     lua_gc(P, LUA_GCSTOP, 0);
 
     client->shared->processContext = P;
+    client->shared->allocStats     = stats;
    
     lua_pushcfunction(P, process_error_handler);
     client->shared->processErrorHandlerRef = luaL_ref(P, LUA_REGISTRYINDEX);
-   
-    return 0;
-}
+    lua_pushcfunction(P, process_gc_step);
+    client->shared->processGcStepRef = luaL_ref(P, LUA_REGISTRYINDEX);
 
-static int jack_process_callback(jack_nframes_t nframes, void* arg)
-{
-    JackClientShared* client = arg;
-    lua_State* L = client->processContext;
-    
-    client->currentProcessNframes = nframes;
-    
-    if (L && client->processCallbackRef != LUA_NOREF && !client->errorInProcessContext) {
-        int oldTop = lua_gettop(L);
-        int errorHandler = oldTop + 1; lua_rawgeti(L, LUA_REGISTRYINDEX, client->processErrorHandlerRef);
-        lua_rawgeti(L, LUA_REGISTRYINDEX, client->processCallbackRef);
-        lua_pushinteger(L, nframes);
-        int rc = lua_pcall(L, 1, 0, errorHandler);
-        if (rc != LUA_OK) {
-            async_mutex_lock(&client->mutex);
-            
-            //printf("Error in process callback: {%s}\n", lua_tostring(L, -1));
-            if (client->errorInProcessContext) {
-                free(client->errorInProcessContext);
-            }
-            const char* errmsg = lua_tostring(L, -1);
-            if (errmsg == NULL) {
-                errmsg = "unknown error";
-            }
-            client->errorInProcessContext = strdup(errmsg);
-            atomic_inc(&client->processContextErrorFlag);
-            async_mutex_unlock(&client->mutex);
-        }
-        lua_settop(L, oldTop);
-    }
-    client->currentProcessNframes = 0;
+    setProcessClient(P, client->shared);
+   
     return 0;
 }
 
-
 static int process_callback(lua_State* L)
 {
     JackClient* client = getCheckedClient(L, 1);
@@ -150,7 +240,7 @@ static int process_callback(lua_State* L)
     lua_pushvalue(L, 2);
     client->shared->processCallbackRef = luaL_ref(L, LUA_REGISTRYINDEX);
     
-    jack_set_process_callback(client->ptr, jack_process_callback, client->shared);
+    jack_set_process_callback(client->ptr, processCallback, client->shared);
     return 0;
 }
 
@@ -171,10 +261,10 @@ static const struct luaL_Reg ModuleFunctions[] =
 bool luajack_open_process(lua_State* L, int module, int clientMeta, int clientClass)
 {
     lua_pushvalue(L, module);
-        luaL_setfuncs(L, ModuleFunctions, 0);
+        setfuncs(L, ModuleFunctions);
 
         lua_pushvalue(L, clientClass);
-            luaL_setfuncs(L, ClientMethods, 0);
+            setfuncs(L, ClientMethods);
     
     lua_pop(L, 2);
     
@@ -1 +1,132 @@
+#include <stdio.h>
+
+#include "util.h"
 #include "process_util.h"
+#include "native_util.h"
+#include "profiler_util.h"
+#include "trace_util.h"
+#include "alloc_util.h"
+#include "recorder_util.h"
+
+/* address is the registry key of the client lightuserdata */
+static const char ProcessClientKey = 0;
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+/* Stores the error message on top of the stack for the main context, the
+ * process callback is not called again */
+static void setProcessError(JackClientShared* client, lua_State* L)
+{
+    async_mutex_lock(&client->mutex);
+    
+    //printf("Error in process callback: {%s}\n", lua_tostring(L, -1));
+    if (client->errorInProcessContext) {
+        free(client->errorInProcessContext);
+    }
+    const char* errmsg = lua_tostring(L, -1);
+    if (errmsg == NULL) {
+        errmsg = "unknown error";
+    }
+    client->errorInProcessContext = strdup(errmsg);
+    atomic_inc(&client->processContextErrorFlag);
+    async_mutex_unlock(&client->mutex);
+}
+
+int processCallback(jack_nframes_t nframes, void* arg)
+{
+    JackClientShared* client = arg;
+    lua_State* L = client->processContext;
+    
+    client->processCycle         += 1;
+    client->currentCycleNframes   = nframes;
+    client->currentProcessOffset  = 0;
+    client->currentProcessNframes = nframes;
+    
+    bool tracing = isTraceEnabled();
+    if (tracing) {
+        setTraceThreadName(jack_get_client_name(client->ptr), false);
+        recordTraceEvent('B', "process");
+    }
+
+    if (client->profiler) {
+        beginProfilerCycle(client->profiler);
+    }
+
+    if (client->recorder) {
+        recordCycle(client->recorder, nframes);
+    }
+
+    if (client->nativeChain) {
+        if (tracing) recordTraceEvent('B', "native chain");
+        processNativeChain(client->nativeChain, nframes);
+        if (tracing) recordTraceEvent('E', NULL);
+    }
+    
+    if (L && client->processCallbackRef != LUA_NOREF && !client->errorInProcessContext) {
+        if (tracing) recordTraceEvent('B', "lua callback");
+        int oldTop = lua_gettop(L);
+        int errorHandler = oldTop + 1; lua_rawgeti(L, LUA_REGISTRYINDEX, client->processErrorHandlerRef);
+        lua_rawgeti(L, LUA_REGISTRYINDEX, client->processCallbackRef);
+        lua_pushinteger(L, nframes);
+        JackAllocStats* stats = client->allocStats;
+        if (stats) {
+            beginAllocCycle(stats);
+        }
+        int rc = lua_pcall(L, 1, 0, errorHandler);
+        if (stats && endAllocCycle(stats) && rc == LUA_OK 
+                  && stats->strictMode == ALLOC_STRICT_ERROR)
+        {
+            /* the callback itself succeeded, its allocations are reported
+             * like an error raised by the callback */
+            char errmsg[160];
+            snprintf(errmsg, sizeof(errmsg), "process callback allocated %d times (%ld bytes) "
+                                             "in cycle %ld after warm-up",
+                                             stats->violationAllocs, 
+                                             (long) stats->violationBytes,
+                                             (long) stats->violationCycle);
+            lua_pushstring(L, errmsg);
+            rc = LUA_ERRRUN;
+        }
+        if (rc != LUA_OK) {
+            setProcessError(client, L);
+        }
+        if (tracing) recordTraceEvent('E', NULL);
+
+        if (rc == LUA_OK) {
+            /* the collector of the process context is stopped, it advances by
+             * one incremental step per cycle. The step is protected, because
+             * it runs __gc metamethods, which may raise errors. */
+            if (tracing) recordTraceEvent('B', "gc step");
+            lua_rawgeti(L, LUA_REGISTRYINDEX, client->processGcStepRef);
+            if (lua_pcall(L, 0, 0, errorHandler) != LUA_OK) {
+                setProcessError(client, L);
+            }
+            if (tracing) recordTraceEvent('E', NULL);
+        }
+        lua_settop(L, oldTop);
+    }
+    client->currentCycleNframes   = 0;
+    client->currentProcessNframes = 0;
+    if (tracing) {
+        recordTraceEvent('E', NULL);
+    }
+    return 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+void setProcessClient(lua_State* P, JackClientShared* client)
+{
+    lua_pushlightuserdata(P, client);
+    lua_rawsetp(P, LUA_REGISTRYINDEX, &ProcessClientKey);
+}
+
+JackClientShared* getProcessClient(lua_State* P)
+{
+    lua_rawgetp(P, LUA_REGISTRYINDEX, &ProcessClientKey);
+    JackClientShared* client = (JackClientShared*) lua_touserdata(P, -1);
+    lua_pop(P, 1);
+    return client;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
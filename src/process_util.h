@@ -3,5 +3,26 @@
 
 #include "util.h"
 
+/////////////////////////////////////////////////////////////////////////////////
+
+/* JACK process callback of all clients: runs the native module chain and the
+ * Lua process callback of the process context. */
+
+#define processCallback luajack_processCallback 
+
+int processCallback(jack_nframes_t nframes, void* arg);
+
+/* The process context stores its client in the registry, so that hooks and
+ * other callbacks that only get the lua_State can find it. */
+
+#define setProcessClient luajack_setProcessClient 
+
+void setProcessClient(lua_State* P, JackClientShared* client);
+
+#define getProcessClient luajack_getProcessClient 
+
+JackClientShared* getProcessClient(lua_State* P);
+
+/////////////////////////////////////////////////////////////////////////////////
 
 #endif // LUAJACK_PROCESS_UTIL_H
@@ -0,0 +1,338 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "util.h"
+#include "profiler.h"
+#include "profiler_util.h"
+#include "client_util.h"
+
+static int profiler_new(lua_State* L)
+/* profiler = client:profiler([options])
+ * creates a sampling profiler for the Lua code of the process context. The
+ * profiler costs nothing until it is started. Options:
+ *   interval  = n   VM instructions between two samples (default 1000)
+ *   depth     = n   maximal recorded stack depth (default 32)
+ *   capacity  = n   samples buffered until the next report (default 16384)
+ *   functions = n   maximal number of distinct functions (default 4096)
+ */
+{
+    JackClient* client = getCheckedClient(L, 1);
+    if (client->isInProcessContext) {
+        return luaL_error(L, "profiler can only be created in main context");
+    }
+    if (!client->shared->processContext) {
+        return luaL_error(L, "process chunk must be loaded before creating a profiler");
+    }
+    if (client->shared->profiler) {
+        return luaL_error(L, "client already has a profiler");
+    }
+    lua_Integer interval  = getIntegerOption(L, 2, "interval",  1000);
+    lua_Integer depth     = getIntegerOption(L, 2, "depth",     32);
+    lua_Integer capacity  = getIntegerOption(L, 2, "capacity",  16384);
+    lua_Integer functions = getIntegerOption(L, 2, "functions", 4096);
+    luaL_argcheck(L, interval >= 1,                    2, "invalid interval");
+    luaL_argcheck(L, depth >= 1 && depth <= 256,       2, "invalid depth");
+    luaL_argcheck(L, capacity >= 1,                    2, "invalid capacity");
+    luaL_argcheck(L, functions >= 2 && (functions & (functions - 1)) == 0, 2, 
+                     "functions must be a power of two");
+
+    JackProfiler* profiler = (JackProfiler*) lua_newuserdata(L, sizeof(JackProfiler));
+    memset(profiler, 0, sizeof(JackProfiler));
+    profiler->foldedRef = LUA_NOREF;
+    profiler->flatRef   = LUA_NOREF;
+    luaL_setmetatable(L, PROFILER_TYPE_NAME);
+    profiler->shared = createProfiler((int) interval, (int) depth, (int) capacity, (int) functions);
+    if (!profiler->shared) {
+        return luaL_error(L, "cannot create profiler");
+    }
+    lua_newtable(L);
+    profiler->foldedRef = luaL_ref(L, LUA_REGISTRYINDEX);
+    lua_newtable(L);
+    profiler->flatRef = luaL_ref(L, LUA_REGISTRYINDEX);
+
+    profiler->client = client->shared;
+    atomic_inc(&client->shared->refCounter);
+    
+    /* the client keeps the profiler alive as long as the hook may run */
+    atomic_inc(&profiler->shared->refCounter);
+    client->shared->profiler = profiler->shared;
+    return 1;
+}
+
+static void stopHook(JackProfiler* profiler)
+{
+    if (profiler->shared->running && profiler->client->processContext) {
+        stopProfiler(profiler->shared, profiler->client->processContext);
+    }
+}
+
+static int profiler_release(lua_State* L)
+{
+    JackProfiler* profiler = getCheckedProfiler(L, 1);
+    if (profiler->shared) {
+        stopHook(profiler);
+        /* the process callback may still use the profiler in the current
+         * cycle, the client keeps it until the next profiler is released */
+        JackClientShared* client = profiler->client;
+        if (client && atomic_set_ptr_if_equal((void**) &client->profiler, profiler->shared, NULL)) {
+            releaseProfiler(client->retiredProfiler);
+            client->retiredProfiler = profiler->shared;
+        }
+        releaseProfiler(profiler->shared);
+        profiler->shared = NULL;
+    }
+    if (profiler->client) {
+        releaseClientShared(profiler->client);
+        profiler->client = NULL;
+    }
+    luaL_unref(L, LUA_REGISTRYINDEX, profiler->foldedRef);
+    luaL_unref(L, LUA_REGISTRYINDEX, profiler->flatRef);
+    profiler->foldedRef = LUA_NOREF;
+    profiler->flatRef   = LUA_NOREF;
+    return 0;
+}
+
+static JackProfiler* getValidProfiler(lua_State* L, int stackIndex)
+{
+    JackProfiler* profiler = getCheckedProfiler(L, stackIndex);
+    if (!profiler->shared) {
+        luaL_error(L, "profiler was released");
+    }
+    return profiler;
+}
+
+static int profiler_toString(lua_State* L)
+{
+    JackProfiler* profiler = getCheckedProfiler(L, 1);
+    lua_pushfstring(L, "%s: %p", PROFILER_TYPE_NAME, profiler->shared);
+    return 1;
+}
+
+static int profiler_start(lua_State* L)
+/* profiler:start()
+ * installs the count hook on the process context.
+ */
+{
+    JackProfiler* profiler = getValidProfiler(L, 1);
+    if (!profiler->client->processContext) {
+        return luaL_error(L, "process context was closed");
+    }
+    if (!profiler->shared->running) {
+        startProfiler(profiler->shared, profiler->client->processContext);
+    }
+    return 0;
+}
+
+static int profiler_stop(lua_State* L)
+/* profiler:stop()
+ * removes the hook, the process context runs again without any overhead.
+ */
+{
+    JackProfiler* profiler = getValidProfiler(L, 1);
+    stopHook(profiler);
+    return 0;
+}
+
+static void addTicks(lua_State* L, int table, int key, unsigned long long ticks)
+{
+    lua_pushvalue(L, key);
+    lua_rawget(L, table);
+    lua_Number sum = lua_tonumber(L, -1) + (lua_Number) ticks;
+    lua_pop(L, 1);
+    lua_pushvalue(L, key);
+    lua_pushnumber(L, sum);
+    lua_rawset(L, table);
+}
+
+/* moves the buffered samples into the aggregation tables */
+static void drainSamples(lua_State* L, JackProfiler* profiler)
+{
+    JackProfilerShared*   shared    = profiler->shared;
+    JackProfilerSample*   sample    = (JackProfilerSample*) lua_newuserdata(L, shared->sampleSize);
+    JackProfilerFunction* functions = shared->functions;
+    int sampleIndex = lua_gettop(L);
+    lua_rawgeti(L, LUA_REGISTRYINDEX, profiler->foldedRef);
+    int folded = lua_gettop(L);
+    lua_rawgeti(L, LUA_REGISTRYINDEX, profiler->flatRef);
+    int flat = lua_gettop(L);
+
+    while (jack_ringbuffer_read_space(shared->samples) >= shared->sampleSize) {
+        jack_ringbuffer_read(shared->samples, (char*) sample, shared->sampleSize);
+        if (sample->depth == 0) {
+            continue;
+        }
+        luaL_Buffer buffer;
+        luaL_buffinit(L, &buffer);
+        int d;
+        for (d = sample->depth - 1; d >= 0; --d) {
+            luaL_addstring(&buffer, functions[sample->frames[d].function].label);
+            if (d > 0) {
+                luaL_addchar(&buffer, ';');
+            }
+        }
+        luaL_pushresult(&buffer);
+        addTicks(L, folded, lua_gettop(L), sample->ticks);
+        lua_pop(L, 1);
+
+        lua_pushfstring(L, "%s line %d", functions[sample->frames[0].function].label,
+                                         sample->frames[0].line);
+        addTicks(L, flat, lua_gettop(L), sample->ticks);
+        lua_pop(L, 1);
+    }
+    lua_settop(L, sampleIndex - 1);
+}
+
+typedef struct {
+    const char* key;
+    lua_Number  ticks;
+}
+ReportEntry;
+
+static int compareEntries(const void* a, const void* b)
+{
+    lua_Number ta = ((const ReportEntry*) a)->ticks;
+    lua_Number tb = ((const ReportEntry*) b)->ticks;
+    return (ta < tb) ? 1 : (ta > tb) ? -1 : 0;
+}
+
+static int profiler_report(lua_State* L)
+/* report, total_us = profiler:report([format])
+ * format - "folded" (default): one line "outer;...;inner microseconds" per 
+ *                              stack, input format of flamegraph.pl
+ *          "flat":             self time per function and line, sorted
+ * The report covers all samples since creation or the last reset().
+ */
+{
+    static const char* const FormatNames[] = { "folded", "flat", NULL };
+
+    JackProfiler* profiler = getValidProfiler(L, 1);
+    int           format   = luaL_checkoption(L, 2, "folded", FormatNames);
+    double        tickRate = getProfilerTickRate(profiler->shared);
+
+    lua_settop(L, 2);
+    drainSamples(L, profiler);
+    lua_rawgeti(L, LUA_REGISTRYINDEX, (format == 0) ? profiler->foldedRef : profiler->flatRef);
+    int table = lua_gettop(L);
+
+    /* keys stay referenced by the table while the entries are sorted */
+    int count = 0;
+    lua_pushnil(L);
+    while (lua_next(L, table)) {
+        ++count;
+        lua_pop(L, 1);
+    }
+    ReportEntry* entries = (ReportEntry*) lua_newuserdata(L, sizeof(ReportEntry) * (count > 0 ? count : 1));
+    lua_Number   total   = 0;
+    int i = 0;
+    lua_pushnil(L);
+    while (lua_next(L, table)) {
+        entries[i].key   = lua_tostring(L, -2);
+        entries[i].ticks = lua_tonumber(L, -1);
+        total += entries[i].ticks;
+        ++i;
+        lua_pop(L, 1);
+    }
+    qsort(entries, count, sizeof(ReportEntry), compareEntries);
+
+    luaL_Buffer buffer;
+    luaL_buffinit(L, &buffer);
+    char line[64];
+    for (i = 0; i < count; ++i) {
+        double usecs = entries[i].ticks / tickRate;
+        if (format == 0) {
+            if (usecs < 0.5) {
+                continue;
+            }
+            luaL_addstring(&buffer, entries[i].key);
+            snprintf(line, sizeof(line), " %.0f\n", usecs);
+            luaL_addstring(&buffer, line);
+        } else {
+            snprintf(line, sizeof(line), "%6.2f%% %12.0f us  ", 
+                     total > 0 ? 100.0 * entries[i].ticks / total : 0.0, usecs);
+            luaL_addstring(&buffer, line);
+            luaL_addstring(&buffer, entries[i].key);
+            luaL_addchar(&buffer, '\n');
+        }
+    }
+    luaL_pushresult(&buffer);
+    lua_pushnumber(L, total / tickRate);
+    return 2;
+}
+
+static int profiler_reset(lua_State* L)
+/* profiler:reset()
+ * discards all samples collected so far.
+ */
+{
+    JackProfiler* profiler = getValidProfiler(L, 1);
+    lua_settop(L, 1);
+    drainSamples(L, profiler);
+    luaL_unref(L, LUA_REGISTRYINDEX, profiler->foldedRef);
+    luaL_unref(L, LUA_REGISTRYINDEX, profiler->flatRef);
+    lua_newtable(L);
+    profiler->foldedRef = luaL_ref(L, LUA_REGISTRYINDEX);
+    lua_newtable(L);
+    profiler->flatRef = luaL_ref(L, LUA_REGISTRYINDEX);
+    return 0;
+}
+
+static int profiler_samples(lua_State* L)
+/* recorded, dropped = profiler:samples()
+ * returns the number of samples recorded and dropped because the buffer was
+ * full.
+ */
+{
+    JackProfiler* profiler = getValidProfiler(L, 1);
+    lua_pushinteger(L, atomic_get(&profiler->shared->recorded));
+    lua_pushinteger(L, atomic_get(&profiler->shared->dropped));
+    return 2;
+}
+
+static const struct luaL_Reg ClientMethods[] = 
+{
+    { "profiler",   profiler_new },
+    { NULL, NULL } /* sentinel */
+};
+
+static const struct luaL_Reg ProfilerMetaMethods[] = 
+{
+    { "__tostring", profiler_toString },
+    { "__gc",       profiler_release },
+    { NULL, NULL } /* sentinel */
+};
+
+static const struct luaL_Reg ProfilerMethods[] = 
+{
+    { "start",      profiler_start },
+    { "stop",       profiler_stop },
+    { "report",     profiler_report },
+    { "reset",      profiler_reset },
+    { "samples",    profiler_samples },
+    { NULL, NULL } /* sentinel */
+};
+
+static const struct luaL_Reg ModuleFunctions[] = 
+{
+    { "profiler",   profiler_new },
+    { NULL, NULL } /* sentinel */
+};
+
+bool luajack_open_profiler(lua_State* L, int module, int clientMeta, int clientClass,
+                                                     int profilerMeta, int profilerClass)
+{
+    lua_pushvalue(L, module);
+        setfuncs(L, ModuleFunctions);
+
+        lua_pushvalue(L, clientClass);
+            setfuncs(L, ClientMethods);
+
+            lua_pushvalue(L, profilerMeta);
+                setfuncs(L, ProfilerMetaMethods);
+    
+                lua_pushvalue(L, profilerClass);
+                    setfuncs(L, ProfilerMethods);
+    
+    lua_pop(L, 4);
+    
+    return true;
+}
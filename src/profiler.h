@@ -0,0 +1,7 @@
+#ifndef LUAJACK_PROFILER_H
+#define LUAJACK_PROFILER_H
+
+bool luajack_open_profiler(lua_State* L, int module, int clientMeta, int clientClass,
+                                                     int profilerMeta, int profilerClass);
+
+#endif // LUAJACK_PROFILER_H
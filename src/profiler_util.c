@@ -0,0 +1,159 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "util.h"
+#include "profiler_util.h"
+#include "process_util.h"
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+static void initFunction(JackProfilerFunction* f, const void* source, const void* name, 
+                         int lineDefined, const lua_Debug* ar)
+{
+    f->source      = source;
+    f->name        = name;
+    f->lineDefined = lineDefined;
+    if (*ar->what == 'm') {
+        snprintf(f->label, sizeof(f->label), "main chunk@%s", ar->short_src);
+    } else if (*ar->what == 'C') {
+        snprintf(f->label, sizeof(f->label), "%.*s [C]", PROFILER_NAME_SIZE, ar->name ? ar->name : "?");
+    } else {
+        snprintf(f->label, sizeof(f->label), "%.*s@%s:%d", PROFILER_NAME_SIZE, ar->name ? ar->name : "?", 
+                                                           ar->short_src, lineDefined);
+    }
+    /* ';' separates frames in the folded format */
+    char* p;
+    for (p = f->label; *p; ++p) {
+        if (*p == ';') {
+            *p = ',';
+        }
+    }
+}
+
+/* Returns the index of the function, 0 if the table is full */
+static int internFunction(JackProfilerShared* profiler, const lua_Debug* ar)
+{
+    const void* source = ar->source;
+    const void* name   = (*ar->what == 'C') ? (const void*) ar->name : NULL;
+    int         line   = ar->linedefined;
+
+    size_t h    = ((size_t) source >> 3) ^ ((size_t) name >> 3) ^ ((size_t) line * 2654435761u);
+    int    mask = 2 * profiler->maxFunctions - 1;
+    int    slot = (int)(h & mask);
+    for (;;) {
+        int index = profiler->hash[slot] - 1;
+        if (index < 0) {
+            int count = profiler->functionCount;
+            if (count >= profiler->maxFunctions) {
+                return 0;
+            }
+            initFunction(&profiler->functions[count], source, name, line, ar);
+            profiler->hash[slot] = count + 1;
+            atomic_set(&profiler->functionCount, count + 1);
+            return count;
+        }
+        JackProfilerFunction* f = &profiler->functions[index];
+        if (f->source == source && f->name == name && f->lineDefined == line) {
+            return index;
+        }
+        slot = (slot + 1) & mask;
+    }
+}
+
+static void profilerHook(lua_State* L, lua_Debug* hookAr)
+{
+    JackClientShared*   client   = getProcessClient(L);
+    JackProfilerShared* profiler = client ? client->profiler : NULL;
+    if (!profiler || !profiler->running) {
+        return;
+    }
+    unsigned long long  now    = cycleClock();
+    JackProfilerSample* sample = profiler->current;
+    lua_Debug ar;
+    int depth = 0;
+    while (depth < profiler->maxDepth && lua_getstack(L, depth, &ar)) {
+        lua_getinfo(L, "Sln", &ar);
+        sample->frames[depth].function = internFunction(profiler, &ar);
+        sample->frames[depth].line     = ar.currentline;
+        ++depth;
+    }
+    sample->ticks = now - profiler->lastTicks;
+    sample->depth = depth;
+    profiler->lastTicks = now;
+
+    if (jack_ringbuffer_write_space(profiler->samples) >= profiler->sampleSize) {
+        jack_ringbuffer_write(profiler->samples, (const char*) sample, profiler->sampleSize);
+        atomic_inc(&profiler->recorded);
+    } else {
+        atomic_inc(&profiler->dropped);
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+JackProfilerShared* createProfiler(int interval, int maxDepth, int capacity, int maxFunctions)
+{
+    JackProfilerShared* profiler = (JackProfilerShared*) calloc(1, sizeof(JackProfilerShared));
+    if (!profiler) {
+        return NULL;
+    }
+    profiler->refCounter   = 1;
+    profiler->interval     = interval;
+    profiler->maxDepth     = maxDepth;
+    profiler->maxFunctions = maxFunctions;
+    profiler->sampleSize   = sizeof(JackProfilerSample) + sizeof(JackProfilerFrame) * (maxDepth - 1);
+    profiler->samples      = jack_ringbuffer_create(profiler->sampleSize * capacity);
+    profiler->current      = (JackProfilerSample*) calloc(1, profiler->sampleSize);
+    profiler->functions    = (JackProfilerFunction*) calloc(maxFunctions, sizeof(JackProfilerFunction));
+    profiler->hash         = (int*) calloc(2 * maxFunctions, sizeof(int));
+    if (!profiler->samples || !profiler->current || !profiler->functions || !profiler->hash) {
+        releaseProfiler(profiler);
+        return NULL;
+    }
+    jack_ringbuffer_mlock(profiler->samples);
+
+    /* index 0 collects all functions that did not fit into the table */
+    snprintf(profiler->functions[0].label, sizeof(profiler->functions[0].label), "(other)");
+    profiler->functionCount = 1;
+
+    profiler->startTicks = cycleClock();
+    profiler->startTime  = jack_get_time();
+    return profiler;
+}
+
+void releaseProfiler(JackProfilerShared* profiler)
+{
+    if (profiler && atomic_dec(&profiler->refCounter) == 0) {
+        if (profiler->samples) {
+            jack_ringbuffer_free(profiler->samples);
+        }
+        free(profiler->current);
+        free(profiler->functions);
+        free(profiler->hash);
+        free(profiler);
+    }
+}
+
+void startProfiler(JackProfilerShared* profiler, lua_State* processContext)
+{
+    profiler->lastTicks = cycleClock();
+    profiler->running   = true;
+    lua_sethook(processContext, profilerHook, LUA_MASKCOUNT, profiler->interval);
+}
+
+void stopProfiler(JackProfilerShared* profiler, lua_State* processContext)
+{
+    lua_sethook(processContext, NULL, 0, 0);
+    profiler->running = false;
+}
+
+double getProfilerTickRate(JackProfilerShared* profiler)
+{
+    jack_time_t usecs = jack_get_time() - profiler->startTime;
+    if (usecs == 0) {
+        return 1;
+    }
+    return (double)(cycleClock() - profiler->startTicks) / usecs;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,127 @@
+#ifndef LUAJACK_PROFILER_UTIL_H
+#define LUAJACK_PROFILER_UTIL_H
+
+#include "util.h"
+
+/////////////////////////////////////////////////////////////////////////////////
+
+/* Cheap monotonic tick counter, the tick rate is calibrated against 
+ * jack_get_time() */
+
+static inline unsigned long long cycleClock(void)
+{
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    return __builtin_ia32_rdtsc();
+#else
+    return jack_get_time();
+#endif
+}
+
+/////////////////////////////////////////////////////////////////////////////////
+
+#define PROFILER_NAME_SIZE 64
+
+/* Functions seen by the hook are interned in a preallocated table. Entries 
+ * are written once by the process context before functionCount is 
+ * increased, the main context only reads entries below functionCount. */
+
+typedef struct {
+    const void*          source;         /* key: source string of the function */
+    const void*          name;           /* key for C functions: name string */
+    int                  lineDefined;    /* key */
+    char                 label[PROFILER_NAME_SIZE + LUA_IDSIZE + 16];
+}
+JackProfilerFunction;
+
+typedef struct {
+    int                  function;
+    int                  line;
+}
+JackProfilerFrame;
+
+/* Fixed size record in the sample ringbuffer, frames[0] is the innermost */
+typedef struct {
+    unsigned long long   ticks;
+    int                  depth;
+    JackProfilerFrame    frames[1];
+}
+JackProfilerSample;
+
+typedef struct JackProfilerShared {
+    AtomicCounter        refCounter;
+    int                  interval;       /* VM instructions between two samples */
+    int                  maxDepth;
+    size_t               sampleSize;
+    jack_ringbuffer_t*   samples;
+    AtomicCounter        recorded;
+    AtomicCounter        dropped;
+    volatile bool        running;
+
+    JackProfilerFunction* functions;
+    int                  maxFunctions;
+    AtomicCounter        functionCount;
+    int*                 hash;           /* 2 * maxFunctions slots of function index + 1 */
+
+    /* process context state */
+    JackProfilerSample*  current;
+    unsigned long long   lastTicks;
+
+    /* tick rate calibration */
+    unsigned long long   startTicks;
+    jack_time_t          startTime;
+}
+JackProfilerShared;
+
+/* Main context object, aggregates the drained samples into Lua tables */
+typedef struct {
+    JackProfilerShared*  shared;
+    JackClientShared*    client;
+    int                  foldedRef;      /* stack -> ticks */
+    int                  flatRef;        /* function and line -> ticks */
+}
+JackProfiler;
+
+static inline JackProfiler* getCheckedProfiler(lua_State* L, int stackIndex)
+{
+    JackProfiler* profiler = (JackProfiler*) checkudata(L, stackIndex, PROFILER_TYPE, PROFILER_TYPE_NAME);
+    return profiler;
+}
+
+/////////////////////////////////////////////////////////////////////////////////
+
+#define createProfiler luajack_createProfiler 
+
+JackProfilerShared* createProfiler(int interval, int maxDepth, int capacity, int maxFunctions);
+
+#define releaseProfiler luajack_releaseProfiler 
+
+void releaseProfiler(JackProfilerShared* profiler);
+
+/* Installs or removes the count hook on the process context. May be called
+ * from the main context while the process context is running. */
+
+#define startProfiler luajack_startProfiler 
+
+void startProfiler(JackProfilerShared* profiler, lua_State* processContext);
+
+#define stopProfiler luajack_stopProfiler 
+
+void stopProfiler(JackProfilerShared* profiler, lua_State* processContext);
+
+/* Called at the beginning of each process cycle, so that time outside the 
+ * process callback is not attributed to the first sample */
+
+static inline void beginProfilerCycle(JackProfilerShared* profiler)
+{
+    profiler->lastTicks = cycleClock();
+}
+
+/* Ticks per microsecond since the profiler was created */
+
+#define getProfilerTickRate luajack_getProfilerTickRate 
+
+double getProfilerTickRate(JackProfilerShared* profiler);
+
+/////////////////////////////////////////////////////////////////////////////////
+
+#endif // LUAJACK_PROFILER_UTIL_H
@@ -3,6 +3,24 @@
 #include "util.h"
 #include "rbuf.h"
 #include "rbuf_util.h"
+#include "trace_util.h"
+#include "recorder_util.h"
+#include "process_util.h"
+
+/* Returns the recorder of the ringbuffer if L is the process context of the
+ * recording client, else NULL. The recorder fifo has the process thread as
+ * its only producer, reads in other contexts are not recorded and keep the
+ * ringbuffer from being recorded later. */
+static JackRecorderShared* getRecorderOfContext(lua_State* L, JackRbufShared* rbuf)
+{
+    JackClientShared* client = getProcessClient(L);
+    if (!client) {
+        rbuf->readOutsideProcess = true;
+        return NULL;
+    }
+    JackRecorderShared* recorder = rbuf->recorder;
+    return (recorder && client->recorder == recorder) ? recorder : NULL;
+}
 
 static int rbuf_ptr(lua_State* L)
 {
@@ -59,7 +77,40 @@ static int rbuf_write(lua_State* L)
 static int rbuf_read(lua_State* L)
 {
     JackRbuf* rbuf = getCheckedRbuf(L, 1);
-    return readRbuf(rbuf->ptr, L, 2);
+    traceBegin("rbuf read");
+    int n = readRbuf(rbuf->ptr, L, 2);
+    traceEnd();
+    JackRecorderShared* recorder = (n == 2) ? getRecorderOfContext(L, rbuf->shared) : NULL;
+    if (recorder) {
+        size_t len;
+        const char* data = lua_tolstring(L, -1, &len);
+        recordRbufMessage(recorder, rbuf->shared->recorderIndex,
+                          (int32_t) lua_tointeger(L, -2), NULL, data, (uint32_t) len);
+    }
+    return n;
+}
+
+static int rbuf_write_at(lua_State* L)
+{
+    JackRbuf* rbuf = getCheckedRbuf(L, 1);
+    return writeTimedRbuf(rbuf->ptr, L, 2);
+}
+
+static int rbuf_read_at(lua_State* L)
+{
+    JackRbuf* rbuf = getCheckedRbuf(L, 1);
+    traceBegin("rbuf read");
+    int n = readTimedRbuf(rbuf->ptr, L, 2);
+    traceEnd();
+    JackRecorderShared* recorder = (n == 3) ? getRecorderOfContext(L, rbuf->shared) : NULL;
+    if (recorder) {
+        size_t   len;
+        const char* data = lua_tolstring(L, -1, &len);
+        uint32_t time    = (uint32_t) lua_tointeger(L, -3);
+        recordRbufMessage(recorder, rbuf->shared->recorderIndex,
+                          (int32_t) lua_tointeger(L, -2), &time, data, (uint32_t) len);
+    }
+    return n;
 }
 
 
@@ -75,6 +126,8 @@ static const struct luaL_Reg RbufMethods[] =
     { "ptr",        rbuf_ptr   },
     { "write",      rbuf_write },
     { "read",       rbuf_read  },
+    { "write_at",   rbuf_write_at },
+    { "read_at",    rbuf_read_at  },
     { NULL, NULL } /* sentinel */
 };
 
@@ -88,6 +141,8 @@ static const struct luaL_Reg ModuleFunctions[] =
     { "ringbuffer",        rbuf_new   },
     { "ringbuffer_write",  rbuf_write },
     { "ringbuffer_read",   rbuf_read  },
+    { "ringbuffer_write_at", rbuf_write_at },
+    { "ringbuffer_read_at",  rbuf_read_at  },
     { NULL, NULL } /* sentinel */
 };
 
@@ -95,16 +150,16 @@ bool luajack_open_rbuf(lua_State* L, int module, int clientMeta, int clientClass
                                                   int   rbufMeta, int   rbufClass)
 {
     lua_pushvalue(L, module);
-        luaL_setfuncs(L, ModuleFunctions, 0);
+        setfuncs(L, ModuleFunctions);
 
         lua_pushvalue(L, clientClass);
-            luaL_setfuncs(L, ClientMethods, 0);
+            setfuncs(L, ClientMethods);
     
             lua_pushvalue(L, rbufMeta);
-                luaL_setfuncs(L, RbufMetaMethods, 0);
+                setfuncs(L, RbufMetaMethods);
         
                 lua_pushvalue(L, rbufClass);
-                    luaL_setfuncs(L, RbufMethods, 0);
+                    setfuncs(L, RbufMethods);
             
     lua_pop(L, 4);
     
@@ -2,6 +2,7 @@
 
 #include "util.h"
 #include "rbuf_util.h"
+#include "recorder_util.h"
 
 /////////////////////////////////////////////////////////////////////////////////
 
@@ -37,6 +38,7 @@ void releaseJackRbuf(JackRbufShared* sharedRbuf)
                 jack_ringbuffer_free(sharedRbuf->ptr);
                 sharedRbuf->ptr = NULL;
             }
+            releaseRecorder(sharedRbuf->recorder);
             free(sharedRbuf);
         }
     }
@@ -187,3 +189,163 @@ int readRbuf(jack_ringbuffer_t *rbuf, lua_State *L, int advance)
 	}
 
 /////////////////////////////////////////////////////////////////////////////////
+
+int writeTimedRbuf(jack_ringbuffer_t *rbuf, lua_State *L, int arg)
+/* bool = write_at(..., time, tag, data)
+ * like writeRbuf, but with frame time (integer) at index 'arg' of the stack 
+ */
+{
+    hdr_t hdr;
+    int isnum;
+    size_t len;
+    const char *data;
+    uint32_t time = (uint32_t)lua_tointegerx(L, arg, &isnum);
+    if(!isnum)
+        luaL_error(L, "invalid time");
+
+    hdr.tag = (uint32_t)lua_tointegerx(L, arg + 1, &isnum);
+    if(!isnum)
+        luaL_error(L, "invalid tag");
+
+    data = luaL_optlstring(L, arg + 2, NULL, &len);
+    if(!data)
+        len = 0;
+    hdr.len = sizeof(time) + len;
+
+    if((sizeof(hdr) + hdr.len) > jack_ringbuffer_write_space(rbuf))
+        { lua_pushboolean(L, 0); return 1; }
+
+    /* jack_ringbuffer_write() handles the wrap around and advances */
+    jack_ringbuffer_write(rbuf, (const char *)&hdr, sizeof(hdr));
+    jack_ringbuffer_write(rbuf, (const char *)&time, sizeof(time));
+    if(len)
+        jack_ringbuffer_write(rbuf, data, len);
+
+    lua_pushboolean(L, 1);
+    return 1;
+}
+
+/////////////////////////////////////////////////////////////////////////////////
+
+int readTimedRbuf(jack_ringbuffer_t *rbuf, lua_State *L, int advance)
+/* time, tag, data = read_at()
+ * returns time=nil if there is not a complete timed message in the ringbuffer
+ */
+{
+    int nresults = readRbuf(rbuf, L, advance);
+    if(nresults < 2)
+        return nresults;
+
+    size_t len;
+    const char* data = lua_tolstring(L, -1, &len);
+    uint32_t time;
+    if(len < sizeof(time))
+        return luaL_error(L, "message is not a timed message");
+    memcpy(&time, data, sizeof(time));
+
+    lua_pushinteger(L, time);
+    lua_insert(L, -3);
+    lua_pushlstring(L, data + sizeof(time), len - sizeof(time));
+    lua_replace(L, -2);
+    return 3;
+}
+
+/////////////////////////////////////////////////////////////////////////////////
+
+int readTimedRbufMessage(jack_ringbuffer_t* rbuf, jack_nframes_t* time, int32_t* tag, 
+                         char* data, uint32_t* len)
+{
+    hdr_t hdr;
+    uint32_t t;
+
+    if(jack_ringbuffer_peek(rbuf, (char*)&hdr, sizeof(hdr)) != sizeof(hdr))
+        return RBUF_MESSAGE_NONE;
+
+    if(jack_ringbuffer_read_space(rbuf) < (sizeof(hdr) + hdr.len))
+        return RBUF_MESSAGE_NONE;
+
+    if(hdr.len < sizeof(t) || hdr.len - sizeof(t) > *len) 
+        {
+        jack_ringbuffer_read_advance(rbuf, sizeof(hdr) + hdr.len);
+        return RBUF_MESSAGE_TOO_LARGE;
+        }
+    jack_ringbuffer_read_advance(rbuf, sizeof(hdr));
+    jack_ringbuffer_read(rbuf, (char*)&t, sizeof(t));
+    *len  = hdr.len - sizeof(t);
+    *tag  = hdr.tag;
+    *time = t;
+    if(*len)
+        jack_ringbuffer_read(rbuf, data, *len);
+    return RBUF_MESSAGE_OK;
+}
+
+/////////////////////////////////////////////////////////////////////////////////
+
+int readRbufMessage(jack_ringbuffer_t* rbuf, int32_t* tag, char* data, uint32_t* len)
+{
+    hdr_t hdr;
+
+    if(jack_ringbuffer_peek(rbuf, (char*)&hdr, sizeof(hdr)) != sizeof(hdr))
+        return RBUF_MESSAGE_NONE;
+
+    if(jack_ringbuffer_read_space(rbuf) < (sizeof(hdr) + hdr.len))
+        return RBUF_MESSAGE_NONE;
+
+    if(hdr.len > *len) 
+        {
+        jack_ringbuffer_read_advance(rbuf, sizeof(hdr) + hdr.len);
+        return RBUF_MESSAGE_TOO_LARGE;
+        }
+    jack_ringbuffer_read_advance(rbuf, sizeof(hdr));
+    *len = hdr.len;
+    *tag = hdr.tag;
+    if(*len)
+        jack_ringbuffer_read(rbuf, data, *len);
+    return RBUF_MESSAGE_OK;
+}
+
+bool writeRbufMessage(jack_ringbuffer_t* rbuf, int32_t tag, const char* data, uint32_t len)
+{
+    hdr_t hdr;
+    hdr.tag = tag;
+    hdr.len = data ? len : 0;
+
+    if(jack_ringbuffer_write_space(rbuf) < (sizeof(hdr) + hdr.len))
+        return false;
+
+    jack_ringbuffer_write(rbuf, (const char*)&hdr, sizeof(hdr));
+    if(hdr.len)
+        jack_ringbuffer_write(rbuf, data, hdr.len);
+    return true;
+}
+
+bool writeRbufHeader(jack_ringbuffer_t* rbuf, int32_t tag, uint32_t len)
+{
+    hdr_t hdr;
+    hdr.tag = tag;
+    hdr.len = len;
+
+    if(jack_ringbuffer_write_space(rbuf) < (sizeof(hdr) + hdr.len))
+        return false;
+
+    jack_ringbuffer_write(rbuf, (const char*)&hdr, sizeof(hdr));
+    return true;
+}
+
+bool readRbufHeader(jack_ringbuffer_t* rbuf, int32_t* tag, uint32_t* len)
+{
+    hdr_t hdr;
+
+    if(jack_ringbuffer_peek(rbuf, (char*)&hdr, sizeof(hdr)) != sizeof(hdr))
+        return false;
+
+    if(jack_ringbuffer_read_space(rbuf) < (sizeof(hdr) + hdr.len))
+        return false;
+
+    jack_ringbuffer_read_advance(rbuf, sizeof(hdr));
+    *tag = hdr.tag;
+    *len = hdr.len;
+    return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////////
@@ -30,6 +30,58 @@ int writeRbuf(jack_ringbuffer_t* rbuf, lua_State* L, int arg);
 
 int readRbuf(jack_ringbuffer_t* rbuf, lua_State* L, int arg);
 
+/* Same message format without Lua: writeRbufMessage returns false if there is
+ * not enough space, readRbufMessage returns one of the RBUF_MESSAGE_* values 
+ * below with *len as for readTimedRbufMessage. */
+
+#define writeRbufMessage luajack_writeRbufMessage 
+
+bool writeRbufMessage(jack_ringbuffer_t* rbuf, int32_t tag, const char* data, uint32_t len);
+
+#define readRbufMessage luajack_readRbufMessage 
+
+int readRbufMessage(jack_ringbuffer_t* rbuf, int32_t* tag, char* data, uint32_t* len);
+
+/* For messages whose data are produced or consumed in pieces: writeRbufHeader
+ * writes the header only if there is space for the whole message, the caller
+ * must then write exactly len bytes. readRbufHeader consumes the header only
+ * if the whole message is available, the caller must then read or skip len
+ * bytes. */
+
+#define writeRbufHeader luajack_writeRbufHeader 
+
+bool writeRbufHeader(jack_ringbuffer_t* rbuf, int32_t tag, uint32_t len);
+
+#define readRbufHeader luajack_readRbufHeader 
+
+bool readRbufHeader(jack_ringbuffer_t* rbuf, int32_t* tag, uint32_t* len);
+
+/////////////////////////////////////////////////////////////////////////////////
+
+/* Timed messages carry a target frame time (see jack_frame_time()) as 
+ * uint32_t in front of the message data */
+
+#define writeTimedRbuf luajack_writeTimedRbuf 
+
+int writeTimedRbuf(jack_ringbuffer_t* rbuf, lua_State* L, int arg);
+
+#define readTimedRbuf luajack_readTimedRbuf 
+
+int readTimedRbuf(jack_ringbuffer_t* rbuf, lua_State* L, int advance);
+
+#define RBUF_MESSAGE_NONE      0
+#define RBUF_MESSAGE_OK        1
+#define RBUF_MESSAGE_TOO_LARGE 2
+
+/* Reads a timed message without Lua: *len is the capacity of data on input and
+ * the length of the message data on output. Messages larger than the capacity 
+ * are skipped (RBUF_MESSAGE_TOO_LARGE). */
+
+#define readTimedRbufMessage luajack_readTimedRbufMessage
+
+int readTimedRbufMessage(jack_ringbuffer_t* rbuf, jack_nframes_t* time, int32_t* tag, 
+                         char* data, uint32_t* len);
+
 /////////////////////////////////////////////////////////////////////////////////
 
 #endif // LUAJACK_RBUF_UTIL_H
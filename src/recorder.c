@@ -0,0 +1,379 @@
+#include <stdlib.h>
+
+#include "util.h"
+#include "recorder.h"
+#include "recorder_util.h"
+#include "rbuf_util.h"
+#include "client_util.h"
+
+/* Pushes an array of the audio ports of the client in the list options[name]
+ * as userdata, so that it is freed by the garbage collector */
+static JackPortShared** pushPortList(lua_State* L, int optIndex, const char* name,
+                                     JackClient* client, int* count)
+{
+    lua_getfield(L, optIndex, name);
+    int list = lua_gettop(L);
+    int n    = lua_isnil(L, list) ? 0 : (int) luaL_len(L, list);
+    JackPortShared** ports = (JackPortShared**) lua_newuserdata(L, sizeof(JackPortShared*) * (n + 1));
+    int i;
+    for (i = 0; i < n; ++i) {
+        lua_rawgeti(L, list, i + 1);
+        JackPort* port = getOptionalPort(L, -1);
+        if (!port || !port->shared || port->shared->client != client->shared) {
+            luaL_error(L, "%s[%d]: port of this client expected", name, i + 1);
+        }
+        if (strcmp(jack_port_type(port->ptr), JACK_DEFAULT_AUDIO_TYPE) != 0) {
+            luaL_error(L, "%s[%d]: audio port expected", name, i + 1);
+        }
+        ports[i] = port->shared;
+        lua_pop(L, 1);
+    }
+    lua_remove(L, list);
+    *count = n;
+    return ports;
+}
+
+static JackRbufShared** pushRbufList(lua_State* L, int optIndex, int* count)
+{
+    lua_getfield(L, optIndex, "rbufs");
+    int list = lua_gettop(L);
+    int n    = lua_isnil(L, list) ? 0 : (int) luaL_len(L, list);
+    JackRbufShared** rbufs = (JackRbufShared**) lua_newuserdata(L, sizeof(JackRbufShared*) * (n + 1));
+    int i;
+    for (i = 0; i < n; ++i) {
+        lua_rawgeti(L, list, i + 1);
+        JackRbuf* rbuf = getOptionalRbuf(L, -1);
+        if (!rbuf || !rbuf->shared) {
+            luaL_error(L, "rbufs[%d]: ringbuffer expected", i + 1);
+        }
+        rbufs[i] = rbuf->shared;
+        lua_pop(L, 1);
+    }
+    lua_remove(L, list);
+    *count = n;
+    return rbufs;
+}
+
+static int recorder_new(lua_State* L)
+/* recorder = client:recorder(filename, options)
+ * records the input ports and the ringbuffer messages read by the process
+ * chunk cycle by cycle into a file that can be replayed with client:replay().
+ * A writer thread writes the file, the process callback only copies into a
+ * fifo. Options:
+ *   inputs = {port, ...}   recorded audio ports of the client
+ *   rbufs  = {rbuf, ...}   ringbuffers whose messages are read by the process
+ *                          chunk with read() or read_at(). Reads in other
+ *                          contexts are not recorded, a ringbuffer that has
+ *                          already been read in another context is rejected.
+ *   fifo   = n             fifo size in frames (default: two seconds)
+ * The recorder is created stopped, a client can only have one recorder at a
+ * time. Closing the recorder detaches it from the client and the ringbuffers.
+ */
+{
+    JackClient* client   = getCheckedClient(L, 1);
+    const char* fileName = luaL_checkstring(L, 2);
+    luaL_checktype(L, 3, LUA_TTABLE);
+    if (!client->isMaster || client->isInProcessContext) {
+        return luaL_error(L, "recorder can only be created for the master client in main context");
+    }
+    if (client->shared->recorder) {
+        return luaL_error(L, "client already has a recorder");
+    }
+    int nPorts, nRbufs;
+    JackPortShared** ports = pushPortList(L, 3, "inputs", client, &nPorts);
+    JackRbufShared** rbufs = pushRbufList(L, 3, &nRbufs);
+    int i;
+    for (i = 0; i < nRbufs; ++i) {
+        if (rbufs[i]->recorder) {
+            return luaL_error(L, "rbufs[%d]: ringbuffer is already recorded", i + 1);
+        }
+        if (rbufs[i]->readOutsideProcess) {
+            return luaL_error(L, "rbufs[%d]: ringbuffer is read outside of the process context", i + 1);
+        }
+    }
+    jack_nframes_t sampleRate = jack_get_sample_rate(client->ptr);
+    jack_nframes_t bufferSize = jack_get_buffer_size(client->ptr);
+    lua_Integer    fifo       = getIntegerOption(L, 3, "fifo", 2 * sampleRate);
+    luaL_argcheck(L, fifo >= bufferSize, 3, "fifo must hold at least one cycle");
+
+    /* message space of the fifo is the same as for one audio channel */
+    size_t fifoSize = (size_t) fifo * sizeof(float) * (nPorts + 1)
+                    + (size_t)(fifo / bufferSize + 1) * sizeof(JackRecordHeader);
+
+    JackRecorder* recorder = (JackRecorder*) lua_newuserdata(L, sizeof(JackRecorder));
+    memset(recorder, 0, sizeof(JackRecorder));
+    luaL_setmetatable(L, RECORDER_TYPE_NAME);
+
+    const char* errorMessage = NULL;
+    recorder->shared = createRecorder(fileName, ports, nPorts, nRbufs, fifoSize,
+                                      sampleRate, bufferSize, &errorMessage);
+    if (!recorder->shared) {
+        return luaL_error(L, "%s: %s", errorMessage, fileName);
+    }
+    recorder->rbufs = (JackRbufShared**) malloc(sizeof(JackRbufShared*) * (nRbufs + 1));
+    if (!recorder->rbufs) {
+        return luaL_error(L, "cannot create recorder");
+    }
+    for (i = 0; i < nRbufs; ++i) {
+        rbufs[i]->recorderIndex = i;
+        rbufs[i]->recorder      = recorder->shared;
+        atomic_inc(&recorder->shared->refCounter);
+        recorder->rbufs[i] = rbufs[i];
+        atomic_inc(&rbufs[i]->refCounter);
+    }
+    recorder->nRbufs = nRbufs;
+
+    /* the client keeps the recorder alive as long as the process callback
+     * may use it */
+    atomic_inc(&recorder->shared->refCounter);
+    client->shared->recorder = recorder->shared;
+    recorder->client = client->shared;
+    atomic_inc(&client->shared->refCounter);
+    return 1;
+}
+
+/* Detaches the recorder from its ringbuffers and its client. The process
+ * callback may still use the recorder in the current cycle, therefore the
+ * client keeps it as retired recorder until the next recorder is closed or
+ * the client is closed. */
+static void detachRecorder(JackRecorder* recorder)
+{
+    JackRecorderShared* shared = recorder->shared;
+    int i;
+    for (i = 0; i < recorder->nRbufs; ++i) {
+        JackRbufShared* rbuf = recorder->rbufs[i];
+        if (atomic_set_ptr_if_equal((void**) &rbuf->recorder, shared, NULL)) {
+            releaseRecorder(shared);
+        }
+        releaseJackRbuf(rbuf);
+    }
+    free(recorder->rbufs);
+    recorder->rbufs  = NULL;
+    recorder->nRbufs = 0;
+
+    JackClientShared* client = recorder->client;
+    if (client) {
+        if (atomic_set_ptr_if_equal((void**) &client->recorder, shared, NULL)) {
+            releaseRecorder(client->retiredRecorder);
+            client->retiredRecorder = shared;
+        }
+        releaseClientShared(client);
+        recorder->client = NULL;
+    }
+}
+
+static JackRecorderShared* getValidRecorder(lua_State* L, int stackIndex)
+{
+    JackRecorder* recorder = getCheckedRecorder(L, stackIndex);
+    if (!recorder->shared) {
+        luaL_error(L, "recorder was closed");
+    }
+    return recorder->shared;
+}
+
+static int recorder_close(lua_State* L)
+/* recorder:close()
+ * stops recording, waits until the writer thread has written everything and
+ * closes the file. Is also done by the garbage collector.
+ */
+{
+    JackRecorder* recorder = getCheckedRecorder(L, 1);
+    if (recorder->shared) {
+        JackRecorderShared* shared = recorder->shared;
+        detachRecorder(recorder);
+        recorder->shared = NULL;
+        closeRecorder(shared);
+        bool failed = atomic_get(&shared->writeErrors) > 0;
+        releaseRecorder(shared);
+        if (failed) {
+            return luaL_error(L, "error writing recording");
+        }
+    }
+    return 0;
+}
+
+static int recorder_release(lua_State* L)
+{
+    JackRecorder* recorder = getCheckedRecorder(L, 1);
+    if (recorder->shared) {
+        detachRecorder(recorder);
+        closeRecorder(recorder->shared);
+        releaseRecorder(recorder->shared);
+        recorder->shared = NULL;
+    }
+    return 0;
+}
+
+static int recorder_toString(lua_State* L)
+{
+    JackRecorder* recorder = getCheckedRecorder(L, 1);
+    lua_pushfstring(L, "%s: %p", RECORDER_TYPE_NAME, recorder->shared);
+    return 1;
+}
+
+static int recorder_start(lua_State* L)
+{
+    JackRecorderShared* recorder = getValidRecorder(L, 1);
+    recorder->running = true;
+    return 0;
+}
+
+static int recorder_stop(lua_State* L)
+/* recorder:stop()
+ * pauses recording, recorder:start() continues it. Paused cycles are not
+ * part of the recording.
+ */
+{
+    JackRecorderShared* recorder = getValidRecorder(L, 1);
+    recorder->running = false;
+    return 0;
+}
+
+static int recorder_cycles(lua_State* L)
+/* cycles, messages = recorder:cycles()
+ * returns the number of recorded cycles and messages.
+ */
+{
+    JackRecorderShared* recorder = getValidRecorder(L, 1);
+    lua_pushinteger(L, atomic_get(&recorder->cycles));
+    lua_pushinteger(L, atomic_get(&recorder->messages));
+    return 2;
+}
+
+static int recorder_overruns(lua_State* L)
+/* n = recorder:overruns()
+ * returns the number of cycles and messages lost because the fifo was full.
+ */
+{
+    JackRecorderShared* recorder = getValidRecorder(L, 1);
+    lua_pushinteger(L, atomic_get(&recorder->overruns));
+    return 1;
+}
+
+static int replay(lua_State* L)
+/* cycles, maxdiff, cycle = client:replay(filename, options)
+ * runs the process callback once per cycle of a recording, synchronously in
+ * the calling thread and without JACK driving it. The recorded samples are
+ * fed into virtual input ports and the messages are written into their
+ * ringbuffers before the cycle that has read them. The client must not be
+ * activated. Options:
+ *   inputs    = {port, ...}  ports in the same order as for recording
+ *   outputs   = {port, ...}  audio ports written by the process chunk
+ *   rbufs     = {rbuf, ...}  ringbuffers in the same order as for recording
+ *   output    = filename     writes the outputs in the recording format
+ *   golden    = filename     compares the outputs with a file written by
+ *                            an earlier replay with output = filename
+ *   tolerance = x            largest accepted difference (default 0)
+ * Returns the number of replayed cycles and, if a golden file is given, the
+ * largest difference and the first cycle with a difference above tolerance
+ * (or nil).
+ */
+{
+    JackClient* client   = getCheckedClient(L, 1);
+    const char* fileName = luaL_checkstring(L, 2);
+    luaL_checktype(L, 3, LUA_TTABLE);
+    if (!client->isMaster || client->isInProcessContext) {
+        return luaL_error(L, "method can only be called on master client object in main context");
+    }
+    if (client->isActivated) {
+        return luaL_error(L, "client must not be activated for replay");
+    }
+    if (!client->shared->processContext) {
+        return luaL_error(L, "process chunk must be loaded before replay");
+    }
+    if (client->shared->errorInProcessContext) {
+        return luaL_error(L, "process callback has failed before");
+    }
+    JackReplaySetup setup;
+    memset(&setup, 0, sizeof(setup));
+    setup.fileName = fileName;
+    setup.inputs   = pushPortList(L, 3, "inputs",  client, &setup.nInputs);
+    setup.outputs  = pushPortList(L, 3, "outputs", client, &setup.nOutputs);
+    setup.rbufs    = pushRbufList(L, 3, &setup.nRbufs);
+
+    lua_getfield(L, 3, "output");
+    setup.outputFileName = luaL_optstring(L, -1, NULL);
+    lua_getfield(L, 3, "golden");
+    setup.goldenFileName = luaL_optstring(L, -1, NULL);
+    lua_getfield(L, 3, "tolerance");
+    setup.tolerance = luaL_optnumber(L, -1, 0);
+
+    JackReplayResult result;
+    const char* errorMessage = NULL;
+    if (!replayRecording(client->shared, &setup, &result, &errorMessage)) {
+        JackClientShared* shared = client->shared;
+        if (shared->errorInProcessContext) {
+            /* same as client:check_error() */
+            async_mutex_lock(&shared->mutex);
+            lua_pushstring(L, shared->errorInProcessContext);
+            free(shared->errorInProcessContext);
+            shared->errorInProcessContext = NULL;
+            shared->processContextErrorFlag = 0;
+            async_mutex_unlock(&shared->mutex);
+            return lua_error(L);
+        }
+        return luaL_error(L, "%s: %s", errorMessage, fileName);
+    }
+    lua_pushinteger(L, result.cycles);
+    if (!setup.goldenFileName) {
+        return 1;
+    }
+    lua_pushnumber(L, result.maxDiff);
+    if (result.mismatchCycle >= 0) {
+        lua_pushinteger(L, result.mismatchCycle);
+    } else {
+        lua_pushnil(L);
+    }
+    return 3;
+}
+
+static const struct luaL_Reg ClientMethods[] =
+{
+    { "recorder",   recorder_new },
+    { "replay",     replay },
+    { NULL, NULL } /* sentinel */
+};
+
+static const struct luaL_Reg RecorderMetaMethods[] =
+{
+    { "__tostring", recorder_toString },
+    { "__gc",       recorder_release },
+    { NULL, NULL } /* sentinel */
+};
+
+static const struct luaL_Reg RecorderMethods[] =
+{
+    { "start",      recorder_start },
+    { "stop",       recorder_stop },
+    { "close",      recorder_close },
+    { "cycles",     recorder_cycles },
+    { "overruns",   recorder_overruns },
+    { NULL, NULL } /* sentinel */
+};
+
+static const struct luaL_Reg ModuleFunctions[] =
+{
+    { "recorder",   recorder_new },
+    { "replay",     replay },
+    { NULL, NULL } /* sentinel */
+};
+
+bool luajack_open_recorder(lua_State* L, int module, int clientMeta, int clientClass,
+                                                     int recorderMeta, int recorderClass)
+{
+    lua_pushvalue(L, module);
+        setfuncs(L, ModuleFunctions);
+
+        lua_pushvalue(L, clientClass);
+            setfuncs(L, ClientMethods);
+
+            lua_pushvalue(L, recorderMeta);
+                setfuncs(L, RecorderMetaMethods);
+
+                lua_pushvalue(L, recorderClass);
+                    setfuncs(L, RecorderMethods);
+
+    lua_pop(L, 4);
+
+    return true;
+}
@@ -0,0 +1,7 @@
+#ifndef LUAJACK_RECORDER_H
+#define LUAJACK_RECORDER_H
+
+bool luajack_open_recorder(lua_State* L, int module, int clientMeta, int clientClass,
+                                                     int recorderMeta, int recorderClass);
+
+#endif // LUAJACK_RECORDER_H
@@ -0,0 +1,475 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "util.h"
+#include "recorder_util.h"
+#include "process_util.h"
+#include "port_util.h"
+#include "rbuf_util.h"
+#include "trace_util.h"
+
+#define RECORDER_POLL_MILLIS 10
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+static void writeFifo(JackRecorderShared* recorder)
+{
+    jack_ringbuffer_data_t vec[2];
+    jack_ringbuffer_get_read_vector(recorder->fifo, vec);
+    size_t n = vec[0].len + vec[1].len;
+    if (n == 0) {
+        return;
+    }
+    traceThreadBegin("recorder writer", "recorder write");
+    int i;
+    for (i = 0; i < 2; ++i) {
+        if (vec[i].len > 0 && fwrite(vec[i].buf, 1, vec[i].len, recorder->file) != vec[i].len) {
+            atomic_inc(&recorder->writeErrors);
+        }
+    }
+    jack_ringbuffer_read_advance(recorder->fifo, n);
+    traceEnd();
+}
+
+static void recorderWriter(void* arg)
+{
+    JackRecorderShared* recorder = (JackRecorderShared*) arg;
+    bool stopped = false;
+    while (!stopped) {
+        async_mutex_lock(&recorder->mutex);
+        if (!recorder->stopped) {
+            async_mutex_wait_millis(&recorder->mutex, RECORDER_POLL_MILLIS);
+        }
+        stopped = recorder->stopped;
+        async_mutex_unlock(&recorder->mutex);
+
+        /* after stopping everything left in the fifo is written */
+        writeFifo(recorder);
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+JackRecorderShared* createRecorder(const char* fileName, JackPortShared** ports, int channels,
+                                   int rbufs, size_t fifoSize,
+                                   jack_nframes_t sampleRate, jack_nframes_t bufferSize,
+                                   const char** errorMessage)
+{
+    JackRecorderShared* recorder = (JackRecorderShared*) calloc(1, sizeof(JackRecorderShared));
+    if (!recorder) {
+        *errorMessage = "cannot create recorder";
+        return NULL;
+    }
+    recorder->refCounter = 1;
+    recorder->rbufs      = rbufs;
+    recorder->ports      = (JackPortShared**) calloc(channels > 0 ? channels : 1, sizeof(JackPortShared*));
+    recorder->fifo       = jack_ringbuffer_create(fifoSize);
+    if (!recorder->ports || !recorder->fifo) {
+        *errorMessage = "cannot create recorder";
+        releaseRecorder(recorder);
+        return NULL;
+    }
+    int c;
+    for (c = 0; c < channels; ++c) {
+        recorder->ports[c] = ports[c];
+        atomic_inc(&ports[c]->refCounter);
+    }
+    recorder->channels = channels;
+
+    if (jack_ringbuffer_mlock(recorder->fifo) != 0) {
+        verbosePrintf("could not lock recorder fifo into memory\n");
+    }
+    recorder->file = fopen(fileName, "wb");
+    if (!recorder->file) {
+        *errorMessage = "cannot open file";
+        releaseRecorder(recorder);
+        return NULL;
+    }
+    JackRecordFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, RECORD_MAGIC, sizeof(header.magic));
+    header.sampleRate = sampleRate;
+    header.bufferSize = bufferSize;
+    header.channels   = channels;
+    header.rbufs      = rbufs;
+    if (fwrite(&header, sizeof(header), 1, recorder->file) != 1) {
+        *errorMessage = "cannot write file";
+        releaseRecorder(recorder);
+        return NULL;
+    }
+    recorder->hasMutex  = async_mutex_init(&recorder->mutex);
+    recorder->hasThread = recorder->hasMutex
+                       && async_thread_create(&recorder->thread, recorderWriter, recorder);
+    if (!recorder->hasThread) {
+        *errorMessage = "cannot start writer thread";
+        releaseRecorder(recorder);
+        return NULL;
+    }
+    return recorder;
+}
+
+void closeRecorder(JackRecorderShared* recorder)
+{
+    recorder->running = false;
+    if (recorder->hasThread) {
+        async_mutex_lock(&recorder->mutex);
+        recorder->stopped = true;
+        async_mutex_notify(&recorder->mutex);
+        async_mutex_unlock(&recorder->mutex);
+        async_thread_join(recorder->thread);
+        recorder->hasThread = false;
+    }
+    if (recorder->file) {
+        if (fclose(recorder->file) != 0) {
+            atomic_inc(&recorder->writeErrors);
+        }
+        recorder->file = NULL;
+    }
+}
+
+void releaseRecorder(JackRecorderShared* recorder)
+{
+    if (recorder && atomic_dec(&recorder->refCounter) == 0) {
+        closeRecorder(recorder);
+        if (recorder->hasMutex) {
+            async_mutex_destruct(&recorder->mutex);
+        }
+        if (recorder->fifo) {
+            jack_ringbuffer_free(recorder->fifo);
+        }
+        int c;
+        for (c = 0; c < recorder->channels; ++c) {
+            releasePort(recorder->ports[c]);
+        }
+        free(recorder->ports);
+        free(recorder);
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+void recordCycle(JackRecorderShared* recorder, jack_nframes_t nframes)
+{
+    if (!recorder->running) {
+        return;
+    }
+    recorder->cycle += 1;
+
+    JackRecordHeader header;
+    header.kind  = RECORD_CYCLE;
+    header.cycle = recorder->cycle;
+    header.index = nframes;
+    header.tag   = 0;
+    header.len   = sizeof(float) * nframes * recorder->channels;
+
+    if (jack_ringbuffer_write_space(recorder->fifo) < sizeof(header) + header.len) {
+        atomic_inc(&recorder->overruns);
+        return;
+    }
+    jack_ringbuffer_write(recorder->fifo, (const char*) &header, sizeof(header));
+    int c;
+    for (c = 0; c < recorder->channels; ++c) {
+        const float* in = getSharedPortCycleBuffer(recorder->ports[c], nframes);
+        jack_ringbuffer_write(recorder->fifo, (const char*) in, sizeof(float) * nframes);
+    }
+    atomic_inc(&recorder->cycles);
+}
+
+void recordRbufMessage(JackRecorderShared* recorder, int index, int32_t tag,
+                       const uint32_t* time, const char* data, uint32_t len)
+{
+    if (!recorder->running) {
+        return;
+    }
+    JackRecordHeader header;
+    header.kind  = RECORD_MESSAGE;
+    header.cycle = recorder->cycle;
+    header.index = index;
+    header.tag   = tag;
+    header.len   = (time ? sizeof(*time) : 0) + len;
+
+    if (jack_ringbuffer_write_space(recorder->fifo) < sizeof(header) + header.len) {
+        atomic_inc(&recorder->overruns);
+        return;
+    }
+    jack_ringbuffer_write(recorder->fifo, (const char*) &header, sizeof(header));
+    if (time) {
+        jack_ringbuffer_write(recorder->fifo, (const char*) time, sizeof(*time));
+    }
+    if (len) {
+        jack_ringbuffer_write(recorder->fifo, data, len);
+    }
+    atomic_inc(&recorder->messages);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+static bool readRecordHeader(FILE* file, JackRecordHeader* header)
+{
+    return fread(header, sizeof(*header), 1, file) == 1;
+}
+
+static bool readFileHeader(FILE* file, JackRecordFileHeader* header)
+{
+    return fread(header, sizeof(*header), 1, file) == 1
+        && memcmp(header->magic, RECORD_MAGIC, sizeof(header->magic)) == 0;
+}
+
+/* Reads the next cycle of the golden file into buffer, skips messages */
+static bool readGoldenCycle(FILE* file, int channels, jack_nframes_t capacity,
+                            float* buffer, jack_nframes_t* nframes)
+{
+    JackRecordHeader header;
+    while (readRecordHeader(file, &header)) {
+        if (header.kind != RECORD_CYCLE) {
+            if (fseek(file, header.len, SEEK_CUR) != 0) {
+                return false;
+            }
+            continue;
+        }
+        if (   header.index == 0 || header.index > capacity
+            || header.len != sizeof(float) * header.index * channels)
+        {
+            return false;
+        }
+        int c;
+        for (c = 0; c < channels; ++c) {
+            if (fread(buffer + c * capacity, sizeof(float), header.index, file) != header.index) {
+                return false;
+            }
+        }
+        *nframes = header.index;
+        return true;
+    }
+    return false;
+}
+
+/* Writes a recorded message into its ringbuffer, data is grown as needed */
+static bool replayMessage(FILE* in, const JackRecordHeader* record, const JackReplaySetup* setup,
+                          char** data, uint32_t* dataSize, const char** errorMessage)
+{
+    if (record->index >= (uint32_t) setup->nRbufs) {
+        *errorMessage = "invalid ringbuffer index in recording";
+        return false;
+    }
+    if (record->len > *dataSize) {
+        char* newData = (char*) realloc(*data, record->len);
+        if (!newData) {
+            *errorMessage = "out of memory";
+            return false;
+        }
+        *data     = newData;
+        *dataSize = record->len;
+    }
+    if (record->len > 0 && fread(*data, 1, record->len, in) != record->len) {
+        *errorMessage = "truncated recording";
+        return false;
+    }
+    if (!writeRbufMessage(setup->rbufs[record->index]->ptr, record->tag, *data, record->len)) {
+        *errorMessage = "ringbuffer overflow during replay";
+        return false;
+    }
+    return true;
+}
+
+bool replayRecording(JackClientShared* client, const JackReplaySetup* setup,
+                     JackReplayResult* result, const char** errorMessage)
+{
+    FILE*    in       = NULL;
+    FILE*    out      = NULL;
+    FILE*    golden   = NULL;
+    float*   buffers  = NULL;
+    float*   expected = NULL;
+    char*    data     = NULL;
+    uint32_t dataSize = 0;
+    bool     ok       = false;
+    int      c;
+
+    const int nInputs  = setup->nInputs;
+    const int nOutputs = setup->nOutputs;
+
+    result->cycles        = 0;
+    result->maxDiff       = 0;
+    result->mismatchCycle = -1;
+
+    JackRecordFileHeader header;
+    in = fopen(setup->fileName, "rb");
+    if (!in) {
+        *errorMessage = "cannot open recording";
+        goto finally;
+    }
+    if (!readFileHeader(in, &header) || header.bufferSize == 0) {
+        *errorMessage = "not a recording file";
+        goto finally;
+    }
+    if (header.channels != (uint32_t) nInputs) {
+        *errorMessage = "number of input ports does not match recording";
+        goto finally;
+    }
+    if (header.rbufs != (uint32_t) setup->nRbufs) {
+        *errorMessage = "number of ringbuffers does not match recording";
+        goto finally;
+    }
+    const jack_nframes_t capacity = header.bufferSize;
+
+    if (setup->goldenFileName) {
+        JackRecordFileHeader goldenHeader;
+        golden = fopen(setup->goldenFileName, "rb");
+        if (!golden) {
+            *errorMessage = "cannot open golden file";
+            goto finally;
+        }
+        if (!readFileHeader(golden, &goldenHeader)) {
+            *errorMessage = "golden file is not a recording file";
+            goto finally;
+        }
+        if (goldenHeader.channels != (uint32_t) nOutputs) {
+            *errorMessage = "number of output ports does not match golden file";
+            goto finally;
+        }
+    }
+    if (setup->outputFileName) {
+        JackRecordFileHeader outHeader = header;
+        outHeader.channels = nOutputs;
+        outHeader.rbufs    = 0;
+        out = fopen(setup->outputFileName, "wb");
+        if (!out || fwrite(&outHeader, sizeof(outHeader), 1, out) != 1) {
+            *errorMessage = "cannot write output file";
+            goto finally;
+        }
+    }
+    buffers  = (float*) calloc((size_t) capacity * (nInputs + nOutputs) + 1, sizeof(float));
+    expected = (float*) calloc((size_t) capacity * nOutputs + 1, sizeof(float));
+    if (!buffers || !expected) {
+        *errorMessage = "out of memory";
+        goto finally;
+    }
+    float* outputBuffers = buffers + (size_t) capacity * nInputs;
+    for (c = 0; c < nInputs; ++c) {
+        setup->inputs[c]->replayBuffer = buffers + (size_t) c * capacity;
+    }
+    for (c = 0; c < nOutputs; ++c) {
+        setup->outputs[c]->replayBuffer = outputBuffers + (size_t) c * capacity;
+    }
+
+    JackRecordHeader record;
+    bool hasRecord = readRecordHeader(in, &record);
+    uint32_t cycle = 0;
+
+    while (hasRecord)
+    {
+        if (record.kind == RECORD_MESSAGE) {
+            /* messages of a cycle that was lost by an overrun are delivered
+             * with the next cycle */
+            if (!replayMessage(in, &record, setup, &data, &dataSize, errorMessage)) {
+                goto finally;
+            }
+            hasRecord = readRecordHeader(in, &record);
+            continue;
+        }
+        if (record.kind != RECORD_CYCLE) {
+            *errorMessage = "invalid record in recording";
+            goto finally;
+        }
+        const jack_nframes_t nframes = record.index;
+        if (   nframes == 0 || nframes > capacity
+            || record.len != sizeof(float) * nframes * nInputs)
+        {
+            *errorMessage = "invalid cycle in recording";
+            goto finally;
+        }
+        for (c = 0; c < nInputs; ++c) {
+            if (fread(buffers + (size_t) c * capacity, sizeof(float), nframes, in) != nframes) {
+                *errorMessage = "truncated recording";
+                goto finally;
+            }
+        }
+        cycle = record.cycle;
+
+        /* the messages read in this cycle follow the cycle record */
+        hasRecord = readRecordHeader(in, &record);
+        while (hasRecord && record.kind == RECORD_MESSAGE && record.cycle <= cycle) {
+            if (!replayMessage(in, &record, setup, &data, &dataSize, errorMessage)) {
+                goto finally;
+            }
+            hasRecord = readRecordHeader(in, &record);
+        }
+
+        memset(outputBuffers, 0, sizeof(float) * capacity * nOutputs);
+        processCallback(nframes, client);
+        if (client->errorInProcessContext) {
+            *errorMessage = "error in process callback";
+            goto finally;
+        }
+        result->cycles += 1;
+
+        if (out) {
+            JackRecordHeader outRecord;
+            outRecord.kind  = RECORD_CYCLE;
+            outRecord.cycle = cycle;
+            outRecord.index = nframes;
+            outRecord.tag   = 0;
+            outRecord.len   = sizeof(float) * nframes * nOutputs;
+            bool written = fwrite(&outRecord, sizeof(outRecord), 1, out) == 1;
+            for (c = 0; c < nOutputs && written; ++c) {
+                written = fwrite(outputBuffers + (size_t) c * capacity, sizeof(float),
+                                 nframes, out) == nframes;
+            }
+            if (!written) {
+                *errorMessage = "cannot write output file";
+                goto finally;
+            }
+        }
+        if (golden) {
+            jack_nframes_t expectedNframes;
+            if (!readGoldenCycle(golden, nOutputs, capacity, expected, &expectedNframes)) {
+                *errorMessage = "golden file has fewer cycles than recording";
+                goto finally;
+            }
+            if (expectedNframes != nframes) {
+                *errorMessage = "cycle sizes of golden file do not match recording";
+                goto finally;
+            }
+            for (c = 0; c < nOutputs; ++c) {
+                const float* a = outputBuffers + (size_t) c * capacity;
+                const float* b = expected      + (size_t) c * capacity;
+                jack_nframes_t i;
+                for (i = 0; i < nframes; ++i) {
+                    double diff = fabs((double) a[i] - (double) b[i]);
+                    if (diff != diff) {
+                        diff = HUGE_VAL; /* NaN on one side only */
+                        if (a[i] != a[i] && b[i] != b[i]) diff = 0;
+                    }
+                    if (diff > result->maxDiff) {
+                        result->maxDiff = diff;
+                    }
+                    if (diff > setup->tolerance && result->mismatchCycle < 0) {
+                        result->mismatchCycle = cycle;
+                    }
+                }
+            }
+        }
+    }
+    ok = true;
+
+finally:
+    for (c = 0; c < nInputs; ++c) {
+        setup->inputs[c]->replayBuffer = NULL;
+    }
+    for (c = 0; c < nOutputs; ++c) {
+        setup->outputs[c]->replayBuffer = NULL;
+    }
+    if (in)     fclose(in);
+    if (golden) fclose(golden);
+    if (out && fclose(out) != 0 && ok) {
+        *errorMessage = "cannot write output file";
+        ok = false;
+    }
+    free(buffers);
+    free(expected);
+    free(data);
+    return ok;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,155 @@
+#ifndef LUAJACK_RECORDER_UTIL_H
+#define LUAJACK_RECORDER_UTIL_H
+
+#include <stdio.h>
+
+#include "util.h"
+
+/////////////////////////////////////////////////////////////////////////////////
+
+/* Recording file: a file header followed by records in native byte order.
+ * Each recorded cycle is a RECORD_CYCLE record with the samples of all input
+ * ports (channel after channel), followed by the RECORD_MESSAGE records of
+ * the ringbuffer messages the process chunk has read in that cycle. Messages
+ * read with read_at() keep their frame time in front of the data. */
+
+#define RECORD_MAGIC "LJREC01\n"
+
+enum {
+    RECORD_CYCLE   = 1,
+    RECORD_MESSAGE = 2
+};
+
+typedef struct {
+    char                 magic[8];
+    uint32_t             sampleRate;
+    uint32_t             bufferSize;
+    uint32_t             channels;       /* recorded ports */
+    uint32_t             rbufs;          /* recorded ringbuffers */
+}
+JackRecordFileHeader;
+
+typedef struct {
+    uint32_t             kind;
+    uint32_t             cycle;
+    uint32_t             index;          /* nframes for cycles, ringbuffer index for messages */
+    int32_t              tag;
+    uint32_t             len;            /* bytes following the header */
+}
+JackRecordHeader;
+
+/////////////////////////////////////////////////////////////////////////////////
+
+typedef struct JackRecorderShared {
+    AtomicCounter        refCounter;
+    int                  channels;
+    JackPortShared**     ports;
+    int                  rbufs;
+    FILE*                file;
+
+    /* process context -> writer thread */
+    jack_ringbuffer_t*   fifo;
+    AtomicCounter        overruns;
+    AtomicCounter        cycles;         /* recorded cycles */
+    AtomicCounter        messages;       /* recorded messages */
+    volatile bool        running;
+    uint32_t             cycle;          /* process context only */
+
+    /* writer thread */
+    Thread               thread;
+    bool                 hasThread;
+    Mutex                mutex;
+    bool                 hasMutex;
+    volatile bool        stopped;
+    AtomicCounter        writeErrors;
+}
+JackRecorderShared;
+
+typedef struct {
+    JackRecorderShared*  shared;
+    JackClientShared*    client;         /* recording client, referenced */
+    JackRbufShared**     rbufs;          /* recorded ringbuffers, referenced */
+    int                  nRbufs;
+}
+JackRecorder;
+
+static inline JackRecorder* getCheckedRecorder(lua_State* L, int stackIndex)
+{
+    JackRecorder* recorder = (JackRecorder*) checkudata(L, stackIndex, RECORDER_TYPE, RECORDER_TYPE_NAME);
+    return recorder;
+}
+
+/////////////////////////////////////////////////////////////////////////////////
+
+/* Creates the recording file and starts the writer thread. The recorder takes
+ * a reference of the ports, fifoSize is in bytes. Sets *errorMessage if NULL
+ * is returned. */
+
+#define createRecorder luajack_createRecorder
+
+JackRecorderShared* createRecorder(const char* fileName, JackPortShared** ports, int channels,
+                                   int rbufs, size_t fifoSize,
+                                   jack_nframes_t sampleRate, jack_nframes_t bufferSize,
+                                   const char** errorMessage);
+
+/* Stops the writer thread after it has written everything and closes the
+ * file, the recorder is not running anymore afterwards */
+
+#define closeRecorder luajack_closeRecorder
+
+void closeRecorder(JackRecorderShared* recorder);
+
+#define releaseRecorder luajack_releaseRecorder
+
+void releaseRecorder(JackRecorderShared* recorder);
+
+/* Called by the process callback at the beginning of each cycle */
+
+#define recordCycle luajack_recordCycle
+
+void recordCycle(JackRecorderShared* recorder, jack_nframes_t nframes);
+
+/* Records a message read by the process chunk, the optional time is written
+ * in front of the data */
+
+#define recordRbufMessage luajack_recordRbufMessage
+
+void recordRbufMessage(JackRecorderShared* recorder, int index, int32_t tag,
+                       const uint32_t* time, const char* data, uint32_t len);
+
+/////////////////////////////////////////////////////////////////////////////////
+
+typedef struct {
+    const char*          fileName;
+    const char*          outputFileName; /* optional */
+    const char*          goldenFileName; /* optional */
+    JackPortShared**     inputs;
+    int                  nInputs;
+    JackPortShared**     outputs;
+    int                  nOutputs;
+    JackRbufShared**     rbufs;
+    int                  nRbufs;
+    double               tolerance;
+}
+JackReplaySetup;
+
+typedef struct {
+    lua_Integer          cycles;
+    double               maxDiff;        /* largest output difference to golden file */
+    lua_Integer          mismatchCycle;  /* first cycle above tolerance or -1 */
+}
+JackReplayResult;
+
+/* Runs the process callback of the client synchronously once per recorded
+ * cycle with virtual input and output ports. The client must not be
+ * activated. Returns false and sets *errorMessage on failure, an error of 
+ * the process callback is left in errorInProcessContext of the client. */
+
+#define replayRecording luajack_replayRecording
+
+bool replayRecording(JackClientShared* client, const JackReplaySetup* setup,
+                     JackReplayResult* result, const char** errorMessage);
+
+/////////////////////////////////////////////////////////////////////////////////
+
+#endif // LUAJACK_RECORDER_UTIL_H
@@ -0,0 +1,350 @@
+#include <math.h>
+
+#include "util.h"
+#include "router.h"
+#include "router_util.h"
+#include "port_util.h"
+
+static const char* const TypeNames[] = { "note_off", "note_on", "poly_pressure", "cc", "program",
+                                         "pressure", "pitchbend", "system", "note", NULL };
+
+static void checkMidiPorts(lua_State* L, int arg, JackMidiRouterShared* router, bool isInput)
+{
+    luaL_checktype(L, arg, LUA_TTABLE);
+    int count = (int) luaL_len(L, arg);
+    luaL_argcheck(L, count >= 1 && count <= ROUTER_MAX_PORTS, arg, "invalid number of ports");
+    int i;
+    for (i = 0; i < count; ++i) {
+        lua_rawgeti(L, arg, i + 1);
+        JackPort* port = getOptionalPort(L, -1);
+        if (!port || !port->ptr) {
+            luaL_error(L, "invalid port at index %d of argument #%d", i + 1, arg);
+        }
+        if (strcmp(jack_port_type(port->ptr), JACK_DEFAULT_MIDI_TYPE) != 0) {
+            luaL_error(L, "port at index %d of argument #%d is not a MIDI port", i + 1, arg);
+        }
+        if (!(jack_port_flags(port->ptr) & (isInput ? JackPortIsInput : JackPortIsOutput))) {
+            luaL_error(L, "port at index %d of argument #%d is not an %s port",
+                          i + 1, arg, isInput ? "input" : "output");
+        }
+        if (router->client && port->shared->client != router->client) {
+            luaL_error(L, "port at index %d of argument #%d belongs to another client", i + 1, arg);
+        }
+        router->client = port->shared->client;
+        atomic_inc(&port->shared->refCounter);
+        if (isInput) {
+            router->inputs[router->ninputs++] = port->shared;
+        } else {
+            router->outputs[router->noutputs++] = port->shared;
+        }
+        lua_pop(L, 1);
+    }
+}
+
+/* Reads the field name of the rule table on top of the stack as a single
+ * integer or {lo, hi} range, returns false if the field is nil */
+
+static bool getRangeField(lua_State* L, int index, const char* name,
+                          lua_Integer min, lua_Integer max, lua_Integer* lo, lua_Integer* hi)
+{
+    lua_getfield(L, -1, name);
+    if (lua_isnil(L, -1)) {
+        lua_pop(L, 1);
+        return false;
+    }
+    if (lua_istable(L, -1)) {
+        lua_rawgeti(L, -1, 1);
+        lua_rawgeti(L, -2, 2);
+        *lo = lua_tointeger(L, -2);
+        *hi = lua_isnil(L, -1) ? *lo : lua_tointeger(L, -1);
+        lua_pop(L, 2);
+    } else {
+        *lo = *hi = luaL_checkinteger(L, -1);
+    }
+    if (*lo < min || *hi > max || *lo > *hi) {
+        luaL_error(L, "invalid %s in rule %d", name, index);
+    }
+    lua_pop(L, 1);
+    return true;
+}
+
+static lua_Integer getIntegerField(lua_State* L, int index, const char* name,
+                                   lua_Integer min, lua_Integer max, lua_Integer defaultValue)
+{
+    lua_Integer value = defaultValue;
+    lua_getfield(L, -1, name);
+    if (!lua_isnil(L, -1)) {
+        value = luaL_checkinteger(L, -1);
+        if (value < min || value > max) {
+            luaL_error(L, "invalid %s in rule %d", name, index);
+        }
+    }
+    lua_pop(L, 1);
+    return value;
+}
+
+/* Calls setBit for the value or for every value of the list in field name of
+ * the rule table on top of the stack */
+
+static bool getListField(lua_State* L, int index, const char* name,
+                         void (*setBit)(lua_State* L, int index, JackMidiRule* rule), JackMidiRule* rule)
+{
+    lua_getfield(L, -1, name);
+    if (lua_isnil(L, -1)) {
+        lua_pop(L, 1);
+        return false;
+    }
+    if (lua_istable(L, -1)) {
+        int n = (int) luaL_len(L, -1);
+        int i;
+        for (i = 1; i <= n; ++i) {
+            lua_rawgeti(L, -1, i);
+            setBit(L, index, rule);
+            lua_pop(L, 1);
+        }
+    } else {
+        setBit(L, index, rule);
+    }
+    lua_pop(L, 1);
+    return true;
+}
+
+static void setInputBit(lua_State* L, int index, JackMidiRule* rule)
+{
+    lua_Integer input = lua_tointeger(L, -1);
+    if (input < 1 || input > ROUTER_MAX_PORTS) {
+        luaL_error(L, "invalid input in rule %d", index);
+    }
+    rule->inputMask |= 1u << (input - 1);
+}
+
+static void setTypeBit(lua_State* L, int index, JackMidiRule* rule)
+{
+    const char* name = lua_tostring(L, -1);
+    int type;
+    for (type = 0; TypeNames[type]; ++type) {
+        if (name && strcmp(name, TypeNames[type]) == 0) {
+            rule->typeMask |= (type == 8) ? (ROUTER_NOTE_OFF | ROUTER_NOTE_ON) : (1 << type);
+            return;
+        }
+    }
+    luaL_error(L, "invalid type '%s' in rule %d", name ? name : "?", index);
+}
+
+static void setControllerBit(lua_State* L, int index, JackMidiRule* rule)
+{
+    lua_Integer cc = lua_tointeger(L, -1);
+    if (cc < 0 || cc > 127 || !lua_isnumber(L, -1)) {
+        luaL_error(L, "invalid controller in rule %d", index);
+    }
+    rule->ccMask[cc >> 5] |= 1u << (cc & 31);
+}
+
+static void getVelocityCurve(lua_State* L, int index, JackMidiRule* rule)
+{
+    lua_getfield(L, -1, "velocity");
+    if (!lua_isnil(L, -1)) {
+        int v;
+        rule->hasVelocityCurve = true;
+        rule->velocity[0]      = 0;
+        for (v = 1; v < 128; ++v) {
+            lua_Number out;
+            if (lua_istable(L, -1)) {
+                lua_rawgeti(L, -1, v);
+                out = lua_isnil(L, -1) ? v : lua_tonumber(L, -1);
+                lua_pop(L, 1);
+            } else {
+                lua_Number gamma = luaL_checknumber(L, -1);
+                if (gamma <= 0) {
+                    luaL_error(L, "invalid velocity in rule %d", index);
+                }
+                out = 127 * pow(v / 127.0, gamma);
+            }
+            out = floor(out + 0.5);
+            rule->velocity[v] = (uint8_t)(out < 1 ? 1 : (out > 127 ? 127 : out));
+        }
+    }
+    lua_pop(L, 1);
+}
+
+static void compileRule(lua_State* L, int index, JackMidiRouterShared* router, JackMidiRule* rule)
+{
+    lua_Integer lo, hi;
+
+    if (!getListField(L, index, "input", setInputBit, rule)) {
+        rule->inputMask = 0xffffffffu;
+    }
+    if (!getListField(L, index, "type", setTypeBit, rule)) {
+        rule->typeMask = ROUTER_ALL_TYPES;
+    }
+    if (getRangeField(L, index, "channel", 1, 16, &lo, &hi)) {
+        rule->channelMask = (uint16_t)(((1u << hi) - 1) & ~((1u << (lo - 1)) - 1));
+    } else {
+        rule->channelMask = 0xffff;
+    }
+    if (getRangeField(L, index, "notes", 0, 127, &lo, &hi)) {
+        rule->noteLow  = (uint8_t) lo;
+        rule->noteHigh = (uint8_t) hi;
+    } else {
+        rule->noteLow  = 0;
+        rule->noteHigh = 127;
+    }
+    if (!getListField(L, index, "controllers", setControllerBit, rule)) {
+        memset(rule->ccMask, 0xff, sizeof(rule->ccMask));
+    }
+    rule->output    = (int) getIntegerField(L, index, "output",     1, router->noutputs, 1) - 1;
+    rule->toChannel = (int) getIntegerField(L, index, "to_channel", 1, 16, 0) - 1;
+    rule->transpose = (int) getIntegerField(L, index, "transpose",  -127, 127, 0);
+    getVelocityCurve(L, index, rule);
+
+    lua_getfield(L, -1, "drop");
+    lua_getfield(L, -2, "stop");
+    rule->drop = lua_toboolean(L, -2);
+    rule->stop = lua_toboolean(L, -1);
+    lua_pop(L, 2);
+}
+
+static int router_new(lua_State* L)
+/* router = jack.midi_router(inputs, outputs, rules)
+ * creates a MIDI router from the array inputs of MIDI input ports to the
+ * array outputs of MIDI output ports of the same client. rules is an array
+ * of tables, the rules are compiled once into a compact C structure and
+ * router:process() applies them to all events of a cycle without calling
+ * Lua per event. Every event is checked against the rules in order, every
+ * matching rule writes a transformed copy of the event to its output.
+ * Events not matched by any rule are discarded. Rule fields (all optional):
+ *   input       = n|{n,...}    input port indices (default all)
+ *   type        = name|{...}   message types: "note_on", "note_off", "note",
+ *                              "poly_pressure", "cc", "program", "pressure",
+ *                              "pitchbend", "system" (default all). A note on
+ *                              with velocity 0 counts as note off.
+ *   channel     = n|{lo,hi}    channels 1-16 of channel messages
+ *   notes       = n|{lo,hi}    note range of note and poly pressure messages
+ *   controllers = n|{n,...}    controller numbers of cc messages
+ *   output      = n            output port index (default 1)
+ *   to_channel  = n            changes the channel
+ *   transpose   = n            semitones, notes out of range are discarded
+ *   velocity    = gamma|table  note on velocity curve: 127*(v/127)^gamma or
+ *                              a table mapping 1-127 to new velocities
+ *   drop        = true         discards matching events, ends the rules
+ *   stop        = true         ends the rules after this one
+ * Routers can be passed to the process context of the client.
+ */
+{
+    luaL_checktype(L, 3, LUA_TTABLE);
+    int nrules = (int) luaL_len(L, 3);
+
+    JackMidiRouter* router = (JackMidiRouter*) lua_newuserdata(L, sizeof(JackMidiRouter));
+    memset(router, 0, sizeof(JackMidiRouter));
+    luaL_setmetatable(L, MIDI_ROUTER_TYPE_NAME);
+    router->shared = createMidiRouter(nrules);
+    if (!router->shared) {
+        return luaL_error(L, "cannot create MIDI router");
+    }
+    checkMidiPorts(L, 1, router->shared, true);
+    checkMidiPorts(L, 2, router->shared, false);
+
+    int i;
+    for (i = 0; i < nrules; ++i) {
+        lua_rawgeti(L, 3, i + 1);
+        if (!lua_istable(L, -1)) {
+            return luaL_error(L, "rule %d is not a table", i + 1);
+        }
+        compileRule(L, i + 1, router->shared, &router->shared->rules[i]);
+        lua_pop(L, 1);
+    }
+    return 1;
+}
+
+static int router_release(lua_State* L)
+{
+    JackMidiRouter* router = getCheckedMidiRouter(L, 1);
+    releaseMidiRouter(router->shared);
+    router->shared = NULL;
+    return 0;
+}
+
+static int router_toString(lua_State* L)
+{
+    JackMidiRouter* router = getCheckedMidiRouter(L, 1);
+    lua_pushfstring(L, "%s: %p", MIDI_ROUTER_TYPE_NAME, router->shared);
+    return 1;
+}
+
+static JackMidiRouterShared* getCheckedMidiRouterShared(lua_State* L, int stackIndex)
+{
+    JackMidiRouter* router = getCheckedMidiRouter(L, stackIndex);
+    if (!router->shared) {
+        luaL_argerror(L, stackIndex, "released MIDI router");
+    }
+    return router->shared;
+}
+
+static int router_process(lua_State* L)
+/* router:process()
+ * routes the events of the current cycle, the output ports are cleared
+ * before. Must be called in the process callback, further calls in the same
+ * cycle have no effect.
+ */
+{
+    JackMidiRouterShared* router = getCheckedMidiRouterShared(L, 1);
+    processMidiRouter(router);
+    return 0;
+}
+
+static int router_events(lua_State* L)
+/* n = router:events()
+ * returns the number of input events processed so far.
+ */
+{
+    JackMidiRouterShared* router = getCheckedMidiRouterShared(L, 1);
+    lua_pushinteger(L, (lua_Integer) router->events);
+    return 1;
+}
+
+static int router_dropped(lua_State* L)
+/* n = router:dropped()
+ * returns the number of events lost so far because an output buffer was full.
+ */
+{
+    JackMidiRouterShared* router = getCheckedMidiRouterShared(L, 1);
+    lua_pushinteger(L, (lua_Integer) router->dropped);
+    return 1;
+}
+
+static const struct luaL_Reg RouterMetaMethods[] =
+{
+    { "__tostring", router_toString },
+    { "__gc",       router_release },
+    { NULL, NULL } /* sentinel */
+};
+
+static const struct luaL_Reg RouterMethods[] =
+{
+    { "process",    router_process },
+    { "events",     router_events },
+    { "dropped",    router_dropped },
+    { NULL, NULL } /* sentinel */
+};
+
+static const struct luaL_Reg ModuleFunctions[] =
+{
+    { "midi_router", router_new },
+    { NULL, NULL } /* sentinel */
+};
+
+bool luajack_open_router(lua_State* L, int module, int routerMeta, int routerClass)
+{
+    lua_pushvalue(L, module);
+        setfuncs(L, ModuleFunctions);
+
+        lua_pushvalue(L, routerMeta);
+            setfuncs(L, RouterMetaMethods);
+
+            lua_pushvalue(L, routerClass);
+                setfuncs(L, RouterMethods);
+
+    lua_pop(L, 3);
+
+    return true;
+}
@@ -0,0 +1,6 @@
+#ifndef LUAJACK_ROUTER_H
+#define LUAJACK_ROUTER_H
+
+bool luajack_open_router(lua_State* L, int module, int routerMeta, int routerClass);
+
+#endif // LUAJACK_ROUTER_H
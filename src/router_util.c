@@ -0,0 +1,190 @@
+#include <jack/midiport.h>
+
+#include "util.h"
+#include "router_util.h"
+#include "port_util.h"
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+JackMidiRouterShared* createMidiRouter(int nrules)
+{
+    JackMidiRouterShared* router = (JackMidiRouterShared*) calloc(1, sizeof(JackMidiRouterShared));
+    if (!router) {
+        return NULL;
+    }
+    router->rules = (JackMidiRule*) calloc(nrules > 0 ? nrules : 1, sizeof(JackMidiRule));
+    if (!router->rules) {
+        free(router);
+        return NULL;
+    }
+    router->refCounter = 1;
+    router->nrules     = nrules;
+    return router;
+}
+
+void releaseMidiRouter(JackMidiRouterShared* router)
+{
+    if (router && atomic_dec(&router->refCounter) == 0) {
+        int i;
+        for (i = 0; i < router->ninputs; ++i) {
+            releasePort(router->inputs[i]);
+        }
+        for (i = 0; i < router->noutputs; ++i) {
+            releasePort(router->outputs[i]);
+        }
+        free(router->rules);
+        free(router);
+    }
+}
+
+void transferMidiRouter(lua_State* T, JackMidiRouterShared* sharedRouter)
+{
+    JackMidiRouter* router = (JackMidiRouter*) lua_newuserdata(T, sizeof(JackMidiRouter));
+    memset(router, 0, sizeof(JackMidiRouter));
+    luaL_setmetatable(T, MIDI_ROUTER_TYPE_NAME);
+    router->shared = sharedRouter;
+    atomic_inc(&sharedRouter->refCounter);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+static inline bool matchRule(const JackMidiRule* rule, int input, const jack_midi_event_t* event)
+{
+    const jack_midi_data_t* data   = event->buffer;
+    int                     status = data[0];
+    int                     type   = (status >> 4) - 8;
+
+    /* note on with velocity 0 is a note off */
+    if (type == 1 && event->size >= 3 && data[2] == 0) {
+        type = 0;
+    }
+    if (!(rule->inputMask & (1u << input)) || !(rule->typeMask & (1 << type))) {
+        return false;
+    }
+    if (status < 0xF0) {
+        if (!(rule->channelMask & (1 << (status & 0x0F)))) {
+            return false;
+        }
+        if (type <= 2 && event->size >= 2) {
+            if (data[1] < rule->noteLow || data[1] > rule->noteHigh) {
+                return false;
+            }
+        }
+        else if (type == 3 && event->size >= 2) {
+            if (!(rule->ccMask[data[1] >> 5] & (1u << (data[1] & 31)))) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/* Writes the transformed event, returns false if the output buffer is full */
+
+static inline bool writeEvent(const JackMidiRule* rule, void* out, const jack_midi_event_t* event)
+{
+    const jack_midi_data_t* data   = event->buffer;
+    int                     status = data[0];
+    int                     note   = -1;
+
+    if (status < 0xB0 && event->size >= 2) {
+        note = data[1] + rule->transpose;
+        if (note < 0 || note > 127) {
+            return true; /* transposed out of range: nothing to play */
+        }
+    }
+    jack_midi_data_t* p = jack_midi_event_reserve(out, event->time, event->size);
+    if (!p) {
+        return false;
+    }
+    memcpy(p, data, event->size);
+    if (status < 0xF0) {
+        if (rule->toChannel >= 0) {
+            p[0] = (jack_midi_data_t)((status & 0xF0) | rule->toChannel);
+        }
+        if (note >= 0) {
+            p[1] = (jack_midi_data_t) note;
+        }
+        if ((status & 0xF0) == 0x90 && event->size >= 3 && data[2] > 0 && rule->hasVelocityCurve) {
+            p[2] = rule->velocity[data[2]];
+        }
+    }
+    return true;
+}
+
+void processMidiRouter(JackMidiRouterShared* router)
+{
+    JackClientShared* client = router->client;
+    if (!client || client->currentProcessNframes == 0 || router->lastCycle == client->processCycle + 1) {
+        return;
+    }
+    router->lastCycle = client->processCycle + 1;
+
+    jack_nframes_t     nframes = client->currentCycleNframes;
+    void*              in[ROUTER_MAX_PORTS];
+    void*              out[ROUTER_MAX_PORTS];
+    uint32_t           count[ROUTER_MAX_PORTS];
+    uint32_t           pos[ROUTER_MAX_PORTS];
+    jack_midi_event_t  next[ROUTER_MAX_PORTS];
+    int i;
+
+    for (i = 0; i < router->noutputs; ++i) {
+        out[i] = router->outputs[i]->ptr ? jack_port_get_buffer(router->outputs[i]->ptr, nframes) : NULL;
+        if (out[i]) {
+            jack_midi_clear_buffer(out[i]);
+        }
+    }
+    for (i = 0; i < router->ninputs; ++i) {
+        in[i]    = router->inputs[i]->ptr ? jack_port_get_buffer(router->inputs[i]->ptr, nframes) : NULL;
+        count[i] = in[i] ? jack_midi_get_event_count(in[i]) : 0;
+        pos[i]   = 0;
+        if (count[i] > 0 && jack_midi_event_get(&next[i], in[i], 0) != 0) {
+            count[i] = 0;
+        }
+    }
+
+    unsigned long events  = 0;
+    unsigned long dropped = 0;
+    while (true)
+    {
+        /* k-way merge by time, equal times in input order */
+        int input = -1;
+        for (i = 0; i < router->ninputs; ++i) {
+            if (pos[i] < count[i] && (input < 0 || next[i].time < next[input].time)) {
+                input = i;
+            }
+        }
+        if (input < 0) {
+            break;
+        }
+        jack_midi_event_t event = next[input];
+        if (++pos[input] < count[input] && jack_midi_event_get(&next[input], in[input], pos[input]) != 0) {
+            count[input] = pos[input];
+        }
+        if (event.size == 0 || event.buffer[0] < 0x80) {
+            continue;
+        }
+        ++events;
+
+        const JackMidiRule* rule = router->rules;
+        const JackMidiRule* end  = rule + router->nrules;
+        for (; rule < end; ++rule) {
+            if (!matchRule(rule, input, &event)) {
+                continue;
+            }
+            if (rule->drop) {
+                break;
+            }
+            if (out[rule->output] && !writeEvent(rule, out[rule->output], &event)) {
+                ++dropped;
+            }
+            if (rule->stop) {
+                break;
+            }
+        }
+    }
+    router->events  += events;
+    router->dropped += dropped;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
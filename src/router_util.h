@@ -0,0 +1,103 @@
+#ifndef LUAJACK_ROUTER_UTIL_H
+#define LUAJACK_ROUTER_UTIL_H
+
+#include "util.h"
+
+/////////////////////////////////////////////////////////////////////////////////
+
+#define ROUTER_MAX_PORTS 32
+
+/* Message type bits of a rule, index is the status nibble - 8 */
+
+#define ROUTER_NOTE_OFF       0x01
+#define ROUTER_NOTE_ON        0x02
+#define ROUTER_POLY_PRESSURE  0x04
+#define ROUTER_CC             0x08
+#define ROUTER_PROGRAM        0x10
+#define ROUTER_PRESSURE       0x20
+#define ROUTER_PITCHBEND      0x40
+#define ROUTER_SYSTEM         0x80
+#define ROUTER_ALL_TYPES      0xff
+
+/* A compiled rule: an event matches if all masks match, a matching event is
+ * written transformed to the output unless the rule drops it. */
+
+typedef struct {
+    uint32_t  inputMask;          /* bit per input port */
+    uint16_t  channelMask;        /* bit per channel, channel messages only */
+    uint8_t   typeMask;
+    uint8_t   noteLow;            /* note range, note and poly pressure only */
+    uint8_t   noteHigh;
+    uint32_t  ccMask[4];          /* bit per controller, cc only */
+    int       output;             /* 0-based output port index */
+    int       toChannel;          /* 0-based or -1 */
+    int       transpose;
+    bool      drop;
+    bool      stop;
+    bool      hasVelocityCurve;
+    uint8_t   velocity[128];      /* note on velocity curve */
+}
+JackMidiRule;
+
+typedef struct {
+    AtomicCounter     refCounter;
+    JackClientShared* client;
+    int               ninputs;
+    int               noutputs;
+    JackPortShared*   inputs[ROUTER_MAX_PORTS];
+    JackPortShared*   outputs[ROUTER_MAX_PORTS];
+    int               nrules;
+    JackMidiRule*     rules;
+    unsigned long     lastCycle;      /* processCycle of the last run + 1 */
+
+    /* only written by the process context */
+    volatile unsigned long events;
+    volatile unsigned long dropped;   /* lost because an output was full */
+}
+JackMidiRouterShared;
+
+typedef struct {
+    JackMidiRouterShared* shared;
+}
+JackMidiRouter;
+
+static inline JackMidiRouter* getCheckedMidiRouter(lua_State* L, int stackIndex)
+{
+    JackMidiRouter* router = (JackMidiRouter*) checkudata(L, stackIndex, MIDI_ROUTER_TYPE, MIDI_ROUTER_TYPE_NAME);
+    return router;
+}
+
+static inline JackMidiRouter* getOptionalMidiRouter(lua_State* L, int stackIndex)
+{
+    JackMidiRouter* router = (JackMidiRouter*) testudata(L, stackIndex, MIDI_ROUTER_TYPE, MIDI_ROUTER_TYPE_NAME);
+    return router;
+}
+
+/////////////////////////////////////////////////////////////////////////////////
+
+/* Creates a router with room for nrules rules, the ports and rules are
+ * filled in by the caller */
+
+#define createMidiRouter luajack_createMidiRouter
+
+JackMidiRouterShared* createMidiRouter(int nrules);
+
+#define releaseMidiRouter luajack_releaseMidiRouter
+
+void releaseMidiRouter(JackMidiRouterShared* router);
+
+#define transferMidiRouter luajack_transferMidiRouter
+
+void transferMidiRouter(lua_State* T, JackMidiRouterShared* router);
+
+/* Merges the events of all inputs of the current cycle in time order, applies
+ * the rules and writes the results to the cleared output buffers. Runs only
+ * once per process cycle. */
+
+#define processMidiRouter luajack_processMidiRouter
+
+void processMidiRouter(JackMidiRouterShared* router);
+
+/////////////////////////////////////////////////////////////////////////////////
+
+#endif // LUAJACK_ROUTER_UTIL_H
@@ -0,0 +1,211 @@
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+    #define _GNU_SOURCE
+#endif
+
+#include <stdlib.h>
+
+#if !defined(_WIN32)
+    #include <alloca.h>
+    #include <sys/mman.h>
+    #include <pthread.h>
+#else
+    #include <malloc.h>
+#endif
+
+#if defined(__SSE__) || defined(_M_X64) || defined(_M_IX86_FP)
+    #include <xmmintrin.h>
+    #define LUAJACK_RT_USE_SSE
+#endif
+
+#if defined(__linux__)
+    #include <sched.h>
+#endif
+
+#include "util.h"
+#include "rt_util.h"
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+bool getRtOptions(lua_State* L, int optIndex, JackRtOptions* options)
+{
+    memset(options, 0, sizeof(JackRtOptions));
+    
+    if (!lua_istable(L, optIndex)) {
+        return false;
+    }
+    lua_getfield(L, optIndex, "flush_denormals");
+    options->flushDenormals = lua_toboolean(L, -1);
+    lua_pop(L, 1);
+
+    lua_getfield(L, optIndex, "stack_prefault");
+    if (!lua_isnil(L, -1)) {
+        lua_Integer n = luaL_checkinteger(L, -1);
+        luaL_argcheck(L, n >= 0 && n <= RT_MAX_STACK_PREFAULT, optIndex, "stack_prefault out of range");
+        options->stackPrefault = (size_t) n;
+    }
+    lua_pop(L, 1);
+
+    lua_getfield(L, optIndex, "lua_stack_prefault");
+    if (!lua_isnil(L, -1)) {
+        lua_Integer n = luaL_checkinteger(L, -1);
+        luaL_argcheck(L, n >= 0 && n <= 100000, optIndex, "lua_stack_prefault out of range");
+        options->luaStackPrefault = (int) n;
+    }
+    lua_pop(L, 1);
+
+    lua_getfield(L, optIndex, "mlockall");
+    options->lockMemory = lua_toboolean(L, -1);
+    lua_pop(L, 1);
+
+    lua_getfield(L, optIndex, "cpus");
+    if (lua_istable(L, -1)) {
+        int i;
+        for (i = 1; ; ++i) {
+            lua_geti(L, -1, i);
+            if (lua_isnil(L, -1)) {
+                lua_pop(L, 1);
+                break;
+            }
+            lua_Integer cpu = luaL_checkinteger(L, -1);
+            luaL_argcheck(L, cpu >= 0 && cpu < 1024, optIndex, "invalid cpu number");
+            luaL_argcheck(L, options->nCpus < RT_MAX_CPUS, optIndex, "too many cpus");
+            options->cpus[options->nCpus++] = (int) cpu;
+            lua_pop(L, 1);
+        }
+    }
+    else if (!lua_isnil(L, -1)) {
+        luaL_argerror(L, optIndex, "cpus must be a list of cpu numbers");
+    }
+    lua_pop(L, 1);
+
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+bool enableFlushToZero(void)
+{
+#if defined(LUAJACK_RT_USE_SSE)
+    /* FTZ (bit 15) and DAZ (bit 6) */
+    _mm_setcsr(_mm_getcsr() | 0x8040);
+    return true;
+#elif defined(__aarch64__)
+    uint64_t fpcr;
+    __asm__ __volatile__("mrs %0, fpcr" : "=r"(fpcr));
+    fpcr |= (1 << 24); /* FZ */
+    __asm__ __volatile__("msr fpcr, %0" : : "r"(fpcr));
+    return true;
+#elif defined(__arm__) && defined(__ARM_PCS_VFP)
+    uint32_t fpscr;
+    __asm__ __volatile__("vmrs %0, fpscr" : "=r"(fpscr));
+    fpscr |= (1 << 24); /* FZ */
+    __asm__ __volatile__("vmsr fpscr, %0" : : "r"(fpscr));
+    return true;
+#else
+    return false;
+#endif
+}
+
+/* Returns the number of bytes of the calling thread's stack below the frame
+ * of the caller, or 0 if unknown */
+static size_t getFreeStackSize(void)
+{
+#if defined(__linux__)
+    pthread_attr_t attr;
+    void*          addr;
+    size_t         size;
+    char           here;
+    if (pthread_getattr_np(pthread_self(), &attr) != 0) {
+        return 0;
+    }
+    int rc = pthread_attr_getstack(&attr, &addr, &size);
+    pthread_attr_destroy(&attr);
+    if (rc != 0 || &here <= (char*) addr || &here > (char*) addr + size) {
+        return 0;
+    }
+    return (size_t)(&here - (char*) addr);
+#else
+    return 0;
+#endif
+}
+
+/* Touches size bytes of the stack, at most the free stack size minus a
+ * safety margin. Returns the number of bytes touched. */
+static size_t prefaultStack(size_t size)
+{
+    size_t available = getFreeStackSize();
+    if (available > 0) {
+        available = (available > RT_STACK_SAFETY_MARGIN) ? available - RT_STACK_SAFETY_MARGIN : 0;
+        if (size > available) {
+            size = available;
+        }
+    }
+    if (size > 0) {
+        volatile char* stack = (volatile char*) alloca(size);
+        size_t i;
+        for (i = 0; i < size; i += 1024) {
+            stack[i] = 0;
+        }
+    }
+    return size;
+}
+
+static bool setAffinity(JackRtOptions* options)
+{
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    int i;
+    for (i = 0; i < options->nCpus; ++i) {
+        CPU_SET(options->cpus[i], &set);
+    }
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    return false;
+#endif
+}
+
+static void threadInitCallback(void* arg)
+{
+    JackRtOptions* options = ((JackClientShared*) arg)->rtOptions;
+    if (!options) {
+        return;
+    }
+    if (options->flushDenormals) {
+        options->denormalsFlushed = enableFlushToZero();
+    }
+    if (options->stackPrefault > 0) {
+        options->stackPrefaulted = (prefaultStack(options->stackPrefault) > 0);
+    }
+    if (options->nCpus > 0) {
+        options->affinitySet = setAffinity(options);
+    }
+}
+
+void applyRtOptions(JackClientShared* client, JackRtOptions* options)
+{
+    if (!client->rtOptions) {
+        client->rtOptions = (JackRtOptions*) malloc(sizeof(JackRtOptions));
+        if (!client->rtOptions) {
+            return;
+        }
+        jack_set_thread_init_callback(client->ptr, threadInitCallback, client);
+    }
+    *client->rtOptions = *options;
+    options = client->rtOptions;
+
+    if (options->lockMemory) {
+#if !defined(_WIN32)
+        options->memoryLocked = (mlockall(MCL_CURRENT | MCL_FUTURE) == 0);
+#endif
+        if (!options->memoryLocked) {
+            verbosePrintf("mlockall failed\n");
+        }
+    }
+    if (options->luaStackPrefault > 0 && client->processContext) {
+        options->luaStackPrefaulted = lua_checkstack(client->processContext, 
+                                                     options->luaStackPrefault);
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
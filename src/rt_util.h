@@ -0,0 +1,61 @@
+#ifndef LUAJACK_RT_UTIL_H
+#define LUAJACK_RT_UTIL_H
+
+#include "util.h"
+
+/////////////////////////////////////////////////////////////////////////////////
+
+#define RT_MAX_CPUS 64
+
+/* JACK2 creates its realtime threads with a small stack of its own (not the
+ * default thread stack size), the stack prefault must fit into it */
+#define RT_MAX_STACK_PREFAULT  (128 * 1024)
+
+/* Stack left untouched below the prefaulted part for the process callback */
+#define RT_STACK_SAFETY_MARGIN (64 * 1024)
+
+/* Options for the process thread, given to client:activate() */
+typedef struct JackRtOptions {
+    bool          flushDenormals;   /* FTZ/DAZ on the process thread */
+    size_t        stackPrefault;    /* bytes of process thread stack to touch */
+    int           luaStackPrefault; /* slots to preallocate on the process context's stack */
+    bool          lockMemory;       /* mlockall(MCL_CURRENT | MCL_FUTURE) */
+    int           nCpus;
+    int           cpus[RT_MAX_CPUS];
+
+    /* results, set by the thread init callback */
+    volatile bool denormalsFlushed;
+    volatile bool stackPrefaulted;
+    volatile bool affinitySet;
+    bool          memoryLocked;
+    bool          luaStackPrefaulted;
+}
+JackRtOptions;
+
+/////////////////////////////////////////////////////////////////////////////////
+
+/* Reads the rt options from the table at optIndex, returns false if there is
+ * no options table. Raises Lua errors for invalid options. */
+
+#define getRtOptions luajack_getRtOptions 
+
+bool getRtOptions(lua_State* L, int optIndex, JackRtOptions* options);
+
+/* Applies the options that are not bound to the process thread and sets the 
+ * JACK thread init callback that applies the others. Must be called before 
+ * the client is activated. */
+
+#define applyRtOptions luajack_applyRtOptions 
+
+void applyRtOptions(JackClientShared* client, JackRtOptions* options);
+
+/* Sets flush to zero and denormals are zero for the calling thread, returns
+ * false if not supported on this platform */
+
+#define enableFlushToZero luajack_enableFlushToZero 
+
+bool enableFlushToZero(void);
+
+/////////////////////////////////////////////////////////////////////////////////
+
+#endif // LUAJACK_RT_UTIL_H
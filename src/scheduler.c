@@ -0,0 +1,369 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stddef.h>
+
+#include "util.h"
+#include "scheduler.h"
+#include "scheduler_util.h"
+#include "client_util.h"
+#include "rbuf_util.h"
+
+static int scheduler_toString(lua_State* L)
+{
+    JackScheduler* scheduler = getCheckedScheduler(L, 1);
+    lua_pushfstring(L, "%s: %p", SCHEDULER_TYPE_NAME, 
+                                 scheduler);
+    return 1;
+}
+
+static int scheduler_new(lua_State* L)
+/* scheduler = jack.scheduler(client, capacity [, max_data_size])
+ * creates a priority queue for up to 'capacity' timed events with up to 
+ * 'max_data_size' (default 64) bytes of data each. Should be created while the
+ * process chunk is loaded, all memory is preallocated.
+ */
+{
+    JackClient* client   = getCheckedClient(L, 1);
+    lua_Integer capacity = luaL_checkinteger(L, 2);
+    lua_Integer dataSize = luaL_optinteger(L, 3, 64);
+    
+    luaL_argcheck(L, capacity > 0, 2, "capacity must be positive");
+    luaL_argcheck(L, dataSize >= 0, 3, "invalid data size");
+    
+    JackScheduler* scheduler = (JackScheduler*) lua_newuserdata(L, sizeof(JackScheduler));
+    memset(scheduler, 0, sizeof(JackScheduler));
+    luaL_setmetatable(L, SCHEDULER_TYPE_NAME);
+
+    bool ok = initScheduler(scheduler, client->shared, (uint32_t)capacity, (uint32_t)dataSize);
+    scheduler->eventDataRef = LUA_NOREF;
+    if (!ok) {
+        return luaL_error(L, "cannot create scheduler");
+    }
+    atomic_inc(&client->shared->refCounter);
+
+    scheduler->eventData = (JackEventData*) lua_newuserdata(L, offsetof(JackEventData, bytes) + (size_t)dataSize + 1);
+    scheduler->eventData->len = 0;
+    luaL_setmetatable(L, EVENT_DATA_TYPE_NAME);
+    scheduler->eventDataRef = luaL_ref(L, LUA_REGISTRYINDEX);
+    return 1;
+}
+
+static int scheduler_release(lua_State* L)
+{
+    JackScheduler* scheduler = getCheckedScheduler(L, 1);
+    releaseScheduler(scheduler);
+    luaL_unref(L, LUA_REGISTRYINDEX, scheduler->eventDataRef);
+    scheduler->eventDataRef = LUA_NOREF;
+    scheduler->eventData    = NULL;
+    if (scheduler->client) {
+        releaseClientShared(scheduler->client);
+        scheduler->client = NULL;
+    }
+    return 0;
+}
+
+static int scheduler_schedule(lua_State* L)
+/* bool = scheduler:schedule(time, tag [, data])
+ * returns false if the queue is full.
+ */
+{
+    JackScheduler* scheduler = getCheckedScheduler(L, 1);
+    jack_nframes_t time = (jack_nframes_t) luaL_checkinteger(L, 2);
+    int32_t        tag  = (int32_t) luaL_checkinteger(L, 3);
+    size_t         len  = 0;
+    const char*    data = luaL_optlstring(L, 4, NULL, &len);
+    
+    if (len > scheduler->maxDataSize) {
+        return luaL_argerror(L, 4, "data exceeds maximum data size of scheduler");
+    }
+    uint32_t slot;
+    char* slotData = reserveSchedulerSlot(scheduler, &slot);
+    if (!slotData) {
+        lua_pushboolean(L, false);
+        return 1;
+    }
+    if (len > 0) {
+        memcpy(slotData, data, len);
+    }
+    pushSchedulerEvent(scheduler, time, tag, slot, len);
+    lua_pushboolean(L, true);
+    return 1;
+}
+
+static int scheduler_receive(lua_State* L)
+/* n = scheduler:receive(rbuf)
+ * moves all timed messages (see rbuf:write_at()) from the ringbuffer into
+ * the queue until the queue is full. Returns the number of received messages.
+ */
+{
+    JackScheduler* scheduler = getCheckedScheduler(L, 1);
+    JackRbuf*      rbuf      = getCheckedRbuf(L, 2);
+    int            n         = 0;
+    
+    while (true) {
+        uint32_t slot;
+        char* slotData = reserveSchedulerSlot(scheduler, &slot);
+        if (!slotData) {
+            break;
+        }
+        jack_nframes_t time;
+        int32_t        tag;
+        uint32_t       len = scheduler->maxDataSize;
+        int rc = readTimedRbufMessage(rbuf->ptr, &time, &tag, slotData, &len);
+        if (rc == RBUF_MESSAGE_OK) {
+            pushSchedulerEvent(scheduler, time, tag, slot, len);
+            ++n;
+        } else {
+            releaseSchedulerSlot(scheduler, slot);
+            if (rc == RBUF_MESSAGE_TOO_LARGE) {
+                scheduler->dropped += 1;
+            } else {
+                break;
+            }
+        }
+    }
+    lua_pushinteger(L, n);
+    return 1;
+}
+
+/* The handler is called in protected mode, so that the sub-block is reset to
+ * the whole cycle before an error is propagated */
+static void callHandler(lua_State* L, JackClientShared* client, int nargs,
+                        jack_nframes_t offset, jack_nframes_t nframes)
+{
+    lua_pushvalue(L, 2);
+    lua_insert(L, -(nargs + 1));
+    client->currentProcessOffset  = offset;
+    client->currentProcessNframes = nframes;
+    if (lua_pcall(L, nargs, 0, 0) != LUA_OK) {
+        client->currentProcessOffset  = 0;
+        client->currentProcessNframes = client->currentCycleNframes;
+        lua_error(L);
+    }
+}
+
+static int scheduler_process(lua_State* L)
+/* scheduler:process(handler)
+ * splits the current process cycle into sub-blocks at the frame times of 
+ * the due events and invokes handler(offset, nframes [, tag, data]) for each 
+ * sub-block. A sub-block starting with an event gets the event's tag and data.
+ * data is an event data object of the scheduler that is reused for every
+ * event, it is only valid during the handler call (see data:len(),
+ * data:byte() and data:string()).
+ * Several events with the same frame time are delivered with nframes = 0 except
+ * for the last one. Events with frame times before the current cycle are 
+ * delivered at offset 0. During the handler, port buffer operations only affect 
+ * the sub-block.
+ */
+{
+    JackScheduler*    scheduler = getCheckedScheduler(L, 1);
+    JackClientShared* client    = scheduler->client;
+    luaL_checktype(L, 2, LUA_TFUNCTION);
+    lua_settop(L, 2);
+    
+    jack_nframes_t cycleNframes = client ? client->currentCycleNframes : 0;
+    if (cycleNframes == 0) {
+        return luaL_error(L, "method can only be called from process callback");
+    }
+    if (client->currentProcessOffset != 0 || client->currentProcessNframes != cycleNframes) {
+        return luaL_error(L, "scheduler cannot be nested");
+    }
+    jack_nframes_t cycleStart = jack_last_frame_time(client->ptr);
+    jack_nframes_t pos        = 0;
+    
+    while (scheduler->count > 0) {
+        int32_t due = (int32_t)(scheduler->heap[0].time - cycleStart);
+        if (due >= (int32_t)cycleNframes) {
+            break;
+        }
+        if (due > (int32_t)pos) {
+            lua_pushinteger(L, pos);
+            lua_pushinteger(L, due - pos);
+            callHandler(L, client, 2, pos, due - pos);
+            pos = due;
+        }
+        JackSchedulerEvent event;
+        popSchedulerEvent(scheduler, &event);
+
+        jack_nframes_t end = cycleNframes;
+        if (scheduler->count > 0) {
+            int32_t next = (int32_t)(scheduler->heap[0].time - cycleStart);
+            if (next < (int32_t)cycleNframes) {
+                end = (next > (int32_t)pos) ? (jack_nframes_t)next : pos;
+            }
+        }
+        lua_pushinteger(L, pos);
+        lua_pushinteger(L, end - pos);
+        lua_pushinteger(L, event.tag);
+        memcpy(scheduler->eventData->bytes, getSchedulerEventData(scheduler, &event), event.len);
+        scheduler->eventData->len = event.len;
+        lua_rawgeti(L, LUA_REGISTRYINDEX, scheduler->eventDataRef);
+        releaseSchedulerSlot(scheduler, event.slot);
+        callHandler(L, client, 4, pos, end - pos);
+        pos = end;
+    }
+    if (pos < cycleNframes) {
+        lua_pushinteger(L, pos);
+        lua_pushinteger(L, cycleNframes - pos);
+        callHandler(L, client, 2, pos, cycleNframes - pos);
+    }
+    client->currentProcessOffset  = 0;
+    client->currentProcessNframes = cycleNframes;
+    return 0;
+}
+
+static int scheduler_pending(lua_State* L)
+{
+    JackScheduler* scheduler = getCheckedScheduler(L, 1);
+    lua_pushinteger(L, scheduler->count);
+    return 1;
+}
+
+static int scheduler_dropped(lua_State* L)
+{
+    JackScheduler* scheduler = getCheckedScheduler(L, 1);
+    lua_pushinteger(L, scheduler->dropped);
+    return 1;
+}
+
+static int scheduler_clear(lua_State* L)
+{
+    JackScheduler* scheduler = getCheckedScheduler(L, 1);
+    clearScheduler(scheduler);
+    return 0;
+}
+
+static int event_data_len(lua_State* L)
+/* n = data:len()
+ * returns the number of bytes of the event data, also #data.
+ */
+{
+    JackEventData* data = getCheckedEventData(L, 1);
+    lua_pushinteger(L, data->len);
+    return 1;
+}
+
+/* Converts the optional byte range at arg, arg + 1 like string.sub() does,
+ * returns false for an empty range */
+static bool getByteRange(lua_State* L, int arg, JackEventData* data, lua_Integer defaultEnd,
+                         lua_Integer* first, lua_Integer* last)
+{
+    lua_Integer len = data->len;
+    lua_Integer i   = luaL_optinteger(L, arg, 1);
+    lua_Integer j   = luaL_optinteger(L, arg + 1, defaultEnd);
+    if (i < 0) i = (-i > len) ? 1 : len + i + 1;
+    if (j < 0) j = len + j + 1;
+    if (i < 1) i = 1;
+    if (j > len) j = len;
+    *first = i;
+    *last  = j;
+    return i <= j;
+}
+
+static int event_data_byte(lua_State* L)
+/* b1, ... = data:byte([i [, j]])
+ * returns the bytes of the event data like string.byte().
+ */
+{
+    JackEventData* data = getCheckedEventData(L, 1);
+    lua_Integer i, j;
+    if (!getByteRange(L, 2, data, luaL_optinteger(L, 2, 1), &i, &j)) {
+        return 0;
+    }
+    int n = (int)(j - i + 1);
+    luaL_checkstack(L, n, "event data slice too long");
+    lua_Integer k;
+    for (k = i; k <= j; ++k) {
+        lua_pushinteger(L, (unsigned char) data->bytes[k - 1]);
+    }
+    return n;
+}
+
+static int event_data_string(lua_State* L)
+/* s = data:string([i [, j]])
+ * returns the event data or a part of it like string.sub() as a string. 
+ * Creates a new string, i.e. allocates in the process context.
+ */
+{
+    JackEventData* data = getCheckedEventData(L, 1);
+    lua_Integer i, j;
+    if (!getByteRange(L, 2, data, -1, &i, &j)) {
+        lua_pushliteral(L, "");
+    } else {
+        lua_pushlstring(L, data->bytes + i - 1, (size_t)(j - i + 1));
+    }
+    return 1;
+}
+
+static int event_data_toString(lua_State* L)
+{
+    JackEventData* data = getCheckedEventData(L, 1);
+    lua_pushfstring(L, "%s: %p", EVENT_DATA_TYPE_NAME, data);
+    return 1;
+}
+
+static const struct luaL_Reg EventDataMetaMethods[] = 
+{
+    { "__tostring", event_data_toString },
+    { "__len",      event_data_len },
+    { NULL, NULL } /* sentinel */
+};
+
+static const struct luaL_Reg EventDataMethods[] = 
+{
+    { "len",        event_data_len },
+    { "byte",       event_data_byte },
+    { "string",     event_data_string },
+    { NULL, NULL } /* sentinel */
+};
+
+static const struct luaL_Reg SchedulerMetaMethods[] = 
+{
+    { "__tostring", scheduler_toString },
+    { "__gc",       scheduler_release },
+    { NULL, NULL } /* sentinel */
+};
+
+static const struct luaL_Reg SchedulerMethods[] = 
+{
+    { "schedule",   scheduler_schedule },
+    { "receive",    scheduler_receive },
+    { "process",    scheduler_process },
+    { "pending",    scheduler_pending },
+    { "dropped",    scheduler_dropped },
+    { "clear",      scheduler_clear },
+    { NULL, NULL } /* sentinel */
+};
+
+static const struct luaL_Reg ModuleFunctions[] = 
+{
+    { "scheduler",  scheduler_new },
+    { NULL, NULL } /* sentinel */
+};
+
+bool luajack_open_scheduler(lua_State* L, int module, int clientMeta, int clientClass,
+                                                       int schedulerMeta, int schedulerClass,
+                                                       int eventDataMeta, int eventDataClass)
+{
+    lua_pushvalue(L, module);
+        setfuncs(L, ModuleFunctions);
+
+        lua_pushvalue(L, schedulerMeta);
+            setfuncs(L, SchedulerMetaMethods);
+    
+            lua_pushvalue(L, schedulerClass);
+                setfuncs(L, SchedulerMethods);
+    
+    lua_pop(L, 3);
+
+    lua_pushvalue(L, eventDataMeta);
+        setfuncs(L, EventDataMetaMethods);
+
+        lua_pushvalue(L, eventDataClass);
+            setfuncs(L, EventDataMethods);
+
+    lua_pop(L, 2);
+    
+    return true;
+}
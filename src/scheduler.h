@@ -0,0 +1,8 @@
+#ifndef LUAJACK_SCHEDULER_H
+#define LUAJACK_SCHEDULER_H
+
+bool luajack_open_scheduler(lua_State* L, int module, int clientMeta, int clientClass,
+                                                       int schedulerMeta, int schedulerClass,
+                                                       int eventDataMeta, int eventDataClass);
+
+#endif // LUAJACK_SCHEDULER_H
@@ -0,0 +1,128 @@
+#include <stdlib.h>
+
+#include "util.h"
+#include "scheduler_util.h"
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+bool initScheduler(JackScheduler* scheduler, JackClientShared* client, 
+                   uint32_t capacity, uint32_t maxDataSize)
+{
+    memset(scheduler, 0, sizeof(JackScheduler));
+    
+    scheduler->heap      = (JackSchedulerEvent*) malloc(sizeof(JackSchedulerEvent) * capacity);
+    scheduler->freeSlots = (uint32_t*) malloc(sizeof(uint32_t) * capacity);
+    scheduler->data      = (char*) malloc((size_t)capacity * maxDataSize + 1);
+    
+    if (!scheduler->heap || !scheduler->freeSlots || !scheduler->data) {
+        releaseScheduler(scheduler);
+        return false;
+    }
+    scheduler->capacity    = capacity;
+    scheduler->maxDataSize = maxDataSize;
+    scheduler->client      = client;
+    clearScheduler(scheduler);
+    return true;
+}
+
+void releaseScheduler(JackScheduler* scheduler)
+{
+    if (scheduler->heap)      free(scheduler->heap);
+    if (scheduler->freeSlots) free(scheduler->freeSlots);
+    if (scheduler->data)      free(scheduler->data);
+    scheduler->heap      = NULL;
+    scheduler->freeSlots = NULL;
+    scheduler->data      = NULL;
+    scheduler->capacity  = 0;
+    scheduler->count     = 0;
+    scheduler->freeCount = 0;
+}
+
+void clearScheduler(JackScheduler* scheduler)
+{
+    uint32_t i;
+    scheduler->count     = 0;
+    scheduler->freeCount = scheduler->capacity;
+    for (i = 0; i < scheduler->capacity; ++i) {
+        scheduler->freeSlots[i] = scheduler->capacity - 1 - i;
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+char* reserveSchedulerSlot(JackScheduler* scheduler, uint32_t* slot)
+{
+    if (scheduler->freeCount == 0) {
+        return NULL;
+    }
+    *slot = scheduler->freeSlots[--scheduler->freeCount];
+    return scheduler->data + (size_t)*slot * scheduler->maxDataSize;
+}
+
+void releaseSchedulerSlot(JackScheduler* scheduler, uint32_t slot)
+{
+    scheduler->freeSlots[scheduler->freeCount++] = slot;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+/* frame times wrap around, so they are compared by their signed distance */
+static inline bool isEarlier(const JackSchedulerEvent* a, const JackSchedulerEvent* b)
+{
+    int32_t d = (int32_t)(a->time - b->time);
+    return (d < 0) || (d == 0 && (int32_t)(a->seq - b->seq) < 0);
+}
+
+void pushSchedulerEvent(JackScheduler* scheduler, jack_nframes_t time, int32_t tag,
+                        uint32_t slot, uint32_t len)
+{
+    JackSchedulerEvent* heap = scheduler->heap;
+    JackSchedulerEvent  event;
+    
+    event.time = time;
+    event.seq  = scheduler->seq++;
+    event.tag  = tag;
+    event.len  = len;
+    event.slot = slot;
+
+    uint32_t i = scheduler->count++;
+    while (i > 0) {
+        uint32_t parent = (i - 1) / 2;
+        if (!isEarlier(&event, &heap[parent])) {
+            break;
+        }
+        heap[i] = heap[parent];
+        i = parent;
+    }
+    heap[i] = event;
+}
+
+void popSchedulerEvent(JackScheduler* scheduler, JackSchedulerEvent* event)
+{
+    JackSchedulerEvent* heap = scheduler->heap;
+
+    *event = heap[0];
+    
+    JackSchedulerEvent last = heap[--scheduler->count];
+    uint32_t n = scheduler->count;
+    uint32_t i = 0;
+    while (true) {
+        uint32_t child = 2 * i + 1;
+        if (child >= n) {
+            break;
+        }
+        if (child + 1 < n && isEarlier(&heap[child + 1], &heap[child])) {
+            child += 1;
+        }
+        if (!isEarlier(&heap[child], &last)) {
+            break;
+        }
+        heap[i] = heap[child];
+        i = child;
+    }
+    if (n > 0) {
+        heap[i] = last;
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
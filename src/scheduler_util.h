@@ -0,0 +1,102 @@
+#ifndef LUAJACK_SCHEDULER_UTIL_H
+#define LUAJACK_SCHEDULER_UTIL_H
+
+#include "util.h"
+
+/////////////////////////////////////////////////////////////////////////////////
+
+typedef struct {
+    jack_nframes_t time;  /* target frame time */
+    uint32_t       seq;   /* insertion order for events with equal time */
+    int32_t        tag;
+    uint32_t       len;
+    uint32_t       slot;  /* index of data slot */
+}
+JackSchedulerEvent;
+
+/* Data of the event delivered to the handler of scheduler:process(), one
+ * preallocated object per scheduler that is overwritten for every event */
+
+typedef struct {
+    uint32_t            len;
+    char                bytes[1];    /* maxDataSize bytes */
+}
+JackEventData;
+
+static inline JackEventData* getCheckedEventData(lua_State* L, int stackIndex)
+{
+    JackEventData* data = (JackEventData*) checkudata(L, stackIndex, EVENT_DATA_TYPE, EVENT_DATA_TYPE_NAME);
+    return data;
+}
+
+typedef struct {
+    JackClientShared*   client;
+    JackSchedulerEvent* heap;        /* binary min-heap ordered by time */
+    uint32_t            count;
+    uint32_t            capacity;
+    uint32_t*           freeSlots;
+    uint32_t            freeCount;
+    char*               data;        /* capacity * maxDataSize bytes */
+    uint32_t            maxDataSize;
+    uint32_t            seq;
+    uint32_t            dropped;
+    JackEventData*      eventData;
+    int                 eventDataRef;
+}
+JackScheduler;
+
+static inline JackScheduler* getCheckedScheduler(lua_State* L, int stackIndex)
+{
+    JackScheduler* scheduler = (JackScheduler*) checkudata(L, stackIndex, SCHEDULER_TYPE, SCHEDULER_TYPE_NAME);
+    return scheduler;
+}
+
+static inline char* getSchedulerEventData(JackScheduler* scheduler, JackSchedulerEvent* event)
+{
+    return scheduler->data + (size_t)event->slot * scheduler->maxDataSize;
+}
+
+/////////////////////////////////////////////////////////////////////////////////
+
+#define initScheduler luajack_initScheduler 
+
+bool initScheduler(JackScheduler* scheduler, JackClientShared* client, 
+                   uint32_t capacity, uint32_t maxDataSize);
+
+#define releaseScheduler luajack_releaseScheduler 
+
+void releaseScheduler(JackScheduler* scheduler);
+
+/////////////////////////////////////////////////////////////////////////////////
+
+/* Allocates a data slot and returns a pointer to it or NULL if the queue is full.
+ * The slot is either committed by pushSchedulerEvent() or returned by
+ * releaseSchedulerSlot(). */
+
+#define reserveSchedulerSlot luajack_reserveSchedulerSlot 
+
+char* reserveSchedulerSlot(JackScheduler* scheduler, uint32_t* slot);
+
+#define releaseSchedulerSlot luajack_releaseSchedulerSlot 
+
+void releaseSchedulerSlot(JackScheduler* scheduler, uint32_t slot);
+
+#define pushSchedulerEvent luajack_pushSchedulerEvent 
+
+void pushSchedulerEvent(JackScheduler* scheduler, jack_nframes_t time, int32_t tag,
+                        uint32_t slot, uint32_t len);
+
+/* Removes the earliest event from the heap, the data slot of the event
+ * must be released by the caller */
+
+#define popSchedulerEvent luajack_popSchedulerEvent 
+
+void popSchedulerEvent(JackScheduler* scheduler, JackSchedulerEvent* event);
+
+#define clearScheduler luajack_clearScheduler 
+
+void clearScheduler(JackScheduler* scheduler);
+
+/////////////////////////////////////////////////////////////////////////////////
+
+#endif // LUAJACK_SCHEDULER_UTIL_H
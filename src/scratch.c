@@ -0,0 +1,139 @@
+#include "util.h"
+#include "scratch.h"
+#include "scratch_util.h"
+#include "client_util.h"
+
+static JackScratch* getCheckedScratch(lua_State* L, int stackIndex)
+{
+    return (JackScratch*) checkudata(L, stackIndex, SCRATCH_TYPE, SCRATCH_TYPE_NAME);
+}
+
+static int scratch_buffers(lua_State* L)
+/* client:scratch_buffers(count)
+ * allocates a pool of 'count' scratch buffers of the current buffer size.
+ * The memory is locked into RAM if possible. The pool is reallocated 
+ * whenever the server's buffer size changes, this happens in JACK's 
+ * notification thread, never in the process callback. Must be called 
+ * before the client is activated.
+ */
+{
+    JackClient* client = getCheckedClient(L, 1);
+    lua_Integer count  = luaL_checkinteger(L, 2);
+
+    if (!client->isMaster) {
+        return luaL_argerror(L, 1, "method can only be called on master client object");
+    }
+    if (client->isActivated) {
+        return luaL_error(L, "scratch buffers must be allocated before the client is activated");
+    }
+    luaL_argcheck(L, count >= 0 && count <= 1024, 2, "count out of range");
+
+    JackScratchPool* pool = createScratchPool((int) count, jack_get_buffer_size(client->ptr));
+    if (!pool) {
+        return luaL_error(L, "cannot allocate scratch buffers");
+    }
+    releaseClientScratchPools(client->shared);
+    client->shared->scratchPool = pool;
+    
+    lua_pushboolean(L, pool->isLocked || pool->size == 0);
+    return 1;
+}
+
+static int scratch_buffer(lua_State* L)
+/* scratch = client:scratch_buffer(index)
+ * returns the scratch buffer with the given index (1 .. count). The buffer
+ * can be used instead of a port by the buffer operations, its content is
+ * only accessible within the process callback and is not cleared between
+ * process cycles.
+ */
+{
+    JackClient* client = getCheckedClient(L, 1);
+    lua_Integer index  = luaL_checkinteger(L, 2);
+    
+    JackScratchPool* pool = client->shared->scratchPool;
+    if (!pool) {
+        return luaL_error(L, "no scratch buffers allocated");
+    }
+    luaL_argcheck(L, index >= 1 && index <= pool->count, 2, "invalid scratch buffer index");
+    
+    JackScratch* scratch = (JackScratch*) lua_newuserdata(L, sizeof(JackScratch));
+    scratch->client = client->shared;
+    scratch->index  = (int)(index - 1);
+    luaL_setmetatable(L, SCRATCH_TYPE_NAME);
+    
+    atomic_inc(&client->shared->refCounter);
+    return 1;
+}
+
+static int scratch_count(lua_State* L)
+/* client:scratch_count()
+ * returns the number of allocated scratch buffers.
+ */
+{
+    JackClient* client = getCheckedClient(L, 1);
+    JackScratchPool* pool = client->shared->scratchPool;
+    lua_pushinteger(L, pool ? pool->count : 0);
+    return 1;
+}
+
+static int scratch_release(lua_State* L)
+{
+    JackScratch* scratch = getCheckedScratch(L, 1);
+    if (scratch->client) {
+        releaseClientShared(scratch->client);
+        scratch->client = NULL;
+    }
+    return 0;
+}
+
+static int scratch_toString(lua_State* L)
+{
+    JackScratch* scratch = getCheckedScratch(L, 1);
+    lua_pushfstring(L, "%s: %d (%p)", SCRATCH_TYPE_NAME, scratch->index + 1, scratch);
+    return 1;
+}
+
+static int scratch_index(lua_State* L)
+{
+    JackScratch* scratch = getCheckedScratch(L, 1);
+    lua_pushinteger(L, scratch->index + 1);
+    return 1;
+}
+
+static const struct luaL_Reg ClientMethods[] = 
+{
+    { "scratch_buffers", scratch_buffers },
+    { "scratch_buffer",  scratch_buffer },
+    { "scratch_count",   scratch_count },
+    { NULL, NULL } /* sentinel */
+};
+
+static const struct luaL_Reg ScratchMetaMethods[] = 
+{
+    { "__tostring", scratch_toString },
+    { "__gc",       scratch_release },
+    { NULL, NULL } /* sentinel */
+};
+
+static const struct luaL_Reg ScratchMethods[] = 
+{
+    { "index",      scratch_index },
+    { NULL, NULL } /* sentinel */
+};
+
+bool luajack_open_scratch(lua_State* L, int module, int clientMeta, int clientClass,
+                                                    int scratchMeta, int scratchClass)
+{
+    lua_pushvalue(L, clientClass);
+        setfuncs(L, ClientMethods);
+
+        lua_pushvalue(L, scratchMeta);
+            setfuncs(L, ScratchMetaMethods);
+    
+            lua_pushvalue(L, scratchClass);
+                setfuncs(L, ScratchMethods);
+    
+    lua_pop(L, 3);
+    
+    return true;
+}
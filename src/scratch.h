@@ -0,0 +1,7 @@
+#ifndef LUAJACK_SCRATCH_H
+#define LUAJACK_SCRATCH_H
+
+bool luajack_open_scratch(lua_State* L, int module, int clientMeta, int clientClass,
+                                                    int scratchMeta, int scratchClass);
+
+#endif // LUAJACK_SCRATCH_H
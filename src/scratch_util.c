@@ -0,0 +1,78 @@
+#include <stdlib.h>
+
+#if !defined(_WIN32)
+    #include <sys/mman.h>
+#endif
+
+#include "util.h"
+#include "scratch_util.h"
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+JackScratchPool* createScratchPool(int count, jack_nframes_t nframes)
+{
+    JackScratchPool* pool = (JackScratchPool*) calloc(1, sizeof(JackScratchPool));
+    if (!pool) {
+        return NULL;
+    }
+    pool->count   = count;
+    pool->nframes = nframes;
+    pool->size    = sizeof(jack_default_audio_sample_t) * (size_t)count * nframes;
+    if (pool->size > 0) {
+        pool->memory = (jack_default_audio_sample_t*) calloc(1, pool->size);
+        if (!pool->memory) {
+            free(pool);
+            return NULL;
+        }
+#if !defined(_WIN32)
+        pool->isLocked = (mlock(pool->memory, pool->size) == 0);
+        if (!pool->isLocked) {
+            verbosePrintf("cannot lock scratch buffer memory (%lu bytes)\n", 
+                          (unsigned long) pool->size);
+        }
+#endif
+    }
+    return pool;
+}
+
+void releaseScratchPool(JackScratchPool* pool)
+{
+    if (pool) {
+        if (pool->memory) {
+#if !defined(_WIN32)
+            if (pool->isLocked) {
+                munlock(pool->memory, pool->size);
+            }
+#endif
+            free(pool->memory);
+        }
+        free(pool);
+    }
+}
+
+bool resizeScratchPool(JackClientShared* client, jack_nframes_t nframes)
+{
+    JackScratchPool* oldPool = client->scratchPool;
+    if (!oldPool || oldPool->nframes == nframes) {
+        return true;
+    }
+    JackScratchPool* newPool = createScratchPool(oldPool->count, nframes);
+    if (!newPool) {
+        return false;
+    }
+    atomic_set_ptr_if_equal((void**) &client->scratchPool, oldPool, newPool);
+
+    releaseScratchPool(client->retiredScratchPool);
+    client->retiredScratchPool = oldPool;
+    return true;
+}
+
+void releaseClientScratchPools(JackClientShared* client)
+{
+    releaseScratchPool(client->scratchPool);
+    releaseScratchPool(client->retiredScratchPool);
+    client->scratchPool        = NULL;
+    client->retiredScratchPool = NULL;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,37 @@
+#ifndef LUAJACK_SCRATCH_UTIL_H
+#define LUAJACK_SCRATCH_UTIL_H
+
+#include "util.h"
+
+/////////////////////////////////////////////////////////////////////////////////
+
+/* Allocates a pool of 'count' buffers with 'nframes' samples each. The memory
+ * is zeroed and locked into RAM if possible. */
+
+#define createScratchPool luajack_createScratchPool 
+
+JackScratchPool* createScratchPool(int count, jack_nframes_t nframes);
+
+#define releaseScratchPool luajack_releaseScratchPool 
+
+void releaseScratchPool(JackScratchPool* pool);
+
+/* Replaces the scratch pool of the client by a pool with the same number of 
+ * buffers and 'nframes' samples each. Must not be called from the process 
+ * thread. The previous pool is kept until the next call or until the client is
+ * released, so that a process cycle still holding it stays valid. Returns 
+ * false if the new pool could not be allocated. */
+
+#define resizeScratchPool luajack_resizeScratchPool 
+
+bool resizeScratchPool(JackClientShared* client, jack_nframes_t nframes);
+
+/* Releases both scratch pools of the client */
+
+#define releaseClientScratchPools luajack_releaseClientScratchPools 
+
+void releaseClientScratchPools(JackClientShared* client);
+
+/////////////////////////////////////////////////////////////////////////////////
+
+#endif // LUAJACK_SCRATCH_UTIL_H
@@ -0,0 +1,49 @@
+#include "util.h"
+#include "serialize.h"
+#include "serialize_util.h"
+
+static int serialize(lua_State* L)
+/* data = jack.serialize(value)
+ * encodes nil, booleans, numbers, strings and tables of these into a compact
+ * binary string, e.g. for sending configurations through a ringbuffer. Shared
+ * and cyclic tables are preserved, metatables are not encoded.
+ */
+{
+    luaL_checkany(L, 1);
+    const char* err = serializeValue(L, 1);
+    if (err) {
+        return luaL_error(L, "cannot serialize value: %s", err);
+    }
+    return 1;
+}
+
+static int deserialize(lua_State* L)
+/* value = jack.deserialize(data)
+ * decodes a string created by jack.serialize() in any Lua state.
+ */
+{
+    size_t      len;
+    const char* data = luaL_checklstring(L, 1, &len);
+    const char* err  = deserializeValue(L, data, len);
+    if (err) {
+        return luaL_error(L, "cannot deserialize value: %s", err);
+    }
+    return 1;
+}
+
+static const struct luaL_Reg ModuleFunctions[] = 
+{
+    { "serialize",      serialize },
+    { "deserialize",    deserialize },
+    { NULL, NULL } /* sentinel */
+};
+
+bool luajack_open_serialize(lua_State* L, int module)
+{
+    lua_pushvalue(L, module);
+        setfuncs(L, ModuleFunctions);
+    
+    lua_pop(L, 1);
+    
+    return true;
+}
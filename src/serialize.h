@@ -0,0 +1,6 @@
+#ifndef LUAJACK_SERIALIZE_H
+#define LUAJACK_SERIALIZE_H
+
+bool luajack_open_serialize(lua_State* L, int module);
+
+#endif // LUAJACK_SERIALIZE_H
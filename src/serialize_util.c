@@ -0,0 +1,318 @@
+#include <stdlib.h>
+
+#include "util.h"
+#include "serialize_util.h"
+
+#define SERIAL_MAX_DEPTH 200
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+/* The data is kept in a userdata anchored at stack index anchor, so that
+ * nothing leaks if a Lua error is raised while serializing. */
+
+typedef struct {
+    lua_State* L;
+    int        anchor;
+    char*      data;
+    size_t     size;
+    size_t     capacity;
+}
+SerialBuffer;
+
+static void put(SerialBuffer* b, const void* p, size_t n)
+{
+    if (b->size + n > b->capacity) {
+        size_t capacity = b->capacity ? 2 * b->capacity : 256;
+        while (capacity < b->size + n) {
+            capacity *= 2;
+        }
+        char* data = (char*) lua_newuserdata(b->L, capacity);
+        if (b->size > 0) {
+            memcpy(data, b->data, b->size);
+        }
+        lua_replace(b->L, b->anchor);
+        b->data     = data;
+        b->capacity = capacity;
+    }
+    memcpy(b->data + b->size, p, n);
+    b->size += n;
+}
+
+static void putByte(SerialBuffer* b, int c)
+{
+    char byte = (char) c;
+    put(b, &byte, 1);
+}
+
+static void putVarint(SerialBuffer* b, unsigned long long v)
+{
+    while (v >= 0x80) {
+        putByte(b, (int)(v & 0x7f) | 0x80);
+        v >>= 7;
+    }
+    putByte(b, (int) v);
+}
+
+static const char* writeValue(lua_State* L, int n, SerialBuffer* b, int memo, int* tableCount, int depth);
+
+static const char* writeTable(lua_State* L, int n, SerialBuffer* b, int memo, int* tableCount, int depth)
+{
+    lua_pushvalue(L, n);
+    lua_rawget(L, memo);
+    if (!lua_isnil(L, -1)) {
+        putByte(b, SERIAL_REF);
+        putVarint(b, (unsigned long long) lua_tointeger(L, -1));
+        lua_pop(L, 1);
+        return NULL;
+    }
+    lua_pop(L, 1);
+    if (depth >= SERIAL_MAX_DEPTH || !lua_checkstack(L, 4)) {
+        return "table nesting too deep";
+    }
+    lua_pushvalue(L, n);
+    lua_pushinteger(L, (*tableCount)++);
+    lua_rawset(L, memo);
+
+    lua_Integer narr  = (lua_Integer) lua_rawlen(L, n);
+    lua_Integer nhash = 0;
+    lua_pushnil(L);
+    while (lua_next(L, n) != 0) {
+        lua_pop(L, 1);
+        if (!lua_isinteger(L, -1) || lua_tointeger(L, -1) < 1 || lua_tointeger(L, -1) > narr) {
+            ++nhash;
+        }
+    }
+    putByte(b, SERIAL_TABLE);
+    putVarint(b, (unsigned long long) narr);
+    putVarint(b, (unsigned long long) nhash);
+
+    const char* err = NULL;
+    lua_Integer i;
+    for (i = 1; i <= narr && !err; ++i) {
+        lua_rawgeti(L, n, i);
+        err = writeValue(L, lua_gettop(L), b, memo, tableCount, depth + 1);
+        lua_pop(L, 1);
+    }
+    lua_pushnil(L);
+    while (!err && lua_next(L, n) != 0) {
+        int value = lua_gettop(L);
+        if (!lua_isinteger(L, value - 1) || lua_tointeger(L, value - 1) < 1
+                                         || lua_tointeger(L, value - 1) > narr)
+        {
+            err = writeValue(L, value - 1, b, memo, tableCount, depth + 1);
+            if (!err) {
+                err = writeValue(L, value, b, memo, tableCount, depth + 1);
+            }
+        }
+        lua_pop(L, err ? 2 : 1);
+    }
+    return err;
+}
+
+static const char* writeValue(lua_State* L, int n, SerialBuffer* b, int memo, int* tableCount, int depth)
+{
+    switch (lua_type(L, n))
+    {
+        case LUA_TNIL:
+            putByte(b, SERIAL_NIL);
+            return NULL;
+
+        case LUA_TBOOLEAN:
+            putByte(b, lua_toboolean(L, n) ? SERIAL_TRUE : SERIAL_FALSE);
+            return NULL;
+
+        case LUA_TNUMBER:
+            if (lua_isinteger(L, n)) {
+                long long v = (long long) lua_tointeger(L, n);
+                putByte(b, SERIAL_INTEGER);
+                putVarint(b, ((unsigned long long) v << 1) ^ (unsigned long long)(v >> 63));
+            } else {
+                double v = (double) lua_tonumber(L, n);
+                putByte(b, SERIAL_NUMBER);
+                put(b, &v, sizeof(v));
+            }
+            return NULL;
+
+        case LUA_TSTRING: {
+            size_t len;
+            const char* s = lua_tolstring(L, n, &len);
+            putByte(b, SERIAL_STRING);
+            putVarint(b, len);
+            put(b, s, len);
+            return NULL;
+        }
+        case LUA_TTABLE:
+            return writeTable(L, n, b, memo, tableCount, depth);
+
+        default:
+            return "unsupported type (only nil, boolean, number, string and table)";
+    }
+}
+
+const char* serializeValue(lua_State* L, int index)
+{
+    int n = lua_absindex(L, index);
+    SerialBuffer b;
+    memset(&b, 0, sizeof(b));
+    lua_pushnil(L);
+    b.L      = L;
+    b.anchor = lua_gettop(L);
+    putByte(&b, SERIAL_VERSION);
+
+    lua_newtable(L);
+    int memo = lua_gettop(L);
+    int tableCount = 0;
+    const char* err = writeValue(L, n, &b, memo, &tableCount, 0);
+    lua_settop(L, memo - 1);
+
+    if (!err) {
+        lua_pushlstring(L, b.data, b.size);
+        lua_remove(L, b.anchor);
+    } else {
+        lua_pop(L, 1);
+    }
+    return err;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+typedef struct {
+    const unsigned char* p;
+    const unsigned char* end;
+    int                  memo;
+    lua_Integer          tableCount;
+}
+SerialReader;
+
+static bool getVarint(SerialReader* r, unsigned long long* v)
+{
+    unsigned long long result = 0;
+    int shift = 0;
+    while (r->p < r->end && shift < 64) {
+        unsigned char c = *r->p++;
+        result |= (unsigned long long)(c & 0x7f) << shift;
+        if (!(c & 0x80)) {
+            *v = result;
+            return true;
+        }
+        shift += 7;
+    }
+    return false;
+}
+
+static const char* readValue(lua_State* L, SerialReader* r, int depth)
+{
+    unsigned long long v;
+    if (r->p >= r->end) {
+        return "truncated data";
+    }
+    switch (*r->p++)
+    {
+        case SERIAL_NIL:   lua_pushnil(L);        return NULL;
+        case SERIAL_FALSE: lua_pushboolean(L, 0); return NULL;
+        case SERIAL_TRUE:  lua_pushboolean(L, 1); return NULL;
+
+        case SERIAL_INTEGER:
+            if (!getVarint(r, &v)) {
+                return "truncated data";
+            }
+            lua_pushinteger(L, (lua_Integer)(long long)((v >> 1) ^ (~(v & 1) + 1)));
+            return NULL;
+
+        case SERIAL_NUMBER: {
+            double d;
+            if ((size_t)(r->end - r->p) < sizeof(d)) {
+                return "truncated data";
+            }
+            memcpy(&d, r->p, sizeof(d));
+            r->p += sizeof(d);
+            lua_pushnumber(L, (lua_Number) d);
+            return NULL;
+        }
+        case SERIAL_STRING:
+            if (!getVarint(r, &v) || v > (unsigned long long)(r->end - r->p)) {
+                return "truncated data";
+            }
+            lua_pushlstring(L, (const char*) r->p, (size_t) v);
+            r->p += v;
+            return NULL;
+
+        case SERIAL_REF:
+            if (!getVarint(r, &v) || v >= (unsigned long long) r->tableCount) {
+                return "invalid table reference";
+            }
+            lua_rawgeti(L, r->memo, (lua_Integer) v);
+            return NULL;
+
+        case SERIAL_TABLE: {
+            unsigned long long narr, nhash;
+            if (!getVarint(r, &narr) || !getVarint(r, &nhash)) {
+                return "truncated data";
+            }
+            /* every value takes at least one byte */
+            unsigned long long left = (unsigned long long)(r->end - r->p);
+            if (narr > left || nhash > left / 2) {
+                return "truncated data";
+            }
+            if (depth >= SERIAL_MAX_DEPTH || !lua_checkstack(L, 4)) {
+                return "table nesting too deep";
+            }
+            lua_createtable(L, (int) narr, (int) nhash);
+            int t = lua_gettop(L);
+            lua_pushvalue(L, t);
+            lua_rawseti(L, r->memo, r->tableCount++);
+
+            const char* err;
+            unsigned long long i;
+            for (i = 1; i <= narr; ++i) {
+                if ((err = readValue(L, r, depth + 1)) != NULL) {
+                    return err;
+                }
+                lua_rawseti(L, t, (lua_Integer) i);
+            }
+            for (i = 0; i < nhash; ++i) {
+                if (   (err = readValue(L, r, depth + 1)) != NULL
+                    || (err = readValue(L, r, depth + 1)) != NULL)
+                {
+                    return err;
+                }
+                if (lua_isnil(L, -2) || (lua_type(L, -2) == LUA_TNUMBER
+                                         && lua_tonumber(L, -2) != lua_tonumber(L, -2)))
+                {
+                    return "invalid table key";
+                }
+                lua_rawset(L, t);
+            }
+            return NULL;
+        }
+        default:
+            return "invalid data";
+    }
+}
+
+const char* deserializeValue(lua_State* L, const char* data, size_t len)
+{
+    if (len < 1 || data[0] != SERIAL_VERSION) {
+        return "invalid data";
+    }
+    int base = lua_gettop(L);
+    SerialReader r;
+    r.p          = (const unsigned char*) data + 1;
+    r.end        = (const unsigned char*) data + len;
+    r.tableCount = 0;
+    lua_newtable(L);
+    r.memo = lua_gettop(L);
+
+    const char* err = readValue(L, &r, 0);
+    if (!err && r.p != r.end) {
+        err = "invalid data";
+    }
+    if (err) {
+        lua_settop(L, base);
+    } else {
+        lua_remove(L, r.memo);
+    }
+    return err;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
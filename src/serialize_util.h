@@ -0,0 +1,52 @@
+#ifndef LUAJACK_SERIALIZE_UTIL_H
+#define LUAJACK_SERIALIZE_UTIL_H
+
+#include "util.h"
+
+/////////////////////////////////////////////////////////////////////////////////
+
+/* Compact binary encoding of nil, booleans, numbers, strings and tables for
+ * passing values between unrelated Lua states, e.g. through a ringbuffer:
+ *
+ *   data   := VERSION value
+ *   value  := NIL | FALSE | TRUE
+ *           | INTEGER zigzag-varint
+ *           | NUMBER  double (8 bytes, native byte order)
+ *           | STRING  varint(length) bytes
+ *           | TABLE   varint(narray) varint(nhash) value{narray} (value value){nhash}
+ *           | REF     varint(index)    table number index (in order of appearance)
+ *
+ * Tables reached more than once (also by cycles) are encoded once and then
+ * referenced. Metatables are not encoded. */
+
+#define SERIAL_VERSION 1
+
+enum {
+    SERIAL_NIL     = 0,
+    SERIAL_FALSE   = 1,
+    SERIAL_TRUE    = 2,
+    SERIAL_INTEGER = 3,
+    SERIAL_NUMBER  = 4,
+    SERIAL_STRING  = 5,
+    SERIAL_TABLE   = 6,
+    SERIAL_REF     = 7
+};
+
+/* Pushes the encoding of the value at index as string. Returns NULL or an
+ * error message, in which case nothing is pushed. Memory errors are raised
+ * as Lua errors. */
+
+#define serializeValue luajack_serializeValue
+
+const char* serializeValue(lua_State* L, int index);
+
+/* Pushes the decoded value. Returns NULL or an error message, in which case
+ * nothing is pushed. */
+
+#define deserializeValue luajack_deserializeValue
+
+const char* deserializeValue(lua_State* L, const char* data, size_t len);
+
+/////////////////////////////////////////////////////////////////////////////////
+
+#endif // LUAJACK_SERIALIZE_UTIL_H
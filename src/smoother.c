@@ -0,0 +1,148 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "util.h"
+#include "smoother.h"
+#include "smoother_util.h"
+
+static const char* const SmootherKindNames[] = { "linear", "exp", "ramp", NULL };
+
+static int smoother_toString(lua_State* L)
+{
+    JackSmoother* smoother = getCheckedSmoother(L, 1);
+    lua_pushfstring(L, "%s: %s (%p)", SMOOTHER_TYPE_NAME, 
+                                      SmootherKindNames[smoother->kind],
+                                      smoother);
+    return 1;
+}
+
+static int smoother_new(lua_State* L)
+/* smoother = jack.smoother(kind, time [, initial])
+ * kind    - "linear", "exp" or "ramp"
+ * time    - in frames: "linear": frames for a change of 1.0, 
+ *                      "exp":    time constant,
+ *                      "ramp":   duration of every transition
+ * initial - initial value (default 0)
+ */
+{
+    int     kind = luaL_checkoption(L, 1, NULL, SmootherKindNames);
+    lua_Number time = luaL_checknumber(L, 2);
+    lua_Number initial = luaL_optnumber(L, 3, 0);
+    
+    JackSmoother* smoother = (JackSmoother*) lua_newuserdata(L, sizeof(JackSmoother));
+    initSmoother(smoother, (JackSmootherKind)kind, (float)time, (float)initial);
+    luaL_setmetatable(L, SMOOTHER_TYPE_NAME);
+    return 1;
+}
+
+static int smoother_set_target(lua_State* L)
+{
+    JackSmoother* smoother = getCheckedSmoother(L, 1);
+    setSmootherTarget(smoother, (float)luaL_checknumber(L, 2));
+    return 0;
+}
+
+static int smoother_reset(lua_State* L)
+{
+    JackSmoother* smoother = getCheckedSmoother(L, 1);
+    resetSmoother(smoother, (float)luaL_optnumber(L, 2, smoother->target));
+    return 0;
+}
+
+static int smoother_target(lua_State* L)
+{
+    JackSmoother* smoother = getCheckedSmoother(L, 1);
+    lua_pushnumber(L, smoother->target);
+    return 1;
+}
+
+static int smoother_value(lua_State* L)
+{
+    JackSmoother* smoother = getCheckedSmoother(L, 1);
+    lua_pushnumber(L, smoother->current);
+    return 1;
+}
+
+static int smoother_is_settled(lua_State* L)
+{
+    JackSmoother* smoother = getCheckedSmoother(L, 1);
+    lua_pushboolean(L, isSmootherSettled(smoother));
+    return 1;
+}
+
+static int smoother_apply_gain(lua_State* L)
+/* smoother:apply_gain(dst [, src])
+ * multiplies the buffer of src (default: dst) with the smoothed value and 
+ * writes the result into dst. Both may be ports or scratch buffers. Advances the smoother by one cycle.
+ */
+{
+    JackSmoother* smoother = getCheckedSmoother(L, 1);
+
+    jack_nframes_t nframes;
+    jack_default_audio_sample_t* out = getCheckedSignalBuffer(L, 2, &nframes);
+    jack_default_audio_sample_t* in  = lua_isnoneornil(L, 3) ? out : getCheckedSignalBuffer(L, 3, &nframes);
+    if (out) {
+        if (in) {
+            applySmootherGain(smoother, out, in, nframes);
+        }
+    }
+    return 0;
+}
+
+static int smoother_render(lua_State* L)
+/* smoother:render(dst)
+ * writes the smoothed values into the buffer of a port or scratch buffer. Advances the smoother 
+ * by one cycle.
+ */
+{
+    JackSmoother* smoother = getCheckedSmoother(L, 1);
+
+    jack_nframes_t nframes;
+    jack_default_audio_sample_t* out = getCheckedSignalBuffer(L, 2, &nframes);
+    if (out) {
+        renderSmoother(smoother, out, nframes);
+    }
+    return 0;
+}
+
+static const struct luaL_Reg SmootherMetaMethods[] = 
+{
+    { "__tostring", smoother_toString },
+    { NULL, NULL } /* sentinel */
+};
+
+static const struct luaL_Reg SmootherMethods[] = 
+{
+    { "set_target",  smoother_set_target },
+    { "reset",       smoother_reset },
+    { "target",      smoother_target },
+    { "value",       smoother_value },
+    { "is_settled",  smoother_is_settled },
+    { "apply_gain",  smoother_apply_gain },
+    { "render",      smoother_render },
+    { NULL, NULL } /* sentinel */
+};
+
+static const struct luaL_Reg ModuleFunctions[] = 
+{
+    { "smoother",    smoother_new },
+    { NULL, NULL } /* sentinel */
+};
+
+bool luajack_open_smoother(lua_State* L, int module, int clientMeta, int clientClass,
+                                                      int smootherMeta, int smootherClass)
+{
+    lua_pushvalue(L, module);
+        setfuncs(L, ModuleFunctions);
+
+        lua_pushvalue(L, smootherMeta);
+            setfuncs(L, SmootherMetaMethods);
+    
+            lua_pushvalue(L, smootherClass);
+                setfuncs(L, SmootherMethods);
+    
+    lua_pop(L, 3);
+    
+    return true;
+}
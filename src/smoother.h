@@ -0,0 +1,7 @@
+#ifndef LUAJACK_SMOOTHER_H
+#define LUAJACK_SMOOTHER_H
+
+bool luajack_open_smoother(lua_State* L, int module, int clientMeta, int clientClass,
+                                                      int smootherMeta, int smootherClass);
+
+#endif // LUAJACK_SMOOTHER_H
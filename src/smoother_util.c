@@ -0,0 +1,160 @@
+#include <math.h>
+
+#include "util.h"
+#include "smoother_util.h"
+
+/* below this distance relative to the target (absolute for targets below 1)
+ * the exponential smoother snaps to its target */
+#define SMOOTHER_EPSILON 1e-6f
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+void initSmoother(JackSmoother* smoother, JackSmootherKind kind, float time, float initial)
+{
+    memset(smoother, 0, sizeof(JackSmoother));
+    smoother->kind    = kind;
+    smoother->time    = (time > 1) ? time : 1;
+    smoother->current = initial;
+    smoother->target  = initial;
+    smoother->coeff   = 1 - expf(-1 / smoother->time);
+}
+
+void setSmootherTarget(JackSmoother* smoother, float target)
+{
+    smoother->target = target;
+
+    float distance = target - smoother->current;
+
+    switch (smoother->kind) {
+        case SMOOTHER_LINEAR: {
+            float frames = ceilf(fabsf(distance) * smoother->time);
+            smoother->remaining = (jack_nframes_t) frames;
+            smoother->step      = (frames > 0) ? distance / frames : 0;
+            break;
+        }
+        case SMOOTHER_RAMP: {
+            smoother->remaining = (jack_nframes_t) smoother->time;
+            smoother->step      = distance / smoother->time;
+            break;
+        }
+        case SMOOTHER_EXP: {
+            break;
+        }
+    }
+    if (smoother->remaining == 0 && smoother->kind != SMOOTHER_EXP) {
+        smoother->current = target;
+    }
+}
+
+void resetSmoother(JackSmoother* smoother, float value)
+{
+    smoother->current   = value;
+    smoother->target    = value;
+    smoother->remaining = 0;
+    smoother->step      = 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+/* Returns target if the exponential smoother is close enough or if the next
+ * step would no longer change current, which happens far from the target for
+ * large values and small coefficients, otherwise current */
+static inline float settleExp(float current, float target, float coeff)
+{
+    float distance = target - current;
+    if (   fabsf(distance) <= SMOOTHER_EPSILON * fmaxf(fabsf(target), 1.0f)
+        || current + coeff * distance == current)
+    {
+        return target;
+    }
+    return current;
+}
+
+/* Number of frames of the next block that are still moving; for the linear
+ * segments the values are start + step * (i + 1) which vectorizes well. */
+static jack_nframes_t advanceLinear(JackSmoother* smoother, jack_nframes_t nframes, 
+                                    float* start, float* step)
+{
+    jack_nframes_t n = smoother->remaining < nframes ? smoother->remaining : nframes;
+    *start = smoother->current;
+    *step  = smoother->step;
+    smoother->remaining -= n;
+    if (smoother->remaining == 0) {
+        smoother->current = smoother->target;
+    } else {
+        smoother->current += smoother->step * n;
+    }
+    return n;
+}
+
+void renderSmoother(JackSmoother* smoother, float* out, jack_nframes_t nframes)
+{
+    jack_nframes_t i = 0;
+
+    if (!isSmootherSettled(smoother)) {
+        if (smoother->kind == SMOOTHER_EXP) {
+            float current = smoother->current;
+            float target  = smoother->target;
+            float coeff   = smoother->coeff;
+            for (; i < nframes; ++i) {
+                current += coeff * (target - current);
+                out[i] = current;
+            }
+            smoother->current = settleExp(current, target, coeff);
+            return;
+        }
+        else {
+            float start, step;
+            jack_nframes_t n = advanceLinear(smoother, nframes, &start, &step);
+            for (; i < n; ++i) {
+                out[i] = start + step * (i + 1);
+            }
+        }
+    }
+    float value = smoother->current;
+    for (; i < nframes; ++i) {
+        out[i] = value;
+    }
+}
+
+void applySmootherGain(JackSmoother* smoother, float* dst, const float* src, jack_nframes_t nframes)
+{
+    jack_nframes_t i = 0;
+
+    if (!isSmootherSettled(smoother)) {
+        if (smoother->kind == SMOOTHER_EXP) {
+            float current = smoother->current;
+            float target  = smoother->target;
+            float coeff   = smoother->coeff;
+            for (; i < nframes; ++i) {
+                current += coeff * (target - current);
+                dst[i] = src[i] * current;
+            }
+            smoother->current = settleExp(current, target, coeff);
+            return;
+        }
+        else {
+            float start, step;
+            jack_nframes_t n = advanceLinear(smoother, nframes, &start, &step);
+            for (; i < n; ++i) {
+                dst[i] = src[i] * (start + step * (i + 1));
+            }
+        }
+    }
+    float gain = smoother->current;
+    if (gain == 1) {
+        if (dst != src) {
+            memcpy(dst + i, src + i, sizeof(float) * (nframes - i));
+        }
+    }
+    else if (gain == 0) {
+        memset(dst + i, 0, sizeof(float) * (nframes - i));
+    }
+    else {
+        for (; i < nframes; ++i) {
+            dst[i] = src[i] * gain;
+        }
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,68 @@
+#ifndef LUAJACK_SMOOTHER_UTIL_H
+#define LUAJACK_SMOOTHER_UTIL_H
+
+#include "util.h"
+
+/////////////////////////////////////////////////////////////////////////////////
+
+typedef enum {
+    SMOOTHER_LINEAR,  /* constant slew rate: 'time' frames for a change of 1.0 */
+    SMOOTHER_EXP,     /* one-pole lowpass: 'time' is the time constant in frames */
+    SMOOTHER_RAMP     /* fixed duration: every new target is reached after 'time' frames */
+}
+JackSmootherKind;
+
+typedef struct {
+    JackSmootherKind kind;
+    float            time;
+    float            current;
+    float            target;
+    float            step;       /* increment per frame for linear and ramp */
+    float            coeff;      /* feedback coefficient for exp */
+    jack_nframes_t   remaining;  /* frames until target is reached for linear and ramp */
+}
+JackSmoother;
+
+static inline JackSmoother* getCheckedSmoother(lua_State* L, int stackIndex)
+{
+    JackSmoother* smoother = (JackSmoother*) checkudata(L, stackIndex, SMOOTHER_TYPE, SMOOTHER_TYPE_NAME);
+    return smoother;
+}
+
+static inline bool isSmootherSettled(JackSmoother* smoother)
+{
+    return smoother->current == smoother->target;
+}
+
+/////////////////////////////////////////////////////////////////////////////////
+
+#define initSmoother luajack_initSmoother
+
+void initSmoother(JackSmoother* smoother, JackSmootherKind kind, float time, float initial);
+
+#define setSmootherTarget luajack_setSmootherTarget
+
+void setSmootherTarget(JackSmoother* smoother, float target);
+
+#define resetSmoother luajack_resetSmoother
+
+void resetSmoother(JackSmoother* smoother, float value);
+
+/////////////////////////////////////////////////////////////////////////////////
+
+/* out[i] = smoothed value, advances the smoother by nframes */
+
+#define renderSmoother luajack_renderSmoother
+
+void renderSmoother(JackSmoother* smoother, float* out, jack_nframes_t nframes);
+
+/* dst[i] = src[i] * smoothed value, advances the smoother by nframes,
+ * dst and src may be the same buffer */
+
+#define applySmootherGain luajack_applySmootherGain
+
+void applySmootherGain(JackSmoother* smoother, float* dst, const float* src, jack_nframes_t nframes);
+
+/////////////////////////////////////////////////////////////////////////////////
+
+#endif // LUAJACK_SMOOTHER_UTIL_H
@@ -31,16 +31,16 @@ bool luajack_open_thread(lua_State* L, int module, int clientMeta, int clientCla
                                                     int threadMeta, int threadClass)
 {
     lua_pushvalue(L, module);
-        luaL_setfuncs(L, ModuleFunctions, 0);
+        setfuncs(L, ModuleFunctions);
 
         lua_pushvalue(L, clientClass);
-            luaL_setfuncs(L, ClientMethods, 0);
+            setfuncs(L, ClientMethods);
     
             lua_pushvalue(L, threadMeta);
-                luaL_setfuncs(L, ThreadMetaMethods, 0);
+                setfuncs(L, ThreadMetaMethods);
         
                 lua_pushvalue(L, threadClass);
-                    luaL_setfuncs(L, ThreadMethods, 0);
+                    setfuncs(L, ThreadMethods);
             
     lua_pop(L, 4);
     
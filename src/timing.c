@@ -0,0 +1,212 @@
+#include "util.h"
+#include "timing.h"
+
+static const char transportStatesKey = 0;
+
+static const char* transportStateName(jack_transport_state_t state)
+{
+    switch (state) {
+        case JackTransportStopped:    return "stopped";
+        case JackTransportRolling:    return "rolling";
+        case JackTransportLooping:    return "looping";
+        case JackTransportStarting:   return "starting";
+        default:                      return "unknown";
+    }
+}
+
+/* The state names are interned once in the registry, so that pushing them
+ * from the process callback does not allocate */
+
+static void initTransportStates(lua_State* L)
+{
+    lua_createtable(L, 4, 1); /* [-1] = "unknown" */
+    lua_pushstring(L, transportStateName(JackTransportStopped));
+    lua_rawseti(L, -2, JackTransportStopped);
+    lua_pushstring(L, transportStateName(JackTransportRolling));
+    lua_rawseti(L, -2, JackTransportRolling);
+    lua_pushstring(L, transportStateName(JackTransportLooping));
+    lua_rawseti(L, -2, JackTransportLooping);
+    lua_pushstring(L, transportStateName(JackTransportStarting));
+    lua_rawseti(L, -2, JackTransportStarting);
+    lua_pushstring(L, transportStateName((jack_transport_state_t) -1));
+    lua_rawseti(L, -2, -1);
+    lua_rawsetp(L, LUA_REGISTRYINDEX, &transportStatesKey);
+}
+
+static void pushTransportState(lua_State* L, jack_transport_state_t state)
+{
+    lua_rawgetp(L, LUA_REGISTRYINDEX, &transportStatesKey);
+    lua_rawgeti(L, -1, state);
+    if (lua_isnil(L, -1)) {
+        lua_pop(L, 1);
+        lua_rawgeti(L, -1, -1);
+    }
+    lua_remove(L, -2);
+}
+
+static int sample_rate(lua_State* L)
+{
+    JackClient* client = getCheckedClient(L, 1);
+    lua_pushinteger(L, jack_get_sample_rate(client->ptr));
+    return 1;
+}
+
+static int frame_time(lua_State* L)
+{
+    JackClient* client = getCheckedClient(L, 1);
+    lua_pushinteger(L, jack_frame_time(client->ptr));
+    return 1;
+}
+
+static int last_frame_time(lua_State* L)
+{
+    JackClient* client = getCheckedClient(L, 1);
+    lua_pushinteger(L, jack_last_frame_time(client->ptr));
+    return 1;
+}
+
+static int frames_since_cycle_start(lua_State* L)
+{
+    JackClient* client = getCheckedClient(L, 1);
+    lua_pushinteger(L, jack_frames_since_cycle_start(client->ptr));
+    return 1;
+}
+
+static int cycle_times(lua_State* L)
+/* current_frames, current_usecs, next_usecs, period_usecs = client:cycle_times()
+ * returns nil if the cycle times are not available.
+ */
+{
+    JackClient* client = getCheckedClient(L, 1);
+    jack_nframes_t currentFrames;
+    jack_time_t    currentUsecs;
+    jack_time_t    nextUsecs;
+    float          periodUsecs;
+    
+    if (jack_get_cycle_times(client->ptr, &currentFrames, &currentUsecs, &nextUsecs, &periodUsecs) != 0) {
+        lua_pushnil(L);
+        return 1;
+    }
+    lua_pushinteger(L, currentFrames);
+    lua_pushinteger(L, currentUsecs);
+    lua_pushinteger(L, nextUsecs);
+    lua_pushnumber (L, periodUsecs);
+    return 4;
+}
+
+static int get_time(lua_State* L)
+{
+    lua_pushinteger(L, jack_get_time());
+    return 1;
+}
+
+static int frames_to_time(lua_State* L)
+{
+    JackClient*    client = getCheckedClient(L, 1);
+    jack_nframes_t frames = (jack_nframes_t) luaL_checkinteger(L, 2);
+    lua_pushinteger(L, jack_frames_to_time(client->ptr, frames));
+    return 1;
+}
+
+static int time_to_frames(lua_State* L)
+{
+    JackClient* client = getCheckedClient(L, 1);
+    jack_time_t usecs  = (jack_time_t) luaL_checkinteger(L, 2);
+    lua_pushinteger(L, jack_time_to_frames(client->ptr, usecs));
+    return 1;
+}
+
+static int frames_to_usecs(lua_State* L)
+/* converts a duration in frames into microseconds using the sample rate */
+{
+    JackClient* client = getCheckedClient(L, 1);
+    lua_Number  frames = luaL_checknumber(L, 2);
+    lua_pushnumber(L, frames * 1000000.0 / jack_get_sample_rate(client->ptr));
+    return 1;
+}
+
+static int usecs_to_frames(lua_State* L)
+/* converts a duration in microseconds into frames using the sample rate */
+{
+    JackClient* client = getCheckedClient(L, 1);
+    lua_Number  usecs  = luaL_checknumber(L, 2);
+    lua_pushnumber(L, usecs * jack_get_sample_rate(client->ptr) / 1000000.0);
+    return 1;
+}
+
+static int transport_query(lua_State* L)
+/* state, frame [, bar, beat, tick, bpm] = client:transport_query()
+ * state is one of "stopped", "rolling", "looping", "starting"; 
+ * bar, beat, tick and bpm are only returned if BBT information is available.
+ */
+{
+    JackClient* client = getCheckedClient(L, 1);
+    jack_position_t pos;
+    jack_transport_state_t state = jack_transport_query(client->ptr, &pos);
+    
+    pushTransportState(L, state);
+    lua_pushinteger(L, pos.frame);
+    if (pos.valid & JackPositionBBT) {
+        lua_pushinteger(L, pos.bar);
+        lua_pushinteger(L, pos.beat);
+        lua_pushinteger(L, pos.tick);
+        lua_pushnumber (L, pos.beats_per_minute);
+        return 6;
+    }
+    return 2;
+}
+
+static int transport_frame(lua_State* L)
+{
+    JackClient* client = getCheckedClient(L, 1);
+    lua_pushinteger(L, jack_get_current_transport_frame(client->ptr));
+    return 1;
+}
+
+static const struct luaL_Reg ClientMethods[] = 
+{
+    { "sample_rate",              sample_rate },
+    { "frame_time",               frame_time },
+    { "last_frame_time",          last_frame_time },
+    { "frames_since_cycle_start", frames_since_cycle_start },
+    { "cycle_times",              cycle_times },
+    { "frames_to_time",           frames_to_time },
+    { "time_to_frames",           time_to_frames },
+    { "frames_to_usecs",          frames_to_usecs },
+    { "usecs_to_frames",          usecs_to_frames },
+    { "transport_query",          transport_query },
+    { "transport_frame",          transport_frame },
+    { NULL, NULL } /* sentinel */
+};
+
+static const struct luaL_Reg ModuleFunctions[] = 
+{
+    { "time",                     get_time },
+    { "sample_rate",              sample_rate },
+    { "frame_time",               frame_time },
+    { "last_frame_time",          last_frame_time },
+    { "frames_since_cycle_start", frames_since_cycle_start },
+    { "cycle_times",              cycle_times },
+    { "frames_to_time",           frames_to_time },
+    { "time_to_frames",           time_to_frames },
+    { "frames_to_usecs",          frames_to_usecs },
+    { "usecs_to_frames",          usecs_to_frames },
+    { "transport_query",          transport_query },
+    { "transport_frame",          transport_frame },
+    { NULL, NULL } /* sentinel */
+};
+
+bool luajack_open_timing(lua_State* L, int module, int clientMeta, int clientClass)
+{
+    initTransportStates(L);
+
+    lua_pushvalue(L, module);
+        setfuncs(L, ModuleFunctions);
+
+        lua_pushvalue(L, clientClass);
+            setfuncs(L, ClientMethods);
+    
+    lua_pop(L, 2);
+    
+    return true;
+}
@@ -0,0 +1,6 @@
+#ifndef LUAJACK_TIMING_H
+#define LUAJACK_TIMING_H
+
+bool luajack_open_timing(lua_State* L, int module, int clientMeta, int clientClass);
+
+#endif // LUAJACK_TIMING_H
@@ -0,0 +1,129 @@
+#include "util.h"
+#include "trace.h"
+#include "trace_util.h"
+
+/* The functions are available as module functions and as client methods,
+ * the client argument of the methods is ignored. */
+static int firstArg(lua_State* L)
+{
+    return getOptionalClient(L, 1) ? 2 : 1;
+}
+
+static int trace_start(lua_State* L)
+/* jack.trace_start([capacity])
+ * starts recording trace events, capacity is the number of events buffered
+ * per thread until the next trace_dump() (default 65536). The buffers are 
+ * allocated on the first call, later calls ignore capacity.
+ */
+{
+    int         arg      = firstArg(L);
+    lua_Integer capacity = luaL_optinteger(L, arg, 65536);
+    luaL_argcheck(L, capacity >= 1, arg, "invalid capacity");
+    if (!startTrace((int) capacity)) {
+        return luaL_error(L, "cannot allocate trace buffers");
+    }
+    return 0;
+}
+
+static int trace_stop(lua_State* L)
+{
+    stopTrace();
+    return 0;
+}
+
+static int trace_dump(lua_State* L)
+/* count, dropped = jack.trace_dump(filename)
+ * moves all buffered events into a Chrome trace_event JSON file that can be
+ * opened with chrome://tracing or Perfetto. Returns the number of events 
+ * written and the number of events lost because a buffer was full, plus 
+ * the number of threads not traced because 64 threads were already 
+ * traced.
+ */
+{
+    const char* fileName = luaL_checkstring(L, firstArg(L));
+    int dropped;
+    int count = dumpTrace(fileName, &dropped);
+    if (count < 0) {
+        return luaL_error(L, "cannot write trace file '%s'", fileName);
+    }
+    lua_pushinteger(L, count);
+    lua_pushinteger(L, dropped);
+    return 2;
+}
+
+static int trace_begin(lua_State* L)
+/* jack.trace_begin(name)
+ * begins a span on the timeline of the calling thread. Can be called from 
+ * the process context.
+ */
+{
+    const char* name = luaL_checkstring(L, firstArg(L));
+    traceBegin(name);
+    return 0;
+}
+
+static int trace_end(lua_State* L)
+/* jack.trace_end()
+ * ends the innermost span of the calling thread.
+ */
+{
+    traceEnd();
+    return 0;
+}
+
+static int trace_instant(lua_State* L)
+/* jack.trace_instant(name)
+ * marks a point in time on the timeline of the calling thread.
+ */
+{
+    const char* name = luaL_checkstring(L, firstArg(L));
+    traceInstant(name);
+    return 0;
+}
+
+static int trace_thread_name(lua_State* L)
+/* jack.trace_thread_name(name)
+ * names the timeline of the calling thread.
+ */
+{
+    const char* name = luaL_checkstring(L, firstArg(L));
+    setTraceThreadName(name, true);
+    return 0;
+}
+
+static const struct luaL_Reg ClientMethods[] = 
+{
+    { "trace_start",        trace_start },
+    { "trace_stop",         trace_stop },
+    { "trace_dump",         trace_dump },
+    { "trace_begin",        trace_begin },
+    { "trace_end",          trace_end },
+    { "trace_instant",      trace_instant },
+    { "trace_thread_name",  trace_thread_name },
+    { NULL, NULL } /* sentinel */
+};
+
+static const struct luaL_Reg ModuleFunctions[] = 
+{
+    { "trace_start",        trace_start },
+    { "trace_stop",         trace_stop },
+    { "trace_dump",         trace_dump },
+    { "trace_begin",        trace_begin },
+    { "trace_end",          trace_end },
+    { "trace_instant",      trace_instant },
+    { "trace_thread_name",  trace_thread_name },
+    { NULL, NULL } /* sentinel */
+};
+
+bool luajack_open_trace(lua_State* L, int module, int clientMeta, int clientClass)
+{
+    lua_pushvalue(L, module);
+        setfuncs(L, ModuleFunctions);
+
+        lua_pushvalue(L, clientClass);
+            setfuncs(L, ClientMethods);
+    
+    lua_pop(L, 2);
+    
+    return true;
+}
@@ -0,0 +1,6 @@
+#ifndef LUAJACK_TRACE_H
+#define LUAJACK_TRACE_H
+
+bool luajack_open_trace(lua_State* L, int module, int clientMeta, int clientClass);
+
+#endif // LUAJACK_TRACE_H
@@ -0,0 +1,191 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "util.h"
+#include "trace_util.h"
+
+#if defined(_MSC_VER)
+    #define THREAD_LOCAL __declspec(thread)
+#else
+    #define THREAD_LOCAL __thread
+#endif
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+AtomicCounter traceEnabled = false;
+
+/* The rings are never freed: threads may still hold a pointer to their ring
+ * after tracing was stopped. */
+static JackTraceThread* TraceThreads      = NULL;
+static AtomicCounter    TraceThreadCount  = 0;
+static AtomicCounter    TraceOverflow     = 0;
+
+static THREAD_LOCAL JackTraceThread* CurrentThread = NULL;
+
+/* CurrentThread of threads that did not get a slot, so that they neither
+ * retry nor count again on every event */
+static JackTraceThread RefusedThread;
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+bool startTrace(int capacity)
+{
+    if (!TraceThreads) {
+        JackTraceThread* threads = (JackTraceThread*) calloc(TRACE_MAX_THREADS, sizeof(JackTraceThread));
+        if (!threads) {
+            return false;
+        }
+        int i;
+        for (i = 0; i < TRACE_MAX_THREADS; ++i) {
+            threads[i].events = jack_ringbuffer_create(sizeof(JackTraceEvent) * capacity);
+            if (!threads[i].events) {
+                while (--i >= 0) {
+                    jack_ringbuffer_free(threads[i].events);
+                }
+                free(threads);
+                return false;
+            }
+            jack_ringbuffer_mlock(threads[i].events);
+        }
+        TraceThreads = threads;
+    }
+    atomic_set(&traceEnabled, true);
+    return true;
+}
+
+void stopTrace(void)
+{
+    atomic_set(&traceEnabled, false);
+}
+
+static JackTraceThread* claimThread(const char* threadName)
+{
+    int index;
+    do {
+        index = atomic_get(&TraceThreadCount);
+        if (index >= TRACE_MAX_THREADS) {
+            atomic_inc(&TraceOverflow);
+            CurrentThread = &RefusedThread;
+            return NULL;
+        }
+    } while (!atomic_set_if_equal(&TraceThreadCount, index, index + 1));
+
+    JackTraceThread* thread = &TraceThreads[index];
+    if (threadName) {
+        snprintf(thread->threadName, TRACE_NAME_SIZE, "%s", threadName);
+    } else {
+        snprintf(thread->threadName, TRACE_NAME_SIZE, "thread %d", index + 1);
+    }
+    atomic_set(&thread->ready, true);
+    CurrentThread = thread;
+    return thread;
+}
+
+void recordTraceEvent(char phase, const char* name)
+{
+    JackTraceThread* thread = CurrentThread;
+    if (!thread) {
+        if (!TraceThreads || !(thread = claimThread(NULL))) {
+            return;
+        }
+    } else if (thread == &RefusedThread) {
+        return;
+    }
+    if (jack_ringbuffer_write_space(thread->events) < sizeof(JackTraceEvent)) {
+        atomic_inc(&thread->dropped);
+        return;
+    }
+    JackTraceEvent event;
+    event.time  = jack_get_time();
+    event.phase = phase;
+    if (name) {
+        strncpy(event.name, name, TRACE_NAME_SIZE - 1);
+        event.name[TRACE_NAME_SIZE - 1] = '\0';
+    } else {
+        event.name[0] = '\0';
+    }
+    jack_ringbuffer_write(thread->events, (const char*) &event, sizeof(JackTraceEvent));
+}
+
+void setTraceThreadName(const char* threadName, bool force)
+{
+    if (!TraceThreads) {
+        return;
+    }
+    if (!CurrentThread) {
+        claimThread(threadName);
+    } else if (force && CurrentThread != &RefusedThread) {
+        snprintf(CurrentThread->threadName, TRACE_NAME_SIZE, "%s", threadName);
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+static void writeJsonString(FILE* out, const char* s)
+{
+    fputc('"', out);
+    for (; *s; ++s) {
+        unsigned char c = (unsigned char) *s;
+        if (c == '"' || c == '\\') {
+            fputc('\\', out);
+            fputc(c, out);
+        } else if (c < 0x20) {
+            fprintf(out, "\\u%04x", c);
+        } else {
+            fputc(c, out);
+        }
+    }
+    fputc('"', out);
+}
+
+int dumpTrace(const char* fileName, int* dropped)
+{
+    FILE* out = fopen(fileName, "w");
+    if (!out) {
+        return -1;
+    }
+    int count    = 0;
+    int nthreads = atomic_get(&TraceThreadCount);
+    if (nthreads > TRACE_MAX_THREADS) {
+        nthreads = TRACE_MAX_THREADS;
+    }
+    bool first   = true;
+    int i;
+    *dropped = atomic_get(&TraceOverflow);
+
+    fprintf(out, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    for (i = 0; i < nthreads; ++i) {
+        JackTraceThread* thread = &TraceThreads[i];
+        if (!atomic_get(&thread->ready)) {
+            continue;
+        }
+        fprintf(out, "%s{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":", 
+                     first ? "" : ",\n", i + 1);
+        first = false;
+        writeJsonString(out, thread->threadName);
+        fprintf(out, "}}");
+
+        JackTraceEvent event;
+        while (jack_ringbuffer_read_space(thread->events) >= sizeof(JackTraceEvent)) {
+            jack_ringbuffer_read(thread->events, (char*) &event, sizeof(JackTraceEvent));
+            fprintf(out, ",\n{\"ph\":\"%c\",\"pid\":1,\"tid\":%d,\"ts\":%llu", 
+                         event.phase, i + 1, (unsigned long long) event.time);
+            if (event.phase != 'E') {
+                fprintf(out, ",\"name\":");
+                writeJsonString(out, event.name);
+            }
+            if (event.phase == 'i') {
+                fprintf(out, ",\"s\":\"t\"");
+            }
+            fprintf(out, "}");
+            ++count;
+        }
+        *dropped += atomic_get(&thread->dropped);
+    }
+    fprintf(out, "\n]}\n");
+    bool ok = !ferror(out);
+    fclose(out);
+    return ok ? count : -1;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,104 @@
+#ifndef LUAJACK_TRACE_UTIL_H
+#define LUAJACK_TRACE_UTIL_H
+
+#include "util.h"
+
+/////////////////////////////////////////////////////////////////////////////////
+
+/* Process wide tracing into per-thread single producer rings. A thread 
+ * claims one of the preallocated rings on its first event, so recording 
+ * never allocates or locks. The main context drains all rings and writes 
+ * Chrome trace_event JSON. */
+
+#define TRACE_MAX_THREADS  64
+#define TRACE_NAME_SIZE    40
+
+typedef struct {
+    jack_time_t          time;
+    char                 phase;          /* 'B', 'E' or 'i' */
+    char                 name[TRACE_NAME_SIZE];
+}
+JackTraceEvent;
+
+typedef struct {
+    jack_ringbuffer_t*   events;
+    AtomicCounter        ready;          /* set after threadName was written */
+    AtomicCounter        dropped;
+    char                 threadName[TRACE_NAME_SIZE];
+}
+JackTraceThread;
+
+#define traceEnabled luajack_traceEnabled
+
+extern AtomicCounter traceEnabled;
+
+static inline bool isTraceEnabled(void)
+{
+    return *(volatile AtomicCounter*) &traceEnabled;
+}
+
+/////////////////////////////////////////////////////////////////////////////////
+
+/* Allocates the rings on first call, capacity is in events per thread */
+
+#define startTrace luajack_startTrace
+
+bool startTrace(int capacity);
+
+#define stopTrace luajack_stopTrace
+
+void stopTrace(void);
+
+#define recordTraceEvent luajack_recordTraceEvent
+
+void recordTraceEvent(char phase, const char* name);
+
+/* Names the calling thread in the trace, threadName is only used if the 
+ * thread has not claimed a ring yet unless force is true */
+
+#define setTraceThreadName luajack_setTraceThreadName
+
+void setTraceThreadName(const char* threadName, bool force);
+
+/* Drains all rings into a trace_event JSON file, returns the number of 
+ * events written or -1 if the file cannot be written */
+
+#define dumpTrace luajack_dumpTrace
+
+int dumpTrace(const char* fileName, int* dropped);
+
+/////////////////////////////////////////////////////////////////////////////////
+
+static inline void traceBegin(const char* name)
+{
+    if (isTraceEnabled()) {
+        recordTraceEvent('B', name);
+    }
+}
+
+static inline void traceEnd(void)
+{
+    if (isTraceEnabled()) {
+        recordTraceEvent('E', NULL);
+    }
+}
+
+/* Like traceBegin, also names the calling thread on its first event */
+static inline void traceThreadBegin(const char* threadName, const char* name)
+{
+    if (isTraceEnabled()) {
+        setTraceThreadName(threadName, false);
+        recordTraceEvent('B', name);
+    }
+}
+
+static inline void traceInstant(const char* name)
+{
+    if (isTraceEnabled()) {
+        recordTraceEvent('i', name);
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////////
+
+#endif // LUAJACK_TRACE_UTIL_H
@@ -4,6 +4,12 @@
 #include "port_util.h"
 #include "client_util.h"
 #include "rbuf_util.h"
+#include "meter_util.h"
+#include "analyzer_util.h"
+#include "convolver_util.h"
+#include "oscillator_util.h"
+#include "array_util.h"
+#include "router_util.h"
 #include "main.h"
 
 //////////////////////////////////////////////////////////////////////////////////////////////
@@ -34,6 +40,54 @@ int verbosePrintf(const char* fmt, ...)
 
 //////////////////////////////////////////////////////////////////////////////////////////////
 
+static const char typesKey = 0;
+
+static const char* const TypeNames[TYPE_COUNT] = 
+{
+    CLIENT_TYPE_NAME,
+    PORT_TYPE_NAME,
+    RBUF_TYPE_NAME,
+    THREAD_TYPE_NAME,
+    SMOOTHER_TYPE_NAME,
+    SCHEDULER_TYPE_NAME,
+    LATENCY_PROBE_TYPE_NAME,
+    SCRATCH_TYPE_NAME,
+    NATIVE_TYPE_NAME,
+    METER_TYPE_NAME,
+    ANALYZER_TYPE_NAME,
+    CONVOLVER_TYPE_NAME,
+    OSCILLATOR_TYPE_NAME,
+    WAVETABLE_TYPE_NAME,
+    PROFILER_TYPE_NAME,
+    RECORDER_TYPE_NAME,
+    ARRAY_TYPE_NAME,
+    PORT_GROUP_TYPE_NAME,
+    MIDI_ROUTER_TYPE_NAME,
+    EVENT_DATA_TYPE_NAME
+};
+
+void initTypes(lua_State* L)
+{
+    LuaJackTypes* types = (LuaJackTypes*) lua_newuserdata(L, sizeof(LuaJackTypes));
+    memset(types, 0, sizeof(LuaJackTypes));
+    types->self = types;
+    int i;
+    for (i = 0; i < TYPE_COUNT; ++i) {
+        luaL_getmetatable(L, TypeNames[i]);
+        types->metatables[i] = lua_topointer(L, -1);
+        lua_pop(L, 1);
+    }
+    lua_rawsetp(L, LUA_REGISTRYINDEX, &typesKey);
+}
+
+void setfuncs(lua_State* L, const luaL_Reg* l)
+{
+    lua_rawgetp(L, LUA_REGISTRYINDEX, &typesKey);
+    luaL_setfuncs(L, l, 1);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
 
 bool checkonoff(lua_State* L, int arg)
 {
@@ -50,6 +104,42 @@ bool checkonoff(lua_State* L, int arg)
     }
 }
 
+lua_Integer getIntegerOption(lua_State* L, int optIndex, const char* name, lua_Integer defaultValue)
+{
+    lua_Integer value = defaultValue;
+    if (lua_istable(L, optIndex)) {
+        lua_getfield(L, optIndex, name);
+        if (!lua_isnil(L, -1)) {
+            value = luaL_checkinteger(L, -1);
+        }
+        lua_pop(L, 1);
+    }
+    return value;
+}
+
+lua_Number getNumberOption(lua_State* L, int optIndex, const char* name, lua_Number defaultValue)
+{
+    lua_Number value = defaultValue;
+    if (lua_istable(L, optIndex)) {
+        lua_getfield(L, optIndex, name);
+        if (!lua_isnil(L, -1)) {
+            value = luaL_checknumber(L, -1);
+        }
+        lua_pop(L, 1);
+    }
+    return value;
+}
+
+jack_nframes_t getOptionalNframes(lua_State* L, int arg, jack_nframes_t nframes)
+{
+    if (!lua_isnoneornil(L, arg)) {
+        lua_Integer n = luaL_checkinteger(L, arg);
+        luaL_argcheck(L, n >= 0 && n <= (lua_Integer) nframes, arg, "number of frames out of range");
+        return (jack_nframes_t) n;
+    }
+    return nframes;
+}
+
 
 //////////////////////////////////////////////////////////////////////////////////////////////
 
@@ -60,6 +150,159 @@ static inline void setArg(lua_State* T, int argTable, int arg)
     lua_seti(T, argTable, arg);
 }
 
+#define XMOVE_MAX_DEPTH 200
+
+static int xmoveValue(JackClientShared* client, lua_State* T, lua_State* L, int n, 
+                      int memo, int depth, int argNumber);
+
+static int xmoveTable(JackClientShared* client, lua_State* T, lua_State* L, int n, 
+                      int memo, int depth, int argNumber)
+/* Tables are copied with their contents, metatables are not copied. A table 
+ * that is reached more than once (also by a cycle) is copied only once, memo 
+ * maps the addresses of the tables in L to their copies in T. */
+{
+    lua_pushlightuserdata(T, (void*) lua_topointer(L, n));
+    lua_rawget(T, memo);
+    if (!lua_isnil(T, -1)) {
+        return 0;
+    }
+    lua_pop(T, 1);
+
+    if (depth >= XMOVE_MAX_DEPTH || !lua_checkstack(L, 3) || !lua_checkstack(T, 4)) {
+        lua_pushfstring(L, "table nesting too deep in argument #%d", argNumber);
+        return 1;
+    }
+    int narr = (int) lua_rawlen(L, n);
+    lua_createtable(T, narr, 0);
+    int copy = lua_gettop(T);
+    lua_pushlightuserdata(T, (void*) lua_topointer(L, n));
+    lua_pushvalue(T, copy);
+    lua_rawset(T, memo);
+
+    lua_pushnil(L);
+    while (lua_next(L, n) != 0) {
+        int value = lua_gettop(L);
+        if (   xmoveValue(client, T, L, value - 1, memo, depth + 1, argNumber)
+            || xmoveValue(client, T, L, value,     memo, depth + 1, argNumber))
+        {
+            /* error message is on top of L */
+            lua_replace(L, value - 1);
+            lua_settop(L, value - 1);
+            lua_settop(T, copy - 1);
+            return 1;
+        }
+        lua_rawset(T, copy);
+        lua_pop(L, 1);
+    }
+    return 0;
+}
+
+static int xmoveValue(JackClientShared* client, lua_State* T, lua_State* L, int n, 
+                      int memo, int depth, int argNumber)
+/* Pushes a copy of L[n] onto T and returns 0, or pushes an error message onto
+ * L and returns 1. */
+{
+    int type = lua_type(L, n);
+    switch (type)
+    {
+        case LUA_TNIL:     lua_pushnil(T);                            return 0;
+        case LUA_TBOOLEAN: lua_pushboolean(T, lua_toboolean(L, n));   return 0;
+        case LUA_TNUMBER:  if (lua_isinteger(L, n)) {
+                             lua_pushinteger(T, lua_tointeger(L, n));
+                           } else {
+                             lua_pushnumber(T, lua_tonumber(L, n)); } return 0;
+        case LUA_TSTRING:  {
+            size_t len;
+            const char* s = lua_tolstring(L, n, &len);
+            lua_pushlstring(T, s, len);
+            return 0;
+        }
+        case LUA_TTABLE:
+            return xmoveTable(client, T, L, n, memo, depth, argNumber);
+
+        case LUA_TUSERDATA: {
+            JackPort* p = getOptionalPort(L, n);
+            if (p && p->shared) {
+                if (p->shared->client == client) {
+                    transferPort(T, p->shared);
+                    return 0;
+                } else {
+                    lua_pushfstring(L, "port '%s' does not belong to client '%s'", 
+                                       jack_port_name(p->ptr),
+                                       jack_get_client_name(client->ptr));
+                    return 1;
+                }
+            }
+            JackClient* c = getOptionalClient(L, n);
+            if (c && c->shared) {
+                if (c->shared == client) {
+                    if (!transferClient(T, c)) {
+                        lua_pushfstring(L, "cannot transfer client");
+                        return 1;
+                    }
+                    return 0;
+                } else {
+                    lua_pushfstring(L, "client '%s' cannot be transferred to process context for client '%s'", 
+                                       jack_get_client_name(c->ptr),
+                                       jack_get_client_name(client->ptr));
+                    return 1;
+                }
+            }
+            JackRbuf* b = getOptionalRbuf(L, n);
+            if (b && b->shared) {
+                transferRbuf(T, b->shared);
+                return 0;
+            }
+            JackMeter* m = getOptionalMeter(L, n);
+            if (m && m->shared) {
+                transferMeter(T, m->shared);
+                return 0;
+            }
+            JackAnalyzer* a = getOptionalAnalyzer(L, n);
+            if (a && a->shared) {
+                transferAnalyzer(T, a->shared);
+                return 0;
+            }
+            JackConvolver* cv = getOptionalConvolver(L, n);
+            if (cv && cv->shared) {
+                transferConvolver(T, cv->shared);
+                return 0;
+            }
+            JackWavetable* w = getOptionalWavetable(L, n);
+            if (w && w->shared) {
+                transferWavetable(T, w->shared);
+                return 0;
+            }
+            JackArray* ar = getOptionalArray(L, n);
+            if (ar && ar->shared) {
+                transferArray(T, ar->shared);
+                return 0;
+            }
+            JackMidiRouter* mr = getOptionalMidiRouter(L, n);
+            if (mr && mr->shared) {
+                if (mr->shared->client == client) {
+                    transferMidiRouter(T, mr->shared);
+                    return 0;
+                } else {
+                    lua_pushfstring(L, "MIDI router does not belong to client '%s'", 
+                                       jack_get_client_name(client->ptr));
+                    return 1;
+                }
+            }
+            // FALLTHROUGH
+        }
+        default:
+            if (depth > 0) {
+                lua_pushfstring(L, "invalid type '%s' in table of argument #%d ", 
+                                    lua_typename(L, type), argNumber);
+            } else {
+                lua_pushfstring(L, "invalid type '%s' of argument #%d ", 
+                                    lua_typename(L, type), argNumber);
+            }
+            return 1;
+    }
+}
+
 int luajack_xmove(JackClientShared* client, lua_State* T, lua_State* L, int chunkName, int first_index, int last_index)
 /* Checks and copies arguments between unrelated states L and T (L to T)
  * (lua_xmove() cannot be used here, because the states are not related).
@@ -70,11 +313,13 @@ int luajack_xmove(JackClientShared* client, lua_State* T, lua_State* L, int chun
  * ...
  * L[last_index]      --> arg[N]
  * Since arguments are to be passed between unrelated states, the only admitted
- * types are: nil, boolean, number and string.
+ * types are: nil, boolean, number, string, tables of these and the LuaJack 
+ * objects that can be transferred to the process context. Tables are deep
+ * copied in one pass.
  */ 
 {
     int nargs = last_index + 1 - first_index ; /* no. of optional arguments */
-    luaL_checkstack(T, nargs, "cannot grow Lua stack for thread");
+    luaL_checkstack(T, nargs + 2, "cannot grow Lua stack for thread");
     
     luaopen_luajack(T);
     lua_setglobal(T, "jack");
@@ -82,6 +327,9 @@ int luajack_xmove(JackClientShared* client, lua_State* T, lua_State* L, int chun
     lua_newtable(T); /* "arg" table */
     int argTable = lua_gettop(T);
 
+    lua_newtable(T); /* copies of tables */
+    int memo = lua_gettop(T);
+
     lua_pushstring(T, lua_tostring(L, chunkName)); /* arg[0] = full scriptname */
     lua_seti(T, argTable, 0);
 
@@ -89,57 +337,12 @@ int luajack_xmove(JackClientShared* client, lua_State* T, lua_State* L, int chun
     int n;
     for (n = first_index; n <= last_index; n++)
     {
-        int type = lua_type(L, n);
-        switch (type)
-        {
-            case LUA_TNIL:     lua_pushnil(T);                            setArg(T, argTable, arg++); break;
-            case LUA_TBOOLEAN: lua_pushboolean(T, lua_toboolean(L, n));   setArg(T, argTable, arg++); break;
-            case LUA_TNUMBER:  if (lua_isinteger(L, n)) {
-                                 lua_pushinteger(T, lua_tointeger(L, n));
-                               } else {
-                                 lua_pushnumber(T, lua_tonumber(L, n)); } setArg(T, argTable, arg++); break;
-            case LUA_TSTRING:  lua_pushstring(T, lua_tostring(L, n));     setArg(T, argTable, arg++); break;
-            case LUA_TUSERDATA: {
-                JackPort* p = getOptionalPort(L, n);
-                if (p && p->shared) {
-                    if (p->shared->client == client) {
-                        transferPort(T, p->shared);
-                        break;   
-                    } else {
-                        lua_pushfstring(L, "port '%s' does not belong to client '%s'", 
-                                           jack_port_name(p->ptr),
-                                           jack_get_client_name(client->ptr));
-                        return 1;
-                    }
-                }
-                JackClient* c = getOptionalClient(L, n);
-                if (c && c->shared) {
-                    if (c->shared == client) {
-                        if (!transferClient(T, c)) {
-                            lua_pushfstring(L, "cannot transfer client");
-                            return 1;
-                        }
-                        break;
-                    } else {
-                        lua_pushfstring(L, "client '%s' cannot be transferred to process context for client '%s'", 
-                                           jack_get_client_name(c->ptr),
-                                           jack_get_client_name(client->ptr));
-                        return 1;
-                    }
-                }
-                JackRbuf* b = getOptionalRbuf(L, n);
-                if (b && b->shared) {
-                    transferRbuf(T, b->shared);
-                    break;
-                }
-                // FALLTHROUGH
-            }
-            default:
-                lua_pushfstring(L, "invalid type '%s' of argument #%d ", 
-                                    lua_typename(L, type), n - first_index + 1);
-                return 1;
+        if (xmoveValue(client, T, L, n, memo, 0, n - first_index + 1)) {
+            return 1;
         }
+        setArg(T, argTable, arg++);
     }
+    lua_remove(T, memo);
     lua_pushvalue(T, argTable);
     lua_setglobal(T, "arg");
     lua_remove(T, argTable);
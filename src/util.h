@@ -8,6 +8,8 @@
 #include <lualib.h>
 #include <lauxlib.h>
 
+#include "compat.h"
+
 #include <jack/jack.h>
 #include <jack/ringbuffer.h>
 
@@ -47,6 +49,93 @@ static inline Type* pushNew##Type(lua_State* L) \
 #define PORT_TYPE_NAME   "luajack.port"
 #define RBUF_TYPE_NAME   "luajack.ringbuffer"
 #define THREAD_TYPE_NAME "luajack.thread"
+#define SMOOTHER_TYPE_NAME "luajack.smoother"
+#define SCHEDULER_TYPE_NAME "luajack.scheduler"
+#define LATENCY_PROBE_TYPE_NAME "luajack.latency_probe"
+#define SCRATCH_TYPE_NAME "luajack.scratch_buffer"
+#define NATIVE_TYPE_NAME "luajack.native_module"
+#define METER_TYPE_NAME "luajack.meter"
+#define ANALYZER_TYPE_NAME "luajack.analyzer"
+#define CONVOLVER_TYPE_NAME "luajack.convolver"
+#define OSCILLATOR_TYPE_NAME "luajack.oscillator"
+#define WAVETABLE_TYPE_NAME "luajack.wavetable"
+#define PROFILER_TYPE_NAME "luajack.profiler"
+#define RECORDER_TYPE_NAME "luajack.recorder"
+#define ARRAY_TYPE_NAME "luajack.array"
+#define PORT_GROUP_TYPE_NAME "luajack.port_group"
+#define MIDI_ROUTER_TYPE_NAME "luajack.midi_router"
+#define EVENT_DATA_TYPE_NAME "luajack.event_data"
+
+/////////////////////////////////////////////////////////////////////////////////
+
+/* Metatables of all LuaJack types in the current Lua state. Every C function 
+ * registered by LuaJack gets this as first upvalue, so that type checks of 
+ * arguments only need a pointer compare instead of a registry lookup by 
+ * type name. */
+
+typedef enum {
+    CLIENT_TYPE,
+    PORT_TYPE,
+    RBUF_TYPE,
+    THREAD_TYPE,
+    SMOOTHER_TYPE,
+    SCHEDULER_TYPE,
+    LATENCY_PROBE_TYPE,
+    SCRATCH_TYPE,
+    NATIVE_TYPE,
+    METER_TYPE,
+    ANALYZER_TYPE,
+    CONVOLVER_TYPE,
+    OSCILLATOR_TYPE,
+    WAVETABLE_TYPE,
+    PROFILER_TYPE,
+    RECORDER_TYPE,
+    ARRAY_TYPE,
+    PORT_GROUP_TYPE,
+    MIDI_ROUTER_TYPE,
+    EVENT_DATA_TYPE,
+    TYPE_COUNT
+}
+LuaJackTypeId;
+
+typedef struct {
+    const void* self;
+    const void* metatables[TYPE_COUNT];
+}
+LuaJackTypes;
+
+#define initTypes luajack_initTypes
+void initTypes(lua_State* L);
+
+/* Same as luaL_setfuncs with the types as upvalue */
+#define setfuncs luajack_setfuncs
+void setfuncs(lua_State* L, const luaL_Reg* l);
+
+static inline void* testudata(lua_State* L, int stackIndex, LuaJackTypeId type, const char* typeName)
+{
+    const LuaJackTypes* types = (const LuaJackTypes*) lua_touserdata(L, lua_upvalueindex(1));
+    if (types && types->self == types) {
+        void* p = lua_touserdata(L, stackIndex);
+        if (p && lua_getmetatable(L, stackIndex)) {
+            const void* meta = lua_topointer(L, -1);
+            lua_pop(L, 1);
+            if (meta == types->metatables[type]) {
+                return p;
+            }
+        }
+        return NULL;
+    }
+    return luaL_testudata(L, stackIndex, typeName);
+}
+
+static inline void* checkudata(lua_State* L, int stackIndex, LuaJackTypeId type, const char* typeName)
+{
+    void* p = testudata(L, stackIndex, type, typeName);
+    if (!p) {
+        p = luaL_checkudata(L, stackIndex, typeName); /* raises the error */
+    }
+    return p;
+}
 
 /////////////////////////////////////////////////////////////////////////////////
 
@@ -67,6 +156,25 @@ int verbosePrintf(const char* fmt, ...);
 #define checkonoff luajack_checkonoff
 bool checkonoff(lua_State* L, int arg);
 
+/* Field name of the options table at optIndex, defaultValue if there is no
+ * options table or the field is nil */
+#define getIntegerOption luajack_getIntegerOption
+lua_Integer getIntegerOption(lua_State* L, int optIndex, const char* name, lua_Integer defaultValue);
+
+#define getNumberOption luajack_getNumberOption
+lua_Number getNumberOption(lua_State* L, int optIndex, const char* name, lua_Number defaultValue);
+
+/////////////////////////////////////////////////////////////////////////////////
+
+typedef struct {
+    jack_default_audio_sample_t* memory;
+    size_t                       size;
+    int                          count;
+    jack_nframes_t               nframes;
+    bool                         isLocked;
+}
+JackScratchPool;
+
 /////////////////////////////////////////////////////////////////////////////////
 
 typedef struct {
@@ -78,9 +186,29 @@ typedef struct {
     char*                    processContextChunkName;
     int                      processCallbackRef;
     int                      processErrorHandlerRef;
+    int                      processGcStepRef;
+    unsigned long            processCycle;    /* incremented for every process callback */
+    jack_nframes_t           currentCycleNframes;
+    jack_nframes_t           currentProcessOffset;
     jack_nframes_t           currentProcessNframes;
     AtomicCounter            processContextErrorFlag;
     char*                    errorInProcessContext;
+    volatile jack_nframes_t  processLatency;
+    bool                     hasLatencyCallback;
+    AtomicCounter            portsGeneration;
+    Mutex                    portsCacheMutex; /* guards portsCache */
+    const char**             portsCache;
+    int                      portsCacheGeneration;
+    struct JackNotificationQueue* notificationQueue;
+    JackScratchPool* volatile scratchPool;
+    JackScratchPool*         retiredScratchPool;
+    struct JackNativeChain*  nativeChain;
+    struct JackRtOptions*    rtOptions;
+    struct JackProfilerShared* volatile profiler;
+    struct JackProfilerShared* retiredProfiler; /* released, may still be used by the current cycle */
+    struct JackAllocStats*   allocStats;
+    struct JackRecorderShared* volatile recorder;
+    struct JackRecorderShared* retiredRecorder; /* closed, may still be used by the current cycle */
 }
 JackClientShared;
 
@@ -97,13 +225,13 @@ DECLARE_NEW_OBJ(JackClient, CLIENT_TYPE_NAME);
 
 static inline JackClient* getCheckedClient(lua_State* L, int stackIndex)
 {
-    JackClient* client = (JackClient*) luaL_checkudata(L, stackIndex, CLIENT_TYPE_NAME);
+    JackClient* client = (JackClient*)checkudata(L, stackIndex, CLIENT_TYPE, CLIENT_TYPE_NAME);
     return client;
 }
     
 static inline JackClient* getOptionalClient(lua_State* L, int stackIndex)
 {
-    JackClient* client = (JackClient*) luaL_testudata(L, stackIndex, CLIENT_TYPE_NAME);
+    JackClient* client = (JackClient*)testudata(L, stackIndex, CLIENT_TYPE, CLIENT_TYPE_NAME);
     return client;
 }
     
@@ -114,6 +242,7 @@ typedef struct {
     jack_port_t*      ptr;
     AtomicCounter     refCounter;
     JackClientShared* client;
+    jack_default_audio_sample_t* replayBuffer; /* replaces the JACK buffer during replay */
 }
 JackPortShared;
 
@@ -129,22 +258,114 @@ DECLARE_NEW_OBJ(JackPort, PORT_TYPE_NAME);
 
 static inline JackPort* getCheckedPort(lua_State* L, int stackIndex)
 {
-    JackPort* port = (JackPort*)luaL_checkudata(L, stackIndex, PORT_TYPE_NAME);
+    JackPort* port = (JackPort*)checkudata(L, stackIndex, PORT_TYPE, PORT_TYPE_NAME);
     return port;
 }
     
 static inline JackPort* getOptionalPort(lua_State* L, int stackIndex)
 {
-    JackPort* port = (JackPort*)luaL_testudata(L, stackIndex, PORT_TYPE_NAME);
+    JackPort* port = (JackPort*)testudata(L, stackIndex, PORT_TYPE, PORT_TYPE_NAME);
     return port;
 }
-    
+
+/////////////////////////////////////////////////////////////////////////////////
+
+typedef struct {
+    JackClientShared* client;
+    int               index;
+}
+JackScratch;
+
+static inline JackScratch* getOptionalScratch(lua_State* L, int stackIndex)
+{
+    JackScratch* scratch = (JackScratch*)testudata(L, stackIndex, SCRATCH_TYPE, SCRATCH_TYPE_NAME);
+    return scratch;
+}
+
+/* Returns the audio buffer of the port for the whole cycle, the buffer of a
+ * virtual port while a recording is replayed. */
+static inline jack_default_audio_sample_t* getSharedPortCycleBuffer(JackPortShared* port, jack_nframes_t nframes)
+{
+    if (port->replayBuffer) {
+        return port->replayBuffer;
+    }
+    return jack_port_get_buffer(port->ptr, nframes);
+}
+
+/* Returns the audio buffer of the port for the current process block or NULL
+ * if not called from within the process callback. The current block is the
+ * whole cycle unless a scheduler has split the cycle into sub-blocks. */
+static inline jack_default_audio_sample_t* getSharedPortBuffer(JackPortShared* port, jack_nframes_t* nframes)
+{
+    if (port && port->ptr && port->client) {
+        JackClientShared* client = port->client;
+        *nframes = client->currentProcessNframes;
+        if (*nframes > 0) {
+            jack_default_audio_sample_t* buffer = getSharedPortCycleBuffer(port, client->currentCycleNframes);
+            return buffer + client->currentProcessOffset;
+        }
+    }
+    *nframes = 0;
+    return NULL;
+}
+
+static inline jack_default_audio_sample_t* getPortBuffer(JackPort* port, jack_nframes_t* nframes)
+{
+    return getSharedPortBuffer(port->ptr ? port->shared : NULL, nframes);
+}
+
+/* Returns the scratch buffer for the current process block or NULL if not
+ * called from within the process callback or if the pool could not be 
+ * resized to the current buffer size. */
+
+static inline jack_default_audio_sample_t* getScratchBuffer(JackScratch* scratch, jack_nframes_t* nframes)
+{
+    if (scratch && scratch->client) {
+        JackClientShared* client = scratch->client;
+        JackScratchPool*  pool   = client->scratchPool;
+        *nframes = client->currentProcessNframes;
+        if (   *nframes > 0 && pool && scratch->index < pool->count
+            && client->currentCycleNframes <= pool->nframes) 
+        {
+            return pool->memory + (size_t)scratch->index * pool->nframes 
+                                + client->currentProcessOffset;
+        }
+    }
+    *nframes = 0;
+    return NULL;
+}
+
+/* Returns the buffer of a port or scratch buffer argument for the current 
+ * process block, raises an error if the argument is neither. */
+
+static inline jack_default_audio_sample_t* getCheckedSignalBuffer(lua_State* L, int stackIndex, jack_nframes_t* nframes)
+{
+    JackPort* port = getOptionalPort(L, stackIndex);
+    if (port) {
+        return getPortBuffer(port, nframes);
+    }
+    JackScratch* scratch = getOptionalScratch(L, stackIndex);
+    if (scratch) {
+        return getScratchBuffer(scratch, nframes);
+    }
+    luaL_argerror(L, stackIndex, "port or scratch buffer expected");
+    *nframes = 0;
+    return NULL;
+}
+
+/* Returns the optional number of frames at arg, which must not exceed the
+ * nframes of the current process block, or nframes if absent */
+#define getOptionalNframes luajack_getOptionalNframes
+jack_nframes_t getOptionalNframes(lua_State* L, int arg, jack_nframes_t nframes);
 
 /////////////////////////////////////////////////////////////////////////////////
 
 typedef struct {
     jack_ringbuffer_t* ptr;
     AtomicCounter refCounter;
+    struct JackRecorderShared* recorder; /* records the messages read from it */
+    int           recorderIndex;
+    volatile bool readOutsideProcess;    /* read by a context that cannot be recorded */
 }
 JackRbufShared;
 
@@ -159,13 +380,13 @@ DECLARE_NEW_OBJ(JackRbuf, RBUF_TYPE_NAME);
 
 static inline JackRbuf* getCheckedRbuf(lua_State* L, int stackIndex)
 {
-    JackRbuf* rbuf = (JackRbuf*)luaL_checkudata(L, stackIndex, RBUF_TYPE_NAME);
+    JackRbuf* rbuf = (JackRbuf*)checkudata(L, stackIndex, RBUF_TYPE, RBUF_TYPE_NAME);
     return rbuf;
 }
     
 static inline JackRbuf* getOptionalRbuf(lua_State* L, int stackIndex)
 {
-    JackRbuf* rbuf = (JackRbuf*)luaL_testudata(L, stackIndex, RBUF_TYPE_NAME);
+    JackRbuf* rbuf = (JackRbuf*)testudata(L, stackIndex, RBUF_TYPE, RBUF_TYPE_NAME);
     return rbuf;
 }
     
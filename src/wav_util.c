@@ -0,0 +1,160 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "wav_util.h"
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+static unsigned int le16(const unsigned char* p)
+{
+    return p[0] | (p[1] << 8);
+}
+
+static unsigned int le32(const unsigned char* p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((unsigned int) p[3] << 24);
+}
+
+static float sampleToFloat(const unsigned char* p, int format, int bits)
+{
+    if (format == WAV_FORMAT_FLOAT) {
+        if (bits == 32) {
+            union { unsigned int i; float f; } u;
+            u.i = le32(p);
+            return u.f;
+        } else {
+            union { unsigned long long i; double d; } u;
+            u.i = le32(p) | ((unsigned long long) le32(p + 4) << 32);
+            return (float) u.d;
+        }
+    }
+    switch (bits) {
+        case 16: return (float)(short) le16(p) / 32768.0f;
+        case 24: return (float)((int)((p[0] << 8) | (p[1] << 16) | ((unsigned int) p[2] << 24)) >> 8) / 8388608.0f;
+        default: return (float)(int) le32(p) / 2147483648.0f;
+    }
+}
+
+static bool readWavHeader(FILE* file, JackWavInfo* info, const char** errorMessage)
+{
+    unsigned char  header[12];
+    unsigned char  chunk[8];
+    unsigned char  fmt[40];
+    memset(info, 0, sizeof(JackWavInfo));
+    if (   fread(header, 1, 12, file) != 12 
+        || memcmp(header, "RIFF", 4) != 0 || memcmp(header + 8, "WAVE", 4) != 0) 
+    {
+        *errorMessage = "not a RIFF/WAVE file";
+        return false;
+    }
+    while (fread(chunk, 1, 8, file) == 8) {
+        unsigned int size = le32(chunk + 4);
+        if (memcmp(chunk, "fmt ", 4) == 0) {
+            if (size < 16 || size > sizeof(fmt) || fread(fmt, 1, size, file) != size) {
+                *errorMessage = "invalid fmt chunk";
+                return false;
+            }
+            info->format     = le16(fmt);
+            info->channels   = le16(fmt + 2);
+            info->sampleRate = le32(fmt + 4);
+            info->bits       = le16(fmt + 14);
+            if (info->format == WAV_FORMAT_EXTENSIBLE && size >= 26) {
+                info->format = le16(fmt + 24);
+            }
+            if (size & 1) {
+                fseek(file, 1, SEEK_CUR);
+            }
+        }
+        else if (memcmp(chunk, "data", 4) == 0) {
+            if (info->channels == 0) {
+                *errorMessage = "missing fmt chunk";
+                return false;
+            }
+            int format = info->format, bits = info->bits;
+            if (!(   (format == WAV_FORMAT_PCM   && (bits == 16 || bits == 24 || bits == 32))
+                  || (format == WAV_FORMAT_FLOAT && (bits == 32 || bits == 64)))) 
+            {
+                *errorMessage = "unsupported sample format";
+                return false;
+            }
+            info->dataOffset = ftell(file);
+            info->dataBytes  = size;
+            /* streaming writers leave the size at 0xFFFFFFFF, truncated
+             * files have less data than declared */
+            if (fseek(file, 0, SEEK_END) == 0) {
+                long end = ftell(file);
+                if (end >= info->dataOffset && (unsigned long)(end - info->dataOffset) < info->dataBytes) {
+                    info->dataBytes = (size_t)(end - info->dataOffset);
+                }
+                fseek(file, info->dataOffset, SEEK_SET);
+            }
+            return true;
+        }
+        else {
+            fseek(file, size + (size & 1), SEEK_CUR);
+        }
+    }
+    *errorMessage = "missing data chunk";
+    return false;
+}
+
+bool readWavInfo(const char* fileName, JackWavInfo* info, const char** errorMessage)
+{
+    FILE* file = fopen(fileName, "rb");
+    if (!file) {
+        *errorMessage = "cannot open file";
+        return false;
+    }
+    bool rslt = readWavHeader(file, info, errorMessage);
+    fclose(file);
+    return rslt;
+}
+
+float* readWavFile(const char* fileName, int channel, 
+                   int* nframes, int* nchannels, int* sampleRate, const char** errorMessage)
+{
+    JackWavInfo    info;
+    unsigned char* data   = NULL;
+    float*         result = NULL;
+    FILE* file = fopen(fileName, "rb");
+    if (!file) {
+        *errorMessage = "cannot open file";
+        return NULL;
+    }
+    if (!readWavHeader(file, &info, errorMessage)) {
+        goto finally;
+    }
+    if (channel < 0 || channel >= info.channels) {
+        *errorMessage = "invalid channel";
+        goto finally;
+    }
+    unsigned int size = (unsigned int) info.dataBytes;
+    int frameBytes = info.channels * info.bits / 8;
+    data = (unsigned char*) malloc(size > 0 ? size : 1);
+    if (!data) {
+        *errorMessage = "out of memory";
+        goto finally;
+    }
+    size = (unsigned int) fread(data, 1, size, file);
+    int n = size / frameBytes;
+    result = (float*) malloc(sizeof(float) * (n > 0 ? n : 1));
+    if (!result) {
+        *errorMessage = "out of memory";
+        goto finally;
+    }
+    int i;
+    for (i = 0; i < n; ++i) {
+        result[i] = sampleToFloat(data + i * frameBytes + channel * info.bits / 8, info.format, info.bits);
+    }
+    *nframes    = n;
+    *nchannels  = info.channels;
+    *sampleRate = info.sampleRate;
+
+finally:
+    free(data);
+    fclose(file);
+    return result;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,40 @@
+#ifndef LUAJACK_WAV_UTIL_H
+#define LUAJACK_WAV_UTIL_H
+
+#include "util.h"
+
+/////////////////////////////////////////////////////////////////////////////////
+
+#define WAV_FORMAT_PCM         1
+#define WAV_FORMAT_FLOAT       3
+#define WAV_FORMAT_EXTENSIBLE  0xFFFE
+
+typedef struct {
+    int    format;          /* WAV_FORMAT_PCM or WAV_FORMAT_FLOAT */
+    int    bits;
+    int    channels;
+    int    sampleRate;
+    long   dataOffset;      /* file position of the first sample frame */
+    size_t dataBytes;
+}
+JackWavInfo;
+
+/* Reads the format of a RIFF/WAVE file with a supported sample format 
+ * without reading the sample data. */
+
+#define readWavInfo luajack_readWavInfo
+
+bool readWavInfo(const char* fileName, JackWavInfo* info, const char** errorMessage);
+
+/* Reads one channel (0-based) of a RIFF/WAVE file with 16/24/32 bit integer 
+ * or 32/64 bit float samples. Returns a malloc'ed sample array or NULL and 
+ * an error message. */
+
+#define readWavFile luajack_readWavFile
+
+float* readWavFile(const char* fileName, int channel, 
+                   int* nframes, int* nchannels, int* sampleRate, const char** errorMessage);
+
+/////////////////////////////////////////////////////////////////////////////////
+
+#endif // LUAJACK_WAV_UTIL_H